@@ -1,11 +1,52 @@
 // app.js - 디버깅 테스트 추가
-import { SXCamera } from './lib/sx-camera.js';
-import { mkdir } from 'fs/promises';
+import { SXCamera, FrameStacker, TransientDetector, NightComposite, recordStage, setLogLevel, buildCalibrationMaster, detectStars, skyHeaders,
+         buildImagePyramid } from './lib/sx-camera.js';
+import { mkdir, readFile, rename } from 'fs/promises';
 import { join } from 'path';
 import { Gpio } from 'onoff';
 
 
-const cameraPowerPin = new Gpio(532, 'out'); // weired numbering now for gpio 20 //TODO
+// 'usb'(실제 ECHO2) 또는 'sim'(하드웨어 없는 시뮬레이터: CI/벤치마크용, 전원 GPIO 사용 안 함)
+const CAMERA_BACKEND = process.env.SX_CAMERA_BACKEND || 'usb';
+// 시뮬레이터 설정 (JSON, 예: '{"throughputMBps": 20, "timeoutRate": 0.05}')
+const SIM_OPTIONS = process.env.SX_SIM_OPTIONS ? JSON.parse(process.env.SX_SIM_OPTIONS) : undefined;
+
+// 포치 기반 바이어스 보정 ('off' | 'frame' | 'row', 기본 'off'): 냉각하지 않는 카메라의 프레임 간 바이어스 변동 제거
+const BIAS_CORRECTION = process.env.SX_BIAS_CORRECTION || 'off';
+
+// 보정 마스터(.sxcal) 디렉터리: 설정하면 연결할 때 마스터를 불러와 촬영마다 바이어스/다크/플랫 보정
+const CALIBRATION_DIR = process.env.SX_CALIBRATION_DIR || null;
+
+// 핫/데드 픽셀 맵 파일: 설정하면 맵에 있는 픽셀을 촬영마다 교체. SX_DEFECT_LEARN=1이면 촬영하면서 맵을 학습해 갱신
+const DEFECT_MAP = process.env.SX_DEFECT_MAP || null;
+const DEFECT_LEARN = process.env.SX_DEFECT_LEARN === '1';
+
+// 저장할 때 별 검출로 하늘 상태(별 수, FWHM/HFR, 배경)를 재서 FITS 헤더와 촬영 기록에 남김 (SX_STAR_DETECT=0이면 끔)
+const STAR_DETECT = process.env.SX_STAR_DETECT !== '0';
+
+// 구름 지도 기준 (buildCloudReference 결과 JSON): 없으면 프레임 안 별 밀도/배경 무늬로 판단
+const CLOUD_REFERENCE = process.env.SX_CLOUD_REFERENCE || null;
+// 어안 렌즈 하늘 원 (JSON { x, y, radius }, 저장하는 이미지 픽셀 기준, 'off'면 마스크 없음). 없으면 프레임 중앙 내접원
+const CLOUD_SKY = !process.env.SX_CLOUD_SKY ? undefined
+  : process.env.SX_CLOUD_SKY === 'off' ? false : JSON.parse(process.env.SX_CLOUD_SKY);
+
+// 연속 프레임 차분으로 유성/위성 궤적 검출 (SX_TRANSIENT_DETECT=0이면 끔). 궤적 영역은 images/<epoch>_trail<n>.jpg로 저장
+const TRANSIENT_DETECT = process.env.SX_TRANSIENT_DETECT !== '0';
+
+// 밤 단위 키오그램/별 궤적 합성 (SX_NIGHT_COMPOSITE=0이면 끔). 상태는 data/night/<밤>/에 두어 재시작해도 이어 쌓고,
+// 촬영마다 images/keogram_<밤>.jpg, images/startrail_<밤>.jpg를 갱신
+const NIGHT_COMPOSITE = process.env.SX_NIGHT_COMPOSITE !== '0';
+const NIGHT_DIR = join('data', 'night');
+
+// 썸네일 피라미드 단계 수 (기본 3: 1/2, 1/4, 1/8, 0이면 끔). 촬영 변환 패스에서 만들어 images/thumbs/<epoch>_<배율>.jpg로 저장
+const THUMBNAIL_LEVELS = parseInt(process.env.SX_THUMBNAIL_LEVELS ?? '3');
+const THUMBNAIL_DIR = 'thumbs';
+const THUMBNAIL_QUALITY = 80;
+
+// 네이티브 로그 레벨 ('error' | 'warn' | 'info' | 'debug' | 'trace', 기본 'info')
+if (process.env.SX_LOG_LEVEL) setLogLevel(process.env.SX_LOG_LEVEL);
+
+const cameraPowerPin = CAMERA_BACKEND === 'sim' ? null : new Gpio(532, 'out'); // weired numbering now for gpio 20 //TODO
 
 /**
  * 현재 시간을 포맷된 문자열로 반환하는 함수
@@ -30,89 +71,518 @@ function getReadableTimestamp() {
   }
 
 
+// 촬영 시퀀스 동안 유지되는 카메라 세션 (매 프레임마다 전원/열기/닫기를 반복하지 않음)
+let camera = null;
+
+const POWER_ON_TIMEOUT_MS = 10000; // 전원 인가 후 USB 장치가 열릴 때까지 최대 대기 시간
+const POWER_ON_POLL_MS = 500;      // 장치 열기 재시도 간격
+const FITS_COMPRESS = true;        // data/ 의 FITS를 RICE_1 타일 압축으로 저장 (무손실, astropy/funpack으로 읽기 가능)
+
 /**
- * Starlight Xpress 카메라 테스트 함수
+ * 카메라 전원을 켜고 세션을 연다 (이미 열려 있으면 그대로 사용)
+ * @param {Object} options timings: 주어지면 powerUp(전원 인가~장치 응답)/open(장치 열기) 소요 시간(ms) 기록
+ * @returns {Promise<SXCamera>} 연결된 카메라 객체
  */
-export async function saveSXCamera(exposureTime) {
-  // 카메라 객체 생성
-  const camera = new SXCamera();
-  
+export async function openSXCamera(options = {}) {
+  const { timings } = options;
+  if (camera && camera.isConnected()) {
+    return camera;
+  }
+
+  if (!camera) {
+    camera = new SXCamera({ backend: CAMERA_BACKEND, sim: SIM_OPTIONS });
+    // 세션 모드: USB 연결을 유지하고 장치가 끊기면 촬영 전에 자동으로 다시 연결
+    camera.setSessionMode(true);
+    // 촬영과 같은 패스에서 프레임 통계 계산 (JPG 스트레칭과 DB 기록에 사용)
+    camera.setFrameStats(true);
+    camera.setPyramid(THUMBNAIL_LEVELS);
+    camera.setBiasCorrection(BIAS_CORRECTION);
+    loadCalibration();
+    loadDefectMap();
+  }
+
+  console.log('Starlight Xpress 카메라 세션 시작');
+
+  const powerStart = performance.now();
+  cameraPowerPin?.writeSync(1);
+  console.log(`camera power on`);
+
+  // 고정 3초 대기 대신 장치가 열릴 때까지 폴링
+  console.log('카메라 연결 시도...');
+  const start = Date.now();
+  let connectStart = performance.now();
+  while (!camera.connect()) {
+    if (Date.now() - start > POWER_ON_TIMEOUT_MS) {
+      throw new Error(`카메라 연결 실패: ${camera.getLastError()}`);
+    }
+    await delay(POWER_ON_POLL_MS);
+    connectStart = performance.now();
+  }
+  if (timings) {
+    timings.powerUp = connectStart - powerStart;
+    recordStage(timings, 'open', connectStart);
+  }
+
+  console.log(`카메라 연결 성공! (${Date.now() - start} ms)`);
+
+  // 카메라 정보 가져오기
   try {
-    console.log('Starlight Xpress 카메라 테스트 시작');
+    const cameraInfo = camera.getCameraInfo();
+    console.log('카메라 정보:');
+    console.log(` - 모델: ${cameraInfo.model} (코드: ${cameraInfo.modelCode})`);
+    console.log(` - 펌웨어 버전: ${cameraInfo.firmwareVersion}`);
+    const { ccd } = cameraInfo;
+    console.log(` - CCD: ${ccd.width}x${ccd.height}, ${ccd.pixelWidthUm.toFixed(2)} um, ${ccd.bitsPerPixel}비트` +
+                `${ccd.fromCamera ? '' : ' (GET_CCD_PARAMS 실패, 기본값)'}`);
+  } catch (error) {
+    console.error('카메라 정보 가져오기 실패:', error.message);
+  }
 
-    cameraPowerPin.writeSync(1);
-    console.log(`camera power on`);
-    await delay(3000);
-    
+  return camera;
+}
 
-    // 카메라 연결
-    console.log('카메라 연결 시도...');
-    const connected = camera.connect();
-    
-    if (!connected) {
-      console.error('카메라 연결 실패:', camera.getLastError());
-      return;
+/**
+ * CALIBRATION_DIR의 보정 마스터를 (다시) 불러온다. 디렉터리가 없거나 읽지 못하면 보정 없이 계속
+ */
+function loadCalibration() {
+  if (!CALIBRATION_DIR || !camera) return;
+  try {
+    const masters = camera.setCalibration({ dir: CALIBRATION_DIR });
+    console.log(`보정 마스터 ${masters.length}개 로드: ${CALIBRATION_DIR}`);
+  } catch (error) {
+    console.error('보정 마스터 로드 실패:', error.message);
+  }
+}
+
+/**
+ * DEFECT_MAP의 결함 맵을 (다시) 불러온다. 읽지 못하면 결함 보정 없이 계속
+ */
+function loadDefectMap() {
+  if (!DEFECT_MAP || !camera) return;
+  try {
+    const map = camera.setDefectCorrection({ path: DEFECT_MAP, learn: DEFECT_LEARN });
+    console.log(`결함 맵 로드: ${map.grids.map(g => `${g.xBin}x${g.yBin} ${g.count}픽셀`).join(', ') || '비어 있음'}`);
+  } catch (error) {
+    console.error('결함 맵 로드 실패:', error.message);
+  }
+}
+
+// 궤적 검출기 (배경 이력은 네이티브 링 버퍼, 처음 저장할 때 생성)
+let transientDetector = null;
+
+/**
+ * 궤적 검출 배경 이력 비우기 (시퀀스 사이 간격이 길면 하늘이 바뀌어 이전 프레임이 배경으로 맞지 않음)
+ */
+export async function resetTransients() {
+  if (transientDetector) await transientDetector.reset();
+}
+
+// 밤 합성 객체 (밤이 바뀌면 이전 밤을 닫고 새로 엶). 겹쳐 저장해도 한 밤에 하나만 열리도록 Promise로 순서를 지킴
+let nightCompositePending = null;
+
+/**
+ * 밤 구분자 (정오부터 다음 날 정오까지를 시작 날짜로, 예: '20261016')
+ * @param {number} epoch Unix 시간(초)
+ */
+function getNightId(epoch) {
+  const noon = new Date((epoch - 12 * 3600) * 1000);
+  return `${noon.getFullYear()}${String(noon.getMonth() + 1).padStart(2, '0')}${String(noon.getDate()).padStart(2, '0')}`;
+}
+
+function openNightComposite(night) {
+  const previous = nightCompositePending ? nightCompositePending.catch(() => null) : Promise.resolve(null);
+  nightCompositePending = previous.then(async (current) => {
+    if (current && current.night === night) return current;
+    if (current) {
+      await current.composite.close();
+      console.log(`밤 합성 종료: ${current.night}`);
     }
-    
-    console.log('카메라 연결 성공!');
-    
-    // 카메라 정보 가져오기
-    try {
-      const cameraInfo = camera.getCameraInfo();
-      console.log('카메라 정보:');
-      console.log(` - 모델: ${cameraInfo.model} (코드: ${cameraInfo.modelCode})`);
-      console.log(` - 펌웨어 버전: ${cameraInfo.firmwareVersion}`);
-    } catch (error) {
-      console.error('카메라 정보 가져오기 실패:', error.message);
+    const dir = join(NIGHT_DIR, night);
+    await mkdir(dir, { recursive: true });
+    const composite = new NightComposite({ dir });
+    const { resumed, frames } = composite.getInfo();
+    console.log(resumed ? `밤 합성 이어 쌓기: ${night} (${frames}프레임)` : `밤 합성 시작: ${night}`);
+    return { night, composite };
+  });
+  return nightCompositePending;
+}
+
+// 합성 결과를 임시 파일에 쓰고 rename해 보는 쪽이 쓰다 만 JPG를 읽지 않게 함
+async function publishNightPreview(saver, composite, night, imagesDir) {
+  const files = {};
+  for (const [name, read] of [['keogram', () => composite.getKeogram()], ['startrail', () => composite.getStarTrail()]]) {
+    const jpg = `${name}_${night}.jpg`;
+    const temp = join(imagesDir, `.${name}_${night}.tmp.jpg`);
+    await saver.saveAsJPG({ ...(await read()), bitsPerPixel: 16 }, temp, { quality: 90, stretch: true });
+    await rename(temp, join(imagesDir, jpg));
+    files[name] = jpg;
+  }
+  return files;
+}
+
+/**
+ * 현재 밤 합성 상태 (열린 합성이 없으면 null)
+ * @returns {Promise<Object|null>} { night, frames, keogramColumns, totalExposure, ..., keogram, startrail }
+ */
+export async function getNightCompositeInfo() {
+  if (!nightCompositePending) return null;
+  const current = await nightCompositePending.catch(() => null);
+  if (!current) return null;
+  const info = current.composite.getInfo();
+  const published = info.frames > 0;
+  return {
+    night: current.night, ...info,
+    keogram: published ? `keogram_${current.night}.jpg` : null,
+    startrail: published ? `startrail_${current.night}.jpg` : null
+  };
+}
+
+// 구름 지도 기준은 처음 저장할 때 한 번 읽음 (읽지 못하면 기준 없이 계속)
+let cloudReference;
+async function loadCloudReference() {
+  if (cloudReference !== undefined) return cloudReference;
+  cloudReference = null;
+  if (!CLOUD_REFERENCE) return cloudReference;
+  try {
+    cloudReference = JSON.parse(await readFile(CLOUD_REFERENCE, 'utf8'));
+    console.log(`구름 기준 로드: ${cloudReference.columns}x${cloudReference.rows} 구역`);
+  } catch (error) {
+    console.error('구름 기준 로드 실패:', error.message);
+  }
+  return cloudReference;
+}
+
+/**
+ * 보정 마스터 촬영: 같은 설정으로 count장을 찍어 합친 마스터를 CALIBRATION_DIR에 저장하고 다시 불러온다
+ * 바이어스는 최단 노출, 다크는 렌즈를 가린 상태로 촬영에 쓰는 노출, 플랫은 균일한 광원으로 촬영
+ * @param {string} type 'bias' | 'dark' | 'flat'
+ * @param {Object} options count(기본 16), exposureTime(초), region(captureSXFrame과 같음),
+ *                         combine('median' | 'sigma', 기본 'sigma'), kappa, bias(플랫에서 뺄 바이어스 마스터 경로), dir,
+ *                         onProgress(current, total): 프레임마다 호출
+ * @returns {Promise<Object>} 마스터 정보 (buildCalibrationMaster 결과)
+ */
+export async function captureCalibrationMaster(type, options = {}) {
+  const { count = 16, exposureTime = type === 'bias' ? 0.001 : 1.0, region = true,
+          combine = 'sigma', kappa, bias, dir = CALIBRATION_DIR, onProgress } = options;
+  if (!dir) throw new Error('마스터를 저장할 디렉터리(SX_CALIBRATION_DIR 또는 dir)가 필요합니다.');
+  await mkdir(dir, { recursive: true });
+
+  const camera = await openSXCamera();
+  // 마스터 재료는 보정하지 않은 프레임이어야 함 (다크가 핫 픽셀을 담아야 빼낼 수 있음)
+  camera.setCalibration(null);
+  camera.setDefectCorrection(null);
+  try {
+    const images = [];
+    for (let i = 0; i < count; i++) {
+      const { image } = await captureSXFrame(exposureTime, { region });
+      images.push(image);
+      console.log(`${type} 프레임 ${i + 1}/${count}`);
+      onProgress?.(i + 1, count);
     }
-    
-    // 이미지 캡처
-    //const exposureTime = 5.0; //  노출
-    console.log(`이미지 캡처 시작 (노출 시간: ${exposureTime}초)...`);
-    
-// 이미지 저장 부분 수정
-try {
-  const image = camera.captureImage(exposureTime);
-  console.log(`이미지 캡처 완료: ${image.width}x${image.height}, ${image.bitsPerPixel}비트`);
-  
+    const { xBinning: xBin, yBinning: yBin } = images[0];
+    const path = join(dir, `${type}_${xBin}x${yBin}_${exposureTime}s_${getEpochTimestamp()}.sxcal`);
+    const master = await buildCalibrationMaster(images, path, { type, combine, kappa, bias });
+    console.log(`보정 마스터 저장: ${path} (${master.frames}장, 제외 ${master.rejected}, ${master.buildMs.toFixed(0)} ms)`);
+    return master;
+  } finally {
+    loadCalibration();
+    loadDefectMap();
+  }
+}
+
+/**
+ * 카메라 세션을 닫고 전원을 끈다
+ */
+export function closeSXCamera() {
+  // 카메라 객체는 유지 (노출 타이밍 통계 등 누적 값 보존), USB 연결만 해제
+  // 촬영이 진행 중이면 먼저 취소를 요청 (그래도 닫지 못하면 전원은 끔: 워커는 장치 오류로 끝남)
+  try {
+    if (camera && camera.isCapturing()) {
+      camera.cancelCapture();
+      console.log('진행 중인 촬영 취소 요청');
+    }
+    if (camera && camera.isConnected()) {
+      camera.disconnect();
+      console.log('카메라 연결 해제...');
+    }
+  } catch (error) {
+    console.error('카메라 연결 해제 실패:', error.message);
+  }
+
+  cameraPowerPin?.writeSync(0);
+  console.log(`camera power off`);
+}
+
+/**
+ * 진행 중인 촬영 취소 요청 (노출 대기 중이면 중단, 결과 Promise는 거부됨)
+ * @returns {boolean} 취소를 요청했는지 (진행 중인 촬영이 없으면 false)
+ */
+export function cancelSXCapture() {
+  return camera ? camera.cancelCapture() : false;
+}
+
+/**
+ * 한 프레임 촬영 (세션이 없으면 연다)
+ * @param {number} exposureTime 노출 시간(초)
+ * @param {Object} options exposureMode: 'host'(호스트 타이밍) 또는 'camera'(카메라 내부 타이머)
+ *                                       어느 쪽이든 노출 내내 libuv 워커 스레드 하나를 차지함
+ *                         timings: 주어지면 단계별 소요 시간(ms) 기록 (capture, exposure, readout, convert 등)
+ *                         region: 2x2 비닝 여부(기본 true) 또는 부분 영역 { x, y, width, height, bin } (초점/별 추적용)
+ *                                 바이어스 보정 중 포치까지 읽으면 전송량이 영역의 두 배를 넘는 좁은 영역은 포치를 읽지 않고
+ *                                 같은 비닝에서 마지막으로 잰 포치 바이어스를 씀 (biasColumns 0, 그 전에는 보정하지 않음)
+ * @returns {Promise<Object>} { image, epoch, readable }
+ */
+export async function captureSXFrame(exposureTime, options = {}) {
+  const { exposureMode = 'host', timings, region = true } = options;
+  const camera = await openSXCamera({ timings });
+  camera.setExposureMode(exposureMode);
+
+  // 이미지 캡처
+  console.log(`이미지 캡처 시작 (노출 시간: ${exposureTime}초, ${exposureMode} 타이밍)...`);
+
+  const captureStart = performance.now();
+  const image = await camera.captureImageAsync(exposureTime, region, (progress) => {
+    if (progress.phase === 'downloading' && progress.bytes === progress.totalBytes) {
+      console.log(`다운로드 완료: ${progress.totalBytes} 바이트`);
+    }
+  });
+  if (timings) {
+    // capture는 워커 왕복 전체, 나머지는 네이티브에서 측정한 구간
+    recordStage(timings, 'capture', captureStart);
+    timings.exposure = image.measuredExposureMs;
+    timings.readout = image.downloadMs;
+    timings.convert = image.convertMs;
+    timings.readoutMBps = image.downloadMBps; // 시간이 아닌 다운로드 처리량
+  }
+  console.log(`이미지 캡처 완료: ${image.width}x${image.height}, ${image.binning} 비닝, ${image.bitsPerPixel}비트`);
+  console.log(`다운로드: ${image.downloadMs.toFixed(1)} ms, ${image.downloadMBps.toFixed(2)} MB/s`);
+  console.log(`측정 노출: ${image.measuredExposureMs.toFixed(1)} ms`);
+
+  // 타임스탬프를 이용한 파일명 생성
+  //const timestamp = getFormattedTime();
+  const epoch = getEpochTimestamp();
+  const readable = getReadableTimestamp();
+
+  return { image, epoch, readable };
+}
+
+/**
+ * 피라미드 단계별 썸네일 JPG 저장 (촬영 때 만든 image.pyramid가 없으면 여기서 만듦)
+ * 스트레칭은 원본 히스토그램을 그대로 써서 단계마다 같은 밝기로 보이게 함
+ * @returns {Promise<Object[]|null>} [{ scale, width, height, jpg }] (images/ 기준 경로), 끄면 null
+ */
+async function saveThumbnails(saver, image, epoch, imagesDir, timings) {
+  if (THUMBNAIL_LEVELS <= 0) return null;
+  const start = performance.now();
+  await mkdir(join(imagesDir, THUMBNAIL_DIR), { recursive: true });
+  const pyramid = image.pyramid || buildImagePyramid(image, { levels: THUMBNAIL_LEVELS });
+  const thumbnails = await Promise.all(pyramid.map(async (level) => {
+    const jpg = `${THUMBNAIL_DIR}/${epoch}_${level.scale}.jpg`;
+    await saver.saveAsJPG({ ...level, bitsPerPixel: image.bitsPerPixel, stats: image.stats }, join(imagesDir, jpg),
+                          { quality: THUMBNAIL_QUALITY, stretch: true });
+    return { scale: level.scale, width: level.width, height: level.height, jpg };
+  }));
+  recordStage(timings, 'thumbnails', start);
+  return thumbnails;
+}
+
+/**
+ * 촬영된 프레임을 JPG/FITS로 저장 (다음 프레임 노출과 겹쳐서 실행 가능)
+ * @param {Object} frame captureSXFrame 결과
+ * @param {Object} options timings: 주어지면 stretch/jpegEncode/thumbnails/starDetect/transientDetect/nightComposite/fitsWrite/fitsCompress
+ *                         소요 시간(ms) 기록
+ * @returns {Promise<Object>} { epoch, readable, jpg, fits, stats, thumbnails: [{ scale, width, height, jpg }] | null(끔),
+ *                             sky: { stars, measured, fwhm, hfr, background, backgroundRms, cloud: { method, columns, rows, cover, grid, stars } } | null,
+ *                             transients: [{ x1, y1, x2, y2, length, angle, points, flux, box, jpg }] | null(검출 전/끔),
+ *                             composites: { night, frames, keogramColumns, keogram, startrail } | null(끔/실패) }
+ */
+export async function saveSXFrame(frame, options = {}) {
+  const { timings } = options;
+  const { image, epoch, readable } = frame;
+
   // 이미지 저장 디렉토리 생성
   const imagesDir = 'images';
   await mkdir(imagesDir, { recursive: true });
 
   const dataDir = 'data';
   await mkdir(dataDir, { recursive: true });
-  
-  // 타임스탬프를 이용한 파일명 생성
-  //const timestamp = getFormattedTime();
-  const epoch = getEpochTimestamp();
-  const readable = getReadableTimestamp();
-  
+
+  // 저장 함수는 카메라 상태와 무관하므로 세션이 닫혀도 사용 가능
+  const saver = camera || new SXCamera();
+
+  // 궤적 검출은 촬영 순서대로 이력에 쌓여야 하므로 저장 작업보다 먼저 요청 (워커 스레드에서 JPG 인코딩과 겹쳐 진행)
+  let transientsPending = Promise.resolve(null);
+  if (TRANSIENT_DETECT) {
+    if (!transientDetector) transientDetector = new TransientDetector();
+    const transientStart = performance.now();
+    transientsPending = transientDetector.add(image).then(
+      (result) => { recordStage(timings, 'transientDetect', transientStart); return result; },
+      (error) => { console.error('궤적 검출 실패:', error.message); return null; });
+  }
+
+  // 밤 합성도 촬영 순서대로 반영 (프레임당 키오그램 한 열 + 픽셀별 최댓값)
+  let compositePending = Promise.resolve(null);
+  if (NIGHT_COMPOSITE) {
+    const compositeStart = performance.now();
+    compositePending = openNightComposite(getNightId(epoch)).then(async ({ night, composite }) => {
+      const added = await composite.add(image);
+      recordStage(timings, 'nightComposite', compositeStart);
+      return { night, composite, added };
+    }).catch((error) => { console.error('밤 합성 실패:', error.message); return null; });
+  }
+
+  // 별 검출은 워커 스레드에서 JPG 인코딩과 겹쳐 진행 (실패해도 저장은 계속)
+  const detectStart = performance.now();
+  const detecting = STAR_DETECT
+    ? loadCloudReference().then(reference => detectStars(image, { cloud: { reference: reference || undefined, sky: CLOUD_SKY } })).then(
+      (result) => { recordStage(timings, 'starDetect', detectStart); return result; },
+      (error) => { console.error('별 검출 실패:', error.message); return null; })
+    : Promise.resolve(null);
+
   // JPG 형식으로 저장 (명암 스트레칭 및 90% 품질)
   const jpgFilename = join(imagesDir, `${epoch}.jpg`);
-  await camera.saveAsJPG(image, jpgFilename, { quality: 90, stretch: true });
+  await saver.saveAsJPG(image, jpgFilename, { quality: 90, stretch: true, timings });
   console.log(`이미지가 저장되었습니다: ${jpgFilename}`);
 
+  let thumbnails = null;
+  try {
+    thumbnails = await saveThumbnails(saver, image, epoch, imagesDir, timings);
+  } catch (error) {
+    console.error('썸네일 저장 실패:', error.message);
+  }
+
+  let sky = null;
+  const detected = await detecting;
+  if (detected) {
+    const { stars, measured, fwhm, hfr, background, backgroundRms, cloud } = detected;
+    sky = {
+      stars, measured, fwhm, hfr, background, backgroundRms,
+      cloud: {
+        method: cloud.method, columns: cloud.columns, rows: cloud.rows, cover: cloud.cover,
+        grid: Array.from(cloud.grid), stars: Array.from(cloud.stars)
+      }
+    };
+    const cover = cloud.cover === null ? '-' : `${cloud.cover.toFixed(0)}%`;
+    console.log(`별 ${stars}개, FWHM ${fwhm.toFixed(2)}, HFR ${hfr.toFixed(2)}, 배경 ${background.toFixed(1)} ADU, 구름 ${cover}`);
+  }
+
+  let transients = null;
+  const detectedTrails = await transientsPending;
+  if (detectedTrails && detectedTrails.ready) {
+    transients = [];
+    for (const [i, trail] of detectedTrails.trails.entries()) {
+      const { crop, ...info } = trail;
+      const jpg = `${epoch}_trail${i + 1}.jpg`;
+      await saver.saveAsJPG(crop, join(imagesDir, jpg), { quality: 90, stretch: true });
+      transients.push({ ...info, jpg });
+      console.log(`궤적 검출: (${trail.x1.toFixed(0)}, ${trail.y1.toFixed(0)}) - (${trail.x2.toFixed(0)}, ${trail.y2.toFixed(0)}), ` +
+                  `길이 ${trail.length.toFixed(0)}픽셀 -> ${jpg}`);
+    }
+  }
+
+  let composites = null;
+  const composited = await compositePending;
+  if (composited) {
+    const { night, composite, added } = composited;
+    try {
+      const files = await publishNightPreview(saver, composite, night, imagesDir);
+      composites = { night, frames: added.frames, keogramColumns: added.keogramColumns, ...files };
+    } catch (error) {
+      console.error('밤 합성 미리보기 저장 실패:', error.message);
+    }
+  }
+
   const fitsFilename = join(dataDir, `${epoch}.fits`);
   // FITS 형식으로 저장
-  await camera.saveAsFits(image, fitsFilename);
+  await saver.saveAsFits(image, fitsFilename, { compress: FITS_COMPRESS, timings, headers: skyHeaders(sky) });
   console.log(`이미지가 저장되었습니다: ${fitsFilename}`);
 
-  cameraPowerPin.writeSync(0);
-  console.log(`camera power off`);
+  // 히스토그램은 크기가 커서 기록용 결과에서는 제외
+  let stats = null;
+  if (image.stats) {
+    const { histogram, ...summary } = image.stats;
+    stats = summary;
+  }
+
+  return { epoch, readable, jpg: `${epoch}.jpg`, fits: `${epoch}.fits`, stats, thumbnails, sky, transients, composites };
+}
+
+/**
+ * 여러 장을 촬영해 스택 (누적은 워커 스레드에서 다음 노출과 겹쳐 진행) 후 JPG/FITS로 저장
+ * FITS는 float(BITPIX=-32), JPG는 한 장 단위로 반올림한 결과를 스트레칭
+ * @param {number} count 프레임 수
+ * @param {number} exposureTime 프레임당 노출 시간(초)
+ * @param {Object} options mode: 'mean' | 'sum' | 'sigma'(기본), kappa, exposureMode, region(captureSXFrame과 같음),
+ *                         onProgress(current, total): 프레임마다 호출
+ * @returns {Promise<Object>} { epoch, readable, jpg, fits, frames, totalExposure, rejected, rejectedFraction }
+ */
+export async function stackSXFrames(count, exposureTime, options = {}) {
+  const { mode = 'sigma', kappa, exposureMode = 'host', region = true, onProgress } = options;
+  const stacker = new FrameStacker({ mode, kappa });
+
+  const adds = [];
+  for (let i = 0; i < count; i++) {
+    const { image } = await captureSXFrame(exposureTime, { exposureMode, region });
+    const adding = stacker.add(image);
+    adding.catch(() => {}); // 촬영을 계속하는 동안의 unhandled rejection 방지 (아래 Promise.all에서 처리)
+    adds.push(adding);
+    onProgress?.(i + 1, count);
+  }
+  await Promise.all(adds);
 
-  return { epoch, readable, jpg: `${epoch}.jpg`, fits: `${epoch}.fits` };
+  const epoch = getEpochTimestamp();
+  const readable = getReadableTimestamp();
+  const imagesDir = 'images';
+  const dataDir = 'data';
+  await mkdir(imagesDir, { recursive: true });
+  await mkdir(dataDir, { recursive: true });
 
+  const saver = camera || new SXCamera();
+  const stack = await stacker.getResult();
+  const fitsName = `${epoch}_stack.fits`;
+  await saver.saveAsFits(stack, join(dataDir, fitsName));
+  const jpgName = `${epoch}_stack.jpg`;
+  await saver.saveAsJPG(await stacker.getResult({ uint16: true }), join(imagesDir, jpgName), { quality: 90, stretch: true });
 
-} catch (error) {
-  console.error('이미지 캡처 실패:', error);
+  console.log(`스택 완료: ${stack.frames}장 (${stack.stackMode}), 총 ${stack.totalExposure.toFixed(1)}초, ` +
+              `제외 ${(stack.rejectedFraction * 100).toFixed(2)}%`);
+  return {
+    epoch, readable, jpg: jpgName, fits: fitsName, frames: stack.frames, mode: stack.stackMode,
+    totalExposure: stack.totalExposure, rejected: stack.rejected, rejectedFraction: stack.rejectedFraction
+  };
+}
+
+/**
+ * 노출 방식별 타이밍 통계 (카메라 객체가 없으면 null)
+ */
+export function getExposureStats() {
+  return camera ? camera.getExposureStats() : null;
+}
+
+/**
+ * 카메라 전송/다운로드 계측 (카메라 객체가 없으면 null)
+ */
+export function getCameraMetrics() {
+  return camera ? camera.getMetrics() : null;
 }
-    
-    
-  }  finally {
-    if (camera.isConnected()) camera.disconnect();
-    console.log('카메라 연결 해제...');
 
-    cameraPowerPin.writeSync(0);
+/**
+ * Starlight Xpress 카메라 촬영 및 저장 함수
+ * @param {number} exposureTime 노출 시간(초)
+ * @param {Object} options keepOpen: 촬영 후 세션을 유지할지 여부 (연속 촬영 시 true, 끝나면 closeSXCamera 호출)
+ *                         exposureMode: 'host' 또는 'camera'
+ *                         timings: 주어지면 단계별 소요 시간(ms) 기록
+ */
+export async function saveSXCamera(exposureTime, options = {}) {
+  const { keepOpen = false } = options;
+
+  try {
+    const frame = await captureSXFrame(exposureTime, options);
+    return await saveSXFrame(frame, options);
+  } catch (error) {
+    console.error('이미지 캡처 실패:', error);
+  } finally {
+    if (!keepOpen) closeSXCamera();
   }
 }
 
@@ -0,0 +1,90 @@
+// bench/fits-compress.js
+// RICE_1 타일 압축 FITS 벤치마크: 압축률과 처리 속도(MB/s)를 타일 모양/스레드 수별로 측정
+//
+// 사용법: node bench/fits-compress.js [파일.fits ...]
+// 인자가 없으면 data/ 의 비압축 FITS(촬영 원본)를 최대 10개 사용
+import { readdir, unlink, stat } from 'fs/promises';
+import { join } from 'path';
+import { tmpdir, cpus } from 'os';
+import { native } from '../lib/native-loader.js';
+import { readFitsImage } from './fits-read.js';
+
+const MAX_FRAMES = 10;
+
+// 비교할 타일 설정 (0 = 기본값: 한 행씩)
+const TILINGS = [
+  { name: 'row', tileWidth: 0, tileHeight: 0 },
+  { name: '64x64', tileWidth: 64, tileHeight: 64 },
+  { name: '128x128', tileWidth: 128, tileHeight: 128 },
+  { name: 'row x16', tileWidth: 0, tileHeight: 16 },
+];
+
+async function findFrames(args) {
+  if (args.length > 0) return args;
+  const dir = 'data';
+  const names = (await readdir(dir)).filter(n => n.endsWith('.fits')).sort().reverse();
+  return names.map(n => join(dir, n));
+}
+
+async function main() {
+  const paths = await findFrames(process.argv.slice(2));
+  const frames = [];
+  for (const path of paths) {
+    if (frames.length >= MAX_FRAMES) break;
+    const image = await readFitsImage(path).catch(() => null);
+    if (image) frames.push({ path, image });
+  }
+  if (frames.length === 0) {
+    console.error('벤치마크할 비압축 FITS 파일이 없습니다. (data/*.fits 또는 인자로 지정)');
+    process.exit(1);
+  }
+
+  const { width, height } = frames[0].image;
+  console.log(`프레임 ${frames.length}개 (${width}x${height} 등), CPU ${cpus().length}개`);
+
+  const out = join(tmpdir(), `sx-bench-${process.pid}.fits`);
+  const rawMB = frames.reduce((s, f) => s + f.image.data.length * 2, 0) / (1024 * 1024);
+
+  // 기준: 비압축 BITPIX=16 쓰기
+  const start = process.hrtime.bigint();
+  let plainBytes = 0;
+  for (const { image } of frames) {
+    await native.writeFits(image, out, []);
+    plainBytes += (await stat(out)).size;
+  }
+  const ms = Number(process.hrtime.bigint() - start) / 1e6;
+  console.log(`\n비압축 BITPIX=16: ${(rawMB / (ms / 1000)).toFixed(1)} MB/s, 파일 ${(plainBytes / frames.length / 1024).toFixed(0)} KB/프레임`);
+
+  console.log('\n타일        스레드  압축률   압축 MB/s  쓰기 포함 MB/s  파일 KB/프레임');
+  for (const tiling of TILINGS) {
+    for (const threads of [1, 0]) {
+      let compressMs = 0;
+      let totalMs = 0;
+      let raw = 0;
+      let compressed = 0;
+      let fileBytes = 0;
+      let usedThreads = 0;
+      for (const { image } of frames) {
+        const r = await native.writeFitsCompressed(image, out, [], { ...tiling, threads });
+        compressMs += r.compressMs;
+        totalMs += r.totalMs;
+        raw += r.rawBytes;
+        compressed += r.compressedBytes;
+        fileBytes += r.fileBytes;
+        usedThreads = r.threads;
+      }
+      const mb = raw / (1024 * 1024);
+      console.log(
+        `${tiling.name.padEnd(10)}  ${String(usedThreads).padStart(5)}  ${(raw / compressed).toFixed(3).padStart(6)}  ` +
+        `${(mb / (compressMs / 1000)).toFixed(1).padStart(10)}  ${(mb / (totalMs / 1000)).toFixed(1).padStart(14)}  ` +
+        `${(fileBytes / frames.length / 1024).toFixed(0).padStart(14)}`);
+    }
+  }
+
+  await unlink(out).catch(() => {});
+}
+
+main().catch((error) => {
+  console.error('벤치마크 실패:', error);
+  process.exit(1);
+});
@@ -0,0 +1,36 @@
+// bench/fits-read.js
+// 벤치마크용 최소 FITS 리더 (비압축 primary 이미지만)
+import { readFile } from 'fs/promises';
+
+/**
+ * 비압축 FITS(BITPIX 16 또는 -32) primary 이미지를 Uint16Array로 읽기
+ * 압축 FITS 등 읽을 수 없는 파일이면 null
+ */
+export async function readFitsImage(path) {
+  const buf = await readFile(path);
+  const cards = {};
+  let offset = 0;
+  for (; offset + 80 <= buf.length; offset += 80) {
+    const card = buf.toString('ascii', offset, offset + 80);
+    const key = card.slice(0, 8).trim();
+    if (key === 'END') break;
+    if (card[8] === '=') cards[key] = card.slice(10).split('/')[0].trim().replace(/^'|'$/g, '').trim();
+  }
+  const dataStart = Math.ceil((offset + 80) / 2880) * 2880;
+
+  const bitpix = parseInt(cards.BITPIX);
+  const width = parseInt(cards.NAXIS1);
+  const height = parseInt(cards.NAXIS2);
+  if (parseInt(cards.NAXIS) !== 2 || !(width > 0) || !(height > 0)) return null;
+
+  const bzero = parseFloat(cards.BZERO || '0');
+  const data = new Uint16Array(width * height);
+  for (let i = 0; i < data.length; i++) {
+    let v;
+    if (bitpix === 16) v = buf.readInt16BE(dataStart + i * 2) + bzero;
+    else if (bitpix === -32) v = buf.readFloatBE(dataStart + i * 4) + bzero;
+    else return null;
+    data[i] = Math.max(0, Math.min(65535, Math.round(v)));
+  }
+  return { data, width, height };
+}
@@ -0,0 +1,181 @@
+// bench/pipeline.js
+// 촬영 파이프라인 벤치마크: saveSXCamera 흐름(전원/열기/노출/다운로드/변환/JPG/FITS/DB 기록)을 N번 실행하고
+// 단계별 지연 백분위, 처리량, 최대 RSS를 출력 (--out 으로 JSON 저장)
+//
+// 사용법: node bench/pipeline.js [--frames 20] [--warmup 1] [--exposure 0.1] [--mode host|camera]
+//                                [--backend sim|usb] [--keep-open] [--sim '{"throughputMBps":20}'] [--out 결과.json]
+// 기본은 시뮬레이터(하드웨어 불필요). 실제 카메라는 --backend usb (Pi에서 전원 GPIO 포함)
+import { mkdtemp, rm, writeFile } from 'fs/promises';
+import { join, resolve } from 'path';
+import { tmpdir, cpus } from 'os';
+
+// 표에 출력할 단계 순서
+const STAGES = [
+  'powerUp', 'open', 'exposure', 'readout', 'convert', 'capture',
+  'stretch', 'jpegEncode', 'thumbnails', 'starDetect', 'transientDetect', 'nightComposite', 'fitsCompress', 'fitsWrite', 'dbInsert', 'total'
+];
+
+function parseArgs(argv) {
+  const args = {
+    frames: 20,
+    warmup: 1,
+    exposure: 0.1,
+    mode: 'host',
+    backend: process.env.SX_CAMERA_BACKEND || 'sim',
+    keepOpen: false,
+    sim: process.env.SX_SIM_OPTIONS || null,
+    out: null
+  };
+  for (let i = 0; i < argv.length; i++) {
+    const arg = argv[i];
+    const next = () => argv[++i];
+    if (arg === '--frames') args.frames = parseInt(next());
+    else if (arg === '--warmup') args.warmup = parseInt(next());
+    else if (arg === '--exposure') args.exposure = parseFloat(next());
+    else if (arg === '--mode') args.mode = next();
+    else if (arg === '--backend') args.backend = next();
+    else if (arg === '--keep-open') args.keepOpen = true;
+    else if (arg === '--sim') args.sim = next();
+    else if (arg === '--out') args.out = resolve(next());
+    else throw new Error(`알 수 없는 인자: ${arg}`);
+  }
+  return args;
+}
+
+// 정렬된 배열의 nearest-rank 백분위
+function percentile(sorted, p) {
+  if (sorted.length === 0) return null;
+  const rank = Math.ceil((p / 100) * sorted.length);
+  return sorted[Math.min(sorted.length - 1, Math.max(0, rank - 1))];
+}
+
+function summarize(values) {
+  const sorted = [...values].sort((a, b) => a - b);
+  const sum = sorted.reduce((s, v) => s + v, 0);
+  return {
+    count: sorted.length,
+    mean: sorted.length ? sum / sorted.length : null,
+    min: sorted.length ? sorted[0] : null,
+    p50: percentile(sorted, 50),
+    p90: percentile(sorted, 90),
+    p99: percentile(sorted, 99),
+    max: sorted.length ? sorted[sorted.length - 1] : null
+  };
+}
+
+const fmt = (v) => (v === null ? '-' : v.toFixed(2));
+
+async function main() {
+  const args = parseArgs(process.argv.slice(2));
+
+  // app.js가 모듈 로드 시 백엔드/전원 GPIO를 결정하므로 import 전에 환경 변수 설정
+  process.env.SX_CAMERA_BACKEND = args.backend;
+  if (args.sim) process.env.SX_SIM_OPTIONS = args.sim;
+
+  // images/ data/ 는 임시 작업 디렉토리에 생성
+  const workDir = await mkdtemp(join(tmpdir(), 'sx-pipeline-'));
+  process.chdir(workDir);
+
+  const { saveSXCamera, closeSXCamera, getCameraMetrics } = await import('../app.js');
+  const { openCaptureDb, insertCapture } = await import('../lib/capture-db.js');
+  const db = openCaptureDb(join(workDir, 'captures.db'));
+
+  const samples = Object.fromEntries(STAGES.map(s => [s, []]));
+  const downloadMBps = [];
+  let failures = 0;
+  let peakRss = process.memoryUsage().rss;
+  let epoch = Math.floor(Date.now() / 1000);
+
+  const runStart = performance.now();
+  let measuredStart = runStart;
+  for (let i = 0; i < args.warmup + args.frames; i++) {
+    if (i === args.warmup) measuredStart = performance.now();
+    const timings = {};
+    const frameStart = performance.now();
+    const result = await saveSXCamera(args.exposure, { keepOpen: args.keepOpen, exposureMode: args.mode, timings });
+    if (!result) {
+      failures++;
+      continue;
+    }
+
+    // 같은 초에 여러 프레임이 끝나므로 기본키 충돌을 피해 epoch를 증가시켜 기록
+    result.epoch = Math.max(result.epoch, ++epoch);
+    const insertStart = performance.now();
+    insertCapture(db, result);
+    timings.dbInsert = performance.now() - insertStart;
+    timings.total = performance.now() - frameStart;
+
+    peakRss = Math.max(peakRss, process.memoryUsage().rss);
+    if (i < args.warmup) continue;
+
+    for (const stage of STAGES) {
+      if (typeof timings[stage] === 'number') samples[stage].push(timings[stage]);
+    }
+    if (timings.readoutMBps > 0) downloadMBps.push(timings.readoutMBps);
+  }
+  const measuredMs = performance.now() - measuredStart;
+  if (args.keepOpen) closeSXCamera();
+  db.close();
+
+  const frames = samples.total.length;
+  const stages = {};
+  for (const stage of STAGES) {
+    if (samples[stage].length > 0) stages[stage] = summarize(samples[stage]);
+  }
+
+  const report = {
+    benchmark: 'pipeline',
+    date: new Date().toISOString(),
+    node: process.version,
+    platform: `${process.platform}-${process.arch}`,
+    cpus: cpus().length,
+    backend: args.backend,
+    sim: args.sim ? JSON.parse(args.sim) : null,
+    exposure: args.exposure,
+    exposureMode: args.mode,
+    keepOpen: args.keepOpen,
+    frames,
+    failures,
+    // 단계별 지연 (ms)
+    stages,
+    throughput: {
+      framesPerSec: frames > 0 ? frames / (measuredMs / 1000) : 0,
+      readoutMBps: summarize(downloadMBps),
+      // 노출을 제외한 프레임당 처리 시간 기준
+      overheadMsPerFrame: stages.total && stages.exposure ? stages.total.mean - stages.exposure.mean : null
+    },
+    // 최대 RSS (MB): 프레임 사이 샘플과 프로세스 전체 최대값
+    memory: {
+      peakRssMB: peakRss / (1024 * 1024),
+      maxRssMB: process.resourceUsage().maxRSS / 1024
+    },
+    // 네이티브 전송 계측 (워밍업 포함 누적: 타임아웃/재시도/부분 프레임 등)
+    cameraMetrics: getCameraMetrics()
+  };
+
+  console.log(`\n파이프라인 벤치마크: ${args.backend}, 노출 ${args.exposure}초 (${args.mode}), ` +
+              `${frames}프레임 (실패 ${failures}), ${args.keepOpen ? '세션 유지' : '프레임마다 전원/열기'}`);
+  console.log('단계            평균 ms     p50     p90     p99     최대');
+  for (const [stage, s] of Object.entries(stages)) {
+    console.log(`${stage.padEnd(12)} ${fmt(s.mean).padStart(9)} ${fmt(s.p50).padStart(7)} ${fmt(s.p90).padStart(7)} ` +
+                `${fmt(s.p99).padStart(7)} ${fmt(s.max).padStart(8)}`);
+  }
+  console.log(`\n처리량: ${report.throughput.framesPerSec.toFixed(2)} 프레임/초, ` +
+              `노출 제외 오버헤드 ${fmt(report.throughput.overheadMsPerFrame)} ms/프레임`);
+  console.log(`USB 다운로드: p50 ${fmt(report.throughput.readoutMBps.p50)} MB/s, ` +
+              `최소 ${fmt(report.throughput.readoutMBps.min)} MB/s`);
+  console.log(`최대 RSS: ${report.memory.maxRssMB.toFixed(1)} MB`);
+
+  if (args.out) {
+    await writeFile(args.out, JSON.stringify(report, null, 2));
+    console.log(`결과 저장: ${args.out}`);
+  }
+
+  await rm(workDir, { recursive: true, force: true });
+  process.exit(failures > 0 && frames === 0 ? 1 : 0);
+}
+
+main().catch((error) => {
+  console.error('벤치마크 실패:', error);
+  process.exit(1);
+});
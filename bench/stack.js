@@ -0,0 +1,81 @@
+// bench/stack.js
+// 네이티브 스태커 누적 속도: 모드(mean/sum/sigma)와 스레드 수별 프레임당 누적 시간 (1392x1040 기준)
+//
+// 사용법: node bench/stack.js [--frames 30] [--threads 1,2,4]
+// 배경 + 잡음 합성 프레임에 위성 궤적 한 줄을 넣어 시그마 클리핑이 궤적을 지우는지도 확인
+import { cpus } from 'os';
+import { native } from '../lib/native-loader.js';
+
+const WIDTH = 1392;
+const HEIGHT = 1040;
+const STREAK_ROW = 500;
+
+function parseArgs(argv) {
+  const args = { frames: 30, threads: [1, 2, 4, cpus().length] };
+  for (let i = 0; i < argv.length; i++) {
+    const arg = argv[i];
+    if (arg === '--frames') args.frames = parseInt(argv[++i]);
+    else if (arg === '--threads') args.threads = argv[++i].split(',').map(Number);
+    else throw new Error(`알 수 없는 인자: ${arg}`);
+  }
+  args.threads = [...new Set(args.threads)].sort((a, b) => a - b);
+  return args;
+}
+
+function syntheticFrames(count) {
+  // 프레임마다 새로 만들면 생성 시간이 측정을 덮으므로 몇 장을 돌려 씀
+  const frames = [];
+  for (let f = 0; f < 4; f++) {
+    const data = new Uint16Array(WIDTH * HEIGHT);
+    for (let i = 0; i < data.length; i++) {
+      data[i] = 1000 + Math.round((Math.random() + Math.random() + Math.random() - 1.5) * 16);
+    }
+    frames.push({ data, width: WIDTH, height: HEIGHT, exposureTime: 1.0 });
+  }
+  const streak = { ...frames[0], data: frames[0].data.slice() };
+  streak.data.fill(30000, STREAK_ROW * WIDTH, (STREAK_ROW + 1) * WIDTH);
+  return Array.from({ length: count }, (_, i) => (i === Math.floor(count / 2) ? streak : frames[i % frames.length]));
+}
+
+async function run(frames, mode, threads) {
+  const stacker = new native.FrameStacker({ mode, threads });
+  const addMs = [];
+  const start = performance.now();
+  for (const frame of frames) {
+    const { addMs: ms } = await stacker.add(frame);
+    addMs.push(ms);
+  }
+  const totalMs = performance.now() - start;
+  const result = stacker.getResult();
+  let streakMean = 0;
+  for (let x = 0; x < WIDTH; x++) streakMean += result.data[STREAK_ROW * WIDTH + x];
+  addMs.sort((a, b) => a - b);
+  return {
+    median: addMs[Math.floor(addMs.length / 2)],
+    totalMs,
+    streakMean: streakMean / WIDTH / (mode === 'sum' ? result.frames : 1),
+    rejectedPct: result.rejectedFraction * 100
+  };
+}
+
+async function main() {
+  const args = parseArgs(process.argv.slice(2));
+  const frames = syntheticFrames(args.frames);
+  const mpix = WIDTH * HEIGHT / 1e6;
+  console.log(`합성 프레임 ${WIDTH}x${HEIGHT} x ${args.frames}장 (배경 1000 ADU, 궤적 행 ${STREAK_ROW})\n`);
+
+  console.log('모드    스레드   누적 ms/장   Mpix/s   전체 ms   궤적 행 평균   제외 %');
+  for (const mode of ['mean', 'sum', 'sigma']) {
+    for (const threads of args.threads) {
+      const r = await run(frames, mode, threads);
+      console.log(`${mode.padEnd(7)} ${String(threads).padStart(6)} ${r.median.toFixed(2).padStart(12)} ` +
+                  `${(mpix / (r.median / 1000)).toFixed(0).padStart(8)} ${r.totalMs.toFixed(0).padStart(9)} ` +
+                  `${r.streakMean.toFixed(1).padStart(14)} ${r.rejectedPct.toFixed(3).padStart(8)}`);
+    }
+  }
+}
+
+main().catch((error) => {
+  console.error('벤치마크 실패:', error);
+  process.exit(1);
+});
@@ -0,0 +1,102 @@
+// bench/stretch.js
+// JPG 미리보기용 8비트 스트레칭: 기존 JS 루프 vs 네이티브 커널 (1392x1040 기준)
+//
+// 사용법: node bench/stretch.js [파일.fits]
+// 파일이 없으면 별/핫 픽셀이 있는 1392x1040 합성 하늘 프레임 사용
+import { native } from '../lib/native-loader.js';
+import { readFitsImage } from './fits-read.js';
+
+const WIDTH = 1392;
+const HEIGHT = 1040;
+const WARMUP = 3;
+const ITERATIONS = 20;
+
+function syntheticFrame() {
+  const data = new Uint16Array(WIDTH * HEIGHT);
+  for (let i = 0; i < data.length; i++) {
+    // 배경 + 잡음
+    data[i] = 1200 + Math.round((Math.random() + Math.random() + Math.random() - 1.5) * 40);
+  }
+  // 별
+  for (let s = 0; s < 400; s++) {
+    const cx = Math.floor(Math.random() * WIDTH);
+    const cy = Math.floor(Math.random() * HEIGHT);
+    const peak = 2000 + Math.random() * 40000;
+    for (let y = Math.max(0, cy - 3); y < Math.min(HEIGHT, cy + 4); y++) {
+      for (let x = Math.max(0, cx - 3); x < Math.min(WIDTH, cx + 4); x++) {
+        const r2 = (x - cx) ** 2 + (y - cy) ** 2;
+        data[y * WIDTH + x] = Math.min(65535, data[y * WIDTH + x] + Math.round(peak * Math.exp(-r2 / 2)));
+      }
+    }
+  }
+  // 핫 픽셀
+  for (let h = 0; h < 50; h++) {
+    data[Math.floor(Math.random() * data.length)] = 65535;
+  }
+  return { data, width: WIDTH, height: HEIGHT, bitsPerPixel: 16 };
+}
+
+// 기존 saveAsJPG의 min/max + 선형 스트레칭 루프
+function jsStretch(image) {
+  const { data, width, height } = image;
+  const buffer = Buffer.alloc(width * height);
+  let min = 65535;
+  let max = 0;
+  for (let i = 0; i < data.length; i++) {
+    if (data[i] < min) min = data[i];
+    if (data[i] > max) max = data[i];
+  }
+  const range = max - min;
+  for (let i = 0; i < width * height; i++) {
+    buffer[i] = Math.min(255, Math.max(0, Math.round(((data[i] - min) / range) * 255)));
+  }
+  return buffer;
+}
+
+function measure(fn) {
+  for (let i = 0; i < WARMUP; i++) fn();
+  const times = [];
+  for (let i = 0; i < ITERATIONS; i++) {
+    const start = process.hrtime.bigint();
+    fn();
+    times.push(Number(process.hrtime.bigint() - start) / 1e6);
+  }
+  times.sort((a, b) => a - b);
+  return { median: times[Math.floor(times.length / 2)], min: times[0] };
+}
+
+async function main() {
+  const path = process.argv[2];
+  const image = path ? await readFitsImage(path) : syntheticFrame();
+  if (!image) {
+    console.error(`FITS 파일을 읽을 수 없습니다: ${path}`);
+    process.exit(1);
+  }
+  image.bitsPerPixel = 16;
+  const mpix = image.width * image.height / 1e6;
+  console.log(`${path || '합성 프레임'}: ${image.width}x${image.height}, 반복 ${ITERATIONS}회\n`);
+
+  const cases = [
+    ['JS min/max linear', () => jsStretch(image)],
+    ['native linear', () => native.stretchImage(image, { mode: 'linear' })],
+    ['native asinh', () => native.stretchImage(image, { mode: 'asinh' })],
+    ['native gamma', () => native.stretchImage(image, { mode: 'gamma' })],
+  ];
+
+  let baseline = 0;
+  console.log('방식                 중앙값 ms   최소 ms   Mpix/s   배속');
+  for (const [name, fn] of cases) {
+    const { median, min } = measure(fn);
+    if (!baseline) baseline = median;
+    console.log(`${name.padEnd(20)} ${median.toFixed(2).padStart(9)} ${min.toFixed(2).padStart(9)} ` +
+                `${(mpix / (median / 1000)).toFixed(1).padStart(8)} ${(baseline / median).toFixed(1).padStart(6)}x`);
+  }
+
+  const levels = native.stretchImage(image, { mode: 'linear' });
+  console.log(`\n범위 ${levels.min} ~ ${levels.max}, 백분위 구간 ${levels.black} ~ ${levels.white}`);
+}
+
+main().catch((error) => {
+  console.error('벤치마크 실패:', error);
+  process.exit(1);
+});
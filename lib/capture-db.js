@@ -0,0 +1,89 @@
+// lib/capture-db.js
+// 촬영 기록 SQLite DB (server.js와 벤치마크가 같은 스키마/INSERT를 사용)
+import Database from 'better-sqlite3';
+
+// 프레임 통계 컬럼 (기존 DB에는 없으므로 필요한 것만 추가)
+export const STATS_COLUMNS = {
+  stat_min: 'INTEGER',
+  stat_max: 'INTEGER',
+  stat_mean: 'REAL',
+  stat_stddev: 'REAL',
+  stat_median: 'INTEGER',
+  stat_noise: 'REAL',
+  stat_saturated: 'INTEGER'
+};
+
+// 별 검출 하늘 상태 컬럼 (FWHM/HFR은 픽셀 단위)
+export const SKY_COLUMNS = {
+  sky_stars: 'INTEGER',
+  sky_fwhm: 'REAL',
+  sky_hfr: 'REAL',
+  sky_background: 'REAL',
+  sky_rms: 'REAL'
+};
+
+// 구름 지도 컬럼 (cloud_grid는 { columns, rows, grid, stars } JSON, grid는 0 맑음/1 흐림/255 모름)
+export const CLOUD_COLUMNS = {
+  cloud_cover: 'REAL',
+  cloud_method: 'TEXT',
+  cloud_grid: 'TEXT'
+};
+
+// 궤적 검출 컬럼 (transients는 [{ x1, y1, x2, y2, length, angle, points, flux, box, jpg }] JSON, 검출 전이면 NULL)
+export const TRANSIENT_COLUMNS = {
+  transient_count: 'INTEGER',
+  transients: 'TEXT'
+};
+
+// 썸네일 컬럼 (thumbnails는 [{ scale, width, height, jpg }] JSON, jpg는 images/ 기준 경로, 만들지 않았으면 NULL)
+export const THUMBNAIL_COLUMNS = {
+  thumbnails: 'TEXT'
+};
+
+/**
+ * DB 열기 (테이블 생성 및 컬럼 마이그레이션)
+ * @param {string} filename DB 파일 경로
+ * @returns {Database} better-sqlite3 DB 객체
+ */
+export function openCaptureDb(filename = 'captures.db') {
+  const db = new Database(filename);
+
+  db.exec(`
+    CREATE TABLE IF NOT EXISTS captures (
+      epoch INTEGER PRIMARY KEY,
+      readable TEXT NOT NULL,
+      created_at DATETIME DEFAULT CURRENT_TIMESTAMP
+    )
+  `);
+
+  const existingColumns = db.prepare('PRAGMA table_info(captures)').all().map(c => c.name);
+  for (const [name, type] of Object.entries({ ...STATS_COLUMNS, ...SKY_COLUMNS, ...CLOUD_COLUMNS, ...TRANSIENT_COLUMNS, ...THUMBNAIL_COLUMNS })) {
+    if (!existingColumns.includes(name)) {
+      db.exec(`ALTER TABLE captures ADD COLUMN ${name} ${type}`);
+    }
+  }
+
+  return db;
+}
+
+/**
+ * saveSXFrame 결과 한 건 기록
+ * @param {Database} db openCaptureDb 결과
+ * @param {Object} result { epoch, readable, stats, sky: { ..., cloud }, transients, thumbnails }
+ */
+export function insertCapture(db, result) {
+  const s = result.stats || {};
+  const k = result.sky || {};
+  const c = k.cloud;
+  db.prepare(`INSERT INTO captures (epoch, readable, stat_min, stat_max, stat_mean, stat_stddev,
+              stat_median, stat_noise, stat_saturated, sky_stars, sky_fwhm, sky_hfr, sky_background, sky_rms,
+              cloud_cover, cloud_method, cloud_grid, transient_count, transients, thumbnails)
+              VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)`)
+    .run(result.epoch, result.readable, s.min ?? null, s.max ?? null, s.mean ?? null, s.stddev ?? null,
+         s.median ?? null, s.noise ?? null, s.saturated ?? null,
+         k.stars ?? null, k.fwhm ?? null, k.hfr ?? null, k.background ?? null, k.backgroundRms ?? null,
+         c?.cover ?? null, c?.method ?? null,
+         c ? JSON.stringify({ columns: c.columns, rows: c.rows, grid: c.grid, stars: c.stars }) : null,
+         result.transients ? result.transients.length : null, result.transients ? JSON.stringify(result.transients) : null,
+         result.thumbnails ? JSON.stringify(result.thumbnails) : null);
+}
@@ -0,0 +1,77 @@
+// lib/prometheus.js
+// 카메라 계측(getMetrics)을 Prometheus 텍스트 형식(0.0.4)으로 변환 (server.js의 /metrics)
+
+// getMetrics() 키 → 메트릭 이름, 도움말
+const COUNTERS = [
+  ['frames', 'sx_camera_frames_total', '다운로드에 성공한 프레임 수 (부분 프레임 포함)'],
+  ['readoutFailures', 'sx_camera_readout_failures_total', '데이터를 받지 못하고 실패한 다운로드 수'],
+  ['bytes', 'sx_camera_readout_bytes_total', '수신한 이미지 데이터 바이트'],
+  ['transfers', 'sx_camera_usb_transfers_total', '완료된 USB 벌크 전송 수'],
+  ['timeouts', 'sx_camera_usb_timeouts_total', 'USB 전송 타임아웃 횟수'],
+  ['retries', 'sx_camera_readout_retries_total', '첫 데이터 전 타임아웃으로 다시 시도한 횟수'],
+  ['shortReads', 'sx_camera_short_reads_total', '예상 크기 전에 짧은 패킷으로 끝난 다운로드 수'],
+  ['partialFrames', 'sx_camera_partial_frames_total', '예상보다 적게 받고 받아들인 프레임 수'],
+  ['sessionReopens', 'sx_camera_session_reopens_total', '세션 모드에서 장치를 다시 연 횟수']
+];
+
+const GAUGES = [
+  ['lastDownloadMBps', 'sx_camera_last_download_mbps', '마지막 다운로드 속도 (MB/s)'],
+  ['lastExposureOvershootMs', 'sx_camera_last_exposure_overshoot_ms', '마지막 노출 초과 (측정 - 요청, ms)']
+];
+
+const HISTOGRAMS = [
+  ['downloadMBps', 'sx_camera_download_mbps', '다운로드 속도 (MB/s)'],
+  ['exposureOvershootMs', 'sx_camera_exposure_overshoot_ms', '노출 초과 (측정 - 요청, ms)']
+];
+
+function escapeLabel(value) {
+  return String(value).replace(/\\/g, '\\\\').replace(/"/g, '\\"').replace(/\n/g, '\\n');
+}
+
+function formatLabels(labels) {
+  const entries = Object.entries(labels);
+  if (entries.length === 0) return '';
+  return `{${entries.map(([k, v]) => `${k}="${escapeLabel(v)}"`).join(',')}}`;
+}
+
+/**
+ * @param {Object|null} metrics SXCamera.getMetrics() 결과 (null이면 카메라 없음: up 0만 출력)
+ * @param {Object} labels 모든 시계열에 붙일 레이블 (예: { site: 'obs1' })
+ * @returns {string} text/plain; version=0.0.4 본문
+ */
+export function formatPrometheus(metrics, labels = {}) {
+  const lines = [];
+  const base = metrics ? { ...labels, backend: metrics.backend } : labels;
+  const l = formatLabels(base);
+
+  lines.push('# HELP sx_camera_up 카메라 객체 존재 여부');
+  lines.push('# TYPE sx_camera_up gauge');
+  lines.push(`sx_camera_up${formatLabels(labels)} ${metrics ? 1 : 0}`);
+  if (!metrics) return lines.join('\n') + '\n';
+
+  lines.push('# HELP sx_camera_connected USB 연결 여부');
+  lines.push('# TYPE sx_camera_connected gauge');
+  lines.push(`sx_camera_connected${l} ${metrics.connected ? 1 : 0}`);
+
+  for (const [key, name, help] of COUNTERS) {
+    lines.push(`# HELP ${name} ${help}`, `# TYPE ${name} counter`, `${name}${l} ${metrics[key]}`);
+  }
+  for (const [key, name, help] of GAUGES) {
+    lines.push(`# HELP ${name} ${help}`, `# TYPE ${name} gauge`, `${name}${l} ${metrics[key]}`);
+  }
+
+  // 네이티브 히스토그램은 구간별 개수이므로 le 누적값으로 변환
+  for (const [key, name, help] of HISTOGRAMS) {
+    const h = metrics[key];
+    lines.push(`# HELP ${name} ${help}`, `# TYPE ${name} histogram`);
+    let cumulative = 0;
+    h.counts.forEach((count, i) => {
+      cumulative += count;
+      const le = i < h.bounds.length ? String(h.bounds[i]) : '+Inf';
+      lines.push(`${name}_bucket${formatLabels({ ...base, le })} ${cumulative}`);
+    });
+    lines.push(`${name}_sum${l} ${h.sum}`, `${name}_count${l} ${h.count}`);
+  }
+
+  return lines.join('\n') + '\n';
+}
@@ -7,15 +7,198 @@ import { writeFile } from 'fs/promises';
 import { native } from './native-loader.js';
 const nativeModule = native;
 
+/**
+ * 단계별 소요 시간(ms) 누적 - options.timings 객체가 주어졌을 때만 (파이프라인 벤치마크용)
+ * @param {Object} timings 단계 이름 → ms
+ * @param {string} stage 단계 이름
+ * @param {number} start performance.now() 시작 시각
+ */
+export function recordStage(timings, stage, start) {
+  if (timings) timings[stage] = (timings[stage] || 0) + (performance.now() - start);
+}
+
+/**
+ * 이미지의 비닝 (xBinning/yBinning이 없는 이전 형식은 binning 문자열 "2x2"로 판단)
+ * @param {Object} image 이미지 데이터 객체
+ * @returns {{xBin: number, yBin: number}}
+ */
+function imageBinning(image) {
+  if (image.xBinning && image.yBinning) return { xBin: image.xBinning, yBin: image.yBinning };
+  const bin = image.binning === '2x2' ? 2 : 1;
+  return { xBin: bin, yBin: bin };
+}
+
+// 바이어스/마스터 보정 정보 (MaxIm DL 규약: PEDESTAL은 0 기준 ADU로 되돌리려면 더할 값, CALSTAT은 적용한 마스터)
+// 마스터 보정을 했으면 최종 페디스털은 보정 패스에서 더한 값
+function calibrationHeaders(image) {
+  const headers = [];
+  const cal = image.calibration;
+  const pedestal = cal ? cal.pedestal : image.biasMode ? image.biasPedestal : undefined;
+  if (pedestal !== undefined) {
+    headers.push({ key: 'PEDESTAL', value: -pedestal, comment: 'Add to get zero-based ADU' });
+  }
+  if (image.biasMode) {
+    headers.push({ key: 'BIASLVL', value: Number(image.biasLevel.toFixed(1)), comment: `Porch bias subtracted (ADU, ${image.biasMode})` });
+  }
+  if (cal) {
+    const calstat = (cal.bias ? 'B' : '') + (cal.dark ? 'D' : '') + (cal.flat ? 'F' : '');
+    headers.push({ key: 'CALSTAT', value: calstat, comment: 'Calibration applied (Bias/Dark/Flat)' });
+    if (cal.dark && cal.bias) {
+      headers.push({ key: 'DARKSCL', value: Number(cal.darkScale.toFixed(4)), comment: 'Dark scale (exposure / dark exposure)' });
+    }
+  }
+  if (image.defectsCorrected !== undefined) {
+    headers.push({ key: 'DEFECTS', value: image.defectsCorrected, comment: 'Hot/dead pixels replaced by neighbor median' });
+  }
+  return headers;
+}
+
+// 스택 결과 정보 (NCOMBINE은 IRAF 규약)
+function stackHeaders(image) {
+  if (!image.stackMode) return [];
+  return [
+    { key: 'NCOMBINE', value: image.frames, comment: 'Number of frames stacked' },
+    { key: 'STACKMOD', value: image.stackMode, comment: 'Stack combine (mean, sum, sigma)' },
+    { key: 'TOTALEXP', value: image.totalExposure, comment: 'Total integration time (s)' }
+  ];
+}
+
+// 별 검출로 잰 하늘 상태 (SKYBKG는 메시 배경 중앙값, FWHM/HFR은 측정한 별의 중앙값, 픽셀 단위)
+export function skyHeaders(sky) {
+  if (!sky) return [];
+  return [
+    { key: 'STARCNT', value: sky.stars, comment: 'Stars detected' },
+    { key: 'FWHM', value: Number(sky.fwhm.toFixed(2)), comment: 'Median star FWHM (pixels)' },
+    { key: 'HFR', value: Number(sky.hfr.toFixed(2)), comment: 'Median star half-flux radius (pixels)' },
+    { key: 'SKYBKG', value: Number(sky.background.toFixed(1)), comment: 'Median sky background (ADU)' },
+    { key: 'SKYRMS', value: Number(sky.backgroundRms.toFixed(2)), comment: 'Median sky noise (ADU)' },
+    ...(sky.cloud && sky.cloud.cover !== null
+      ? [{ key: 'CLOUDCVR', value: Number(sky.cloud.cover.toFixed(1)), comment: `Cloud cover % (${sky.cloud.method})` }]
+      : [])
+  ];
+}
+
+/**
+ * 네이티브 별 검출 (워커 스레드에서 배경 메시 -> 임계값 -> 연결 요소 -> 중심/FWHM/HFR)
+ * @param {Object} image 촬영 이미지 (Uint16Array data, width, height)
+ * @param {Object} options { sigma(기본 5), minArea(3), maxArea(400), meshSize(64), threads(기본 CPU 수), list(별 목록 포함),
+ *                           cloud: true | { columns(8), rows(6), reference(buildCloudReference 결과),
+ *                                           sky: 하늘 원 { x, y, radius } (이미지 픽셀, 생략하면 중앙 내접원) 또는 false(마스크 없음) } 구름 지도 }
+ * @returns {Promise<Object>} { stars, measured, saturated, large, background, backgroundRms, fwhm, hfr, detectMs,
+ *                              mesh: { columns, rows, size, background }, list?,
+ *                              cloud?: { method, columns, rows, cover(%, 모름 구역 제외), grid(0 맑음/1 흐림/255 모름), clarity, stars, texture,
+ *                                        sky(구역별 하늘 원 안 비율) } }
+ */
+export function detectStars(image, options = {}) {
+  return nativeModule.detectStars(image, options);
+}
+
+/**
+ * 썸네일용 다해상도 피라미드 (2x2 박스 평균, 1/2부터 단계마다 절반)
+ * 촬영 때 setPyramid로 만든 image.pyramid가 없는 이미지(스택 결과 등)에 사용
+ * @param {Object} image { data: Uint16Array, width, height }
+ * @param {Object} options levels(기본 3, 최대 6)
+ * @returns {Object[]} [{ scale, width, height, data: Uint16Array }] 큰 단계부터
+ */
+export function buildImagePyramid(image, options = {}) {
+  return nativeModule.buildImagePyramid(image, options);
+}
+
+/**
+ * 맑은 밤 프레임들의 구름 지도에서 구역별 기대 별 수 기준 만들기 (구역별 중앙값)
+ * 전천 카메라는 하늘이 돌면서 구역별 별 수가 바뀌므로 비슷한 시각의 프레임으로 만드는 것이 좋음
+ * @param {Object[]} clouds detectStars(..., { cloud }) 결과의 cloud (같은 columns/rows)
+ * @param {Object} frame { width, height } 기준 프레임 크기 (다른 크기의 이미지에는 기준을 쓰지 않음)
+ * @returns {Object} { columns, rows, width, height, expected } (detectStars의 cloud.reference로 사용, JSON 저장 가능)
+ */
+export function buildCloudReference(clouds, frame = {}) {
+  if (!clouds.length) throw new Error('구름 기준을 만들 프레임이 없습니다.');
+  const { columns, rows } = clouds[0];
+  if (clouds.some(c => c.columns !== columns || c.rows !== rows)) {
+    throw new Error('구름 지도 구역 수가 서로 다릅니다.');
+  }
+  const expected = Array.from({ length: columns * rows }, (_, i) => {
+    const counts = clouds.map(c => c.stars[i]).sort((a, b) => a - b);
+    return counts[Math.floor(counts.length / 2)];
+  });
+  return { columns, rows, width: frame.width, height: frame.height, expected };
+}
+
+/**
+ * 여러 프레임을 합쳐 보정 마스터 파일(.sxcal) 작성 (네이티브 워커 스레드에서 픽셀별 결합)
+ * @param {Object[]} images 같은 영역/비닝으로 촬영한 이미지 객체 (3장 이상)
+ * @param {string} path 저장할 파일 경로 (setCalibration 디렉터리에 두면 다음 연결부터 사용)
+ * @param {Object} options { type: 'bias' | 'dark' | 'flat', combine: 'median' | 'sigma', kappa, bias(플랫용 바이어스 마스터 경로), threads }
+ * @returns {Promise<Object>} 마스터 정보 { path, type, width, height, exposureTime, frames, ..., mean, rejected, buildMs }
+ */
+export function buildCalibrationMaster(images, path, options = {}) {
+  return nativeModule.buildCalibrationMaster(images, path, options);
+}
+
+/**
+ * 보정 마스터 파일 헤더 읽기
+ * @param {string} path .sxcal 파일 경로
+ * @returns {Object} { path, type, combine, width, height, x, y, xBin, yBin, exposureTime, frames, biasCorrected, createdAt }
+ */
+export function readCalibrationMaster(path) {
+  return nativeModule.readCalibrationMaster(path);
+}
+
+/**
+ * 네이티브 로그 레벨 (컴파일 시 제거된 레벨은 켜도 출력되지 않음)
+ * @param {string|number} level 'error' | 'warn' | 'info' | 'debug' | 'trace' 또는 0~4
+ * @returns {string} 설정된 레벨 이름
+ */
+export function setLogLevel(level) {
+  return nativeModule.setLogLevel(level);
+}
+
+/**
+ * 네이티브 로그의 stdout 출력 여부 (끄더라도 링 버퍼/핸들러에는 계속 기록)
+ * @param {boolean} enabled
+ */
+export function setLogConsole(enabled) {
+  return nativeModule.setLogConsole(enabled);
+}
+
+/**
+ * 네이티브 로그 핸들러 등록 (null이면 해제)
+ * @param {Function|null} handler ({ time, level, message }) => void
+ */
+export function setLogHandler(handler) {
+  return nativeModule.setLogHandler(handler);
+}
+
+/**
+ * 링 버퍼에서 아직 읽지 않은 로그 항목을 꺼냄
+ * @returns {Object} { entries: [{ time, level, message }], dropped }
+ */
+export function getLogs() {
+  return nativeModule.getLogs();
+}
+
+/**
+ * 현재 로그 설정
+ * @returns {Object} { level, compileLevel, console, handler, ringSize }
+ */
+export function getLogConfig() {
+  return nativeModule.getLogConfig();
+}
+
 /**
  * Starlight Xpress 카메라 클래스
  */
 export class SXCamera {
   /**
    * 생성자
+   * @param {Object} options backend: 'usb'(기본) 또는 'sim'(하드웨어 없는 시뮬레이터, 환경 변수 SX_CAMERA_BACKEND=sim 과 같음)
+   *                         sim: 시뮬레이터 설정 { seed, stars, biasAdu, biasDriftAdu, skyAduPerSec, starFlux, starSigma, readNoiseAdu,
+   *                              hotPixels, throughputMBps, timeoutRate, shortReadRate, faultStallMs,
+   *                              ccdWidth, ccdHeight, pixelSizeUm, hBackPorch (GET_CCD_PARAMS로 보고할 CCD, 기본 ECHO2) }
    */
-  constructor() {
-    this._camera = new nativeModule.SXCamera();
+  constructor(options = {}) {
+    this._camera = new nativeModule.SXCamera(options);
+    this._sessionMode = false;
   }
 
 
@@ -44,6 +227,14 @@ export class SXCamera {
     return this._camera.isConnected();
   }
 
+  /**
+   * 통신 계층 이름
+   * @returns {string} 'usb' 또는 'sim'
+   */
+  getBackend() {
+    return this._camera.getBackend();
+  }
+
   /**
    * 마지막 오류 메시지 가져오기
    * @returns {string} 오류 메시지
@@ -68,30 +259,229 @@ export class SXCamera {
       return {
         model: model.modelName,
         modelCode: model.modelCode,
-        firmwareVersion: firmwareVersion
+        firmwareVersion: firmwareVersion,
+        ccd: this._camera.getCcdParams()
       };
     } catch (error) {
       throw new Error(`카메라 정보 가져오기 실패: ${error.message}`);
     }
   }
 
+  /**
+   * open 시 GET_CCD_PARAMS로 읽은 CCD 정보 (조회 실패 또는 open 전이면 ECHO2 값, fromCamera: false)
+   * @returns {Object} { fromCamera, width, height, hFrontPorch, hBackPorch, vFrontPorch, vBackPorch,
+   *                     pixelWidthUm, pixelHeightUm, colorMatrix, bitsPerPixel, serialPorts, extraCaps,
+   *                     guiderCcd, eeprom, camera?, detector? }
+   */
+  getCcdParams() {
+    return this._camera.getCcdParams();
+  }
+
   /**
    * 이미지 촬영
    * @param {number} exposureTime 노출 시간(초)
-   * @returns {Object} 이미지 데이터 객체
+   * @param {boolean|Object} region 2x2 하드웨어 비닝 여부, 또는 부분 영역
+   *   { x, y, width, height: 비닝 전 CCD 픽셀 (생략 시 전체), bin 또는 xBin/yBin: 1~4 (생략 시 1) }
+   * @returns {Object} 이미지 데이터 객체 (width/height는 비닝 후 크기, roi는 읽은 영역, xBinning/yBinning)
    */
-  captureImage(exposureTime = 1.0) {
+  captureImage(exposureTime = 1.0, region = true) {
     if (!this.isConnected()) {
       throw new Error('카메라가 연결되어 있지 않습니다.');
     }
 
     try {
-      return this._camera.captureImage(exposureTime);
+      return this._camera.captureImage(exposureTime, region);
+    } catch (error) {
+      throw new Error(`이미지 캡처 실패: ${error.message}`);
+    }
+  }
+
+  /**
+   * 이미지 촬영 (비동기) - 노출과 다운로드가 워커 스레드에서 실행되어 이벤트 루프를 막지 않음
+   * @param {number} exposureTime 노출 시간(초)
+   * @param {boolean|Object} binning 2x2 하드웨어 비닝 여부, 또는 부분 영역 { x, y, width, height, bin } (captureImage 참고)
+   * @param {Function} onProgress 진행 상황 콜백
+   *   ({ phase: 'exposing', elapsedMs, exposureMs } 또는 { phase: 'downloading', bytes, totalBytes })
+   * @returns {Promise<Object>} 이미지 데이터 객체 (captureImage와 동일)
+   */
+  async captureImageAsync(exposureTime = 1.0, binning = true, onProgress = undefined) {
+    // 세션 모드에서는 끊긴 연결을 네이티브 쪽에서 다시 열어줌
+    if (!this._sessionMode && !this.isConnected()) {
+      throw new Error('카메라가 연결되어 있지 않습니다.');
+    }
+
+    try {
+      return await this._camera.captureImageAsync(exposureTime, binning, onProgress);
     } catch (error) {
       throw new Error(`이미지 캡처 실패: ${error.message}`);
     }
   }
 
+  /**
+   * 진행 중인 비동기 촬영 취소 (노출 대기 중에만 중단됨)
+   * @returns {boolean} 취소 요청 여부 (진행 중인 촬영이 없으면 false)
+   */
+  cancelCapture() {
+    return this._camera.cancelCapture();
+  }
+
+  /**
+   * 촬영 진행 중 여부
+   * @returns {boolean} 촬영 중 여부
+   */
+  isCapturing() {
+    return this._camera.isCapturing();
+  }
+
+  /**
+   * 다운로드 파이프라인 설정
+   * @param {Object} options { queueDepth: 동시 전송 수(1-32), transferSize: 전송 크기(바이트, 512 배수로 올림), timeoutMs }
+   * @returns {Object} 적용된 설정
+   */
+  setReadoutOptions(options = {}) {
+    return this._camera.setReadoutOptions(options);
+  }
+
+  /**
+   * 현재 다운로드 파이프라인 설정
+   * @returns {Object} { queueDepth, transferSize, timeoutMs }
+   */
+  getReadoutOptions() {
+    return this._camera.getReadoutOptions();
+  }
+
+  /**
+   * 세션 모드 설정 - 촬영 사이에 USB 연결(컨텍스트, 핸들, 인터페이스)을 유지하고
+   * 촬영 전 상태 확인에 실패하면 자동으로 다시 연결
+   * @param {boolean} enabled 세션 모드 사용 여부
+   * @returns {Object} { enabled, reopenCount }
+   */
+  setSessionMode(enabled = true) {
+    const result = this._camera.setSessionMode(enabled);
+    this._sessionMode = result.enabled;
+    return result;
+  }
+
+  /**
+   * 카메라 응답 확인 (가벼운 USB 컨트롤 전송)
+   * @returns {boolean} 응답 여부
+   */
+  checkHealth() {
+    return this._camera.checkHealth();
+  }
+
+  /**
+   * 노출 타이밍 방식 설정
+   * @param {string} mode 'host': CLEAR_PIXELS 후 호스트가 대기하고 READ_PIXELS
+   *                      'camera': READ_PIXELS_DELAYED로 카메라 내부 타이머 사용
+   *                      두 방식 모두 노출 동안 libuv 워커 스레드 하나를 점유함 ('camera'도 종료 0.5초 전까지
+   *                      취소를 확인하며 대기한 뒤 다운로드를 걸기 때문). 긴 노출을 여러 대에서 동시에 돌릴 때는
+   *                      UV_THREADPOOL_SIZE를 늘릴 것
+   */
+  setExposureMode(mode = 'host') {
+    return this._camera.setExposureMode(mode);
+  }
+
+  /**
+   * 노출 방식별 타이밍 통계 (측정 노출 - 요청 노출)
+   * @returns {Object} { host: {count, meanErrorMs, jitterMs, minErrorMs, maxErrorMs}, camera: {...} }
+   */
+  getExposureStats() {
+    return this._camera.getExposureStats();
+  }
+
+  /**
+   * 촬영 시 프레임 통계 계산 여부 (USB 수신과 같은 패스에서 히스토그램 누적)
+   * 활성화하면 촬영 결과에 stats: { count, min, max, mean, stddev, median, mad, noise, saturated, histogram } 포함
+   * @param {boolean} enabled
+   */
+  setFrameStats(enabled = true) {
+    return this._camera.setFrameStats(enabled);
+  }
+
+  /**
+   * 촬영마다 썸네일 피라미드 생성 (보정이 끝난 프레임을 변환 직후 2x2 박스 평균으로 줄임)
+   * 켜면 촬영 결과에 pyramid: [{ scale, width, height, data }], pyramidMs 포함
+   * @param {number} levels 단계 수 (0이면 끔, 기본 3 = 1/2, 1/4, 1/8)
+   */
+  setPyramid(levels = 3) {
+    return this._camera.setPyramid(levels);
+  }
+
+  /**
+   * 포치(오버스캔) 기반 바이어스 보정
+   * 켜면 각 행 오른쪽의 수평 백 포치까지 읽어 바이어스를 구하고, 수신 후 변환 패스에서 빼고 pedestal을 더함
+   * 촬영 결과에 biasMode, biasLevel, biasRowMin, biasRowMax, biasPedestal, biasColumns 포함
+   * 포치까지 읽으면 전송량이 영역의 두 배를 넘는 좁은 영역은 포치를 읽지 않고 같은 비닝의 마지막 포치 바이어스를 적용 (biasColumns 0)
+   * @param {string} mode 'off' | 'frame'(프레임 전체 중앙값) | 'row'(행별 중앙값, 이웃 행과 함께)
+   * @param {number} pedestal 보정 후 더할 값 (ADU, 기본 100)
+   */
+  setBiasCorrection(mode = 'frame', pedestal) {
+    return this._camera.setBiasCorrection(mode, pedestal);
+  }
+
+  /**
+   * 마스터 바이어스/다크/플랫 보정 (촬영 중에는 바꿀 수 없음)
+   * 디렉터리의 *.sxcal 마스터를 mmap해 두고, 촬영마다 영역/비닝/노출에 맞는 마스터를 골라 수신 버퍼 위에서
+   * 한 번의 패스로 보정 (바이어스 보정을 켰으면 포치 바이어스도 같은 패스에서 뺌)
+   * 다크는 바이어스 마스터가 있으면 노출이 가장 가까운 것을 노출 비율로 스케일링, 없으면 노출이 같은(5% 이내) 것만 사용
+   * 촬영 결과에 calibration: { bias, dark, flat(적용한 마스터 경로 또는 null), darkScale, pedestal } 포함
+   * @param {Object|null} options { dir, bias, dark, flat(종류별 사용 여부, 기본 true), pedestal(기본 100) }, null이면 끔
+   * @returns {Object[]} 불러온 마스터 정보 배열
+   */
+  setCalibration(options) {
+    return this._camera.setCalibration(options === undefined ? null : options);
+  }
+
+  /**
+   * 핫/데드 픽셀 보정 (촬영 중에는 바꿀 수 없음)
+   * 결함 맵(비닝별 정렬된 픽셀 인덱스 목록)에 있는 픽셀만 변환 후 이웃 8픽셀 중앙값으로 교체
+   * learn을 켜면 전체 프레임 촬영마다 혼자 튀는 픽셀을 세어 learnFrames장마다 맵을 다시 만들고 path에 저장
+   * 촬영 결과에 defectsCorrected(교체한 픽셀 수) 포함
+   * @param {Object|null} options { path(결함 맵 파일, 없으면 메모리에만), correct(기본 true), learn(기본 false),
+   *                                threshold(이웃과의 최소 차이 ADU, 기본 300), learnFrames(기본 20) }, null이면 끔
+   * @returns {Object|null} 결함 맵 정보 (getDefectMap과 같음)
+   */
+  setDefectCorrection(options) {
+    return this._camera.setDefectCorrection(options === undefined ? null : options);
+  }
+
+  /**
+   * 결함 맵 정보 (학습 진행 상황 포함)
+   * @returns {Object|null} { path, threshold, learnFrames, correct, learn,
+   *                          grids: [{ xBin, yBin, width, height, count, learned, indices(Uint32Array, y * width + x) }] }
+   */
+  getDefectMap() {
+    return this._camera.getDefectMap();
+  }
+
+  /**
+   * 프레임 버퍼 풀 통계
+   * @returns {Object} { hits, misses, inUse, highWater, freeBuffers, pooledBytes }
+   */
+  getPoolStats() {
+    return this._camera.getPoolStats();
+  }
+
+  /**
+   * 전송/다운로드 계측 (누적값, 촬영 중에도 호출 가능)
+   * @returns {Object} { backend, connected, frames, readoutFailures, bytes, transfers, timeouts, retries, shortReads,
+   *                     partialFrames, sessionReopens, lastDownloadMBps, lastExposureOvershootMs,
+   *                     downloadMBps: {bounds, counts, count, sum}, exposureOvershootMs: {bounds, counts, count, sum} }
+   *                     히스토그램 counts[i]는 bounds[i-1] < v <= bounds[i] 구간 (마지막은 +Inf, 누적 아님)
+   */
+  getMetrics() {
+    return this._camera.getMetrics();
+  }
+
+  /**
+   * libusb 내부 로그 레벨 (기본 'warning')
+   * @param {string|number} level 'none' | 'error' | 'warning' | 'info' | 'debug' 또는 0~4
+   */
+  setUsbLogLevel(level) {
+    return this._camera.setUsbLogLevel(level);
+  }
+
   /**
    * 이미지를 PGM 형식으로 저장
    * @param {Object} image 이미지 데이터 객체
@@ -127,7 +517,8 @@ export class SXCamera {
    * 이미지를 JPG 형식으로 저장
    * @param {Object} image 이미지 데이터 객체
    * @param {string} filename 저장할 파일 경로
-   * @param {Object} options 옵션 객체 (quality: 품질(1-100), stretch: 명암 스트레칭 여부)
+   * @param {Object} options 옵션 객체 (quality: 품질(1-100), stretch: 명암 스트레칭 방식,
+   *                         lowPercent/highPercent: 블랙/화이트 백분위, beta: asinh 강도, gamma: 감마 값)
    */
 
 
@@ -143,43 +534,32 @@ async saveAsJPG(image, filename, options = {}) {
   }
 
   try {
-    const { data, width, height, bitsPerPixel } = image;
-    
-    console.log(`이미지 JPG 변환 시작: ${width}x${height}`);
-    
-    // 8비트 변환 버퍼
-    const buffer = Buffer.alloc((width) * (height));
-    
-    // 안전한 방법으로 min/max 찾기 (스프레드 연산자 사용 안 함)
-    let min = 65535;
-    let max = 0;
-    
-    for (let i = 0; i < data.length; i++) {
-      if (data[i] < min) min = data[i];
-      if (data[i] > max) max = data[i];
-    }
-    
-    console.log(`데이터 범위: ${min} ~ ${max}`);
-    
-    // 8비트로 변환
-    const range = max - min;
-    const maxVal = (1 << bitsPerPixel) - 1;
-    
-    if (options.stretch !== false && range > 0) {
-      // 명암 스트레칭
-      for (let i = 0; i < width * height; i++) {
-        buffer[i] = Math.min(255, Math.max(0, Math.round(((data[i] - min) / range) * 255)));
-      }
-    } else {
-      // 단순 스케일링
-      for (let i = 0; i < width * height; i++) {
-        buffer[i] = Math.round((data[i] / maxVal) * 255);
-      }
+    const { width, height, bitsPerPixel } = image;
+
+    // 네이티브 스트레칭 (히스토그램 백분위로 블랙/화이트 레벨을 잡아 핫 픽셀에 끌려가지 않음)
+    //   stretch: true(기본, 백분위 linear) | 'linear' | 'asinh' | 'gamma' | false(0~최댓값 단순 스케일링)
+    //   timings: 주어지면 stretch/jpegEncode 소요 시간(ms)을 누적
+    const stretchOptions = {
+      mode: typeof options.stretch === 'string' ? options.stretch : 'linear',
+      lowPercent: options.lowPercent,
+      highPercent: options.highPercent,
+      beta: options.beta,
+      gamma: options.gamma,
+      // 촬영 시 계산한 히스토그램이 있으면 프레임을 다시 읽지 않음
+      histogram: image.stats ? image.stats.histogram : undefined
+    };
+    if (options.stretch === false) {
+      stretchOptions.black = 0;
+      stretchOptions.white = (1 << bitsPerPixel) - 1;
     }
-    
-    console.log(`8비트 변환 완료`);
-    
+
+    const stretchStart = performance.now();
+    const { data: buffer, min, max, black, white } = nativeModule.stretchImage(image, stretchOptions);
+    recordStage(options.timings, 'stretch', stretchStart);
+    console.log(`데이터 범위: ${min} ~ ${max}, 스트레칭 구간: ${black} ~ ${white} (${stretchOptions.mode})`);
+
     // Sharp로 저장
+    const encodeStart = performance.now();
     const sharp = (await import('sharp')).default;
     await sharp(buffer, {
       raw: {
@@ -190,6 +570,7 @@ async saveAsJPG(image, filename, options = {}) {
     })
     .jpeg({ quality: options.quality || 90 })
     .toFile(filename);
+    recordStage(options.timings, 'jpegEncode', encodeStart);
     
     console.log(`이미지가 JPG 형식으로 저장되었습니다: ${filename}`);
   } catch (error) {
@@ -198,18 +579,82 @@ async saveAsJPG(image, filename, options = {}) {
 }
 
 // sx-camera.js에 추가할 함수
+/**
+ * FITS 형식으로 저장
+ * 기본은 네이티브 writer (BITPIX=16 + BZERO=32768, 워커 스레드에서 블록 단위로 기록)
+ * @param {Object} image 촬영 이미지
+ * @param {string} filename 저장 경로
+ * @param {Object} options bitpix: -32면 기존 32비트 float 형식으로 저장
+ *                         compress: true 또는 { tileWidth, tileHeight, threads } 이면 RICE_1 타일 압축 (무손실)
+ *                         object/observer/telescope: 헤더 값, headers: 추가 카드 [{ key, value, comment }]
+ *                         timings: 주어지면 fitsWrite/fitsCompress 소요 시간(ms)을 누적
+ */
 async saveAsFits(image, filename, options = {}) {
   if (!image || !image.data) {
     throw new Error('유효한 이미지 데이터가 아닙니다.');
   }
 
+  if (options.bitpix === -32) {
+    return this._saveAsFitsFloat(image, filename);
+  }
+
+  const { width, height, exposureTime, roi } = image;
+  const { xBin, yBin } = imageBinning(image);
+
+  const headers = [
+    { key: 'EXPTIME', value: exposureTime || 0, comment: 'Exposure time in seconds' },
+    // 센서를 모르는 모델은 DETECTOR 생략 (camera 정보가 없는 이전 이미지 객체는 ECHO2)
+    { key: 'INSTRUME', value: image.camera || 'SX ECHO2', comment: 'Camera model' },
+    ...(image.detector || !image.camera ? [{ key: 'DETECTOR', value: image.detector || 'ICX825AL', comment: 'CCD sensor' }] : []),
+    // 픽셀 크기는 비닝 후 값 (MaxIm DL 규약), CCD 값은 GET_CCD_PARAMS 기준
+    { key: 'XPIXSZ', value: (image.pixelWidthUm || 6.45) * xBin, comment: 'Pixel size X (microns, binned)' },
+    { key: 'YPIXSZ', value: (image.pixelHeightUm || 6.45) * yBin, comment: 'Pixel size Y (microns, binned)' },
+    { key: 'XBINNING', value: xBin, comment: 'X binning factor' },
+    { key: 'YBINNING', value: yBin, comment: 'Y binning factor' },
+    // 부분 영역 원점 (비닝 전 CCD 픽셀, MaxIm DL/SBIG 규약)
+    { key: 'XORGSUBF', value: roi ? roi.x : 0, comment: 'Subframe X origin (unbinned pixels)' },
+    { key: 'YORGSUBF', value: roi ? roi.y : 0, comment: 'Subframe Y origin (unbinned pixels)' },
+    ...calibrationHeaders(image),
+    ...stackHeaders(image),
+    { key: 'DATE-OBS', value: new Date().toISOString().substring(0, 19), comment: 'Observation date' },
+    { key: 'SOFTWARE', value: 'SX-Camera', comment: 'Software used' },
+    { key: 'OBJECT', value: options.object || 'Unknown', comment: 'Target object' },
+    { key: 'OBSERVER', value: options.observer || 'Unknown', comment: 'Observer name' },
+    { key: 'TELESCOP', value: options.telescope || 'Unknown', comment: 'Telescope used' },
+    ...(options.headers || [])
+  ];
+
+  const writeStart = performance.now();
+  try {
+    // RICE_1은 정수 전용이라 float 데이터(스택 결과)는 압축하지 않고 BITPIX=-32로 기록
+    if (options.compress && !(image.data instanceof Float32Array)) {
+      const tiling = typeof options.compress === 'object' ? options.compress : {};
+      const result = await nativeModule.writeFitsCompressed(image, filename, headers, tiling);
+      recordStage(options.timings, 'fitsWrite', writeStart);
+      if (options.timings) options.timings.fitsCompress = (options.timings.fitsCompress || 0) + result.compressMs;
+      console.log(`이미지가 압축 FITS 형식으로 저장되었습니다: ${filename} (${width}x${height}, RICE_1, ` +
+                  `압축률 ${result.ratio.toFixed(2)}, ${result.compressMs.toFixed(1)} ms)`);
+      return result;
+    }
+
+    await nativeModule.writeFits(image, filename, headers);
+    recordStage(options.timings, 'fitsWrite', writeStart);
+    const bitpix = image.data instanceof Float32Array ? -32 : 16;
+    console.log(`이미지가 FITS 형식으로 저장되었습니다: ${filename} (${width}x${height}, BITPIX=${bitpix})`);
+  } catch (error) {
+    throw new Error(`FITS 이미지 저장 실패: ${error.message}`);
+  }
+}
+
+// 32비트 float FITS (BITPIX=-32) 저장 - 기존 형식이 필요한 도구용
+async _saveAsFitsFloat(image, filename) {
   try {
-    const { data, width, height, bitsPerPixel, binning, exposureTime } = image;
+    const { data, width, height, bitsPerPixel, exposureTime } = image;
     
     // 바이닝 정보 파싱
-    const isBinned = binning === "2x2";
+    const { xBin, yBin } = imageBinning(image);
     
-    console.log(`이미지 FITS 변환 시작: ${width}x${height}${isBinned ? ' (2x2 비닝)' : ''}`);
+    console.log(`이미지 FITS 변환 시작: ${width}x${height} (${xBin}x${yBin} 비닝)`);
 
     // 안전한 방법으로 min/max 찾기
     let min = 65535;
@@ -254,12 +699,13 @@ async saveAsFits(image, filename, options = {}) {
       createHeaderLine('NAXIS1', width, 'Width in pixels'),
       createHeaderLine('NAXIS2', height, 'Height in pixels'),
       createHeaderLine('EXPTIME', exposureTime || 0, 'Exposure time in seconds'),
-      createHeaderLine('INSTRUME', 'SX ECHO2', 'Camera model'),
-      createHeaderLine('DETECTOR', 'ICX825AL', 'CCD sensor'),
-      createHeaderLine('XPIXSZ', 6.45, 'Pixel size X (microns)'),
-      createHeaderLine('YPIXSZ', 6.45, 'Pixel size Y (microns)'),
-      createHeaderLine('XBINNING', isBinned ? 2 : 1, 'X binning factor'),
-      createHeaderLine('YBINNING', isBinned ? 2 : 1, 'Y binning factor'),
+      createHeaderLine('INSTRUME', image.camera || 'SX ECHO2', 'Camera model'),
+      ...(image.detector || !image.camera ? [createHeaderLine('DETECTOR', image.detector || 'ICX825AL', 'CCD sensor')] : []),
+      createHeaderLine('XPIXSZ', (image.pixelWidthUm || 6.45) * xBin, 'Pixel size X (microns, binned)'),
+      createHeaderLine('YPIXSZ', (image.pixelHeightUm || 6.45) * yBin, 'Pixel size Y (microns, binned)'),
+      createHeaderLine('XBINNING', xBin, 'X binning factor'),
+      createHeaderLine('YBINNING', yBin, 'Y binning factor'),
+      ...[...calibrationHeaders(image), ...stackHeaders(image)].map(({ key, value, comment }) => createHeaderLine(key, value, comment)),
       createHeaderLine('DATE-OBS', new Date().toISOString().substring(0, 19), 'Observation date'),
       createHeaderLine('SOFTWARE', 'SX-Camera', 'Software used'),
       createHeaderLine('DATAMAX', max, 'Maximum pixel value'),
@@ -302,7 +748,7 @@ async saveAsFits(image, filename, options = {}) {
     
     console.log(`이미지가 FITS 형식으로 저장되었습니다: ${filename}`);
     console.log(`총 파일 크기: ${fitsBuffer.length} 바이트`);
-    console.log(`헤더 정보: ${width}x${height}, ${exposureTime || 0}초, ${isBinned ? '2x2 비닝' : '풀 해상도'}`);
+    console.log(`헤더 정보: ${width}x${height}, ${exposureTime || 0}초, ${xBin}x${yBin} 비닝`);
     
   } catch (error) {
     throw new Error(`FITS 이미지 저장 실패: ${error.message}`);
@@ -331,4 +777,174 @@ async saveAsFits(image, filename, options = {}) {
 
   
 
-}
\ No newline at end of file
+}
+
+// 스택 결과 FITS 헤더에 쓰는 첫 프레임의 촬영 정보
+const STACK_META_KEYS = [
+  'camera', 'detector', 'pixelWidthUm', 'pixelHeightUm', 'binning', 'xBinning', 'yBinning', 'roi',
+  'biasMode', 'biasPedestal', 'biasLevel', 'calibration'
+];
+
+/**
+ * 네이티브 프레임 스태커
+ * 프레임을 보관하지 않고 32비트 누적 버퍼에 더하므로 메모리는 스택 깊이와 무관 (워커 스레드에서 행을 나눠 누적)
+ * mode: 'mean' | 'sum' | 'sigma'(픽셀별 Welford 평균/분산으로 벗어난 값을 버리는 누적 시그마 클리핑)
+ * 결과는 saveAsFits로 저장 (Float32Array면 BITPIX=-32), JPG는 getResult({ uint16: true })로
+ */
+export class FrameStacker {
+  /**
+   * @param {Object} options { mode(기본 'mean'), kappa(시그마 클리핑 폭, 기본 3), threads(기본 CPU 수) }
+   */
+  constructor(options = {}) {
+    this._stacker = new nativeModule.FrameStacker(options);
+    this._meta = null;
+    this._adding = Promise.resolve();
+  }
+
+  /**
+   * 프레임 누적 (이전 누적이 끝난 뒤 차례로 실행되므로 기다리지 않고 연달아 호출 가능)
+   * @param {Object} image 촬영 이미지 (첫 프레임과 크기/비닝이 같아야 함)
+   * @returns {Promise<Object>} { frames, rejected(이 프레임에서 버린 픽셀 수), addMs }
+   */
+  add(image) {
+    const { xBin, yBin } = imageBinning(image);
+    if (this._meta && (xBin !== this._meta.xBinning || yBin !== this._meta.yBinning)) {
+      return Promise.reject(new Error(`프레임 비닝(${xBin}x${yBin})이 스택과 다릅니다.`));
+    }
+    if (!this._meta) {
+      this._meta = Object.fromEntries(STACK_META_KEYS.filter(key => image[key] !== undefined).map(key => [key, image[key]]));
+      this._meta.xBinning = xBin;
+      this._meta.yBinning = yBin;
+    }
+    const adding = this._adding.then(() => this._stacker.add(image));
+    this._adding = adding.catch(() => {});
+    return adding;
+  }
+
+  /**
+   * 누적 결과 (saveAsFits/saveAsJPG에 바로 넘길 수 있는 이미지 객체)
+   * @param {Object} options uint16: true면 반올림/포화한 Uint16Array (기본 Float32Array)
+   * @returns {Promise<Object>} { data, width, height, frames, stackMode, exposureTime, totalExposure, rejected, rejectedFraction, ... }
+   */
+  async getResult(options = {}) {
+    await this._adding;
+    return { ...this._meta, ...this._stacker.getResult(options) };
+  }
+
+  /**
+   * @returns {Object} { mode, kappa, threads, width, height, frames, totalExposure, rejected, lastAddMs, busy }
+   */
+  getInfo() {
+    return this._stacker.getInfo();
+  }
+
+  /**
+   * 누적 버퍼를 비우고 처음부터 다시 시작
+   */
+  async reset() {
+    await this._adding;
+    this._stacker.reset();
+    this._meta = null;
+  }
+}
+
+/**
+ * 유성/위성 궤적 검출기 (연속 프레임 차분 + 허프 변환, 워커 스레드)
+ * 최근 history장을 binning으로 묶어 네이티브 링 버퍼에 보관하므로 JS에는 프레임 이력을 두지 않음
+ * 처음 몇 장(3장)은 배경 이력만 쌓고 검출하지 않음. 프레임 크기가 바뀌면 이력을 비우고 다시 쌓음
+ */
+export class TransientDetector {
+  /**
+   * @param {Object} options { history(배경 프레임 수, 기본 8), binning(기본 2), sigma(잔차 임계, 기본 4), threads(기본 CPU 수) }
+   */
+  constructor(options = {}) {
+    this._detector = new nativeModule.TransientDetector(options);
+    this._adding = Promise.resolve();
+  }
+
+  /**
+   * 프레임 검출 후 이력에 추가 (이전 처리가 끝난 뒤 차례로 실행되므로 촬영 순서대로 호출)
+   * @param {Object} image 촬영 이미지
+   * @returns {Promise<Object>} { frame, ready, skipped, noise, points, processMs,
+   *   trails: [{ x1, y1, x2, y2, length, angle, points, flux, box: { x, y, width, height }, crop: { data, width, height } }] }
+   *   좌표는 이미지 픽셀, crop은 box 영역의 원본 픽셀 (saveAsJPG에 바로 넘길 수 있음)
+   */
+  add(image) {
+    const adding = this._adding.then(() => this._detector.add(image));
+    this._adding = adding.catch(() => {});
+    return adding;
+  }
+
+  /**
+   * @returns {Object} { history, binning, sigma, threads, width, height, frames, historyFrames, historyBytes, trails, lastProcessMs, busy }
+   */
+  getInfo() {
+    return this._detector.getInfo();
+  }
+
+  /**
+   * 배경 이력을 비움 (시퀀스 사이 간격이 길어 하늘이 바뀌었을 때)
+   */
+  async reset() {
+    await this._adding;
+    this._detector.reset();
+  }
+}
+
+/**
+ * 밤 단위 키오그램 + 별 궤적(최댓값) 합성
+ * 상태는 dir의 파일에 바로 갱신되므로 같은 dir로 다시 만들면 이어서 쌓음 (보관 JPG를 다시 읽지 않음)
+ */
+export class NightComposite {
+  /**
+   * @param {Object} options { dir(상태 디렉터리, 미리 만들어 둬야 함), capacity(키오그램 최대 열 수, 기본 8192), column(키오그램 열, 기본 가운데) }
+   */
+  constructor(options = {}) {
+    this._composite = new nativeModule.NightComposite(options);
+    this._pending = Promise.resolve();
+  }
+
+  /**
+   * 프레임 반영 (앞선 요청이 끝난 뒤 차례로 실행)
+   * @param {Object} image 촬영 이미지
+   * @returns {Promise<Object>} { frames, keogramColumns, keogramFull, addMs }
+   */
+  add(image) {
+    return this._queue(() => this._composite.add(image));
+  }
+
+  /**
+   * @returns {Promise<Object>} { data, width(열 수 = 프레임 수), height, frames, column, totalExposure } 가로가 시간 축
+   */
+  getKeogram() {
+    return this._queue(() => this._composite.getKeogram());
+  }
+
+  /**
+   * @returns {Promise<Object>} { data, width, height, frames, totalExposure }
+   */
+  getStarTrail() {
+    return this._queue(() => this._composite.getStarTrail());
+  }
+
+  /**
+   * @returns {Object} { dir, resumed, closed, busy, lastAddMs, width, height, frames, keogramColumns, capacity, column, totalExposure, createdAt, updatedAt }
+   */
+  getInfo() {
+    return this._composite.getInfo();
+  }
+
+  /**
+   * 상태 파일을 디스크에 쓰고 닫음
+   */
+  close() {
+    return this._queue(() => this._composite.close());
+  }
+
+  // 반영/읽기/닫기를 호출 순서대로 실행 (반영 중에는 네이티브 객체가 다른 요청을 거부함)
+  _queue(task) {
+    const running = this._pending.then(task);
+    this._pending = running.catch(() => {});
+    return running;
+  }
+}
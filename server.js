@@ -1,12 +1,15 @@
 import express from 'express';
-import Database from 'better-sqlite3';
 import { mkdir } from 'fs/promises';
-import { saveSXCamera } from './app.js';
+import { captureSXFrame, saveSXFrame, closeSXCamera, getExposureStats, getCameraMetrics,
+         resetTransients, getNightCompositeInfo, cancelSXCapture } from './app.js';
+import { openCaptureDb, insertCapture, STATS_COLUMNS, SKY_COLUMNS, CLOUD_COLUMNS, TRANSIENT_COLUMNS,
+         THUMBNAIL_COLUMNS } from './lib/capture-db.js';
+import { formatPrometheus } from './lib/prometheus.js';
 import cron from 'node-cron';
 
 
 const app = express();
-const db = new Database('captures.db');
+const db = openCaptureDb('captures.db');
 
 await mkdir('images', { recursive: true });
 await mkdir('data', { recursive: true });
@@ -17,14 +20,6 @@ let currentSchedule = null;
 let cronJob = null;
 let runningProgress = { current: 0, total: 0, startTime: null };
 
-db.exec(`
-  CREATE TABLE IF NOT EXISTS captures (
-    epoch INTEGER PRIMARY KEY,
-    readable TEXT NOT NULL,
-    created_at DATETIME DEFAULT CURRENT_TIMESTAMP
-  )
-`);
-
 app.use('/images', express.static('images'));
 app.use('/data', express.static('data'));
 
@@ -33,7 +28,8 @@ function delay(ms) {
 }
 
 // 촬영 실행 함수
-async function executeCapture(exposure, howmany, interval) {
+// 이전 프레임의 JPG/FITS 저장은 다음 프레임 노출과 겹쳐서 진행 (노출은 워커 스레드/카메라 타이머가 담당)
+async function executeCapture(exposure, howmany, interval, exposureMode = 'host') {
   if (isRunning) {
     console.log('이미 촬영 중입니다. 스킵합니다.');
     return { success: false, message: '이미 촬영 중입니다' };
@@ -42,29 +38,68 @@ async function executeCapture(exposure, howmany, interval) {
   isRunning = true;
   runningProgress = { current: 0, total: howmany, startTime: Date.now() };
   const results = [];
+  const errors = [];
+  let pendingSave = null;
+  let capturing = null;
+
+  // 저장 실패는 그 프레임만 기록하고 시퀀스는 계속
+  const record = async (saving, index) => {
+    try {
+      const result = await saving;
+      insertCapture(db, result);
+      results.push(result);
+      console.log(`촬영 ${index + 1} 완료: ${result.epoch}`);
+    } catch (error) {
+      console.error(`촬영 ${index + 1} 저장 실패:`, error.message);
+      errors.push({ index: index + 1, error: error.message });
+    }
+  };
 
   try {
+    // 궤적 검출 배경은 이번 시퀀스 프레임으로만 (이전 시퀀스와는 하늘이 달라 배경으로 맞지 않음)
+    await resetTransients();
     for (let i = 0; i < howmany; i++) {
       runningProgress.current = i + 1;
       console.log(`촬영 ${i + 1}/${howmany} 시작`);
       
-      const result = await saveSXCamera(exposure);
-      db.prepare('INSERT INTO captures (epoch, readable) VALUES (?, ?)').run(result.epoch, result.readable);
-      
-      results.push(result);
-      console.log(`촬영 ${i + 1} 완료: ${result.epoch}`);
+      // 시퀀스 동안 카메라 세션 유지 (프레임마다 전원/연결을 반복하지 않음)
+      capturing = captureSXFrame(exposure, { exposureMode });
+      capturing.catch(() => {}); // 이전 프레임 저장을 기다리는 동안의 unhandled rejection 방지
+
+      if (pendingSave) {
+        const saving = pendingSave;
+        pendingSave = null;
+        await record(saving, i - 1);
+      }
+
+      const frame = await capturing;
+      capturing = null;
+      pendingSave = saveSXFrame(frame);
+      pendingSave.catch(() => {});
       
       if (i < howmany - 1 && interval > 0) {
         await delay(interval * 1000);
       }
     }
+
+    if (pendingSave) {
+      const saving = pendingSave;
+      pendingSave = null;
+      await record(saving, howmany - 1);
+    }
     
-    return { success: true, count: howmany, files: results };
+    return { success: errors.length === 0, count: results.length, files: results, errors };
     
   } catch (error) {
     console.error('촬영 오류:', error.message);
-    return { success: false, error: error.message };
+    return { success: false, error: error.message, count: results.length, files: results, errors };
   } finally {
+    // 진행 중인 촬영이 있으면 취소하고 끝날 때까지 기다린 뒤 닫음 (촬영 중에는 세션을 닫을 수 없음)
+    if (capturing) {
+      cancelSXCapture();
+      await capturing.catch(() => {});
+    }
+    closeSXCamera();
     isRunning = false;
     runningProgress = { current: 0, total: 0, startTime: null };
   }
@@ -75,6 +110,7 @@ app.get('/api/capture', async (req, res) => {
   const exposure = parseFloat(req.query.exposure) || 5.0;
   const howmany = parseInt(req.query.howmany) || 1;
   const interval = parseFloat(req.query.interval) || 0;
+  const exposureMode = req.query.mode === 'camera' ? 'camera' : 'host';
   const schedule = req.query.schedule;
 // 스케줄 등록
   if (schedule) {
@@ -87,7 +123,7 @@ app.get('/api/capture', async (req, res) => {
       // 새 스케줄 등록
       cronJob = cron.schedule(schedule.replace(/\+/g, ' '), async () => {
         console.log(`스케줄 실행: ${new Date().toISOString()}`);
-        await executeCapture(exposure, howmany, interval);
+        await executeCapture(exposure, howmany, interval, exposureMode);
       }, { scheduled: false });
 
       cronJob.start();
@@ -97,6 +133,7 @@ app.get('/api/capture', async (req, res) => {
         exposure,
         howmany,
         interval,
+        exposureMode,
         createdAt: new Date().toISOString()
       };
 
@@ -111,7 +148,7 @@ app.get('/api/capture', async (req, res) => {
     }
   } else {
     // 즉시 촬영
-    const result = await executeCapture(exposure, howmany, interval);
+    const result = await executeCapture(exposure, howmany, interval, exposureMode);
     res.json(result);
   }
   
@@ -150,7 +187,9 @@ app.get('/api/status', (req, res) => {
     schedule: currentSchedule ? {
       active: true,
       cron: currentSchedule.cron
-    } : { active: false }
+    } : { active: false },
+    // 노출 방식별 타이밍 오차/지터 (ms)
+    exposureTiming: getExposureStats()
   };
 
   if (isRunning) {
@@ -162,9 +201,57 @@ app.get('/api/status', (req, res) => {
   res.json(response);
 });
 
+// Prometheus 수집용 카메라 계측 (SX_SITE 환경 변수가 있으면 site 레이블로 구분)
+app.get('/metrics', (req, res) => {
+  const labels = process.env.SX_SITE ? { site: process.env.SX_SITE } : {};
+  res.type('text/plain; version=0.0.4').send(formatPrometheus(getCameraMetrics(), labels));
+});
+
+// 촬영 기록의 구름 지도 (cloud_grid JSON + 흐림 비율)
+function cloudFromRow(row) {
+  if (row.cloud_grid === null) return null;
+  return { cover: row.cloud_cover, method: row.cloud_method, ...JSON.parse(row.cloud_grid) };
+}
+
+// 가장 최근 촬영의 구름 지도 (관측 가능 여부 판단용)
+app.get('/api/cloud', (req, res) => {
+  const row = db.prepare(`SELECT epoch, readable, ${Object.keys(CLOUD_COLUMNS).join(', ')} FROM captures
+                          WHERE cloud_grid IS NOT NULL ORDER BY epoch DESC LIMIT 1`).get();
+  if (!row) {
+    return res.status(404).json({ success: false, error: '구름 지도가 있는 촬영 기록이 없습니다' });
+  }
+  res.json({ epoch: row.epoch, readable: row.readable, ...cloudFromRow(row) });
+});
+
+// 궤적이 검출된 촬영 목록 (최근 순, limit 기본 50)
+app.get('/api/transients', (req, res) => {
+  const limit = parseInt(req.query.limit) || 50;
+  const rows = db.prepare(`SELECT epoch, readable, transients FROM captures
+                           WHERE transient_count > 0 ORDER BY epoch DESC LIMIT ?`).all(limit);
+  res.json(rows.map(row => ({
+    epoch: row.epoch,
+    readable: row.readable,
+    jpg: `${row.epoch}.jpg`,
+    trails: JSON.parse(row.transients)
+  })));
+});
+
+// 촬영 기록의 썸네일 (작은 것부터, url은 /images 정적 경로)
+function thumbnailsFromRow(row) {
+  if (row.thumbnails === null) return null;
+  return JSON.parse(row.thumbnails)
+    .map(({ scale, width, height, jpg }) => ({ scale, width, height, url: `/images/${jpg}` }))
+    .sort((a, b) => b.scale - a.scale);
+}
+
+// 현재 밤 합성 상태 (미리보기는 /images/<keogram|startrail>)
+app.get('/api/night', async (req, res) => {
+  res.json(await getNightCompositeInfo());
+});
+
 app.get('/api/captures', (req, res) => {
   const { from, to } = req.query;
-  let query = 'SELECT epoch, readable FROM captures';
+  let query = `SELECT epoch, readable, ${Object.keys({ ...STATS_COLUMNS, ...SKY_COLUMNS, ...CLOUD_COLUMNS, ...TRANSIENT_COLUMNS, ...THUMBNAIL_COLUMNS }).join(', ')} FROM captures`;
   let params = [];
   
   if (from || to) {
@@ -200,7 +287,26 @@ app.get('/api/captures', (req, res) => {
     epoch: row.epoch,
     readable: row.readable,
     jpg: `${row.epoch}.jpg`,
-    fits: `${row.epoch}.fits`
+    fits: `${row.epoch}.fits`,
+    thumbnails: thumbnailsFromRow(row),
+    stats: row.stat_mean === null ? null : {
+      min: row.stat_min,
+      max: row.stat_max,
+      mean: row.stat_mean,
+      stddev: row.stat_stddev,
+      median: row.stat_median,
+      noise: row.stat_noise,
+      saturated: row.stat_saturated
+    },
+    sky: row.sky_stars === null ? null : {
+      stars: row.sky_stars,
+      fwhm: row.sky_fwhm,
+      hfr: row.sky_hfr,
+      background: row.sky_background,
+      backgroundRms: row.sky_rms
+    },
+    cloud: cloudFromRow(row),
+    transients: row.transients === null ? null : JSON.parse(row.transients)
   }));
   
   res.json(files);
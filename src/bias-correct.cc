@@ -0,0 +1,111 @@
+// bias-correct.cc
+#include "bias-correct.h"
+#include "frame-stats.h"
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+static const char *BIAS_MODE_NAMES[] = {"off", "frame", "row"};
+
+const char* BiasModeName(int mode) {
+  return mode >= BIAS_MODE_OFF && mode <= BIAS_MODE_ROW ? BIAS_MODE_NAMES[mode] : "off";
+}
+
+bool BiasModeFromName(const char *name, int &mode) {
+  for (int i = BIAS_MODE_OFF; i <= BIAS_MODE_ROW; i++) {
+    if (strcmp(name, BIAS_MODE_NAMES[i]) == 0) {
+      mode = i;
+      return true;
+    }
+  }
+  return false;
+}
+
+// 중앙값 (values 순서는 바뀜)
+static uint16_t Median(std::vector<uint16_t> &values) {
+  auto mid = values.begin() + values.size() / 2;
+  std::nth_element(values.begin(), mid, values.end());
+  return *mid;
+}
+
+bool BiasEstimateRows(const uint16_t *pixels, int rows, const BiasLayout &layout, int mode, int pedestal,
+                      std::vector<int> &rowOffset, BiasResult &result) {
+  const int porchColumns = layout.porchEnd - layout.porchStart;
+  result.mode = mode;
+  result.porchColumns = porchColumns > 0 ? porchColumns : 0;
+  result.level = 0.0;
+  result.minRow = 0;
+  result.maxRow = 0;
+  result.pedestal = pedestal;
+  if (porchColumns <= 0 || rows <= 0) return false;
+
+  // 1단계: 포치 열만 읽어 행별 바이어스 결정 (포치는 영상보다 훨씬 작아 전체 패스가 아님)
+  std::vector<uint16_t> rowBias(rows);
+  if (mode == BIAS_MODE_FRAME) {
+    std::vector<uint16_t> samples;
+    samples.reserve(static_cast<size_t>(rows) * porchColumns);
+    for (int y = 0; y < rows; y++) {
+      const uint16_t *porch = pixels + static_cast<size_t>(y) * layout.rawWidth + layout.porchStart;
+      samples.insert(samples.end(), porch, porch + porchColumns);
+    }
+    std::fill(rowBias.begin(), rowBias.end(), Median(samples));
+  } else {
+    std::vector<uint16_t> rowMedian(rows);
+    std::vector<uint16_t> scratch;
+    for (int y = 0; y < rows; y++) {
+      const uint16_t *porch = pixels + static_cast<size_t>(y) * layout.rawWidth + layout.porchStart;
+      scratch.assign(porch, porch + porchColumns);
+      rowMedian[y] = Median(scratch);
+    }
+    // 이웃 행 중앙값들의 중앙값: 우주선/핫 픽셀이 포치에 걸려도 한 행만 튀지 않음
+    for (int y = 0; y < rows; y++) {
+      int y0 = std::max(0, y - BIAS_ROW_WINDOW);
+      int y1 = std::min(rows - 1, y + BIAS_ROW_WINDOW);
+      scratch.assign(rowMedian.begin() + y0, rowMedian.begin() + y1 + 1);
+      rowBias[y] = Median(scratch);
+    }
+  }
+
+  double sum = 0.0;
+  result.minRow = rowBias[0];
+  result.maxRow = rowBias[0];
+  rowOffset.resize(rows);
+  for (int y = 0; y < rows; y++) {
+    rowOffset[y] = pedestal - rowBias[y];
+    sum += rowBias[y];
+    result.minRow = std::min(result.minRow, rowBias[y]);
+    result.maxRow = std::max(result.maxRow, rowBias[y]);
+  }
+  result.level = sum / rows;
+  return true;
+}
+
+bool BiasCorrectFrame(uint16_t *pixels, int rows, const BiasLayout &layout, int mode, int pedestal,
+                      uint32_t *histogram, BiasResult &result) {
+  std::vector<int> rowOffset;
+  if (!BiasEstimateRows(pixels, rows, layout, mode, pedestal, rowOffset, result)) return false;
+
+  // 2단계: 변환 패스 - 바이어스를 빼고 페디스털을 더하며 행을 출력 간격으로 앞당김
+  BiasApplyRows(pixels, rows, layout, rowOffset.data(), histogram);
+  return true;
+}
+
+void BiasApplyRows(uint16_t *pixels, int rows, const BiasLayout &layout, const int *rowOffset, uint32_t *histogram) {
+  // 출력 위치는 항상 입력 위치 이하이므로 앞에서부터 제자리 복사 가능
+  for (int y = 0; y < rows; y++) {
+    const uint16_t *src = pixels + static_cast<size_t>(y) * layout.rawWidth;
+    uint16_t *dst = pixels + static_cast<size_t>(y) * layout.outWidth;
+    const int offset = rowOffset[y];
+    for (int x = 0; x < layout.outWidth; x++) {
+      uint16_t v = src[x];
+      if (v < FRAME_STATS_SATURATION) {
+        // 보정 결과가 포화 값으로 오인되지 않도록 65534에서 자름
+        int corrected = v + offset;
+        v = static_cast<uint16_t>(std::min(FRAME_STATS_SATURATION - 1, std::max(0, corrected)));
+      }
+      dst[x] = v;
+    }
+    // 방금 쓴 행이 캐시에 있을 때 통계 누적
+    if (histogram) FrameStatsAccumulate(dst, layout.outWidth, histogram);
+  }
+}
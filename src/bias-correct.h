@@ -0,0 +1,58 @@
+// bias-correct.h
+// 포치(오버스캔) 기반 바이어스 보정
+// 바이어스 보정을 켜면 READ_PIXELS 창을 각 행 오른쪽의 수평 백 포치(빛을 받지 않는 검은 기준 픽셀)까지
+// 넓혀 읽는다. 수신 후 변환 패스에서 포치 값으로 바이어스를 구해 빼면서 포치 열을 잘라 행을 앞으로
+// 당기므로, 보정을 위해 프레임 전체를 한 번 더 읽지 않는다. 냉각하지 않는 카메라의 프레임 간 바이어스
+// 변동을 없애는 용도.
+#ifndef SX_BIAS_CORRECT_H
+#define SX_BIAS_CORRECT_H
+
+#include <cstdint>
+#include <vector>
+
+#define BIAS_MODE_OFF              0
+#define BIAS_MODE_FRAME            1       // 모든 포치 픽셀의 중앙값 하나를 프레임 전체에 적용
+#define BIAS_MODE_ROW              2       // 행마다 중앙값 (행별 바이어스 변동까지 보정)
+#define BIAS_ROW_WINDOW            4       // 행별 모드에서 위아래로 함께 보는 행 수 (포치 열이 적어 한 행만으로는 잡음이 큼)
+#define BIAS_DEFAULT_PEDESTAL      100     // 보정 후 더하는 값 (잡음으로 0 아래가 잘리지 않도록)
+#define BIAS_MAX_PEDESTAL          10000
+#define BIAS_MAX_PORCH_OVERHEAD    1.0     // 포치까지 읽느라 늘어나는 열이 영역 폭의 이 배수를 넘으면(좁은 영역) 포치를 읽지 않음
+
+// 수신 버퍼의 행 배치 (비닝 후 픽셀 단위)
+struct BiasLayout {
+  int rawWidth;         // 수신한 행 길이 (영상 + 영역 오른쪽 활성 열 + 포치)
+  int outWidth;         // 출력 행 길이 (영상)
+  int porchStart;       // 포치 열 범위 [porchStart, porchEnd) - 활성 영역과 걸친 비닝 열은 제외
+  int porchEnd;
+};
+
+struct BiasResult {
+  int mode;
+  int porchColumns;
+  double level;         // 적용한 바이어스 평균 (행별 모드는 행 평균)
+  uint16_t minRow;      // 행별 바이어스 최솟값/최댓값 (프레임 모드는 level과 같음)
+  uint16_t maxRow;
+  int pedestal;
+};
+
+const char* BiasModeName(int mode);
+
+// 이름('off' | 'frame' | 'row')을 모드로 변환, 모르는 이름이면 false
+bool BiasModeFromName(const char *name, int &mode);
+
+// rows개의 완전한 행(rawWidth 간격)의 포치에서 행별 바이어스를 구하고 rowOffset[y] = pedestal - 바이어스 를 채움
+// (보정 패스를 다른 변환과 합칠 때 사용). 포치 열이 없으면 false
+bool BiasEstimateRows(const uint16_t *pixels, int rows, const BiasLayout &layout, int mode, int pedestal,
+                      std::vector<int> &rowOffset, BiasResult &result);
+
+// 행별 오프셋(pedestal - 바이어스)을 더하며 rawWidth 간격의 행을 outWidth 간격으로 앞당김 (제자리)
+// 포화 픽셀(65535)은 그대로 둠. histogram이 있으면 보정된 픽셀을 같은 패스에서 누적
+void BiasApplyRows(uint16_t *pixels, int rows, const BiasLayout &layout, const int *rowOffset, uint32_t *histogram);
+
+// rows개의 완전한 행(rawWidth 간격)에서 바이어스를 구해 빼고 출력 행(outWidth 간격)으로 앞당김 (제자리)
+// 포화 픽셀(65535)은 그대로 둠. histogram이 있으면 보정된 픽셀을 같은 패스에서 누적.
+// 포치 열이 없으면 false (버퍼는 건드리지 않음)
+bool BiasCorrectFrame(uint16_t *pixels, int rows, const BiasLayout &layout, int mode, int pedestal,
+                      uint32_t *histogram, BiasResult &result);
+
+#endif // SX_BIAS_CORRECT_H
@@ -2,7 +2,7 @@
   "targets": [
     {
       "target_name": "sx_camera",
-      "sources": [ "sx-camera.cc" ],
+      "sources": [ "sx-camera.cc", "fits-writer.cc", "fits-compress.cc", "stretch.cc", "frame-stats.cc", "bias-correct.cc", "calibration.cc", "defect-map.cc", "stacker.cc", "star-detect.cc", "cloud-cover.cc", "transient-detect.cc", "night-composite.cc", "image-pyramid.cc", "usb-transport.cc", "sim-transport.cc", "sx-log.cc" ],
       "include_dirs": [
         "<!@(node -p \"require('node-addon-api').include\")"
       ],
@@ -0,0 +1,592 @@
+// calibration.cc
+#include "calibration.h"
+#include "fits-writer.h"
+#include "frame-stats.h"
+#include "sx-log.h"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <thread>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const char *CAL_TYPE_NAMES[] = {"bias", "dark", "flat"};
+
+const char* CalibrationTypeName(int type) {
+  return type >= CAL_TYPE_BIAS && type <= CAL_TYPE_FLAT ? CAL_TYPE_NAMES[type] : "unknown";
+}
+
+// ===== mmap된 마스터 =====
+
+CalibrationMaster::~CalibrationMaster() {
+  if (mapped) munmap(mapped, mappedBytes);
+}
+
+std::shared_ptr<CalibrationMaster> CalibrationMaster::Open(const std::string &path, std::string &error) {
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    error = path + ": 파일을 열 수 없습니다 (" + strerror(errno) + ")";
+    return nullptr;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < CAL_DATA_OFFSET) {
+    close(fd);
+    error = path + ": 마스터 파일이 너무 작습니다.";
+    return nullptr;
+  }
+
+  // 파일 크기만큼 읽기 전용으로 매핑 (페이지는 처음 보정할 때 읽힘, 여러 촬영과 프로세스가 공유)
+  size_t bytes = static_cast<size_t>(st.st_size);
+  void *mapped = mmap(nullptr, bytes, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (mapped == MAP_FAILED) {
+    error = path + ": mmap 실패 (" + strerror(errno) + ")";
+    return nullptr;
+  }
+
+  std::shared_ptr<CalibrationMaster> master(new CalibrationMaster());
+  master->path = path;
+  master->mapped = mapped;
+  master->mappedBytes = bytes;
+  master->header = static_cast<const CalibrationHeader*>(mapped);
+  master->data = reinterpret_cast<const float*>(static_cast<const char*>(mapped) + CAL_DATA_OFFSET);
+
+  const CalibrationHeader &h = *master->header;
+  if (memcmp(h.magic, CAL_FILE_MAGIC, sizeof(h.magic)) != 0 || h.type > CAL_TYPE_FLAT ||
+      h.width == 0 || h.height == 0 || h.xBin == 0 || h.yBin == 0 ||
+      bytes < CAL_DATA_OFFSET + static_cast<size_t>(h.width) * h.height * sizeof(float)) {
+    error = path + ": 마스터 파일 형식이 올바르지 않습니다.";
+    return nullptr;
+  }
+  return master;
+}
+
+const float* CalibrationMaster::Window(int x, int y, int width, int height, int xBin, int yBin) const {
+  const CalibrationHeader &h = *header;
+  if (static_cast<int>(h.xBin) != xBin || static_cast<int>(h.yBin) != yBin) return nullptr;
+  // 비닝 격자가 맞아야 같은 픽셀 (영역 원점 차이가 비닝의 배수)
+  int dx = x - static_cast<int>(h.x);
+  int dy = y - static_cast<int>(h.y);
+  if (dx < 0 || dy < 0 || dx % xBin != 0 || dy % yBin != 0) return nullptr;
+  int col = dx / xBin;
+  int row = dy / yBin;
+  if (col + width / xBin > static_cast<int>(h.width) || row + height / yBin > static_cast<int>(h.height)) return nullptr;
+  return data + static_cast<size_t>(row) * h.width + col;
+}
+
+// ===== 라이브러리 =====
+
+static uint64_t IndexKey(int type, int xBin, int yBin) {
+  return (static_cast<uint64_t>(type) << 32) | (static_cast<uint64_t>(xBin) << 16) | static_cast<uint64_t>(yBin);
+}
+
+bool CalibrationLibrary::Load(const std::string &directory, std::string &error) {
+  DIR *d = opendir(directory.c_str());
+  if (!d) {
+    error = directory + ": 디렉터리를 열 수 없습니다 (" + strerror(errno) + ")";
+    return false;
+  }
+
+  std::vector<std::string> paths;
+  const size_t extLength = strlen(CAL_FILE_EXTENSION);
+  for (struct dirent *entry = readdir(d); entry; entry = readdir(d)) {
+    std::string name = entry->d_name;
+    if (name.size() > extLength && name.compare(name.size() - extLength, extLength, CAL_FILE_EXTENSION) == 0) {
+      paths.push_back(directory + "/" + name);
+    }
+  }
+  closedir(d);
+  std::sort(paths.begin(), paths.end());
+
+  dir = directory;
+  masters.clear();
+  index.clear();
+  for (const std::string &path : paths) {
+    std::string openError;
+    std::shared_ptr<CalibrationMaster> master = CalibrationMaster::Open(path, openError);
+    if (!master) {
+      LOG_WARN("보정 마스터 건너뜀: %s", openError.c_str());
+      continue;
+    }
+    const CalibrationHeader &h = master->Header();
+    masters.push_back(master);
+    index[IndexKey(h.type, h.xBin, h.yBin)].push_back(master);
+    LOG_DEBUG("보정 마스터: %s (%s, %ux%u, %ux%u 비닝, %.3f초, %u장)", path.c_str(), CalibrationTypeName(h.type),
+              h.width, h.height, h.xBin, h.yBin, h.exposureSec, h.frameCount);
+  }
+  for (auto &entry : index) {
+    std::sort(entry.second.begin(), entry.second.end(),
+              [](const std::shared_ptr<CalibrationMaster> &a, const std::shared_ptr<CalibrationMaster> &b) {
+                return a->Header().exposureSec < b->Header().exposureSec;
+              });
+  }
+  LOG_INFO("보정 라이브러리 %s: 마스터 %zu개", directory.c_str(), masters.size());
+  return true;
+}
+
+std::shared_ptr<CalibrationMaster> CalibrationLibrary::Find(int type, int x, int y, int width, int height,
+                                                            int xBin, int yBin, bool biasCorrected,
+                                                            double exposureSec, double tolerance) const {
+  auto it = index.find(IndexKey(type, xBin, yBin));
+  if (it == index.end()) return nullptr;
+
+  // 영역을 덮는 것 중 노출이 가장 가까운 마스터 (로그 비율 기준, 바이어스/플랫은 노출 무관)
+  std::shared_ptr<CalibrationMaster> best;
+  double bestDistance = 0.0;
+  for (const std::shared_ptr<CalibrationMaster> &master : it->second) {
+    const CalibrationHeader &h = master->Header();
+    if ((h.biasCorrected != 0) != biasCorrected) continue;
+    if (!master->Window(x, y, width, height, xBin, yBin)) continue;
+    double distance = 0.0;
+    if (type == CAL_TYPE_DARK) {
+      if (h.exposureSec <= 0.0 || exposureSec <= 0.0) continue;
+      distance = std::fabs(std::log(exposureSec / h.exposureSec));
+      if (tolerance >= 0.0 && distance > std::log1p(tolerance)) continue;
+    }
+    if (!best || distance < bestDistance) {
+      best = master;
+      bestDistance = distance;
+    }
+  }
+  return best;
+}
+
+bool CalibrationLibrary::Select(int x, int y, int width, int height, int xBin, int yBin, double exposureSec,
+                                bool biasCorrected, bool useBias, bool useDark, bool useFlat,
+                                CalibrationFrames &frames) const {
+  for (int type = CAL_TYPE_BIAS; type <= CAL_TYPE_FLAT; type++) {
+    frames.masters[type] = nullptr;
+    frames.window[type] = nullptr;
+    frames.stride[type] = 0;
+  }
+  frames.darkScale = 1.0;
+
+  if (useBias) {
+    frames.masters[CAL_TYPE_BIAS] = Find(CAL_TYPE_BIAS, x, y, width, height, xBin, yBin, biasCorrected, 0.0, -1.0);
+  }
+  if (useDark) {
+    // 바이어스가 있으면 (다크 - 바이어스)를 노출 비율로 스케일링, 없으면 노출이 거의 같은 다크만 그대로 뺌
+    bool scalable = frames.masters[CAL_TYPE_BIAS] != nullptr;
+    frames.masters[CAL_TYPE_DARK] = Find(CAL_TYPE_DARK, x, y, width, height, xBin, yBin, biasCorrected,
+                                         exposureSec, scalable ? -1.0 : CAL_DARK_TOLERANCE);
+    if (frames.masters[CAL_TYPE_DARK] && scalable) {
+      frames.darkScale = exposureSec / frames.masters[CAL_TYPE_DARK]->Header().exposureSec;
+    }
+  }
+  if (useFlat) {
+    frames.masters[CAL_TYPE_FLAT] = Find(CAL_TYPE_FLAT, x, y, width, height, xBin, yBin, biasCorrected, 0.0, -1.0);
+  }
+
+  bool any = false;
+  for (int type = CAL_TYPE_BIAS; type <= CAL_TYPE_FLAT; type++) {
+    if (!frames.masters[type]) continue;
+    frames.window[type] = frames.masters[type]->Window(x, y, width, height, xBin, yBin);
+    frames.stride[type] = static_cast<int>(frames.masters[type]->Header().width);
+    any = true;
+  }
+  return any;
+}
+
+// ===== 보정 패스 =====
+
+// 한 행 보정. 가진 마스터 조합마다 분기 없는 루프를 따로 만들어 컴파일러가 벡터화하도록 함
+template <bool HasBias, bool HasDark, bool HasFlat>
+static void CalibrateRow(const uint16_t *__restrict src, uint16_t *__restrict out, int width, float offset,
+                         const float *__restrict bias, const float *__restrict dark, const float *__restrict gain,
+                         float darkScale, float pedestal) {
+  for (int x = 0; x < width; x++) {
+    float v = static_cast<float>(src[x]) + offset;
+    if (HasBias) v -= bias[x];
+    if (HasDark) v -= HasBias ? (dark[x] - bias[x]) * darkScale : dark[x];
+    if (HasFlat) v *= gain[x];
+    v += pedestal + 0.5f;
+    // 보정 결과가 포화 값으로 오인되지 않도록 65534에서 자르고, 포화 픽셀은 그대로 둠
+    v = std::min(std::max(v, 0.0f), static_cast<float>(FRAME_STATS_SATURATION - 1));
+    out[x] = src[x] >= FRAME_STATS_SATURATION ? src[x] : static_cast<uint16_t>(v);
+  }
+}
+
+typedef void (*CalibrateRowFn)(const uint16_t*, uint16_t*, int, float, const float*, const float*, const float*,
+                               float, float);
+
+static const CalibrateRowFn CALIBRATE_ROW[8] = {
+  CalibrateRow<false, false, false>, CalibrateRow<true, false, false>,
+  CalibrateRow<false, true, false>,  CalibrateRow<true, true, false>,
+  CalibrateRow<false, false, true>,  CalibrateRow<true, false, true>,
+  CalibrateRow<false, true, true>,   CalibrateRow<true, true, true>
+};
+
+void CalibrationApply(uint16_t *pixels, const CalibrationPass &pass, const CalibrationFrames &frames,
+                      uint32_t *histogram) {
+  const float *bias = frames.window[CAL_TYPE_BIAS];
+  const float *dark = frames.window[CAL_TYPE_DARK];
+  const float *gain = frames.window[CAL_TYPE_FLAT];
+  CalibrateRowFn fn = CALIBRATE_ROW[(bias ? 1 : 0) | (dark ? 2 : 0) | (gain ? 4 : 0)];
+
+  // 출력 행은 입력 행과 겹칠 수 있으므로(포치 열 제거) L1에 머무는 한 행 버퍼에 계산 후 복사
+  std::vector<uint16_t> row(pass.width);
+  for (int y = 0; y < pass.height; y++) {
+    const uint16_t *src = pixels + static_cast<size_t>(y) * pass.srcStride;
+    float offset = pass.rowOffset ? static_cast<float>(pass.rowOffset[y]) : 0.0f;
+    fn(src, row.data(), pass.width, offset,
+       bias ? bias + static_cast<size_t>(y) * frames.stride[CAL_TYPE_BIAS] : nullptr,
+       dark ? dark + static_cast<size_t>(y) * frames.stride[CAL_TYPE_DARK] : nullptr,
+       gain ? gain + static_cast<size_t>(y) * frames.stride[CAL_TYPE_FLAT] : nullptr,
+       static_cast<float>(frames.darkScale), static_cast<float>(pass.pedestal));
+    memcpy(pixels + static_cast<size_t>(y) * pass.width, row.data(), pass.width * sizeof(uint16_t));
+    if (histogram) FrameStatsAccumulate(row.data(), pass.width, histogram);
+  }
+}
+
+// ===== 마스터 만들기 =====
+
+struct CalibrationBuildInput {
+  std::vector<const uint16_t*> frames;
+  int width;
+  int height;
+  CalibrationHeader header;
+  std::shared_ptr<CalibrationMaster> bias;   // 플랫에서 뺄 바이어스 (없으면 nullptr)
+  int threads;
+};
+
+struct CalibrationBuildResult {
+  double mean;              // 마스터 평균 (플랫은 정규화 전 평균)
+  size_t rejected;          // 시그마 클리핑으로 버린 값 수
+  double buildMs;
+};
+
+// 값 n개 합치기 (values 순서는 바뀜)
+static float CombineValues(float *values, int n, int combine, double kappa, size_t &rejected) {
+  float *mid = values + n / 2;
+  std::nth_element(values, mid, values + n);
+  float median = *mid;
+  if (combine == CAL_COMBINE_MEDIAN) return median;
+
+  float deviations[CAL_MAX_FRAMES];
+  for (int i = 0; i < n; i++) deviations[i] = std::fabs(values[i] - median);
+  std::nth_element(deviations, deviations + n / 2, deviations + n);
+  float limit = static_cast<float>(kappa * FRAME_STATS_MAD_TO_SIGMA) * deviations[n / 2];
+
+  double sum = 0.0;
+  int kept = 0;
+  for (int i = 0; i < n; i++) {
+    if (std::fabs(values[i] - median) <= limit) {
+      sum += values[i];
+      kept++;
+    }
+  }
+  rejected += n - kept;
+  return kept > 0 ? static_cast<float>(sum / kept) : median;
+}
+
+static bool BuildMaster(const CalibrationBuildInput &input, const std::string &path,
+                        CalibrationBuildResult &result, std::string &error) {
+  auto startTime = std::chrono::steady_clock::now();
+  const int n = static_cast<int>(input.frames.size());
+  const size_t pixels = static_cast<size_t>(input.width) * input.height;
+  const CalibrationHeader &header = input.header;
+
+  const float *bias = nullptr;
+  if (input.bias) {
+    bias = input.bias->Window(header.x, header.y, input.width * header.xBin, input.height * header.yBin,
+                              header.xBin, header.yBin);
+  }
+  const int biasStride = input.bias ? static_cast<int>(input.bias->Header().width) : 0;
+
+  // 플랫: 프레임마다 (바이어스를 뺀) 중앙값으로 나눠 밝기를 맞춘 뒤 합침
+  std::vector<float> frameScale(n, 1.0f);
+  if (header.type == CAL_TYPE_FLAT) {
+    double biasMean = 0.0;
+    if (bias) {
+      for (int y = 0; y < input.height; y++) {
+        const float *row = bias + static_cast<size_t>(y) * biasStride;
+        for (int x = 0; x < input.width; x++) biasMean += row[x];
+      }
+      biasMean /= pixels;
+    }
+    std::vector<uint32_t> histogram(FRAME_STATS_BINS);
+    for (int i = 0; i < n; i++) {
+      std::fill(histogram.begin(), histogram.end(), 0);
+      FrameStatsAccumulate(input.frames[i], pixels, histogram.data());
+      FrameStats stats;
+      FrameStatsFromHistogram(histogram.data(), stats);
+      double level = stats.median - biasMean;
+      if (level <= 0.0) {
+        error = "플랫 " + std::to_string(i + 1) + "번째 프레임의 신호가 바이어스보다 낮습니다.";
+        return false;
+      }
+      frameScale[i] = static_cast<float>(1.0 / level);
+    }
+  }
+
+  int threadCount = input.threads > 0 ? input.threads : static_cast<int>(std::thread::hardware_concurrency());
+  threadCount = std::max(1, std::min(threadCount, input.height));
+
+  // 행 단위로 나눠 스레드마다 다음 행을 가져가 픽셀별로 합침
+  std::vector<float> master(pixels);
+  std::vector<size_t> threadRejected(threadCount, 0);
+  std::atomic<int> nextRow(0);
+  auto worker = [&](int threadIndex) {
+    float values[CAL_MAX_FRAMES];
+    size_t rejected = 0;
+    for (int y = nextRow.fetch_add(1); y < input.height; y = nextRow.fetch_add(1)) {
+      const size_t rowStart = static_cast<size_t>(y) * input.width;
+      const float *biasRow = bias ? bias + static_cast<size_t>(y) * biasStride : nullptr;
+      for (int x = 0; x < input.width; x++) {
+        float b = biasRow ? biasRow[x] : 0.0f;
+        for (int i = 0; i < n; i++) {
+          float v = input.frames[i][rowStart + x];
+          values[i] = header.type == CAL_TYPE_FLAT ? (v - b) * frameScale[i] : v;
+        }
+        master[rowStart + x] = CombineValues(values, n, header.combine, header.kappa, rejected);
+      }
+    }
+    threadRejected[threadIndex] = rejected;
+  };
+  std::vector<std::thread> threads;
+  for (int i = 1; i < threadCount; i++) threads.emplace_back(worker, i);
+  worker(0);
+  for (std::thread &th : threads) th.join();
+
+  double sum = 0.0;
+  for (float v : master) sum += v;
+  result.mean = sum / pixels;
+  result.rejected = 0;
+  for (size_t r : threadRejected) result.rejected += r;
+
+  // 플랫: 평균 1로 정규화한 뒤 역수(이득)로 저장 (너무 어두운 픽셀은 보정하지 않음)
+  if (header.type == CAL_TYPE_FLAT) {
+    for (float &v : master) {
+      float normalized = static_cast<float>(v / result.mean);
+      v = normalized >= CAL_MIN_FLAT ? 1.0f / normalized : 1.0f;
+    }
+  }
+
+  // 임시 파일에 쓴 뒤 이름을 바꿔 라이브러리가 쓰다 만 파일을 읽지 않도록 함
+  std::string tmpPath = path + ".tmp";
+  FILE *fp = fopen(tmpPath.c_str(), "wb");
+  if (!fp) {
+    error = tmpPath + ": 파일을 만들 수 없습니다 (" + strerror(errno) + ")";
+    return false;
+  }
+  std::vector<char> head(CAL_DATA_OFFSET, 0);
+  memcpy(head.data(), &header, sizeof(header));
+  bool ok = fwrite(head.data(), 1, head.size(), fp) == head.size() &&
+            fwrite(master.data(), sizeof(float), pixels, fp) == pixels;
+  ok = fclose(fp) == 0 && ok;
+  if (!ok || rename(tmpPath.c_str(), path.c_str()) != 0) {
+    unlink(tmpPath.c_str());
+    error = path + ": 마스터 파일 기록 실패 (" + strerror(errno) + ")";
+    return false;
+  }
+
+  result.buildMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+  return true;
+}
+
+// ===== N-API 바인딩 =====
+
+Napi::Object CalibrationMasterToObject(Napi::Env env, const CalibrationMaster &master) {
+  const CalibrationHeader &h = master.Header();
+  Napi::Object obj = Napi::Object::New(env);
+  obj.Set("path", Napi::String::New(env, master.Path()));
+  obj.Set("type", Napi::String::New(env, CalibrationTypeName(h.type)));
+  obj.Set("combine", Napi::String::New(env, h.combine == CAL_COMBINE_SIGMA ? "sigma" : "median"));
+  obj.Set("width", Napi::Number::New(env, h.width));
+  obj.Set("height", Napi::Number::New(env, h.height));
+  obj.Set("x", Napi::Number::New(env, h.x));
+  obj.Set("y", Napi::Number::New(env, h.y));
+  obj.Set("xBin", Napi::Number::New(env, h.xBin));
+  obj.Set("yBin", Napi::Number::New(env, h.yBin));
+  obj.Set("exposureTime", Napi::Number::New(env, h.exposureSec));
+  obj.Set("frames", Napi::Number::New(env, h.frameCount));
+  obj.Set("biasCorrected", Napi::Boolean::New(env, h.biasCorrected != 0));
+  obj.Set("createdAt", Napi::Number::New(env, static_cast<double>(h.createdAt) * 1000.0));
+  return obj;
+}
+
+class CalibrationBuildWorker : public Napi::AsyncWorker {
+public:
+  CalibrationBuildWorker(Napi::Env env, const std::vector<Napi::Uint16Array> &frames, const CalibrationBuildInput &input,
+                         const std::string &path)
+    : Napi::AsyncWorker(env, "SXCalibrationBuild"),
+      deferred(Napi::Promise::Deferred::New(env)),
+      input(input), path(path), result() {
+    // 합치는 동안 프레임 버퍼가 GC되어 풀로 반납되지 않도록 각 data 배열의 참조 유지
+    // (호출 쪽이 images 배열에서 빼거나 바꿔도 버퍼는 살아 있음)
+    dataRefs.reserve(frames.size());
+    for (const Napi::Uint16Array &data : frames) dataRefs.push_back(Napi::Persistent(data.As<Napi::Object>()));
+  }
+
+  Napi::Promise GetPromise() const { return deferred.Promise(); }
+
+protected:
+  void Execute() override {
+    std::string error;
+    if (!BuildMaster(input, path, result, error)) {
+      SetError(error);
+    }
+  }
+
+  void OnOK() override {
+    Napi::Env env = Env();
+    std::string error;
+    std::shared_ptr<CalibrationMaster> master = CalibrationMaster::Open(path, error);
+    if (!master) {
+      deferred.Reject(Napi::Error::New(env, error).Value());
+      return;
+    }
+    Napi::Object obj = CalibrationMasterToObject(env, *master);
+    obj.Set("mean", Napi::Number::New(env, result.mean));
+    obj.Set("rejected", Napi::Number::New(env, static_cast<double>(result.rejected)));
+    obj.Set("buildMs", Napi::Number::New(env, result.buildMs));
+    deferred.Resolve(obj);
+  }
+
+  void OnError(const Napi::Error &error) override {
+    deferred.Reject(error.Value());
+  }
+
+private:
+  Napi::Promise::Deferred deferred;
+  std::vector<Napi::ObjectReference> dataRefs;
+  CalibrationBuildInput input;
+  std::string path;
+  CalibrationBuildResult result;
+};
+
+// 이미지 객체의 정수 속성 (없으면 기본값)
+static int ImageInt(const Napi::Object &image, const char *key, int defaultValue) {
+  Napi::Value v = image.Get(key);
+  return v.IsNumber() ? v.As<Napi::Number>().Int32Value() : defaultValue;
+}
+
+// buildCalibrationMaster(images, path, { type, combine, kappa, bias, threads }) -> Promise<Object>
+//  images: 같은 영역/비닝으로 촬영한 이미지 객체 배열, bias: 플랫에서 뺄 바이어스 마스터 경로
+static Napi::Value BuildCalibrationMaster(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  Napi::Promise::Deferred deferred = Napi::Promise::Deferred::New(env);
+  auto reject = [&](const std::string &message) {
+    deferred.Reject(Napi::TypeError::New(env, message).Value());
+    return deferred.Promise();
+  };
+
+  if (info.Length() < 3 || !info[0].IsArray() || !info[1].IsString() || !info[2].IsObject()) {
+    return reject("buildCalibrationMaster(images, path, { type, combine, kappa, bias }) 형식으로 호출해야 합니다.");
+  }
+  Napi::Array images = info[0].As<Napi::Array>();
+  std::string path = info[1].As<Napi::String>().Utf8Value();
+  Napi::Object opts = info[2].As<Napi::Object>();
+
+  CalibrationBuildInput input;
+  memset(&input.header, 0, sizeof(input.header));
+  memcpy(input.header.magic, CAL_FILE_MAGIC, sizeof(input.header.magic));
+  input.threads = ImageInt(opts, "threads", 0);
+
+  std::string type = opts.Get("type").IsString() ? opts.Get("type").As<Napi::String>().Utf8Value() : "";
+  if (type == "bias") input.header.type = CAL_TYPE_BIAS;
+  else if (type == "dark") input.header.type = CAL_TYPE_DARK;
+  else if (type == "flat") input.header.type = CAL_TYPE_FLAT;
+  else return reject("마스터 종류(type)는 'bias', 'dark', 'flat' 중 하나여야 합니다.");
+
+  std::string combine = opts.Get("combine").IsString() ? opts.Get("combine").As<Napi::String>().Utf8Value() : "median";
+  if (combine == "median") input.header.combine = CAL_COMBINE_MEDIAN;
+  else if (combine == "sigma") input.header.combine = CAL_COMBINE_SIGMA;
+  else return reject("합치는 방식(combine)은 'median' 또는 'sigma'여야 합니다.");
+  input.header.kappa = opts.Get("kappa").IsNumber() ? opts.Get("kappa").As<Napi::Number>().DoubleValue() : CAL_DEFAULT_KAPPA;
+  if (input.header.kappa <= 0.0) return reject("kappa는 0보다 커야 합니다.");
+
+  uint32_t count = images.Length();
+  if (count < CAL_MIN_FRAMES || count > CAL_MAX_FRAMES) {
+    return reject("마스터에는 " + std::to_string(CAL_MIN_FRAMES) + "~" + std::to_string(CAL_MAX_FRAMES) +
+                  "장의 프레임이 필요합니다.");
+  }
+
+  // 모든 프레임의 크기/영역/비닝/포치 보정 여부가 같아야 함 (노출은 평균을 기록)
+  double exposureSum = 0.0;
+  std::vector<Napi::Uint16Array> frames;
+  for (uint32_t i = 0; i < count; i++) {
+    Napi::Uint16Array pixels;
+    int width, height;
+    std::string error;
+    if (!ParseFitsImageArg(images.Get(i), pixels, width, height, error)) return reject(error);
+    Napi::Object image = images.Get(i).As<Napi::Object>();
+    Napi::Value roi = image.Get("roi");
+    int x = roi.IsObject() ? ImageInt(roi.As<Napi::Object>(), "x", 0) : 0;
+    int y = roi.IsObject() ? ImageInt(roi.As<Napi::Object>(), "y", 0) : 0;
+    int xBin = ImageInt(image, "xBinning", image.Get("binning").IsString() &&
+                        image.Get("binning").As<Napi::String>().Utf8Value() == "2x2" ? 2 : 1);
+    int yBin = ImageInt(image, "yBinning", xBin);
+    bool biasCorrected = image.Get("biasMode").IsString();
+
+    if (i == 0) {
+      input.width = width;
+      input.height = height;
+      input.header.width = width;
+      input.header.height = height;
+      input.header.x = x;
+      input.header.y = y;
+      input.header.xBin = xBin;
+      input.header.yBin = yBin;
+      input.header.biasCorrected = biasCorrected ? 1 : 0;
+    } else if (width != input.width || height != input.height || x != static_cast<int>(input.header.x) ||
+               y != static_cast<int>(input.header.y) || xBin != static_cast<int>(input.header.xBin) ||
+               yBin != static_cast<int>(input.header.yBin) || biasCorrected != (input.header.biasCorrected != 0)) {
+      return reject(std::to_string(i + 1) + "번째 프레임의 크기/영역/비닝/바이어스 보정이 첫 프레임과 다릅니다.");
+    }
+    input.frames.push_back(pixels.Data());
+    frames.push_back(pixels);
+    exposureSum += image.Get("exposureTime").IsNumber() ? image.Get("exposureTime").As<Napi::Number>().DoubleValue() : 0.0;
+  }
+  input.header.frameCount = count;
+  input.header.exposureSec = exposureSum / count;
+  input.header.createdAt = static_cast<int64_t>(time(nullptr));
+
+  if (opts.Get("bias").IsString()) {
+    if (input.header.type != CAL_TYPE_FLAT) return reject("바이어스 마스터(bias)는 플랫을 만들 때만 사용합니다.");
+    std::string error;
+    input.bias = CalibrationMaster::Open(opts.Get("bias").As<Napi::String>().Utf8Value(), error);
+    if (!input.bias) return reject(error);
+    const CalibrationHeader &bh = input.bias->Header();
+    if (bh.type != CAL_TYPE_BIAS ||
+        !input.bias->Window(input.header.x, input.header.y, input.width * input.header.xBin,
+                            input.height * input.header.yBin, input.header.xBin, input.header.yBin)) {
+      return reject("바이어스 마스터가 플랫 프레임의 영역/비닝과 맞지 않습니다.");
+    }
+  }
+
+  CalibrationBuildWorker *worker = new CalibrationBuildWorker(env, frames, input, path);
+  Napi::Promise promise = worker->GetPromise();
+  worker->Queue();
+  return promise;
+}
+
+// readCalibrationMaster(path) - 마스터 정보
+static Napi::Value ReadCalibrationMaster(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  if (info.Length() < 1 || !info[0].IsString()) {
+    Napi::TypeError::New(env, "마스터 파일 경로가 필요합니다.").ThrowAsJavaScriptException();
+    return env.Undefined();
+  }
+  std::string error;
+  std::shared_ptr<CalibrationMaster> master = CalibrationMaster::Open(info[0].As<Napi::String>().Utf8Value(), error);
+  if (!master) {
+    Napi::Error::New(env, error).ThrowAsJavaScriptException();
+    return env.Undefined();
+  }
+  return CalibrationMasterToObject(env, *master);
+}
+
+Napi::Object InitCalibration(Napi::Env env, Napi::Object exports) {
+  exports.Set("buildCalibrationMaster", Napi::Function::New(env, BuildCalibrationMaster, "buildCalibrationMaster"));
+  exports.Set("readCalibrationMaster", Napi::Function::New(env, ReadCalibrationMaster, "readCalibrationMaster"));
+  return exports;
+}
@@ -0,0 +1,131 @@
+// calibration.h
+// 마스터 바이어스/다크/플랫 라이브러리와 촬영 시 보정
+// 마스터는 여러 장을 중앙값 또는 시그마 클리핑 평균으로 합쳐 만들고, 4096 바이트 헤더 뒤에 float 픽셀을
+// 그대로 둔 파일(.sxcal)로 저장한다. 라이브러리는 디렉터리의 마스터를 mmap해 (종류, 비닝)별로 색인하고,
+// 촬영 때는 영역/비닝/노출에 맞는 마스터를 골라 수신 버퍼 위에서 한 번의 패스로 보정한다
+// (포치 바이어스 보정과 포치 열 제거도 같은 패스에서 처리).
+#ifndef SX_CALIBRATION_H
+#define SX_CALIBRATION_H
+
+#include <napi.h>
+#include <cstdint>
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#define CAL_FILE_MAGIC             "SXCAL001"
+#define CAL_FILE_EXTENSION         ".sxcal"
+#define CAL_DATA_OFFSET            4096    // 픽셀은 페이지 경계에서 시작 (mmap 후 float*로 바로 사용)
+
+#define CAL_TYPE_BIAS              0
+#define CAL_TYPE_DARK              1
+#define CAL_TYPE_FLAT              2       // 정규화 플랫의 역수(픽셀별 이득)로 저장해 보정 때 곱셈만 함
+
+#define CAL_COMBINE_MEDIAN         0
+#define CAL_COMBINE_SIGMA          1       // 중앙값 ± kappa * (1.4826 * MAD) 밖의 값을 버린 평균
+
+#define CAL_DEFAULT_KAPPA          3.0
+#define CAL_MIN_FRAMES             3
+#define CAL_MAX_FRAMES             256
+#define CAL_MIN_FLAT               0.05    // 정규화 플랫이 이보다 작으면 죽은 픽셀로 보고 보정하지 않음
+#define CAL_DARK_TOLERANCE         0.05    // 바이어스 없이 다크를 쓸 때 허용하는 노출 차이 (비율)
+#define CAL_DEFAULT_PEDESTAL       100     // 보정 후 더하는 값 (ADU)
+
+// 파일 앞부분 (little-endian, 나머지는 0으로 채워 CAL_DATA_OFFSET까지)
+struct CalibrationHeader {
+  char magic[8];
+  uint32_t type;
+  uint32_t combine;
+  uint32_t width;           // 비닝 후 픽셀 수
+  uint32_t height;
+  uint32_t x;               // 영역 원점 (비닝 전 CCD 좌표)
+  uint32_t y;
+  uint32_t xBin;
+  uint32_t yBin;
+  uint32_t frameCount;
+  uint32_t biasCorrected;   // 포치 바이어스 보정한 프레임으로 만들었으면 1 (촬영 설정과 같을 때만 적용)
+  double exposureSec;       // 다크: 노출 시간 (스케일링 기준)
+  double kappa;
+  int64_t createdAt;        // Unix 시간 (초)
+};
+
+// mmap된 마스터 한 장 (읽기 전용, 여러 촬영이 공유)
+class CalibrationMaster {
+public:
+  ~CalibrationMaster();
+  CalibrationMaster(const CalibrationMaster&) = delete;
+  CalibrationMaster& operator=(const CalibrationMaster&) = delete;
+
+  static std::shared_ptr<CalibrationMaster> Open(const std::string &path, std::string &error);
+
+  const CalibrationHeader& Header() const { return *header; }
+  const std::string& Path() const { return path; }
+
+  // 영역(비닝 전 CCD 좌표)을 같은 비닝으로 덮으면 그 영역 첫 픽셀 위치, 아니면 nullptr
+  const float* Window(int x, int y, int width, int height, int xBin, int yBin) const;
+
+private:
+  CalibrationMaster() : header(nullptr), data(nullptr), mapped(nullptr), mappedBytes(0) {}
+
+  std::string path;
+  const CalibrationHeader *header;
+  const float *data;
+  void *mapped;
+  size_t mappedBytes;
+};
+
+// 한 촬영에 적용할 마스터 (CAL_TYPE_* 순, 없는 종류는 nullptr)
+struct CalibrationFrames {
+  std::shared_ptr<CalibrationMaster> masters[3];
+  const float *window[3];   // 촬영 영역 첫 픽셀
+  int stride[3];            // 마스터 행 간격 (픽셀)
+  double darkScale;         // 촬영 노출 / 다크 노출 (바이어스 마스터가 있을 때만 1이 아닐 수 있음)
+};
+
+class CalibrationLibrary {
+public:
+  // 디렉터리의 *.sxcal을 모두 mmap해 색인 (읽지 못한 파일은 건너뛰고 경고)
+  bool Load(const std::string &dir, std::string &error);
+
+  const std::string& Directory() const { return dir; }
+  const std::vector<std::shared_ptr<CalibrationMaster>>& Masters() const { return masters; }
+
+  // 영역/비닝/노출에 맞는 마스터 선택. 다크는 바이어스가 있으면 노출이 가장 가까운 것을 스케일링,
+  // 없으면 노출이 CAL_DARK_TOLERANCE 안에 있는 것만 사용. 하나도 없으면 false
+  bool Select(int x, int y, int width, int height, int xBin, int yBin, double exposureSec,
+              bool biasCorrected, bool useBias, bool useDark, bool useFlat, CalibrationFrames &frames) const;
+
+private:
+  std::shared_ptr<CalibrationMaster> Find(int type, int x, int y, int width, int height, int xBin, int yBin,
+                                          bool biasCorrected, double exposureSec, double tolerance) const;
+
+  std::string dir;
+  std::vector<std::shared_ptr<CalibrationMaster>> masters;
+  // (종류, xBin, yBin) -> 노출 시간 순 마스터
+  std::map<uint64_t, std::vector<std::shared_ptr<CalibrationMaster>>> index;
+};
+
+// 보정 패스 입력 배치
+struct CalibrationPass {
+  int width;                // 출력 폭/높이 (비닝 후)
+  int height;
+  int srcStride;            // 수신 버퍼 행 간격 (포치 열 포함), 출력 행 간격은 width
+  const int *rowOffset;     // 행마다 먼저 더할 값 (포치 바이어스: 페디스털 - 바이어스), 없으면 nullptr
+  int pedestal;             // 보정 후 더할 값
+};
+
+// out = (raw + rowOffset - bias - (dark - bias) * darkScale) * flatGain + pedestal (제자리, 포화 픽셀은 그대로)
+// histogram이 있으면 보정한 행을 같은 패스에서 누적
+void CalibrationApply(uint16_t *pixels, const CalibrationPass &pass, const CalibrationFrames &frames,
+                      uint32_t *histogram);
+
+const char* CalibrationTypeName(int type);
+
+// { path, type, combine, width, height, x, y, xBin, yBin, exposureTime, frames, biasCorrected, createdAt }
+Napi::Object CalibrationMasterToObject(Napi::Env env, const CalibrationMaster &master);
+
+Napi::Object InitCalibration(Napi::Env env, Napi::Object exports);
+
+#endif // SX_CALIBRATION_H
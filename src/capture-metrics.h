@@ -0,0 +1,136 @@
+// capture-metrics.h
+// 카메라별 촬영/전송 계측 (카운터와 고정 버킷 히스토그램)
+//
+// 카운터는 다운로드 경로(워커 스레드)에서 원자 변수 덧셈만 하고, 히스토그램은 프레임당 한 번
+// mutex 안에서 버킷 하나를 올린다. getMetrics()(JS 스레드)는 스냅샷을 복사해 가므로
+// 촬영 중에도 언제든 싸게 읽을 수 있다. 값은 누적만 되며(Prometheus counter 규약) 재설정하지 않는다.
+#ifndef SX_CAPTURE_METRICS_H
+#define SX_CAPTURE_METRICS_H
+
+#include <atomic>
+#include <cstdint>
+#include <initializer_list>
+#include <mutex>
+#include <vector>
+
+// 다운로드 속도 (MB/s): USB 2.0 High-speed에서 ECHO2는 보통 30~40 MB/s
+#define METRICS_MBPS_BOUNDS        {1, 2, 5, 10, 15, 20, 25, 30, 35, 40, 50}
+// 노출 초과 (측정 노출 - 요청 노출, ms): 음수면 요청보다 짧게 노출됨
+#define METRICS_OVERSHOOT_BOUNDS   {-100, -10, 0, 5, 10, 25, 50, 100, 250, 500, 1000, 5000}
+
+class CaptureMetrics {
+public:
+  // 고정 버킷 히스토그램 (counts[i]는 bounds[i-1] < v <= bounds[i], 마지막 칸은 +Inf)
+  struct Histogram {
+    std::vector<double> bounds;
+    std::vector<uint64_t> counts;
+    uint64_t count;
+    double sum;
+  };
+
+  struct Stats {
+    uint64_t frames;            // 다운로드에 성공한 프레임 수 (부분 프레임 포함)
+    uint64_t readoutFailures;   // 데이터를 받지 못하고 실패한 다운로드 수
+    uint64_t bytes;             // 수신한 이미지 데이터 바이트
+    uint64_t transfers;         // 완료된 벌크 전송 수
+    uint64_t timeouts;          // 전송 타임아웃 발생 횟수
+    uint64_t retries;           // 첫 데이터 전 타임아웃으로 다시 시도한 횟수
+    uint64_t shortReads;        // 예상 크기 전에 짧은 패킷으로 끝난 다운로드 수
+    uint64_t partialFrames;     // 예상보다 적게 받고도 받아들인 프레임 수 (남은 픽셀은 0)
+    double lastDownloadMBps;
+    double lastOvershootMs;
+    Histogram downloadMBps;
+    Histogram exposureOvershootMs;
+  };
+
+  CaptureMetrics()
+    : frames(0), readoutFailures(0), bytes(0), transfers(0), timeouts(0), retries(0),
+      shortReads(0), partialFrames(0), lastDownloadMBps(0.0), lastOvershootMs(0.0) {
+    InitHistogram(downloadMBps, METRICS_MBPS_BOUNDS);
+    InitHistogram(exposureOvershootMs, METRICS_OVERSHOOT_BOUNDS);
+  }
+
+  CaptureMetrics(const CaptureMetrics&) = delete;
+  CaptureMetrics& operator=(const CaptureMetrics&) = delete;
+
+  // 다운로드 한 번의 결과 (모든 시도 합계)
+  void RecordReadout(uint64_t receivedBytes, uint64_t completedTransfers, bool shortRead, bool partial) {
+    frames.fetch_add(1, std::memory_order_relaxed);
+    bytes.fetch_add(receivedBytes, std::memory_order_relaxed);
+    transfers.fetch_add(completedTransfers, std::memory_order_relaxed);
+    if (shortRead) shortReads.fetch_add(1, std::memory_order_relaxed);
+    if (partial) partialFrames.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  void RecordReadoutFailure(uint64_t completedTransfers) {
+    readoutFailures.fetch_add(1, std::memory_order_relaxed);
+    transfers.fetch_add(completedTransfers, std::memory_order_relaxed);
+  }
+
+  void RecordTimeout() { timeouts.fetch_add(1, std::memory_order_relaxed); }
+  void RecordRetry() { retries.fetch_add(1, std::memory_order_relaxed); }
+
+  void RecordDownloadMBps(double mbps) {
+    std::lock_guard<std::mutex> lock(mutex);
+    lastDownloadMBps = mbps;
+    Observe(downloadMBps, mbps);
+  }
+
+  void RecordExposureOvershoot(double ms) {
+    std::lock_guard<std::mutex> lock(mutex);
+    lastOvershootMs = ms;
+    Observe(exposureOvershootMs, ms);
+  }
+
+  Stats GetStats() {
+    Stats s;
+    s.frames = frames.load(std::memory_order_relaxed);
+    s.readoutFailures = readoutFailures.load(std::memory_order_relaxed);
+    s.bytes = bytes.load(std::memory_order_relaxed);
+    s.transfers = transfers.load(std::memory_order_relaxed);
+    s.timeouts = timeouts.load(std::memory_order_relaxed);
+    s.retries = retries.load(std::memory_order_relaxed);
+    s.shortReads = shortReads.load(std::memory_order_relaxed);
+    s.partialFrames = partialFrames.load(std::memory_order_relaxed);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    s.lastDownloadMBps = lastDownloadMBps;
+    s.lastOvershootMs = lastOvershootMs;
+    s.downloadMBps = downloadMBps;
+    s.exposureOvershootMs = exposureOvershootMs;
+    return s;
+  }
+
+private:
+  static void InitHistogram(Histogram &h, std::initializer_list<double> bounds) {
+    h.bounds.assign(bounds);
+    h.counts.assign(h.bounds.size() + 1, 0);
+    h.count = 0;
+    h.sum = 0.0;
+  }
+
+  static void Observe(Histogram &h, double value) {
+    size_t i = 0;
+    while (i < h.bounds.size() && value > h.bounds[i]) i++;
+    h.counts[i]++;
+    h.count++;
+    h.sum += value;
+  }
+
+  std::atomic<uint64_t> frames;
+  std::atomic<uint64_t> readoutFailures;
+  std::atomic<uint64_t> bytes;
+  std::atomic<uint64_t> transfers;
+  std::atomic<uint64_t> timeouts;
+  std::atomic<uint64_t> retries;
+  std::atomic<uint64_t> shortReads;
+  std::atomic<uint64_t> partialFrames;
+
+  std::mutex mutex;
+  double lastDownloadMBps;
+  double lastOvershootMs;
+  Histogram downloadMBps;
+  Histogram exposureOvershootMs;
+};
+
+#endif // SX_CAPTURE_METRICS_H
@@ -0,0 +1,269 @@
+// cloud-cover.cc
+#include "cloud-cover.h"
+#include "sx-log.h"
+#include <algorithm>
+#include <cmath>
+
+CloudCoverOptions CloudCoverDefaultOptions() {
+  CloudCoverOptions options;
+  options.enabled = false;
+  options.columns = CLOUD_DEFAULT_COLUMNS;
+  options.rows = CLOUD_DEFAULT_ROWS;
+  options.referenceWidth = 0;
+  options.referenceHeight = 0;
+  options.skyMask = true;
+  options.skyX = 0.0f;
+  options.skyY = 0.0f;
+  options.skyRadius = 0.0f;
+  return options;
+}
+
+static bool GridSizeValid(int columns, int rows) {
+  return columns >= 1 && rows >= 1 && columns <= CLOUD_MAX_GRID && rows <= CLOUD_MAX_GRID;
+}
+
+bool CloudCoverOptionsFromValue(Napi::Value value, CloudCoverOptions &options, std::string &error) {
+  if (value.IsUndefined() || value.IsNull() || (value.IsBoolean() && !value.As<Napi::Boolean>().Value())) {
+    options.enabled = false;
+    return true;
+  }
+  options.enabled = true;
+  if (value.IsBoolean()) return true;
+  if (!value.IsObject()) {
+    error = "cloud 옵션은 true 또는 { columns, rows, reference } 객체여야 합니다.";
+    return false;
+  }
+
+  Napi::Object obj = value.As<Napi::Object>();
+  if (obj.Get("columns").IsNumber()) options.columns = obj.Get("columns").As<Napi::Number>().Int32Value();
+  if (obj.Get("rows").IsNumber()) options.rows = obj.Get("rows").As<Napi::Number>().Int32Value();
+
+  Napi::Value refValue = obj.Get("reference");
+  if (refValue.IsObject()) {
+    Napi::Object ref = refValue.As<Napi::Object>();
+    Napi::Value expected = ref.Get("expected");
+    if (!ref.Get("columns").IsNumber() || !ref.Get("rows").IsNumber() || !expected.IsArray()) {
+      error = "구름 기준은 { columns, rows, expected: number[] } 형식이어야 합니다.";
+      return false;
+    }
+    // 기준이 있으면 구역 나눔은 기준을 따름
+    options.columns = ref.Get("columns").As<Napi::Number>().Int32Value();
+    options.rows = ref.Get("rows").As<Napi::Number>().Int32Value();
+    if (!GridSizeValid(options.columns, options.rows)) {
+      error = "구름 기준 구역 수가 올바르지 않습니다 (1~" + std::to_string(CLOUD_MAX_GRID) + ").";
+      return false;
+    }
+    Napi::Array list = expected.As<Napi::Array>();
+    if (list.Length() != static_cast<uint32_t>(options.columns * options.rows)) {
+      error = "구름 기준 expected 길이(" + std::to_string(list.Length()) + ")가 columns*rows와 다릅니다.";
+      return false;
+    }
+    options.expected.resize(list.Length());
+    for (uint32_t i = 0; i < list.Length(); i++) {
+      Napi::Value v = list.Get(i);
+      options.expected[i] = v.IsNumber() ? v.As<Napi::Number>().FloatValue() : 0.0f;
+    }
+    if (ref.Get("width").IsNumber()) options.referenceWidth = ref.Get("width").As<Napi::Number>().Int32Value();
+    if (ref.Get("height").IsNumber()) options.referenceHeight = ref.Get("height").As<Napi::Number>().Int32Value();
+  }
+
+  if (!GridSizeValid(options.columns, options.rows)) {
+    error = "구름 지도 구역 수가 올바르지 않습니다 (1~" + std::to_string(CLOUD_MAX_GRID) + ").";
+    return false;
+  }
+
+  // 하늘 원: 생략하면 프레임 중앙 내접원, false면 마스크 없음
+  Napi::Value skyValue = obj.Get("sky");
+  if (skyValue.IsBoolean()) {
+    options.skyMask = skyValue.As<Napi::Boolean>().Value();
+  } else if (skyValue.IsObject()) {
+    Napi::Object sky = skyValue.As<Napi::Object>();
+    if (!sky.Get("x").IsNumber() || !sky.Get("y").IsNumber() || !sky.Get("radius").IsNumber() ||
+        sky.Get("radius").As<Napi::Number>().FloatValue() <= 0.0f) {
+      error = "하늘 원은 { x, y, radius } (radius > 0) 형식이어야 합니다.";
+      return false;
+    }
+    options.skyX = sky.Get("x").As<Napi::Number>().FloatValue();
+    options.skyY = sky.Get("y").As<Napi::Number>().FloatValue();
+    options.skyRadius = sky.Get("radius").As<Napi::Number>().FloatValue();
+  } else if (!skyValue.IsUndefined() && !skyValue.IsNull()) {
+    error = "sky 옵션은 false 또는 { x, y, radius } 여야 합니다.";
+    return false;
+  }
+  return true;
+}
+
+// 구역 안 메시 배경에서 평면 a + bx + cy를 빼고 남은 잔차의 표준편차 / 잡음 (하늘 밝기 기울기는 구름으로 보지 않음)
+static float SectorTexture(const std::vector<float> &xs, const std::vector<float> &ys, const std::vector<float> &values,
+                           float noise) {
+  const size_t n = values.size();
+  if (n < CLOUD_MIN_TEXTURE_CELLS || noise <= 0.0f) return 0.0f;
+  double mx = 0, my = 0, mv = 0;
+  for (size_t i = 0; i < n; i++) {
+    mx += xs[i];
+    my += ys[i];
+    mv += values[i];
+  }
+  mx /= n;
+  my /= n;
+  mv /= n;
+  double sxx = 0, syy = 0, sxy = 0, sxv = 0, syv = 0;
+  for (size_t i = 0; i < n; i++) {
+    double dx = xs[i] - mx, dy = ys[i] - my, dv = values[i] - mv;
+    sxx += dx * dx;
+    syy += dy * dy;
+    sxy += dx * dy;
+    sxv += dx * dv;
+    syv += dy * dv;
+  }
+  double det = sxx * syy - sxy * sxy;
+  double b = 0.0, c = 0.0;
+  if (std::fabs(det) > 1e-9) {
+    b = (sxv * syy - syv * sxy) / det;
+    c = (syv * sxx - sxv * sxy) / det;
+  }
+  double residual = 0.0;
+  for (size_t i = 0; i < n; i++) {
+    double r = values[i] - (mv + b * (xs[i] - mx) + c * (ys[i] - my));
+    residual += r * r;
+  }
+  return static_cast<float>(std::sqrt(residual / (n > 3 ? n - 3 : 1)) / noise);
+}
+
+void CloudCoverAnalyze(const StarDetectResult &stars, int width, int height, const CloudCoverOptions &options,
+                       CloudCoverResult &result) {
+  const int columns = options.columns, rows = options.rows, sectors = columns * rows;
+  result.columns = columns;
+  result.rows = rows;
+  result.grid.assign(sectors, CLOUD_UNKNOWN);
+  result.clarity.assign(sectors, 0.0f);
+  result.sectorStars.assign(sectors, 0);
+  result.texture.assign(sectors, 0.0f);
+  result.sky.assign(sectors, 0.0f);
+
+  // 하늘 원 (반지름을 주지 않으면 프레임 중앙 내접원)
+  const bool explicitSky = options.skyRadius > 0.0f;
+  const float skyX = explicitSky ? options.skyX : width * 0.5f;
+  const float skyY = explicitSky ? options.skyY : height * 0.5f;
+  const float skyRadius = explicitSky ? options.skyRadius : std::min(width, height) * 0.5f;
+  auto skyDistance = [&](float x, float y) {
+    return options.skyMask ? std::hypot(x - skyX, y - skyY) : 0.0f;
+  };
+
+  auto sectorOf = [&](float x, float y) {
+    int sx = std::max(0, std::min(columns - 1, static_cast<int>(x * columns / width)));
+    int sy = std::max(0, std::min(rows - 1, static_cast<int>(y * rows / height)));
+    return sy * columns + sx;
+  };
+  for (const StarInfo &star : stars.stars) {
+    if (skyDistance(star.x, star.y) <= skyRadius) result.sectorStars[sectorOf(star.x, star.y)]++;
+  }
+
+  // 구역별 메시 칸 (칸 중심 기준). 하늘 비율은 중심이 원 안인 칸으로 세고, 평면 잔차에는 원 경계의
+  // 밝기 단차가 섞이지 않도록 칸 전체가 원 안인 칸만 씀
+  const float cellHalfDiagonal = stars.meshSize * 0.7072f;
+  std::vector<int> cellTotal(sectors, 0), cellSky(sectors, 0);
+  std::vector<std::vector<float>> cellX(sectors), cellY(sectors), cellBackground(sectors), cellRms(sectors);
+  for (int my = 0; my < stars.meshRows; my++) {
+    for (int mx = 0; mx < stars.meshColumns; mx++) {
+      float x = std::min((mx + 0.5f) * stars.meshSize, width - 1.0f);
+      float y = std::min((my + 0.5f) * stars.meshSize, height - 1.0f);
+      int s = sectorOf(x, y);
+      cellTotal[s]++;
+      const float distance = skyDistance(x, y);
+      if (distance > skyRadius) continue;
+      cellSky[s]++;
+      if (options.skyMask && distance + cellHalfDiagonal > skyRadius) continue;
+      size_t i = static_cast<size_t>(my) * stars.meshColumns + mx;
+      cellX[s].push_back(static_cast<float>(mx));
+      cellY[s].push_back(static_cast<float>(my));
+      cellBackground[s].push_back(stars.meshBackground[i]);
+      cellRms[s].push_back(stars.meshRms[i]);
+    }
+  }
+  for (int s = 0; s < sectors; s++) {
+    result.sky[s] = cellTotal[s] > 0 ? static_cast<float>(cellSky[s]) / cellTotal[s] : 0.0f;
+    std::vector<float> &rms = cellRms[s];
+    if (rms.empty()) continue;
+    std::nth_element(rms.begin(), rms.begin() + rms.size() / 2, rms.end());
+    result.texture[s] = SectorTexture(cellX[s], cellY[s], cellBackground[s], rms[rms.size() / 2]);
+  }
+
+  bool catalog = !options.expected.empty();
+  if (catalog && options.referenceWidth > 0 &&
+      (options.referenceWidth != width || options.referenceHeight != height)) {
+    LOG_WARN("구름 기준 프레임 크기(%dx%d)가 이미지(%dx%d)와 달라 분산 방식으로 계산합니다.",
+             options.referenceWidth, options.referenceHeight, width, height);
+    catalog = false;
+  }
+  result.catalog = catalog;
+
+  if (catalog) {
+    for (int s = 0; s < sectors; s++) {
+      const float expected = options.expected[s];
+      if (expected < CLOUD_MIN_EXPECTED || result.sky[s] < CLOUD_MIN_SKY_FRACTION) continue;
+      const float ratio = result.sectorStars[s] / expected;
+      result.clarity[s] = std::min(1.0f, ratio);
+      result.grid[s] = ratio >= CLOUD_CLEAR_RATIO ? CLOUD_CLEAR : CLOUD_CLOUDY;
+    }
+  } else {
+    // 하늘이 충분한 구역만, 하늘 비율로 나눈 별 밀도로 비교
+    // 프레임 안에서 별이 잘 보이는 구역(상위 25%)을 맑은 하늘 밀도로 봄
+    std::vector<float> density(sectors, 0.0f);
+    std::vector<float> densities;
+    for (int s = 0; s < sectors; s++) {
+      if (result.sky[s] < CLOUD_MIN_SKY_FRACTION) continue;
+      density[s] = result.sectorStars[s] / result.sky[s];
+      densities.push_back(density[s]);
+    }
+    if (!densities.empty()) {
+      std::sort(densities.begin(), densities.end());
+      const float reference = std::max(1.0f, densities[(densities.size() * 3) / 4]);
+      const float minStars = std::max(static_cast<float>(CLOUD_MIN_SECTOR_STARS),
+                                      static_cast<float>(CLOUD_DENSITY_RATIO * reference));
+      for (int s = 0; s < sectors; s++) {
+        if (result.sky[s] < CLOUD_MIN_SKY_FRACTION) continue;
+        float clarity = std::min(1.0f, density[s] / reference);
+        const float texture = result.texture[s];
+        if (texture > CLOUD_TEXTURE_LIMIT) clarity *= CLOUD_TEXTURE_LIMIT / texture;
+        result.clarity[s] = clarity;
+        result.grid[s] = (density[s] < minStars || texture > CLOUD_TEXTURE_LIMIT) ? CLOUD_CLOUDY : CLOUD_CLEAR;
+      }
+    }
+  }
+
+  int known = 0, cloudy = 0;
+  for (uint8_t cell : result.grid) {
+    if (cell == CLOUD_UNKNOWN) continue;
+    known++;
+    if (cell == CLOUD_CLOUDY) cloudy++;
+  }
+  result.cover = known > 0 ? 100.0 * cloudy / known : -1.0;
+  LOG_DEBUG("구름 지도 (%s, %dx%d): 흐림 %d / %d 구역 (%.0f%%)", catalog ? "기준" : "분산", columns, rows,
+            cloudy, known, result.cover);
+}
+
+Napi::Object CloudCoverResultToObject(Napi::Env env, const CloudCoverResult &result) {
+  Napi::Object obj = Napi::Object::New(env);
+  obj.Set("method", Napi::String::New(env, result.catalog ? "catalog" : "variance"));
+  obj.Set("columns", Napi::Number::New(env, result.columns));
+  obj.Set("rows", Napi::Number::New(env, result.rows));
+  obj.Set("cover", result.cover < 0 ? env.Null() : Napi::Number::New(env, result.cover));
+
+  Napi::Uint8Array grid = Napi::Uint8Array::New(env, result.grid.size());
+  std::copy(result.grid.begin(), result.grid.end(), grid.Data());
+  obj.Set("grid", grid);
+  Napi::Float32Array clarity = Napi::Float32Array::New(env, result.clarity.size());
+  std::copy(result.clarity.begin(), result.clarity.end(), clarity.Data());
+  obj.Set("clarity", clarity);
+  Napi::Int32Array stars = Napi::Int32Array::New(env, result.sectorStars.size());
+  std::copy(result.sectorStars.begin(), result.sectorStars.end(), stars.Data());
+  obj.Set("stars", stars);
+  Napi::Float32Array texture = Napi::Float32Array::New(env, result.texture.size());
+  std::copy(result.texture.begin(), result.texture.end(), texture.Data());
+  obj.Set("texture", texture);
+  Napi::Float32Array sky = Napi::Float32Array::New(env, result.sky.size());
+  std::copy(result.sky.begin(), result.sky.end(), sky.Data());
+  obj.Set("sky", sky);
+  return obj;
+}
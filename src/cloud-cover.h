@@ -0,0 +1,71 @@
+// cloud-cover.h
+// 별 검출 결과로 구하는 구름 지도
+// 프레임을 columns x rows 구역으로 나눠 구역마다 맑음/흐림을 정하고 흐린 구역 비율(%)을 낸다. 픽셀을 다시 읽지 않고
+// 별 검출 패스의 별 위치와 배경 메시만 쓴다.
+// - 기준(catalog) 모드: 구역별 기대 별 수(맑은 밤 프레임이나 카탈로그에서 만든 기준)에 대한 검출 별 수 비율
+// - 분산(variance) 모드: 기준이 없으면 프레임 안 밝은 구역 대비 별 밀도와, 구역 배경 메시에서 평면을 뺀 잔차(구름 무늬)로 판단
+// 어안 렌즈의 하늘 원 바깥(검은 모서리)은 별이 없어 흐림으로 세지 않도록 하늘 원 안 메시 칸만 쓰고,
+// 하늘이 거의 없는 구역은 모름으로 두어 비율에서 뺀다.
+#ifndef SX_CLOUD_COVER_H
+#define SX_CLOUD_COVER_H
+
+#include <napi.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "star-detect.h"
+
+#define CLOUD_DEFAULT_COLUMNS      8
+#define CLOUD_DEFAULT_ROWS         6
+#define CLOUD_MAX_GRID             64
+#define CLOUD_CLEAR_RATIO          0.4     // 기준 모드: 기대 별 수의 이 비율 이상 보이면 맑음
+#define CLOUD_MIN_EXPECTED         3.0     // 기준 모드: 기대 별 수가 이보다 적은 구역은 판단 안 함 (지평선/건물)
+#define CLOUD_DENSITY_RATIO        0.3     // 분산 모드: 별 수가 상위 25% 구역 대비 이 비율 미만이면 흐림
+#define CLOUD_MIN_SECTOR_STARS     2       // 분산 모드: 이보다 적으면 흐림 (전체가 흐린 프레임)
+#define CLOUD_TEXTURE_LIMIT        0.5     // 분산 모드: 메시 배경 평면 잔차가 픽셀 잡음의 이 배수를 넘으면 흐림
+#define CLOUD_MIN_TEXTURE_CELLS    4       // 평면 잔차를 계산할 최소 메시 칸 수
+#define CLOUD_MIN_SKY_FRACTION     0.25    // 구역 메시 칸 중 하늘 원 안 비율이 이보다 작으면 판단 안 함
+
+#define CLOUD_CLEAR                0
+#define CLOUD_CLOUDY               1
+#define CLOUD_UNKNOWN              255
+
+struct CloudCoverOptions {
+  bool enabled;
+  int columns;
+  int rows;
+  std::vector<float> expected;   // 구역별 기대 별 수 (비어 있으면 분산 모드)
+  int referenceWidth;            // 기준을 만든 프레임 크기 (0이면 확인 안 함)
+  int referenceHeight;
+  bool skyMask;                  // false면 프레임 전체를 하늘로 봄
+  float skyX;                    // 하늘 원 중심과 반지름 (분석하는 이미지 픽셀), 반지름 0이면 프레임 중앙 내접원
+  float skyY;
+  float skyRadius;
+};
+
+struct CloudCoverResult {
+  bool catalog;                  // 기준 모드로 계산했는지
+  int columns;
+  int rows;
+  double cover;                  // 흐린 구역 / 판단한 구역 (%), 판단한 구역이 없으면 -1
+  std::vector<uint8_t> grid;     // CLOUD_CLEAR | CLOUD_CLOUDY | CLOUD_UNKNOWN (행 우선)
+  std::vector<float> clarity;    // 0(흐림)~1(맑음)
+  std::vector<int> sectorStars;  // 구역별 검출 별 수
+  std::vector<float> texture;    // 구역별 배경 평면 잔차 (잡음 배수)
+  std::vector<float> sky;        // 구역별 하늘 원 안 메시 칸 비율 (0~1)
+};
+
+CloudCoverOptions CloudCoverDefaultOptions();
+
+// options.cloud: true | { columns, rows, reference: { columns, rows, width, height, expected: number[] },
+//                        sky: false | { x, y, radius } }
+bool CloudCoverOptionsFromValue(Napi::Value value, CloudCoverOptions &options, std::string &error);
+
+void CloudCoverAnalyze(const StarDetectResult &stars, int width, int height, const CloudCoverOptions &options,
+                       CloudCoverResult &result);
+
+// { method: 'catalog' | 'variance', columns, rows, cover, grid: Uint8Array, clarity: Float32Array, stars: Int32Array,
+//   texture: Float32Array, sky: Float32Array }
+Napi::Object CloudCoverResultToObject(Napi::Env env, const CloudCoverResult &result);
+
+#endif // SX_CLOUD_COVER_H
@@ -0,0 +1,240 @@
+// defect-map.cc
+#include "defect-map.h"
+#include "sx-log.h"
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+// 파일 형식 (little-endian): magic[8], 격자 수(uint32), 격자마다 { xBin, yBin, width, height, count (uint32), indices[count] (uint32) }
+
+DefectMap::DefectMap()
+  : threshold(DEFECT_DEFAULT_THRESHOLD_ADU),
+    learnFrames(DEFECT_DEFAULT_LEARN_FRAMES)
+{
+}
+
+static bool ReadU32(FILE *fp, uint32_t &value) {
+  return fread(&value, sizeof(value), 1, fp) == 1;
+}
+
+bool DefectMap::Load(const std::string &filePath, std::string &error) {
+  std::lock_guard<std::mutex> lock(mutex);
+  path = filePath;
+  grids.clear();
+  if (path.empty()) return true;
+
+  FILE *fp = fopen(path.c_str(), "rb");
+  if (!fp) {
+    if (errno == ENOENT) return true;  // 첫 학습 때 만듦
+    error = path + ": 결함 맵을 열 수 없습니다 (" + strerror(errno) + ")";
+    return false;
+  }
+
+  char magic[8];
+  uint32_t gridCount = 0;
+  bool ok = fread(magic, 1, sizeof(magic), fp) == sizeof(magic) && memcmp(magic, DEFECT_FILE_MAGIC, 8) == 0 &&
+            ReadU32(fp, gridCount);
+  for (uint32_t i = 0; ok && i < gridCount; i++) {
+    uint32_t xBin, yBin, width, height, count;
+    ok = ReadU32(fp, xBin) && ReadU32(fp, yBin) && ReadU32(fp, width) && ReadU32(fp, height) && ReadU32(fp, count) &&
+         count <= static_cast<uint64_t>(width) * height;
+    if (!ok) break;
+    Grid grid = Grid();
+    grid.width = static_cast<int>(width);
+    grid.height = static_cast<int>(height);
+    grid.indices.resize(count);
+    ok = fread(grid.indices.data(), sizeof(uint32_t), count, fp) == count &&
+         std::is_sorted(grid.indices.begin(), grid.indices.end()) &&
+         (count == 0 || grid.indices.back() < width * height);
+    if (ok) grids[Key(xBin, yBin)] = std::move(grid);
+  }
+  fclose(fp);
+
+  if (!ok) {
+    grids.clear();
+    error = path + ": 결함 맵 파일 형식이 올바르지 않습니다.";
+    return false;
+  }
+  for (const auto &entry : grids) {
+    LOG_INFO("결함 맵 %ux%u 비닝: %zu픽셀", static_cast<unsigned>(entry.first >> 32),
+             static_cast<unsigned>(entry.first & 0xFFFFFFFFu), entry.second.indices.size());
+  }
+  return true;
+}
+
+// 호출자가 mutex를 잡고 있어야 함. 임시 파일에 쓴 뒤 rename (쓰는 도중 죽어도 이전 맵 유지)
+bool DefectMap::Save(std::string &error) const {
+  std::string tmpPath = path + ".tmp";
+  FILE *fp = fopen(tmpPath.c_str(), "wb");
+  if (!fp) {
+    error = tmpPath + ": 결함 맵을 저장할 수 없습니다 (" + strerror(errno) + ")";
+    return false;
+  }
+  uint32_t gridCount = static_cast<uint32_t>(grids.size());
+  bool ok = fwrite(DEFECT_FILE_MAGIC, 1, 8, fp) == 8 && fwrite(&gridCount, sizeof(gridCount), 1, fp) == 1;
+  for (const auto &entry : grids) {
+    const Grid &grid = entry.second;
+    uint32_t fields[5] = {static_cast<uint32_t>(entry.first >> 32), static_cast<uint32_t>(entry.first & 0xFFFFFFFFu),
+                          static_cast<uint32_t>(grid.width), static_cast<uint32_t>(grid.height),
+                          static_cast<uint32_t>(grid.indices.size())};
+    ok = ok && fwrite(fields, sizeof(uint32_t), 5, fp) == 5 &&
+         fwrite(grid.indices.data(), sizeof(uint32_t), grid.indices.size(), fp) == grid.indices.size();
+  }
+  ok = fclose(fp) == 0 && ok;
+  if (!ok || rename(tmpPath.c_str(), path.c_str()) != 0) {
+    error = path + ": 결함 맵 저장 실패 (" + strerror(errno) + ")";
+    remove(tmpPath.c_str());
+    return false;
+  }
+  return true;
+}
+
+bool DefectMap::Learn(const uint16_t *pixels, const DefectFrame &frame, std::string &error) {
+  // 프레임마다 같은 픽셀을 봐야 비율을 셀 수 있으므로 전체 프레임만 학습
+  if (frame.x != 0 || frame.y != 0 || frame.width != frame.gridWidth || frame.height != frame.gridHeight ||
+      frame.rows < frame.height || frame.width < 3 || frame.height < 3) {
+    return false;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex);
+  const int w = frame.width;
+  const int h = frame.height;
+  Grid &grid = grids[Key(frame.xBin, frame.yBin)];
+  if (grid.width != w || grid.height != h) {
+    // 새 비닝이거나 다른 CCD: 이전 목록은 쓸 수 없음
+    grid = Grid();
+    grid.width = w;
+    grid.height = h;
+  }
+  if (grid.hits.size() != static_cast<size_t>(w) * h) {
+    grid.hits.assign(static_cast<size_t>(w) * h, 0);
+    grid.learned = 0;
+  }
+
+  // 핫: 4이웃 최댓값보다 threshold 이상 높고, 8이웃 최솟값 기준으로도 대부분이 한 픽셀에 몰림 (별은 이웃으로 퍼짐)
+  // 데드: 반대로 4이웃 최솟값보다 threshold 이상 낮고 주변이 고름. 가장자리 행/열은 이웃이 모자라 제외
+  const int limit = threshold;
+  for (int y = 1; y < h - 1; y++) {
+    const uint16_t *up = pixels + static_cast<size_t>(y - 1) * w;
+    const uint16_t *row = up + w;
+    const uint16_t *down = row + w;
+    uint16_t *hits = grid.hits.data() + static_cast<size_t>(y) * w;
+    for (int x = 1; x < w - 1; x++) {
+      const int v = row[x];
+      const int max4 = std::max(std::max<int>(up[x], down[x]), std::max<int>(row[x - 1], row[x + 1]));
+      const int min4 = std::min(std::min<int>(up[x], down[x]), std::min<int>(row[x - 1], row[x + 1]));
+      const int minDiag = std::min(std::min<int>(up[x - 1], up[x + 1]), std::min<int>(down[x - 1], down[x + 1]));
+      const int maxDiag = std::max(std::max<int>(up[x - 1], up[x + 1]), std::max<int>(down[x - 1], down[x + 1]));
+      const int hot = v - max4 > limit && (v - max4) > DEFECT_MIN_SHARPNESS * (v - std::min(min4, minDiag));
+      const int dead = min4 - v > limit && (min4 - v) > DEFECT_MIN_SHARPNESS * (std::max(max4, maxDiag) - v);
+      hits[x] += static_cast<uint16_t>(hot | dead);
+    }
+  }
+
+  if (++grid.learned < learnFrames) return false;
+
+  // 학습 한 번 완료: 대부분의 프레임에서 튄 픽셀을 결함으로 확정 (움직이는 별과 우주선은 걸러짐)
+  const uint16_t minHits = static_cast<uint16_t>(std::ceil(DEFECT_MIN_HIT_FRACTION * grid.learned));
+  std::vector<uint32_t> indices;
+  for (size_t i = 0; i < grid.hits.size(); i++) {
+    if (grid.hits[i] >= minHits) indices.push_back(static_cast<uint32_t>(i));
+  }
+  const int frames = grid.learned;
+  std::fill(grid.hits.begin(), grid.hits.end(), 0);
+  grid.learned = 0;
+
+  if (indices.size() > DEFECT_MAX_FRACTION * grid.hits.size()) {
+    LOG_WARN("결함 후보가 너무 많아 (%zu픽셀, %d프레임) 학습 결과를 버립니다. 임계값을 확인하세요.",
+             indices.size(), frames);
+    return false;
+  }
+  LOG_INFO("결함 맵 학습 완료 (%dx%d 비닝, %d프레임): %zu -> %zu픽셀",
+           frame.xBin, frame.yBin, frames, grid.indices.size(), indices.size());
+  grid.indices = std::move(indices);
+  if (!path.empty()) Save(error);
+  return true;
+}
+
+// 작은 배열 중앙값 (짝수 개면 가운데 두 값의 평균)
+static uint16_t SmallMedian(uint16_t *values, int count) {
+  std::sort(values, values + count);
+  return count % 2 ? values[count / 2]
+                   : static_cast<uint16_t>((values[count / 2 - 1] + values[count / 2] + 1) / 2);
+}
+
+int DefectMap::Correct(uint16_t *pixels, const DefectFrame &frame, uint32_t *histogram) const {
+  std::lock_guard<std::mutex> lock(mutex);
+  auto found = grids.find(Key(frame.xBin, frame.yBin));
+  if (found == grids.end() || frame.rows <= 0) return 0;
+  const Grid &grid = found->second;
+  if (grid.width != frame.gridWidth || grid.height != frame.gridHeight || grid.indices.empty()) return 0;
+
+  // 정렬된 목록에서 받은 행 범위에 드는 구간만 훑음
+  const std::vector<uint32_t> &indices = grid.indices;
+  const uint32_t gw = static_cast<uint32_t>(grid.width);
+  const uint32_t first = static_cast<uint32_t>(frame.y) * gw + frame.x;
+  const uint32_t last = static_cast<uint32_t>(frame.y + frame.rows - 1) * gw + frame.x + frame.width;
+  auto begin = std::lower_bound(indices.begin(), indices.end(), first);
+  auto end = std::lower_bound(begin, indices.end(), last);
+
+  int corrected = 0;
+  for (auto it = begin; it != end; ++it) {
+    const int x = static_cast<int>(*it % gw) - frame.x;
+    const int y = static_cast<int>(*it / gw) - frame.y;
+    if (x < 0 || x >= frame.width) continue;
+
+    // 결함이 아닌 이웃만 사용 (붙어 있는 결함끼리 서로를 퍼뜨리지 않도록)
+    uint16_t values[8];
+    int count = 0;
+    for (int dy = -1; dy <= 1; dy++) {
+      const int ny = y + dy;
+      if (ny < 0 || ny >= frame.rows) continue;
+      for (int dx = -1; dx <= 1; dx++) {
+        const int nx = x + dx;
+        if ((dx == 0 && dy == 0) || nx < 0 || nx >= frame.width) continue;
+        if (std::binary_search(indices.begin(), indices.end(), *it + dy * static_cast<int>(gw) + dx)) continue;
+        values[count++] = pixels[static_cast<size_t>(ny) * frame.width + nx];
+      }
+    }
+    if (count == 0) continue;
+
+    uint16_t &pixel = pixels[static_cast<size_t>(y) * frame.width + x];
+    const uint16_t replacement = SmallMedian(values, count);
+    if (histogram) {
+      histogram[pixel]--;
+      histogram[replacement]++;
+    }
+    pixel = replacement;
+    corrected++;
+  }
+  return corrected;
+}
+
+Napi::Object DefectMap::ToObject(Napi::Env env) const {
+  std::lock_guard<std::mutex> lock(mutex);
+  Napi::Object obj = Napi::Object::New(env);
+  obj.Set("path", path.empty() ? env.Null() : Napi::String::New(env, path));
+  obj.Set("threshold", Napi::Number::New(env, threshold));
+  obj.Set("learnFrames", Napi::Number::New(env, learnFrames));
+
+  Napi::Array list = Napi::Array::New(env, grids.size());
+  uint32_t i = 0;
+  for (const auto &entry : grids) {
+    const Grid &grid = entry.second;
+    Napi::Object g = Napi::Object::New(env);
+    g.Set("xBin", Napi::Number::New(env, static_cast<double>(entry.first >> 32)));
+    g.Set("yBin", Napi::Number::New(env, static_cast<double>(entry.first & 0xFFFFFFFFu)));
+    g.Set("width", Napi::Number::New(env, grid.width));
+    g.Set("height", Napi::Number::New(env, grid.height));
+    g.Set("count", Napi::Number::New(env, static_cast<double>(grid.indices.size())));
+    g.Set("learned", Napi::Number::New(env, grid.learned));
+    Napi::Uint32Array indices = Napi::Uint32Array::New(env, grid.indices.size());
+    if (!grid.indices.empty()) memcpy(indices.Data(), grid.indices.data(), grid.indices.size() * sizeof(uint32_t));
+    g.Set("indices", indices);
+    list.Set(i++, g);
+  }
+  obj.Set("grids", list);
+  return obj;
+}
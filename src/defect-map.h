@@ -0,0 +1,79 @@
+// defect-map.h
+// 핫/데드 픽셀 맵과 촬영 시 결함 픽셀 보정
+// 학습을 켜면 전체 프레임 촬영마다 주변 4픽셀보다 혼자 튀는 픽셀(별처럼 퍼지지 않은 한 점)을 세고,
+// DEFECT_DEFAULT_LEARN_FRAMES장마다 대부분의 프레임에서 튄 픽셀을 (비닝별) 정렬된 인덱스 목록으로 확정해 파일에 저장한다.
+// 보정은 변환 패스가 끝난 버퍼에서 목록에 있는 픽셀만 이웃 8픽셀의 중앙값으로 바꾸므로 프레임 크기와 무관하게
+// 결함 수에 비례하는 비용만 든다 (전체 프레임 중앙값 필터 대신).
+#ifndef SX_DEFECT_MAP_H
+#define SX_DEFECT_MAP_H
+
+#include <napi.h>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#define DEFECT_FILE_MAGIC              "SXDEF001"
+#define DEFECT_DEFAULT_THRESHOLD_ADU   300     // 주변 4픽셀 중 가장 가까운 값과의 최소 차이
+#define DEFECT_MIN_SHARPNESS           0.85    // (v - 4이웃 최대) / (v - 8이웃 최소): 별 중심은 약 0.6, 핫 픽셀은 약 1
+#define DEFECT_DEFAULT_LEARN_FRAMES    20      // 한 번의 학습에 쓰는 전체 프레임 수
+#define DEFECT_MIN_LEARN_FRAMES        5
+#define DEFECT_MAX_LEARN_FRAMES        1000
+#define DEFECT_MIN_HIT_FRACTION        0.6     // 학습 프레임 중 이 비율 이상에서 튀어야 결함으로 확정
+#define DEFECT_MAX_FRACTION            0.01    // 결함이 격자 픽셀의 1%를 넘으면 학습 결과를 버림 (빛이 들어온 프레임 등)
+
+// 보정/학습 대상 프레임 (비닝 후 격자 좌표, 격자는 CCD 전체를 같은 비닝으로 나눈 것)
+struct DefectFrame {
+  int x;                // 출력 첫 픽셀의 격자 좌표
+  int y;
+  int width;            // 출력 크기
+  int height;
+  int rows;             // 실제로 받은 행 수 (나머지는 0으로 채워져 보정/학습하지 않음)
+  int xBin;
+  int yBin;
+  int gridWidth;        // 격자 크기 (CCD 폭/높이 ÷ 비닝)
+  int gridHeight;
+};
+
+class DefectMap {
+public:
+  DefectMap();
+
+  // 파일에서 결함 목록을 읽음 (파일이 없으면 빈 맵, 이후 학습 결과를 이 경로에 저장). path가 비면 메모리에만 유지
+  bool Load(const std::string &path, std::string &error);
+  const std::string& Path() const { return path; }
+
+  void SetThreshold(int adu) { threshold = adu; }
+  void SetLearnFrames(int frames) { learnFrames = frames; }
+
+  // 전체 프레임 한 장을 학습에 누적. 학습 한 번이 끝나 목록이 바뀌면 true (파일 저장 실패는 error에)
+  bool Learn(const uint16_t *pixels, const DefectFrame &frame, std::string &error);
+
+  // 목록에 있는 픽셀을 이웃 중앙값으로 제자리 교체하고 교체한 수를 돌려줌
+  // histogram이 있으면 바뀐 값만큼 고쳐서 프레임 통계가 보정 후 영상과 맞게 함
+  int Correct(uint16_t *pixels, const DefectFrame &frame, uint32_t *histogram) const;
+
+  // { path, threshold, learnFrames, grids: [{ xBin, yBin, width, height, count, learned, indices }] }
+  Napi::Object ToObject(Napi::Env env) const;
+
+private:
+  struct Grid {
+    int width;
+    int height;
+    std::vector<uint32_t> indices;   // 결함 픽셀 (y * width + x), 오름차순
+    std::vector<uint16_t> hits;      // 학습 중 프레임별로 튄 횟수 (학습하지 않으면 비어 있음)
+    int learned;                     // 현재 학습에 누적한 프레임 수
+  };
+
+  static uint64_t Key(int xBin, int yBin) { return (static_cast<uint64_t>(xBin) << 32) | static_cast<uint32_t>(yBin); }
+  bool Save(std::string &error) const;
+
+  std::string path;
+  int threshold;
+  int learnFrames;
+  mutable std::mutex mutex;          // 워커 스레드(학습/보정)와 JS 스레드(ToObject)가 공유
+  std::map<uint64_t, Grid> grids;    // (xBin, yBin) -> 격자
+};
+
+#endif // SX_DEFECT_MAP_H
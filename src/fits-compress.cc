@@ -0,0 +1,376 @@
+// fits-compress.cc
+// RICE_1 타일 압축 FITS 쓰기 (CFITSIO fits_rcomp_short와 같은 비트스트림)
+#include "fits-compress.h"
+#include <cstdio>
+#include <cstring>
+#include <cerrno>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <algorithm>
+
+// ===== Rice 부호화 =====
+
+// MSB부터 채우는 비트 출력기
+class RiceBitWriter {
+public:
+  explicit RiceBitWriter(uint8_t *out) : out(out), pos(0), acc(0), nbits(0) {}
+
+  // value의 하위 n비트 기록 (n <= 32)
+  inline void Put(uint32_t value, int n) {
+    acc = (acc << n) | (n == 32 ? value : (value & ((1u << n) - 1)));
+    nbits += n;
+    while (nbits >= 8) {
+      nbits -= 8;
+      out[pos++] = static_cast<uint8_t>(acc >> nbits);
+    }
+    acc &= (1u << nbits) - 1;
+  }
+
+  // count개의 0 다음에 1 기록 (몫의 unary 부호)
+  inline void PutUnary(uint32_t count) {
+    while (count >= 32) {
+      Put(0, 32);
+      count -= 32;
+    }
+    Put(1, count + 1);
+  }
+
+  size_t Flush() {
+    if (nbits > 0) {
+      out[pos++] = static_cast<uint8_t>(acc << (8 - nbits));
+      nbits = 0;
+      acc = 0;
+    }
+    return pos;
+  }
+
+private:
+  uint8_t *out;
+  size_t pos;
+  uint64_t acc;
+  int nbits;
+};
+
+size_t RiceMaxEncodedBytes(size_t count, int blockSize) {
+  size_t blocks = (count + blockSize - 1) / blockSize;
+  // 첫 픽셀 16비트 + 블록마다 fs 코드 + 비압축 차분
+  return 2 + (blocks * RICE_FS_BITS_SHORT + count * RICE_BITS_SHORT + 7) / 8 + 1;
+}
+
+size_t RiceEncodeShort(const int16_t *pixels, size_t count, int blockSize, uint8_t *out) {
+  RiceBitWriter writer(out);
+  if (count == 0) return 0;
+
+  // 첫 픽셀은 그대로 기록하고 이후는 이전 픽셀과의 차분을 부호화
+  writer.Put(static_cast<uint16_t>(pixels[0]), RICE_BITS_SHORT);
+
+  uint32_t diff[256];
+  int16_t lastpix = pixels[0];
+
+  for (size_t i = 0; i < count; i += blockSize) {
+    int thisblock = static_cast<int>(std::min<size_t>(blockSize, count - i));
+
+    // 차분을 zigzag로 부호 없는 값으로 변환 (16비트 래핑)
+    uint64_t pixelsum = 0;
+    for (int j = 0; j < thisblock; j++) {
+      int16_t nextpix = pixels[i + j];
+      int16_t pdiff = static_cast<int16_t>(nextpix - lastpix);
+      diff[j] = static_cast<uint16_t>(pdiff < 0 ? ~(pdiff << 1) : (pdiff << 1));
+      pixelsum += diff[j];
+      lastpix = nextpix;
+    }
+
+    // 블록 평균 차분으로 분할 비트 수(fs) 결정
+    uint64_t bias = thisblock / 2 + 1;
+    uint32_t psum = pixelsum > bias ? static_cast<uint32_t>((pixelsum - bias) / thisblock) >> 1 : 0;
+    int fs = 0;
+    for (; psum > 0; fs++) psum >>= 1;
+
+    if (fs >= RICE_FS_MAX_SHORT) {
+      // 엔트로피가 높은 블록: 차분을 16비트 그대로 기록
+      writer.Put(RICE_FS_MAX_SHORT + 1, RICE_FS_BITS_SHORT);
+      for (int j = 0; j < thisblock; j++) writer.Put(diff[j], RICE_BITS_SHORT);
+    } else if (fs == 0 && pixelsum == 0) {
+      // 모든 차분이 0인 블록
+      writer.Put(0, RICE_FS_BITS_SHORT);
+    } else {
+      writer.Put(fs + 1, RICE_FS_BITS_SHORT);
+      for (int j = 0; j < thisblock; j++) {
+        writer.PutUnary(diff[j] >> fs);
+        if (fs > 0) writer.Put(diff[j], fs);
+      }
+    }
+  }
+
+  return writer.Flush();
+}
+
+// ===== 타일 압축 파일 쓰기 =====
+
+static void PutBigEndian32(uint8_t *p, uint32_t v) {
+  p[0] = static_cast<uint8_t>(v >> 24);
+  p[1] = static_cast<uint8_t>(v >> 16);
+  p[2] = static_cast<uint8_t>(v >> 8);
+  p[3] = static_cast<uint8_t>(v);
+}
+
+bool WriteFitsRiceUint16(const std::string &path, const uint16_t *data, int width, int height,
+                         const FitsHeader &extra, const FitsCompressOptions &options,
+                         FitsCompressResult &result, std::string &error) {
+  auto startTime = std::chrono::steady_clock::now();
+
+  const int tileWidth = options.tileWidth > 0 ? std::min(options.tileWidth, width) : width;
+  const int tileHeight = options.tileHeight > 0 ? std::min(options.tileHeight, height) : 1;
+  const int tilesX = (width + tileWidth - 1) / tileWidth;
+  const int tilesY = (height + tileHeight - 1) / tileHeight;
+  const int tileCount = tilesX * tilesY;
+
+  int threadCount = options.threads > 0 ? options.threads : static_cast<int>(std::thread::hardware_concurrency());
+  threadCount = std::max(1, std::min(threadCount, tileCount));
+
+  // 타일 단위로 작업을 나눠 스레드마다 다음 타일을 가져가 압축
+  std::vector<std::vector<uint8_t>> encoded(tileCount);
+  std::vector<uint16_t> threadMin(threadCount, 0xFFFF);
+  std::vector<uint16_t> threadMax(threadCount, 0);
+  std::atomic<int> nextTile(0);
+
+  auto worker = [&](int threadIndex) {
+    std::vector<int16_t> tile(static_cast<size_t>(tileWidth) * tileHeight);
+    uint16_t lo = 0xFFFF;
+    uint16_t hi = 0;
+
+    for (int t = nextTile.fetch_add(1); t < tileCount; t = nextTile.fetch_add(1)) {
+      int x0 = (t % tilesX) * tileWidth;
+      int y0 = (t / tilesX) * tileHeight;
+      int w = std::min(tileWidth, width - x0);
+      int h = std::min(tileHeight, height - y0);
+
+      // BZERO=32768 적용: uint16 -> int16 (부호 비트 반전)
+      size_t n = 0;
+      for (int y = y0; y < y0 + h; y++) {
+        const uint16_t *row = data + static_cast<size_t>(y) * width + x0;
+        for (int x = 0; x < w; x++) {
+          uint16_t v = row[x];
+          if (v < lo) lo = v;
+          if (v > hi) hi = v;
+          tile[n++] = static_cast<int16_t>(v ^ 0x8000);
+        }
+      }
+
+      std::vector<uint8_t> &out = encoded[t];
+      out.resize(RiceMaxEncodedBytes(n, RICE_BLOCK_SIZE));
+      out.resize(RiceEncodeShort(tile.data(), n, RICE_BLOCK_SIZE, out.data()));
+    }
+
+    threadMin[threadIndex] = lo;
+    threadMax[threadIndex] = hi;
+  };
+
+  std::vector<std::thread> threads;
+  for (int i = 1; i < threadCount; i++) threads.emplace_back(worker, i);
+  worker(0);
+  for (std::thread &th : threads) th.join();
+
+  auto compressedTime = std::chrono::steady_clock::now();
+
+  uint16_t minValue = *std::min_element(threadMin.begin(), threadMin.end());
+  uint16_t maxValue = *std::max_element(threadMax.begin(), threadMax.end());
+
+  // 기술자 테이블 (타일마다 [바이트 수, heap 오프셋], big-endian int32)
+  std::vector<uint8_t> table(static_cast<size_t>(tileCount) * 8);
+  size_t heapBytes = 0;
+  size_t maxTileBytes = 0;
+  for (int t = 0; t < tileCount; t++) {
+    PutBigEndian32(&table[t * 8], static_cast<uint32_t>(encoded[t].size()));
+    PutBigEndian32(&table[t * 8 + 4], static_cast<uint32_t>(heapBytes));
+    heapBytes += encoded[t].size();
+    maxTileBytes = std::max(maxTileBytes, encoded[t].size());
+  }
+  if (heapBytes > 0x7FFFFFFF) {
+    error = "압축 데이터가 FITS heap 크기 제한을 넘습니다.";
+    return false;
+  }
+
+  // 빈 primary HDU
+  FitsHeader primary;
+  primary.AddLogical("SIMPLE", true, "Standard FITS format");
+  primary.AddInt("BITPIX", 16, "16-bit signed integer");
+  primary.AddInt("NAXIS", 0, "No data in primary HDU");
+  primary.AddLogical("EXTEND", true, "Extensions are present");
+
+  // 압축 이미지 BINTABLE 확장
+  FitsHeader ext;
+  ext.AddString("XTENSION", "BINTABLE", "Binary table extension");
+  ext.AddInt("BITPIX", 8, "8-bit bytes");
+  ext.AddInt("NAXIS", 2, "2-dimensional binary table");
+  ext.AddInt("NAXIS1", 8, "Width of table in bytes");
+  ext.AddInt("NAXIS2", tileCount, "Number of rows (tiles)");
+  ext.AddInt("PCOUNT", static_cast<long long>(heapBytes), "Size of heap");
+  ext.AddInt("GCOUNT", 1, "One data group");
+  ext.AddInt("TFIELDS", 1, "Number of fields in each row");
+  ext.AddString("TTYPE1", "COMPRESSED_DATA", "Label for field 1");
+  ext.AddString("TFORM1", "1PB(" + std::to_string(maxTileBytes) + ")", "Data format of field");
+  ext.AddLogical("ZIMAGE", true, "Extension contains compressed image");
+  ext.AddLogical("ZSIMPLE", true, "Image conforms to FITS standard");
+  ext.AddInt("ZBITPIX", 16, "Data type of original image");
+  ext.AddInt("ZNAXIS", 2, "Dimension of original image");
+  ext.AddInt("ZNAXIS1", width, "Length of original image axis");
+  ext.AddInt("ZNAXIS2", height, "Length of original image axis");
+  ext.AddInt("ZTILE1", tileWidth, "Size of tiles to be compressed");
+  ext.AddInt("ZTILE2", tileHeight, "Size of tiles to be compressed");
+  ext.AddString("ZCMPTYPE", "RICE_1", "Compression algorithm");
+  ext.AddString("ZNAME1", "BLOCKSIZE", "Compression block size");
+  ext.AddInt("ZVAL1", RICE_BLOCK_SIZE, "Pixels per block");
+  ext.AddString("ZNAME2", "BYTEPIX", "Bytes per pixel");
+  ext.AddInt("ZVAL2", 2, "Bytes per pixel");
+  ext.AddString("EXTNAME", "COMPRESSED_IMAGE", "Name of this HDU");
+  ext.AddInt("BZERO", 32768, "Offset for unsigned 16-bit data");
+  ext.AddInt("BSCALE", 1, "Data scaling factor");
+  ext.AddInt("DATAMIN", minValue, "Minimum pixel value");
+  ext.AddInt("DATAMAX", maxValue, "Maximum pixel value");
+  ext.Append(extra);
+
+  std::string primaryBytes = primary.Serialize();
+  std::string extBytes = ext.Serialize();
+
+  FILE *fp = fopen(path.c_str(), "wb");
+  if (!fp) {
+    error = "FITS 파일을 열 수 없습니다: " + path + " (" + strerror(errno) + ")";
+    return false;
+  }
+
+  bool ok = fwrite(primaryBytes.data(), 1, primaryBytes.size(), fp) == primaryBytes.size() &&
+            fwrite(extBytes.data(), 1, extBytes.size(), fp) == extBytes.size() &&
+            fwrite(table.data(), 1, table.size(), fp) == table.size();
+  for (int t = 0; ok && t < tileCount; t++) {
+    ok = fwrite(encoded[t].data(), 1, encoded[t].size(), fp) == encoded[t].size();
+  }
+
+  // 테이블 + heap을 2880 바이트 배수로 패딩
+  size_t dataBytes = table.size() + heapBytes;
+  size_t padding = (FITS_BLOCK_SIZE - dataBytes % FITS_BLOCK_SIZE) % FITS_BLOCK_SIZE;
+  if (ok && padding > 0) {
+    std::vector<uint8_t> zeros(padding, 0);
+    ok = fwrite(zeros.data(), 1, padding, fp) == padding;
+  }
+
+  if (fclose(fp) != 0) ok = false;
+  if (!ok) {
+    error = "FITS 파일 기록 실패: " + path + " (" + strerror(errno) + ")";
+    return false;
+  }
+
+  auto endTime = std::chrono::steady_clock::now();
+  result.rawBytes = static_cast<size_t>(width) * height * 2;
+  result.compressedBytes = heapBytes;
+  result.fileBytes = primaryBytes.size() + extBytes.size() + dataBytes + padding;
+  result.tiles = tileCount;
+  result.threads = threadCount;
+  result.compressMs = std::chrono::duration<double, std::milli>(compressedTime - startTime).count();
+  result.totalMs = std::chrono::duration<double, std::milli>(endTime - startTime).count();
+  return true;
+}
+
+// ===== N-API 바인딩 =====
+
+class FitsCompressWorker : public Napi::AsyncWorker {
+public:
+  FitsCompressWorker(Napi::Env env, Napi::Object dataObj, const uint16_t *data, int width, int height,
+                     const std::string &path, const FitsHeader &header, const FitsCompressOptions &options)
+    : Napi::AsyncWorker(env, "SXFitsCompress"),
+      deferred(Napi::Promise::Deferred::New(env)),
+      data(data), width(width), height(height), path(path), header(header), options(options), result() {
+    // 압축이 끝날 때까지 픽셀 버퍼가 GC되지 않도록 참조 유지
+    dataRef = Napi::Persistent(dataObj);
+  }
+
+  Napi::Promise GetPromise() const { return deferred.Promise(); }
+
+protected:
+  void Execute() override {
+    std::string error;
+    if (!WriteFitsRiceUint16(path, data, width, height, header, options, result, error)) {
+      SetError(error);
+    }
+  }
+
+  void OnOK() override {
+    Napi::Env env = Env();
+    Napi::Object obj = Napi::Object::New(env);
+    obj.Set("path", Napi::String::New(env, path));
+    obj.Set("rawBytes", Napi::Number::New(env, static_cast<double>(result.rawBytes)));
+    obj.Set("compressedBytes", Napi::Number::New(env, static_cast<double>(result.compressedBytes)));
+    obj.Set("fileBytes", Napi::Number::New(env, static_cast<double>(result.fileBytes)));
+    obj.Set("ratio", Napi::Number::New(env, result.compressedBytes > 0 ?
+                                       static_cast<double>(result.rawBytes) / result.compressedBytes : 0.0));
+    obj.Set("tiles", Napi::Number::New(env, result.tiles));
+    obj.Set("threads", Napi::Number::New(env, result.threads));
+    obj.Set("compressMs", Napi::Number::New(env, result.compressMs));
+    obj.Set("totalMs", Napi::Number::New(env, result.totalMs));
+    deferred.Resolve(obj);
+  }
+
+  void OnError(const Napi::Error &error) override {
+    deferred.Reject(error.Value());
+  }
+
+private:
+  Napi::Promise::Deferred deferred;
+  Napi::ObjectReference dataRef;
+  const uint16_t *data;
+  int width;
+  int height;
+  std::string path;
+  FitsHeader header;
+  FitsCompressOptions options;
+  FitsCompressResult result;
+};
+
+// writeFitsCompressed(image, path, headers, { tileWidth, tileHeight, threads }) -> Promise<Object>
+static Napi::Value WriteFitsCompressed(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  Napi::Promise::Deferred deferred = Napi::Promise::Deferred::New(env);
+
+  if (info.Length() < 2 || !info[1].IsString()) {
+    deferred.Reject(Napi::TypeError::New(env, "writeFitsCompressed(image, path, headers, options) 형식으로 호출해야 합니다.").Value());
+    return deferred.Promise();
+  }
+
+  Napi::Uint16Array pixels;
+  int width, height;
+  std::string error;
+  if (!ParseFitsImageArg(info[0], pixels, width, height, error)) {
+    deferred.Reject(Napi::TypeError::New(env, error).Value());
+    return deferred.Promise();
+  }
+
+  FitsHeader header;
+  if (!ParseFitsHeaderCards(info.Length() >= 3 ? info[2] : env.Undefined(), header, error)) {
+    deferred.Reject(Napi::TypeError::New(env, error).Value());
+    return deferred.Promise();
+  }
+
+  FitsCompressOptions options = { 0, 0, 0 };
+  if (info.Length() >= 4 && info[3].IsObject()) {
+    Napi::Object opts = info[3].As<Napi::Object>();
+    if (opts.Get("tileWidth").IsNumber()) options.tileWidth = opts.Get("tileWidth").As<Napi::Number>().Int32Value();
+    if (opts.Get("tileHeight").IsNumber()) options.tileHeight = opts.Get("tileHeight").As<Napi::Number>().Int32Value();
+    if (opts.Get("threads").IsNumber()) options.threads = opts.Get("threads").As<Napi::Number>().Int32Value();
+  }
+  if (options.tileWidth < 0 || options.tileHeight < 0 || options.threads < 0) {
+    deferred.Reject(Napi::RangeError::New(env, "tileWidth/tileHeight/threads는 0 이상이어야 합니다.").Value());
+    return deferred.Promise();
+  }
+
+  FitsCompressWorker *worker = new FitsCompressWorker(env, pixels, pixels.Data(), width, height,
+                                                      info[1].As<Napi::String>().Utf8Value(), header, options);
+  Napi::Promise promise = worker->GetPromise();
+  worker->Queue();
+  return promise;
+}
+
+Napi::Object InitFitsCompress(Napi::Env env, Napi::Object exports) {
+  exports.Set("writeFitsCompressed", Napi::Function::New(env, WriteFitsCompressed, "writeFitsCompressed"));
+  return exports;
+}
@@ -0,0 +1,49 @@
+// fits-compress.h
+// FITS 타일 압축 (Tiled Image Compression Convention, RICE_1) 쓰기
+// 이미지를 타일로 나눠 타일마다 Rice 부호화 후 BINTABLE 확장의 가변 길이 배열(heap)에 저장
+// astropy / fpack / funpack 으로 읽을 수 있는 표준 ZIMAGE 파일을 만든다.
+#ifndef SX_FITS_COMPRESS_H
+#define SX_FITS_COMPRESS_H
+
+#include <napi.h>
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "fits-writer.h"
+
+#define RICE_BLOCK_SIZE        32      // Rice 블록 당 픽셀 수 (ZVAL1, fpack 기본값)
+#define RICE_FS_BITS_SHORT     4       // 16비트 데이터의 fs 코드 비트 수
+#define RICE_FS_MAX_SHORT      14      // 이 이상이면 차분을 압축 없이 그대로 기록
+#define RICE_BITS_SHORT        16
+
+struct FitsCompressOptions {
+  int tileWidth;    // 0이면 이미지 폭 (fpack 기본: 한 행씩)
+  int tileHeight;   // 0이면 1
+  int threads;      // 0이면 하드웨어 스레드 수
+};
+
+struct FitsCompressResult {
+  size_t rawBytes;          // 압축 전 픽셀 데이터 크기
+  size_t compressedBytes;   // heap에 기록된 압축 데이터 크기
+  size_t fileBytes;         // 파일 전체 크기
+  int tiles;
+  int threads;
+  double compressMs;        // 타일 압축에 걸린 시간
+  double totalMs;           // 파일 기록까지 포함한 시간
+};
+
+// int16 픽셀을 Rice 부호화. out은 RiceMaxEncodedBytes(count) 이상이어야 하며 기록한 바이트 수 반환
+size_t RiceEncodeShort(const int16_t *pixels, size_t count, int blockSize, uint8_t *out);
+
+// 최악의 경우(모든 블록이 비압축)에 필요한 출력 버퍼 크기
+size_t RiceMaxEncodedBytes(size_t count, int blockSize);
+
+// uint16 이미지를 RICE_1 타일 압축 FITS로 기록 (BZERO=32768로 무손실)
+bool WriteFitsRiceUint16(const std::string &path, const uint16_t *data, int width, int height,
+                         const FitsHeader &extra, const FitsCompressOptions &options,
+                         FitsCompressResult &result, std::string &error);
+
+Napi::Object InitFitsCompress(Napi::Env env, Napi::Object exports);
+
+#endif // SX_FITS_COMPRESS_H
@@ -0,0 +1,483 @@
+// fits-writer.cc
+// 네이티브 FITS 쓰기: uint16 픽셀을 BITPIX=16/BZERO=32768로 (float 픽셀은 BITPIX=-32로) 변환해 블록 단위로 스트리밍 기록
+#include "fits-writer.h"
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+// ===== 헤더 카드 =====
+
+std::string FitsHeader::FormatCard(const std::string &key, const std::string &value, const std::string &comment) {
+  std::string card = key.substr(0, 8);
+  card.resize(8, ' ');
+  if (!value.empty()) {
+    card += "= " + value;
+  }
+  if (!comment.empty()) {
+    card += " / " + comment;
+  }
+  card.resize(FITS_CARD_SIZE, ' ');
+  return card;
+}
+
+std::string FitsHeader::FormatInt(long long value) {
+  char buf[32];
+  snprintf(buf, sizeof(buf), "%20lld", value);
+  return buf;
+}
+
+std::string FitsHeader::FormatFloat(double value) {
+  char buf[32];
+  snprintf(buf, sizeof(buf), "%.10G", value);
+  std::string s = buf;
+  // 정수처럼 보이면 실수임을 알 수 있도록 소수점 추가
+  if (s.find_first_of(".EN") == std::string::npos) s += ".0";
+  snprintf(buf, sizeof(buf), "%20s", s.c_str());
+  return buf;
+}
+
+void FitsHeader::AddLogical(const std::string &key, bool value, const std::string &comment) {
+  char buf[32];
+  snprintf(buf, sizeof(buf), "%20s", value ? "T" : "F");
+  cards.push_back(FormatCard(key, buf, comment));
+}
+
+void FitsHeader::AddInt(const std::string &key, long long value, const std::string &comment) {
+  cards.push_back(FormatCard(key, FormatInt(value), comment));
+}
+
+void FitsHeader::AddFloat(const std::string &key, double value, const std::string &comment) {
+  cards.push_back(FormatCard(key, FormatFloat(value), comment));
+}
+
+void FitsHeader::AddString(const std::string &key, const std::string &value, const std::string &comment) {
+  // 작은따옴표는 두 번 써서 이스케이프, 최소 8자까지 패딩
+  std::string escaped;
+  for (char c : value) {
+    escaped += c;
+    if (c == '\'') escaped += '\'';
+  }
+  if (escaped.size() > 68) escaped.resize(68);
+  if (escaped.size() < 8) escaped.resize(8, ' ');
+  cards.push_back(FormatCard(key, "'" + escaped + "'", comment));
+}
+
+void FitsHeader::AddRaw(const std::string &card) {
+  std::string c = card;
+  c.resize(FITS_CARD_SIZE, ' ');
+  cards.push_back(c);
+}
+
+void FitsHeader::Append(const FitsHeader &other) {
+  cards.insert(cards.end(), other.cards.begin(), other.cards.end());
+}
+
+void FitsHeader::SetInt(const std::string &key, long long value, const std::string &comment) {
+  long offset = CardOffset(key);
+  if (offset < 0) {
+    AddInt(key, value, comment);
+  } else {
+    cards[offset / FITS_CARD_SIZE] = FormatCard(key, FormatInt(value), comment);
+  }
+}
+
+long FitsHeader::CardOffset(const std::string &key) const {
+  std::string padded = key.substr(0, 8);
+  padded.resize(8, ' ');
+  for (size_t i = 0; i < cards.size(); i++) {
+    if (cards[i].compare(0, 8, padded) == 0) return static_cast<long>(i * FITS_CARD_SIZE);
+  }
+  return -1;
+}
+
+std::string FitsHeader::Serialize() const {
+  std::string out;
+  out.reserve((cards.size() + 1) * FITS_CARD_SIZE + FITS_BLOCK_SIZE);
+  for (const std::string &c : cards) out += c;
+  out += FormatCard("END", "", "");
+  size_t padded = (out.size() + FITS_BLOCK_SIZE - 1) / FITS_BLOCK_SIZE * FITS_BLOCK_SIZE;
+  out.resize(padded, ' ');
+  return out;
+}
+
+// ===== 픽셀 변환 =====
+
+void FitsConvertUint16(const uint16_t *src, uint8_t *dst, size_t count, uint16_t &minValue, uint16_t &maxValue) {
+  size_t i = 0;
+  uint16_t lo = minValue;
+  uint16_t hi = maxValue;
+
+#if defined(__SSE2__)
+  // SSE2에는 unsigned 16비트 min/max가 없으므로 부호 비트를 뒤집은 값(= value - 32768)으로 비교
+  const __m128i bias = _mm_set1_epi16(static_cast<short>(0x8000));
+  __m128i vmin = _mm_set1_epi16(static_cast<short>(lo ^ 0x8000));
+  __m128i vmax = _mm_set1_epi16(static_cast<short>(hi ^ 0x8000));
+  for (; i + 8 <= count; i += 8) {
+    __m128i v = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i)), bias);
+    vmin = _mm_min_epi16(vmin, v);
+    vmax = _mm_max_epi16(vmax, v);
+    __m128i swapped = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 2), swapped);
+  }
+  int16_t mins[8], maxs[8];
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(mins), vmin);
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(maxs), vmax);
+  for (int k = 0; k < 8; k++) {
+    lo = std::min<uint16_t>(lo, static_cast<uint16_t>(mins[k]) ^ 0x8000);
+    hi = std::max<uint16_t>(hi, static_cast<uint16_t>(maxs[k]) ^ 0x8000);
+  }
+#elif defined(__ARM_NEON)
+  const uint16x8_t bias = vdupq_n_u16(0x8000);
+  uint16x8_t vmin = vdupq_n_u16(lo);
+  uint16x8_t vmax = vdupq_n_u16(hi);
+  for (; i + 8 <= count; i += 8) {
+    uint16x8_t v = vld1q_u16(src + i);
+    vmin = vminq_u16(vmin, v);
+    vmax = vmaxq_u16(vmax, v);
+    uint8x16_t swapped = vrev16q_u8(vreinterpretq_u8_u16(veorq_u16(v, bias)));
+    vst1q_u8(dst + i * 2, swapped);
+  }
+  uint16_t mins[8], maxs[8];
+  vst1q_u16(mins, vmin);
+  vst1q_u16(maxs, vmax);
+  for (int k = 0; k < 8; k++) {
+    lo = std::min(lo, mins[k]);
+    hi = std::max(hi, maxs[k]);
+  }
+#endif
+
+  // 나머지 (또는 SIMD가 없는 경우 전체)
+  for (; i < count; i++) {
+    uint16_t v = src[i];
+    if (v < lo) lo = v;
+    if (v > hi) hi = v;
+    uint16_t s = v ^ 0x8000;
+    dst[i * 2] = static_cast<uint8_t>(s >> 8);
+    dst[i * 2 + 1] = static_cast<uint8_t>(s & 0xFF);
+  }
+
+  minValue = lo;
+  maxValue = hi;
+}
+
+// ===== 파일 쓰기 =====
+
+bool WriteFitsUint16(const std::string &path, const uint16_t *data, int width, int height,
+                     const FitsHeader &extra, std::string &error) {
+  FitsHeader header;
+  header.AddLogical("SIMPLE", true, "Standard FITS format");
+  header.AddInt("BITPIX", 16, "16-bit signed integer");
+  header.AddInt("NAXIS", 2, "Number of data axes");
+  header.AddInt("NAXIS1", width, "Width in pixels");
+  header.AddInt("NAXIS2", height, "Height in pixels");
+  header.AddInt("BZERO", 32768, "Offset for unsigned 16-bit data");
+  header.AddInt("BSCALE", 1, "Data scaling factor");
+  header.AddInt("DATAMIN", 0, "Minimum pixel value");
+  header.AddInt("DATAMAX", 0, "Maximum pixel value");
+  header.Append(extra);
+
+  long minOffset = header.CardOffset("DATAMIN");
+  long maxOffset = header.CardOffset("DATAMAX");
+  std::string headerBytes = header.Serialize();
+
+  FILE *fp = fopen(path.c_str(), "wb");
+  if (!fp) {
+    error = "FITS 파일을 열 수 없습니다: " + path + " (" + strerror(errno) + ")";
+    return false;
+  }
+
+  bool ok = fwrite(headerBytes.data(), 1, headerBytes.size(), fp) == headerBytes.size();
+
+  // 블록 단위로 변환해서 바로 기록 (전체 파일을 메모리에 만들지 않음)
+  const size_t pixelCount = static_cast<size_t>(width) * height;
+  const size_t chunkPixels = FITS_BLOCK_SIZE * FITS_WRITE_CHUNK_BLOCKS / 2;
+  std::vector<uint8_t> chunk(chunkPixels * 2);
+  uint16_t minValue = 0xFFFF;
+  uint16_t maxValue = 0;
+
+  for (size_t offset = 0; ok && offset < pixelCount; offset += chunkPixels) {
+    size_t n = std::min(chunkPixels, pixelCount - offset);
+    FitsConvertUint16(data + offset, chunk.data(), n, minValue, maxValue);
+    ok = fwrite(chunk.data(), 1, n * 2, fp) == n * 2;
+  }
+
+  // 데이터 영역을 2880 바이트 배수로 패딩
+  size_t dataBytes = pixelCount * 2;
+  size_t padding = (FITS_BLOCK_SIZE - dataBytes % FITS_BLOCK_SIZE) % FITS_BLOCK_SIZE;
+  if (ok && padding > 0) {
+    std::memset(chunk.data(), 0, padding);
+    ok = fwrite(chunk.data(), 1, padding, fp) == padding;
+  }
+
+  // 같은 패스에서 구한 DATAMIN/DATAMAX를 헤더 자리에 다시 기록
+  if (ok && pixelCount > 0) {
+    std::string minCard = FitsHeader::FormatCard("DATAMIN", FitsHeader::FormatInt(minValue), "Minimum pixel value");
+    std::string maxCard = FitsHeader::FormatCard("DATAMAX", FitsHeader::FormatInt(maxValue), "Maximum pixel value");
+    ok = fseek(fp, minOffset, SEEK_SET) == 0 && fwrite(minCard.data(), 1, FITS_CARD_SIZE, fp) == FITS_CARD_SIZE &&
+         fseek(fp, maxOffset, SEEK_SET) == 0 && fwrite(maxCard.data(), 1, FITS_CARD_SIZE, fp) == FITS_CARD_SIZE;
+  }
+
+  if (fclose(fp) != 0) ok = false;
+  if (!ok) {
+    error = "FITS 파일 기록 실패: " + path + " (" + strerror(errno) + ")";
+    return false;
+  }
+  return true;
+}
+
+bool WriteFitsFloat32(const std::string &path, const float *data, int width, int height,
+                      const FitsHeader &extra, std::string &error) {
+  FitsHeader header;
+  header.AddLogical("SIMPLE", true, "Standard FITS format");
+  header.AddInt("BITPIX", -32, "32-bit floating point");
+  header.AddInt("NAXIS", 2, "Number of data axes");
+  header.AddInt("NAXIS1", width, "Width in pixels");
+  header.AddInt("NAXIS2", height, "Height in pixels");
+  header.AddFloat("DATAMIN", 0.0, "Minimum pixel value");
+  header.AddFloat("DATAMAX", 0.0, "Maximum pixel value");
+  header.Append(extra);
+
+  long minOffset = header.CardOffset("DATAMIN");
+  long maxOffset = header.CardOffset("DATAMAX");
+  std::string headerBytes = header.Serialize();
+
+  FILE *fp = fopen(path.c_str(), "wb");
+  if (!fp) {
+    error = "FITS 파일을 열 수 없습니다: " + path + " (" + strerror(errno) + ")";
+    return false;
+  }
+
+  bool ok = fwrite(headerBytes.data(), 1, headerBytes.size(), fp) == headerBytes.size();
+
+  const size_t pixelCount = static_cast<size_t>(width) * height;
+  const size_t chunkPixels = FITS_BLOCK_SIZE * FITS_WRITE_CHUNK_BLOCKS / 4;
+  std::vector<uint32_t> chunk(chunkPixels);
+  float minValue = pixelCount > 0 ? data[0] : 0.0f;
+  float maxValue = minValue;
+
+  for (size_t offset = 0; ok && offset < pixelCount; offset += chunkPixels) {
+    size_t n = std::min(chunkPixels, pixelCount - offset);
+    for (size_t i = 0; i < n; i++) {
+      float v = data[offset + i];
+      minValue = std::min(minValue, v);
+      maxValue = std::max(maxValue, v);
+      uint32_t bits;
+      std::memcpy(&bits, &v, sizeof(bits));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+      chunk[i] = bits;
+#else
+      chunk[i] = __builtin_bswap32(bits);  // FITS는 빅엔디언
+#endif
+    }
+    ok = fwrite(chunk.data(), 4, n, fp) == n;
+  }
+
+  size_t dataBytes = pixelCount * 4;
+  size_t padding = (FITS_BLOCK_SIZE - dataBytes % FITS_BLOCK_SIZE) % FITS_BLOCK_SIZE;
+  if (ok && padding > 0) {
+    std::memset(chunk.data(), 0, padding);
+    ok = fwrite(chunk.data(), 1, padding, fp) == padding;
+  }
+
+  if (ok && pixelCount > 0) {
+    std::string minCard = FitsHeader::FormatCard("DATAMIN", FitsHeader::FormatFloat(minValue), "Minimum pixel value");
+    std::string maxCard = FitsHeader::FormatCard("DATAMAX", FitsHeader::FormatFloat(maxValue), "Maximum pixel value");
+    ok = fseek(fp, minOffset, SEEK_SET) == 0 && fwrite(minCard.data(), 1, FITS_CARD_SIZE, fp) == FITS_CARD_SIZE &&
+         fseek(fp, maxOffset, SEEK_SET) == 0 && fwrite(maxCard.data(), 1, FITS_CARD_SIZE, fp) == FITS_CARD_SIZE;
+  }
+
+  if (fclose(fp) != 0) ok = false;
+  if (!ok) {
+    error = "FITS 파일 기록 실패: " + path + " (" + strerror(errno) + ")";
+    return false;
+  }
+  return true;
+}
+
+// ===== N-API 바인딩 =====
+
+bool ParseFitsHeaderCards(const Napi::Value &value, FitsHeader &header, std::string &error) {
+  if (value.IsUndefined() || value.IsNull()) return true;
+  if (!value.IsArray()) {
+    error = "headers는 [{ key, value, comment }] 배열이어야 합니다.";
+    return false;
+  }
+
+  // 필수 카드는 writer가 직접 기록
+  static const char *reserved[] = {"SIMPLE", "BITPIX", "NAXIS", "NAXIS1", "NAXIS2", "BZERO", "BSCALE",
+                                   "DATAMIN", "DATAMAX", "END", "EXTEND", "XTENSION", "PCOUNT", "GCOUNT"};
+
+  Napi::Array cards = value.As<Napi::Array>();
+  for (uint32_t i = 0; i < cards.Length(); i++) {
+    Napi::Value item = cards.Get(i);
+    if (!item.IsObject()) continue;
+    Napi::Object card = item.As<Napi::Object>();
+    if (!card.Get("key").IsString()) continue;
+
+    std::string key = card.Get("key").As<Napi::String>().Utf8Value();
+    std::transform(key.begin(), key.end(), key.begin(), ::toupper);
+    // FITS 키워드는 8자 이하의 A-Z, 0-9, '-', '_' (잘라서 쓰면 다른 카드와 겹칠 수 있음)
+    if (key.empty() || key.size() > 8 ||
+        key.find_first_not_of("ABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789-_") != std::string::npos) {
+      error = "FITS 헤더 키워드는 8자 이하의 영문 대문자/숫자/'-'/'_'여야 합니다: " + key;
+      return false;
+    }
+    bool skip = false;
+    for (const char *r : reserved) {
+      if (key == r) skip = true;
+    }
+    if (skip) continue;
+
+    std::string comment = card.Get("comment").IsString() ? card.Get("comment").As<Napi::String>().Utf8Value() : "";
+    Napi::Value v = card.Get("value");
+    if (v.IsBoolean()) {
+      header.AddLogical(key, v.As<Napi::Boolean>().Value(), comment);
+    } else if (v.IsNumber()) {
+      double d = v.As<Napi::Number>().DoubleValue();
+      if (!std::isfinite(d)) {
+        error = "FITS 헤더 값은 유한한 숫자여야 합니다: " + key;
+        return false;
+      }
+      if (std::floor(d) == d && std::fabs(d) < 1e15) {
+        header.AddInt(key, static_cast<long long>(d), comment);
+      } else {
+        header.AddFloat(key, d, comment);
+      }
+    } else if (v.IsString()) {
+      header.AddString(key, v.As<Napi::String>().Utf8Value(), comment);
+    } else if (key == "COMMENT" || key == "HISTORY") {
+      header.AddRaw(FitsHeader::FormatCard(key, "", "").substr(0, 8) + comment);
+    }
+  }
+  return true;
+}
+
+bool ParseFitsImageArg(const Napi::Value &value, Napi::Uint16Array &pixels, int &width, int &height, std::string &error) {
+  if (!value.IsObject()) {
+    error = "유효한 이미지 데이터가 아닙니다.";
+    return false;
+  }
+
+  Napi::Object image = value.As<Napi::Object>();
+  if (!image.Get("data").IsTypedArray() || !image.Get("width").IsNumber() || !image.Get("height").IsNumber()) {
+    error = "유효한 이미지 데이터가 아닙니다.";
+    return false;
+  }
+
+  Napi::TypedArray typed = image.Get("data").As<Napi::TypedArray>();
+  width = image.Get("width").As<Napi::Number>().Int32Value();
+  height = image.Get("height").As<Napi::Number>().Int32Value();
+  if (typed.TypedArrayType() != napi_uint16_array || width <= 0 || height <= 0 ||
+      typed.ElementLength() < static_cast<size_t>(width) * height) {
+    error = "이미지 데이터는 width*height 크기의 Uint16Array여야 합니다.";
+    return false;
+  }
+  pixels = typed.As<Napi::Uint16Array>();
+  return true;
+}
+
+// 디스크 기록을 워커 스레드에서 수행 (SD 카드 쓰기가 이벤트 루프를 막지 않도록)
+// data와 floatData 중 하나만 주어짐 (floatData면 BITPIX=-32)
+class FitsWriteWorker : public Napi::AsyncWorker {
+public:
+  FitsWriteWorker(Napi::Env env, Napi::Object dataObj, const uint16_t *data, const float *floatData,
+                  int width, int height, const std::string &path, const FitsHeader &header)
+    : Napi::AsyncWorker(env, "SXFitsWrite"),
+      deferred(Napi::Promise::Deferred::New(env)),
+      data(data), floatData(floatData), width(width), height(height), path(path), header(header) {
+    // 기록이 끝날 때까지 픽셀 버퍼가 GC되지 않도록 참조 유지
+    dataRef = Napi::Persistent(dataObj);
+  }
+
+  Napi::Promise GetPromise() const { return deferred.Promise(); }
+
+protected:
+  void Execute() override {
+    std::string error;
+    bool ok = floatData ? WriteFitsFloat32(path, floatData, width, height, header, error)
+                        : WriteFitsUint16(path, data, width, height, header, error);
+    if (!ok) {
+      SetError(error);
+    }
+  }
+
+  void OnOK() override {
+    deferred.Resolve(Napi::String::New(Env(), path));
+  }
+
+  void OnError(const Napi::Error &error) override {
+    deferred.Reject(error.Value());
+  }
+
+private:
+  Napi::Promise::Deferred deferred;
+  Napi::ObjectReference dataRef;
+  const uint16_t *data;
+  const float *floatData;
+  int width;
+  int height;
+  std::string path;
+  FitsHeader header;
+};
+
+// writeFits(image, path, headers) -> Promise<string>
+//  image.data가 Float32Array면 (스택 결과) BITPIX=-32로 기록
+static Napi::Value WriteFits(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  Napi::Promise::Deferred deferred = Napi::Promise::Deferred::New(env);
+
+  if (info.Length() < 2 || !info[1].IsString()) {
+    deferred.Reject(Napi::TypeError::New(env, "writeFits(image, path, headers) 형식으로 호출해야 합니다.").Value());
+    return deferred.Promise();
+  }
+
+  std::string error;
+  FitsHeader header;
+  if (!ParseFitsHeaderCards(info.Length() >= 3 ? info[2] : env.Undefined(), header, error)) {
+    deferred.Reject(Napi::TypeError::New(env, error).Value());
+    return deferred.Promise();
+  }
+
+  Napi::Value dataValue = info[0].IsObject() ? info[0].As<Napi::Object>().Get("data") : env.Undefined();
+  if (dataValue.IsTypedArray() && dataValue.As<Napi::TypedArray>().TypedArrayType() == napi_float32_array) {
+    Napi::Object image = info[0].As<Napi::Object>();
+    Napi::Float32Array floats = dataValue.As<Napi::Float32Array>();
+    int width = image.Get("width").IsNumber() ? image.Get("width").As<Napi::Number>().Int32Value() : 0;
+    int height = image.Get("height").IsNumber() ? image.Get("height").As<Napi::Number>().Int32Value() : 0;
+    if (width <= 0 || height <= 0 || floats.ElementLength() < static_cast<size_t>(width) * height) {
+      deferred.Reject(Napi::TypeError::New(env, "이미지 데이터는 width*height 크기의 Float32Array여야 합니다.").Value());
+      return deferred.Promise();
+    }
+    FitsWriteWorker *worker = new FitsWriteWorker(env, floats, nullptr, floats.Data(), width, height,
+                                                  info[1].As<Napi::String>().Utf8Value(), header);
+    Napi::Promise promise = worker->GetPromise();
+    worker->Queue();
+    return promise;
+  }
+
+  Napi::Uint16Array pixels;
+  int width, height;
+  if (!ParseFitsImageArg(info[0], pixels, width, height, error)) {
+    deferred.Reject(Napi::TypeError::New(env, error).Value());
+    return deferred.Promise();
+  }
+
+  FitsWriteWorker *worker = new FitsWriteWorker(env, pixels, pixels.Data(), nullptr, width, height,
+                                                info[1].As<Napi::String>().Utf8Value(), header);
+  Napi::Promise promise = worker->GetPromise();
+  worker->Queue();
+  return promise;
+}
+
+Napi::Object InitFitsWriter(Napi::Env env, Napi::Object exports) {
+  exports.Set("writeFits", Napi::Function::New(env, WriteFits, "writeFits"));
+  return exports;
+}
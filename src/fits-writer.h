@@ -0,0 +1,63 @@
+// fits-writer.h
+// FITS 파일 쓰기 (BITPIX=16 + BZERO=32768 또는 스택 결과용 BITPIX=-32, 2880 바이트 블록 단위 스트리밍)
+#ifndef SX_FITS_WRITER_H
+#define SX_FITS_WRITER_H
+
+#include <napi.h>
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#define FITS_BLOCK_SIZE            2880    // FITS 레코드 크기
+#define FITS_CARD_SIZE             80      // 헤더 카드 크기
+#define FITS_WRITE_CHUNK_BLOCKS    64      // 한 번에 변환/기록하는 블록 수 (184 KB)
+
+// 80자 헤더 카드 모음. 카드 순서를 유지하며 직렬화 시 2880 바이트로 패딩
+class FitsHeader {
+public:
+  void AddLogical(const std::string &key, bool value, const std::string &comment = "");
+  void AddInt(const std::string &key, long long value, const std::string &comment = "");
+  void AddFloat(const std::string &key, double value, const std::string &comment = "");
+  void AddString(const std::string &key, const std::string &value, const std::string &comment = "");
+  void AddRaw(const std::string &card);
+  void Append(const FitsHeader &other);
+
+  // key가 있으면 값을 바꾸고 없으면 추가
+  void SetInt(const std::string &key, long long value, const std::string &comment = "");
+
+  // key 카드의 헤더 내 바이트 위치 (없으면 -1)
+  long CardOffset(const std::string &key) const;
+
+  // END 카드를 붙이고 2880 바이트 배수로 패딩한 헤더
+  std::string Serialize() const;
+
+  static std::string FormatCard(const std::string &key, const std::string &value, const std::string &comment);
+  static std::string FormatInt(long long value);
+  static std::string FormatFloat(double value);
+
+private:
+  std::vector<std::string> cards;
+};
+
+// uint16 픽셀을 FITS BITPIX=16 (value - 32768, big-endian)으로 변환하면서 min/max 계산
+void FitsConvertUint16(const uint16_t *src, uint8_t *dst, size_t count, uint16_t &minValue, uint16_t &maxValue);
+
+// 기본 필수 카드(SIMPLE/BITPIX/NAXIS*/BZERO/BSCALE/DATAMIN/DATAMAX) 뒤에 extra 카드를 붙여 기록
+// DATAMIN/DATAMAX는 데이터를 쓰는 같은 패스에서 계산해 기록 후 헤더에 다시 씀
+bool WriteFitsUint16(const std::string &path, const uint16_t *data, int width, int height,
+                     const FitsHeader &extra, std::string &error);
+
+// float 픽셀(스택 결과 등)을 BITPIX=-32 (IEEE big-endian)로 기록. DATAMIN/DATAMAX는 같은 패스에서 계산
+bool WriteFitsFloat32(const std::string &path, const float *data, int width, int height,
+                      const FitsHeader &extra, std::string &error);
+
+// JS 이미지 객체({ data: Uint16Array, width, height }) 검사
+bool ParseFitsImageArg(const Napi::Value &value, Napi::Uint16Array &pixels, int &width, int &height, std::string &error);
+
+// JS 헤더 배열([{ key, value, comment }])을 FitsHeader로 변환
+bool ParseFitsHeaderCards(const Napi::Value &value, FitsHeader &header, std::string &error);
+
+Napi::Object InitFitsWriter(Napi::Env env, Napi::Object exports);
+
+#endif // SX_FITS_WRITER_H
@@ -0,0 +1,136 @@
+// frame-pool.h
+// 연속 촬영용 프레임 버퍼 풀
+//
+// 매 촬영마다 수 MB를 new/delete 하는 대신 페이지 정렬된 버퍼를 미리 할당해 두고
+// 재사용한다. JS 쪽 ArrayBuffer가 GC될 때 finalizer에서 Release()로 돌아온다.
+// 워커 스레드(Acquire)와 JS 스레드(Release)에서 동시에 호출되므로 mutex로 보호한다.
+#ifndef SX_FRAME_POOL_H
+#define SX_FRAME_POOL_H
+
+#include <cstdlib>
+#include <cstddef>
+#include <mutex>
+#include <map>
+#include <vector>
+#include <unordered_map>
+#include <unistd.h>
+
+class FramePool {
+public:
+  struct Stats {
+    size_t hits;          // 풀에서 꺼내 쓴 횟수
+    size_t misses;        // 풀이 비었거나 맞는 크기가 없어 새로 할당한 횟수
+    size_t inUse;         // 현재 JS에 빌려준 버퍼 수
+    size_t highWater;     // inUse 최댓값
+    size_t freeBuffers;   // 풀에 남아 있는 버퍼 수
+    size_t pooledBytes;   // 풀이 보유한 (빌려준 것 포함) 총 바이트
+  };
+
+  // sizeClasses: 버퍼 크기(바이트) -> 미리 할당할 개수
+  explicit FramePool(const std::map<size_t, int> &sizeClasses, int maxFreePerClass = 4)
+    : maxFreePerClass(maxFreePerClass), stats() {
+    pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    for (const auto &sc : sizeClasses) {
+      std::vector<void*> &list = freeLists[RoundUp(sc.first)];
+      for (int i = 0; i < sc.second; i++) {
+        void *p = AllocAligned(RoundUp(sc.first));
+        if (p) {
+          list.push_back(p);
+          stats.pooledBytes += RoundUp(sc.first);
+        }
+      }
+    }
+  }
+
+  ~FramePool() {
+    // 빌려준 버퍼는 Release 시점에 해제됨 (풀은 shared_ptr로 finalizer보다 오래 유지)
+    for (auto &fl : freeLists) {
+      for (void *p : fl.second) free(p);
+    }
+  }
+
+  FramePool(const FramePool&) = delete;
+  FramePool& operator=(const FramePool&) = delete;
+
+  // bytes 이상 크기의 버퍼를 빌림. 실패 시 nullptr
+  void* Acquire(size_t bytes) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    // 요청을 담을 수 있는 가장 작은 크기 클래스에서 꺼냄
+    auto it = freeLists.lower_bound(bytes);
+    for (; it != freeLists.end(); ++it) {
+      if (!it->second.empty()) break;
+    }
+
+    void *p = nullptr;
+    size_t capacity;
+    if (it != freeLists.end()) {
+      p = it->second.back();
+      it->second.pop_back();
+      capacity = it->first;
+      stats.hits++;
+    } else {
+      // 맞는 클래스가 있으면 그 크기로, 없으면 요청 크기로 새로 할당
+      auto cls = freeLists.lower_bound(bytes);
+      capacity = (cls != freeLists.end()) ? cls->first : RoundUp(bytes);
+      p = AllocAligned(capacity);
+      if (!p) return nullptr;
+      stats.misses++;
+      stats.pooledBytes += capacity;
+    }
+
+    outstanding[p] = capacity;
+    stats.inUse++;
+    if (stats.inUse > stats.highWater) stats.highWater = stats.inUse;
+    return p;
+  }
+
+  // Acquire로 빌린 버퍼 반납
+  void Release(void *p) {
+    if (!p) return;
+    std::lock_guard<std::mutex> lock(mutex);
+
+    auto it = outstanding.find(p);
+    if (it == outstanding.end()) return;
+    size_t capacity = it->second;
+    outstanding.erase(it);
+    stats.inUse--;
+
+    // 풀 크기 클래스이고 여유가 있으면 보관, 아니면 해제
+    auto fl = freeLists.find(capacity);
+    if (fl != freeLists.end() && static_cast<int>(fl->second.size()) < maxFreePerClass) {
+      fl->second.push_back(p);
+    } else {
+      free(p);
+      stats.pooledBytes -= capacity;
+    }
+  }
+
+  Stats GetStats() {
+    std::lock_guard<std::mutex> lock(mutex);
+    Stats s = stats;
+    s.freeBuffers = 0;
+    for (const auto &fl : freeLists) s.freeBuffers += fl.second.size();
+    return s;
+  }
+
+private:
+  size_t RoundUp(size_t bytes) const {
+    return (bytes + pageSize - 1) / pageSize * pageSize;
+  }
+
+  void* AllocAligned(size_t bytes) const {
+    void *p = nullptr;
+    if (posix_memalign(&p, pageSize, bytes) != 0) return nullptr;
+    return p;
+  }
+
+  std::mutex mutex;
+  size_t pageSize;
+  int maxFreePerClass;
+  std::map<size_t, std::vector<void*>> freeLists;
+  std::unordered_map<void*, size_t> outstanding;
+  Stats stats;
+};
+
+#endif // SX_FRAME_POOL_H
@@ -0,0 +1,113 @@
+// frame-stats.cc
+#include "frame-stats.h"
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+void FrameStatsAccumulateLE(const unsigned char *bytes, size_t nbytes, uint32_t *histogram) {
+  size_t pixels = nbytes / 2;
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  for (size_t i = 0; i < pixels; i++) {
+    histogram[bytes[i * 2] | (bytes[i * 2 + 1] << 8)]++;
+  }
+#else
+  // 수신 버퍼는 최종 픽셀 버퍼이므로 little-endian 호스트에서는 그대로 uint16으로 읽음
+  FrameStatsAccumulate(reinterpret_cast<const uint16_t*>(bytes), pixels, histogram);
+#endif
+}
+
+void FrameStatsAccumulate(const uint16_t *pixels, size_t count, uint32_t *histogram) {
+  for (size_t i = 0; i < count; i++) histogram[pixels[i]]++;
+}
+
+// 누적 개수가 target을 넘는 첫 값
+static uint16_t HistogramRank(const uint32_t *histogram, size_t target) {
+  size_t cumulative = 0;
+  for (size_t v = 0; v < FRAME_STATS_BINS; v++) {
+    cumulative += histogram[v];
+    if (cumulative > target) return static_cast<uint16_t>(v);
+  }
+  return FRAME_STATS_BINS - 1;
+}
+
+void FrameStatsFromHistogram(const uint32_t *histogram, FrameStats &stats) {
+  memset(&stats, 0, sizeof(stats));
+
+  double sum = 0.0;
+  double sumSq = 0.0;
+  bool first = true;
+  for (size_t v = 0; v < FRAME_STATS_BINS; v++) {
+    uint32_t n = histogram[v];
+    if (n == 0) continue;
+    if (first) {
+      stats.min = static_cast<uint16_t>(v);
+      first = false;
+    }
+    stats.max = static_cast<uint16_t>(v);
+    stats.count += n;
+    sum += static_cast<double>(v) * n;
+    sumSq += static_cast<double>(v) * v * n;
+    if (v >= FRAME_STATS_SATURATION) stats.saturated += n;
+  }
+  if (stats.count == 0) return;
+
+  stats.mean = sum / stats.count;
+  double variance = sumSq / stats.count - stats.mean * stats.mean;
+  stats.stddev = variance > 0 ? std::sqrt(variance) : 0.0;
+  stats.median = HistogramRank(histogram, (stats.count - 1) / 2);
+
+  // |v - median| 의 히스토그램에서 다시 중앙값 (MAD)
+  std::vector<uint32_t> deviation(FRAME_STATS_BINS, 0);
+  for (size_t v = stats.min; v <= stats.max; v++) {
+    int d = static_cast<int>(v) - stats.median;
+    deviation[d < 0 ? -d : d] += histogram[v];
+  }
+  stats.mad = HistogramRank(deviation.data(), (stats.count - 1) / 2);
+  stats.noise = FRAME_STATS_MAD_TO_SIGMA * stats.mad;
+}
+
+Napi::Object FrameStatsToObject(Napi::Env env, const FrameStats &stats, const uint32_t *histogram) {
+  Napi::Object obj = Napi::Object::New(env);
+  obj.Set("count", Napi::Number::New(env, static_cast<double>(stats.count)));
+  obj.Set("min", Napi::Number::New(env, stats.min));
+  obj.Set("max", Napi::Number::New(env, stats.max));
+  obj.Set("mean", Napi::Number::New(env, stats.mean));
+  obj.Set("stddev", Napi::Number::New(env, stats.stddev));
+  obj.Set("median", Napi::Number::New(env, stats.median));
+  obj.Set("mad", Napi::Number::New(env, stats.mad));
+  obj.Set("noise", Napi::Number::New(env, stats.noise));
+  obj.Set("saturated", Napi::Number::New(env, static_cast<double>(stats.saturated)));
+
+  Napi::Uint32Array hist = Napi::Uint32Array::New(env, FRAME_STATS_BINS);
+  memcpy(hist.Data(), histogram, FRAME_STATS_BINS * sizeof(uint32_t));
+  obj.Set("histogram", hist);
+  return obj;
+}
+
+// computeFrameStats(image) -> stats (카메라 밖에서 만든 이미지용)
+static Napi::Value ComputeFrameStats(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+
+  if (info.Length() < 1 || !info[0].IsObject()) {
+    Napi::TypeError::New(env, "유효한 이미지 데이터가 아닙니다.").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+
+  Napi::Value dataValue = info[0].As<Napi::Object>().Get("data");
+  if (!dataValue.IsTypedArray() || dataValue.As<Napi::TypedArray>().TypedArrayType() != napi_uint16_array) {
+    Napi::TypeError::New(env, "이미지 데이터는 Uint16Array여야 합니다.").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  Napi::Uint16Array pixels = dataValue.As<Napi::Uint16Array>();
+
+  std::vector<uint32_t> histogram(FRAME_STATS_BINS, 0);
+  FrameStatsAccumulate(pixels.Data(), pixels.ElementLength(), histogram.data());
+  FrameStats stats;
+  FrameStatsFromHistogram(histogram.data(), stats);
+  return FrameStatsToObject(env, stats, histogram.data());
+}
+
+Napi::Object InitFrameStats(Napi::Env env, Napi::Object exports) {
+  exports.Set("computeFrameStats", Napi::Function::New(env, ComputeFrameStats, "computeFrameStats"));
+  return exports;
+}
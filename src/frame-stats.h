@@ -0,0 +1,42 @@
+// frame-stats.h
+// 프레임 통계 (min/max/평균/표준편차/중앙값/MAD 잡음/포화 픽셀 수)
+// USB 수신 콜백에서 도착한 구간마다 16비트 히스토그램을 누적하고, 나머지 값은 히스토그램에서 계산
+// 하므로 촬영 후 JS나 저장 단계에서 프레임 전체를 다시 읽을 필요가 없다.
+#ifndef SX_FRAME_STATS_H
+#define SX_FRAME_STATS_H
+
+#include <napi.h>
+#include <cstdint>
+#include <cstddef>
+
+#define FRAME_STATS_BINS           65536
+#define FRAME_STATS_SATURATION     65535    // 이 값 이상이면 포화 픽셀
+#define FRAME_STATS_MAD_TO_SIGMA   1.4826   // 정규분포에서 MAD -> 표준편차 환산 계수
+
+struct FrameStats {
+  size_t count;         // 통계에 포함된 픽셀 수 (수신된 픽셀)
+  uint16_t min;
+  uint16_t max;
+  double mean;
+  double stddev;
+  uint16_t median;
+  double mad;           // 중앙값 절대 편차
+  double noise;         // MAD 기반 배경 잡음 (1.4826 * MAD)
+  size_t saturated;
+};
+
+// little-endian uint16 바이트열을 히스토그램에 누적 (홀수 바이트는 무시)
+void FrameStatsAccumulateLE(const unsigned char *bytes, size_t nbytes, uint32_t *histogram);
+
+// 호스트 바이트 순서 픽셀을 히스토그램에 누적
+void FrameStatsAccumulate(const uint16_t *pixels, size_t count, uint32_t *histogram);
+
+// 히스토그램에서 통계 계산
+void FrameStatsFromHistogram(const uint32_t *histogram, FrameStats &stats);
+
+// { count, min, max, mean, stddev, median, mad, noise, saturated, histogram: Uint32Array(65536) }
+Napi::Object FrameStatsToObject(Napi::Env env, const FrameStats &stats, const uint32_t *histogram);
+
+Napi::Object InitFrameStats(Napi::Env env, Napi::Object exports);
+
+#endif // SX_FRAME_STATS_H
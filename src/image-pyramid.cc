@@ -0,0 +1,134 @@
+// image-pyramid.cc
+#include "image-pyramid.h"
+#include <chrono>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+// 두 행을 2x2 박스 평균(반올림)으로 한 행에 줄임
+static void DownsampleRow(const uint16_t *__restrict row0, const uint16_t *__restrict row1,
+                          uint16_t *__restrict out, int outWidth) {
+  int x = 0;
+#if defined(__SSE2__)
+  // madd_epi16은 부호 있는 16비트라 0x8000을 뒤집어 (v - 32768)로 더하고, 네 값의 합에서 131072를 되돌림
+  const __m128i flip = _mm_set1_epi16(static_cast<short>(0x8000));
+  const __m128i ones = _mm_set1_epi16(1);
+  const __m128i bias = _mm_set1_epi32(131072 + 2);
+  const __m128i half = _mm_set1_epi32(32768);
+  for (; x + 8 <= outWidth; x += 8) {
+    const uint16_t *a = row0 + 2 * x, *b = row1 + 2 * x;
+    __m128i lo = _mm_add_epi32(
+      _mm_madd_epi16(_mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(a)), flip), ones),
+      _mm_madd_epi16(_mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(b)), flip), ones));
+    __m128i hi = _mm_add_epi32(
+      _mm_madd_epi16(_mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(a + 8)), flip), ones),
+      _mm_madd_epi16(_mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(b + 8)), flip), ones));
+    lo = _mm_sub_epi32(_mm_srli_epi32(_mm_add_epi32(lo, bias), 2), half);
+    hi = _mm_sub_epi32(_mm_srli_epi32(_mm_add_epi32(hi, bias), 2), half);
+    // 부호 있는 포화 pack 후 다시 뒤집어 0~65535로
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + x), _mm_xor_si128(_mm_packs_epi32(lo, hi), flip));
+  }
+#elif defined(__ARM_NEON)
+  for (; x + 4 <= outWidth; x += 4) {
+    uint32x4_t sum = vpaddlq_u16(vld1q_u16(row0 + 2 * x));
+    sum = vpadalq_u16(sum, vld1q_u16(row1 + 2 * x));
+    vst1_u16(out + x, vrshrn_n_u32(sum, 2));
+  }
+#endif
+  for (; x < outWidth; x++) {
+    const uint32_t sum = static_cast<uint32_t>(row0[2 * x]) + row0[2 * x + 1] + row1[2 * x] + row1[2 * x + 1];
+    out[x] = static_cast<uint16_t>((sum + 2) >> 2);
+  }
+}
+
+static void Downsample(const uint16_t *src, int srcWidth, PyramidLevel &level) {
+  for (int y = 0; y < level.height; y++) {
+    const uint16_t *row0 = src + static_cast<size_t>(2 * y) * srcWidth;
+    DownsampleRow(row0, row0 + srcWidth, level.data.data() + static_cast<size_t>(y) * level.width, level.width);
+  }
+}
+
+void ImagePyramidBuild(const uint16_t *pixels, int width, int height, int levels, ImagePyramid &pyramid) {
+  auto start = std::chrono::steady_clock::now();
+  int count = 0;
+  int w = width, h = height;
+  while (count < levels && w / 2 >= PYRAMID_MIN_SIZE && h / 2 >= PYRAMID_MIN_SIZE) {
+    w /= 2;
+    h /= 2;
+    count++;
+  }
+
+  pyramid.levels.resize(count);
+  const uint16_t *src = pixels;
+  int srcWidth = width;
+  for (int i = 0; i < count; i++) {
+    PyramidLevel &level = pyramid.levels[i];
+    level.scale = 2 << i;
+    level.width = (i == 0 ? width : pyramid.levels[i - 1].width) / 2;
+    level.height = (i == 0 ? height : pyramid.levels[i - 1].height) / 2;
+    level.data.resize(static_cast<size_t>(level.width) * level.height);
+    Downsample(src, srcWidth, level);
+    src = level.data.data();
+    srcWidth = level.width;
+  }
+  pyramid.buildMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+Napi::Array ImagePyramidToArray(Napi::Env env, const ImagePyramid &pyramid) {
+  Napi::Array result = Napi::Array::New(env, pyramid.levels.size());
+  for (size_t i = 0; i < pyramid.levels.size(); i++) {
+    const PyramidLevel &level = pyramid.levels[i];
+    Napi::Uint16Array data = Napi::Uint16Array::New(env, level.data.size());
+    memcpy(data.Data(), level.data.data(), level.data.size() * sizeof(uint16_t));
+
+    Napi::Object obj = Napi::Object::New(env);
+    obj.Set("scale", Napi::Number::New(env, level.scale));
+    obj.Set("width", Napi::Number::New(env, level.width));
+    obj.Set("height", Napi::Number::New(env, level.height));
+    obj.Set("data", data);
+    result.Set(static_cast<uint32_t>(i), obj);
+  }
+  return result;
+}
+
+// buildImagePyramid(image, { levels }) -> [{ scale, width, height, data }]  촬영 때 만들지 않은 이미지용 (동기)
+static Napi::Value BuildImagePyramidJs(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+
+  if (info.Length() < 1 || !info[0].IsObject()) {
+    Napi::TypeError::New(env, "유효한 이미지 데이터가 아닙니다.").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  Napi::Object image = info[0].As<Napi::Object>();
+  Napi::Value data = image.Get("data");
+  int width = image.Get("width").IsNumber() ? image.Get("width").As<Napi::Number>().Int32Value() : 0;
+  int height = image.Get("height").IsNumber() ? image.Get("height").As<Napi::Number>().Int32Value() : 0;
+  if (!data.IsTypedArray() || data.As<Napi::TypedArray>().TypedArrayType() != napi_uint16_array ||
+      width <= 0 || height <= 0 ||
+      data.As<Napi::TypedArray>().ElementLength() < static_cast<size_t>(width) * height) {
+    Napi::TypeError::New(env, "이미지 데이터는 width*height 크기의 Uint16Array여야 합니다.").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+
+  int levels = PYRAMID_DEFAULT_LEVELS;
+  if (info.Length() >= 2 && info[1].IsObject() && info[1].As<Napi::Object>().Get("levels").IsNumber()) {
+    levels = info[1].As<Napi::Object>().Get("levels").As<Napi::Number>().Int32Value();
+    if (levels < 1 || levels > PYRAMID_MAX_LEVELS) {
+      Napi::RangeError::New(env, "levels는 1~" + std::to_string(PYRAMID_MAX_LEVELS) + " 사이여야 합니다.").ThrowAsJavaScriptException();
+      return env.Null();
+    }
+  }
+
+  ImagePyramid pyramid;
+  ImagePyramidBuild(data.As<Napi::Uint16Array>().Data(), width, height, levels, pyramid);
+  return ImagePyramidToArray(env, pyramid);
+}
+
+Napi::Object InitImagePyramid(Napi::Env env, Napi::Object exports) {
+  exports.Set("buildImagePyramid", Napi::Function::New(env, BuildImagePyramidJs, "buildImagePyramid"));
+  return exports;
+}
@@ -0,0 +1,36 @@
+// image-pyramid.h
+// 썸네일용 다해상도 피라미드 (1/2, 1/4, 1/8 ...)
+// 촬영 변환 패스(보정/결함 교체)가 끝난 직후 프레임을 한 번만 읽어 2x2 박스 평균으로 1/2 단계를 만들고,
+// 그 아래 단계는 바로 위 단계(작아서 캐시에 남아 있음)에서 만든다. 홀수 끝 행/열은 버린다.
+#ifndef SX_IMAGE_PYRAMID_H
+#define SX_IMAGE_PYRAMID_H
+
+#include <napi.h>
+#include <cstdint>
+#include <vector>
+
+#define PYRAMID_DEFAULT_LEVELS     3       // 1/2, 1/4, 1/8
+#define PYRAMID_MAX_LEVELS         6
+#define PYRAMID_MIN_SIZE           16      // 가로나 세로가 이보다 작아지는 단계는 만들지 않음
+
+struct PyramidLevel {
+  int scale;                    // 원본 대비 축소 배율 (2, 4, 8 ...)
+  int width;
+  int height;
+  std::vector<uint16_t> data;
+};
+
+struct ImagePyramid {
+  std::vector<PyramidLevel> levels;
+  double buildMs;
+};
+
+// levels 단계까지 만듦 (너무 작아지는 단계는 생략). 이전에 만든 단계의 버퍼는 다시 씀
+void ImagePyramidBuild(const uint16_t *pixels, int width, int height, int levels, ImagePyramid &pyramid);
+
+// [{ scale, width, height, data: Uint16Array }] (큰 단계부터)
+Napi::Array ImagePyramidToArray(Napi::Env env, const ImagePyramid &pyramid);
+
+Napi::Object InitImagePyramid(Napi::Env env, Napi::Object exports);
+
+#endif // SX_IMAGE_PYRAMID_H
@@ -0,0 +1,442 @@
+// night-composite.cc
+#include "night-composite.h"
+#include "sx-log.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+// 별 궤적 최댓값 합성
+static void MaxInto(uint16_t *__restrict dst, const uint16_t *__restrict src, size_t count) {
+  size_t i = 0;
+#if defined(__SSE2__)
+  // SSE2에는 부호 없는 16비트 max가 없어 max(a, b) = (a -포화 b) + b
+  for (; i + 8 <= count; i += 8) {
+    __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + i));
+    __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_add_epi16(_mm_subs_epu16(a, b), b));
+  }
+#elif defined(__ARM_NEON)
+  for (; i + 8 <= count; i += 8) vst1q_u16(dst + i, vmaxq_u16(vld1q_u16(dst + i), vld1q_u16(src + i)));
+#endif
+  for (; i < count; i++) dst[i] = std::max(dst[i], src[i]);
+}
+
+// 데이터 원소 수 (키오그램은 열 단위로 capacity개, 별 궤적은 프레임 한 장)
+static size_t CompositeElements(bool isKeogram, uint32_t width, uint32_t height, uint32_t capacity) {
+  return isKeogram ? static_cast<size_t>(capacity) * height : static_cast<size_t>(width) * height;
+}
+
+// 상태 파일을 읽기/쓰기로 mmap. 형식과 크기가 맞는 기존 파일은 이어 쓰고(width가 0이면 헤더 크기를 따름),
+// 없거나 맞지 않으면 create일 때만 새로 만듦. 이어 쓸 파일이 없으면 error를 비운 채 false
+static bool MapCompositeFile(const std::string &path, const char *magic, bool isKeogram, uint32_t width,
+                             uint32_t height, uint32_t capacity, uint32_t column, bool create,
+                             NightCompositeFile &file, std::string &error) {
+  file = NightCompositeFile();
+  int fd = open(path.c_str(), create ? (O_RDWR | O_CREAT) : O_RDWR, 0644);
+  if (fd < 0) {
+    if (!create && errno == ENOENT) return false;
+    error = path + ": 파일을 열 수 없습니다 (" + strerror(errno) + ")";
+    return false;
+  }
+
+  struct stat st;
+  NightCompositeHeader existing;
+  bool valid = false;
+  if (fstat(fd, &st) == 0 && st.st_size >= NIGHT_DATA_OFFSET &&
+      pread(fd, &existing, sizeof(existing), 0) == static_cast<ssize_t>(sizeof(existing)) &&
+      memcmp(existing.magic, magic, 8) == 0 && existing.width > 0 && existing.height > 0 &&
+      existing.capacity > 0 &&
+      (!isKeogram || (existing.frames <= existing.capacity && existing.column < existing.width)) &&
+      (width == 0 || (existing.width == width && existing.height == height))) {
+    size_t expected = NIGHT_DATA_OFFSET +
+                      CompositeElements(isKeogram, existing.width, existing.height, existing.capacity) * sizeof(uint16_t);
+    valid = static_cast<size_t>(st.st_size) == expected;
+  }
+
+  size_t bytes;
+  if (valid) {
+    bytes = static_cast<size_t>(st.st_size);
+  } else {
+    if (!create || width == 0) {
+      close(fd);
+      return false;
+    }
+    if (st.st_size > 0) LOG_WARN("%s: 헤더가 올바르지 않거나 프레임 크기가 달라 새로 만듭니다.", path.c_str());
+    // 0으로 줄였다 늘리면 내용이 0으로 채워진 sparse 파일 (별 궤적 최댓값의 시작값)
+    bytes = NIGHT_DATA_OFFSET + CompositeElements(isKeogram, width, height, capacity) * sizeof(uint16_t);
+    if (ftruncate(fd, 0) != 0 || ftruncate(fd, static_cast<off_t>(bytes)) != 0) {
+      error = path + ": 파일 크기를 정할 수 없습니다 (" + strerror(errno) + ")";
+      close(fd);
+      return false;
+    }
+  }
+
+  void *mapped = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (mapped == MAP_FAILED) {
+    error = path + ": mmap 실패 (" + strerror(errno) + ")";
+    return false;
+  }
+  file.mapped = mapped;
+  file.bytes = bytes;
+  file.header = static_cast<NightCompositeHeader*>(mapped);
+  file.data = reinterpret_cast<uint16_t*>(static_cast<char*>(mapped) + NIGHT_DATA_OFFSET);
+  if (!valid) {
+    NightCompositeHeader *header = file.header;
+    memcpy(header->magic, magic, 8);
+    header->width = width;
+    header->height = height;
+    header->capacity = capacity;
+    header->frames = 0;
+    header->column = column;
+    header->createdAt = static_cast<int64_t>(time(nullptr));
+    header->updatedAt = header->createdAt;
+    header->totalExposure = 0.0;
+  }
+  return true;
+}
+
+static void UnmapCompositeFile(NightCompositeFile &file) {
+  if (file.mapped) {
+    msync(file.mapped, file.bytes, MS_SYNC);
+    munmap(file.mapped, file.bytes);
+  }
+  file = NightCompositeFile();
+}
+
+bool NightComposite::OpenFiles(int frameWidth, int frameHeight, bool create, std::string &error) {
+  const uint32_t w = static_cast<uint32_t>(frameWidth), h = static_cast<uint32_t>(frameHeight);
+  const uint32_t keogramColumn = column >= 0 ? static_cast<uint32_t>(column) : w / 2;
+  if (!MapCompositeFile(dir + "/" + NIGHT_KEOGRAM_FILE, NIGHT_KEOGRAM_MAGIC, true, w, h,
+                        static_cast<uint32_t>(capacity), keogramColumn, create, keogram, error)) {
+    return false;
+  }
+  // 별 궤적은 키오그램과 같은 프레임 크기여야 이어 씀
+  if (!MapCompositeFile(dir + "/" + NIGHT_TRAIL_FILE, NIGHT_TRAIL_MAGIC, false, keogram.header->width,
+                        keogram.header->height, 1, 0, create, trail, error)) {
+    UnmapCompositeFile(keogram);
+    return false;
+  }
+  return true;
+}
+
+void NightComposite::CloseFiles() {
+  UnmapCompositeFile(keogram);
+  UnmapCompositeFile(trail);
+}
+
+void NightComposite::Accumulate(const uint16_t *pixels, double exposure, bool &keogramFull) {
+  NightCompositeHeader *kh = keogram.header;
+  NightCompositeHeader *th = trail.header;
+  const uint32_t width = th->width, height = th->height;
+  const int64_t now = static_cast<int64_t>(time(nullptr));
+
+  // 데이터를 다 쓴 뒤에 frames를 올림 (쓰는 도중 죽으면 다시 열었을 때 그 프레임은 없던 것)
+  keogramFull = kh->frames >= kh->capacity;
+  if (!keogramFull) {
+    uint16_t *out = keogram.data + static_cast<size_t>(kh->frames) * height;
+    for (uint32_t y = 0; y < height; y++) out[y] = pixels[static_cast<size_t>(y) * width + kh->column];
+    std::atomic_signal_fence(std::memory_order_release);
+    kh->frames++;
+    kh->updatedAt = now;
+    kh->totalExposure += exposure;
+  }
+
+  MaxInto(trail.data, pixels, static_cast<size_t>(width) * height);
+  std::atomic_signal_fence(std::memory_order_release);
+  th->frames++;
+  th->updatedAt = now;
+  th->totalExposure += exposure;
+
+  // 디스크 쓰기는 커널에 맡김 (프로세스가 죽어도 페이지 캐시의 내용은 파일에 남음)
+  msync(keogram.mapped, keogram.bytes, MS_ASYNC);
+  msync(trail.mapped, trail.bytes, MS_ASYNC);
+}
+
+NightComposite::~NightComposite() {
+  CloseFiles();
+}
+
+// ===== 비동기 반영 =====
+
+class NightAddWorker : public Napi::AsyncWorker {
+public:
+  NightAddWorker(Napi::Env env, NightComposite *composite, Napi::Object dataObj, const uint16_t *pixels, double exposure)
+    : Napi::AsyncWorker(env, "SXNightAdd"),
+      deferred(Napi::Promise::Deferred::New(env)),
+      composite(composite), pixels(pixels), exposure(exposure), keogramFull(false), addMs(0.0) {
+    // 반영이 끝날 때까지 프레임 버퍼와 합성 객체가 GC되지 않도록 참조 유지
+    dataRef = Napi::Persistent(dataObj);
+    compositeRef = Napi::Persistent(composite->Value());
+  }
+
+  Napi::Promise GetPromise() const { return deferred.Promise(); }
+
+protected:
+  void Execute() override {
+    auto start = std::chrono::steady_clock::now();
+    composite->Accumulate(pixels, exposure, keogramFull);
+    addMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  }
+
+  void OnOK() override {
+    Napi::Env env = Env();
+    composite->lastAddMs = addMs;
+    composite->busy = false;
+    if (keogramFull) {
+      LOG_WARN("키오그램이 가득 찼습니다 (%u열): 별 궤적만 갱신합니다.", composite->keogram.header->capacity);
+    }
+
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("frames", Napi::Number::New(env, composite->trail.header->frames));
+    result.Set("keogramColumns", Napi::Number::New(env, composite->keogram.header->frames));
+    result.Set("keogramFull", Napi::Boolean::New(env, keogramFull));
+    result.Set("addMs", Napi::Number::New(env, addMs));
+    deferred.Resolve(result);
+  }
+
+  void OnError(const Napi::Error &error) override {
+    composite->busy = false;
+    deferred.Reject(error.Value());
+  }
+
+private:
+  Napi::Promise::Deferred deferred;
+  Napi::ObjectReference dataRef;
+  Napi::ObjectReference compositeRef;
+  NightComposite *composite;
+  const uint16_t *pixels;
+  double exposure;
+  bool keogramFull;
+  double addMs;
+};
+
+// ===== N-API =====
+
+Napi::Object NightComposite::Init(Napi::Env env, Napi::Object exports) {
+  Napi::Function func = DefineClass(env, "NightComposite", {
+    InstanceMethod("add", &NightComposite::Add),
+    InstanceMethod("getKeogram", &NightComposite::GetKeogram),
+    InstanceMethod("getStarTrail", &NightComposite::GetStarTrail),
+    InstanceMethod("getInfo", &NightComposite::GetInfo),
+    InstanceMethod("close", &NightComposite::Close)
+  });
+
+  // 모듈 수명 동안 생성자 유지
+  Napi::FunctionReference *constructor = new Napi::FunctionReference();
+  *constructor = Napi::Persistent(func);
+  constructor->SuppressDestruct();
+
+  exports.Set("NightComposite", func);
+  return exports;
+}
+
+// new NightComposite({ dir, capacity, column })  dir에 상태 파일이 있으면 이어 쌓음 (디렉터리는 미리 만들어 둬야 함)
+NightComposite::NightComposite(const Napi::CallbackInfo& info)
+  : Napi::ObjectWrap<NightComposite>(info),
+    capacity(NIGHT_DEFAULT_CAPACITY),
+    column(-1),
+    resumed(false),
+    closed(false),
+    busy(false),
+    lastAddMs(0.0),
+    keogram(),
+    trail()
+{
+  Napi::Env env = info.Env();
+  if (info.Length() < 1 || !info[0].IsObject() || !info[0].As<Napi::Object>().Get("dir").IsString()) {
+    Napi::TypeError::New(env, "new NightComposite({ dir, capacity, column }) 형식으로 호출해야 합니다.").ThrowAsJavaScriptException();
+    return;
+  }
+  Napi::Object opts = info[0].As<Napi::Object>();
+  dir = opts.Get("dir").As<Napi::String>().Utf8Value();
+  if (opts.Get("capacity").IsNumber()) {
+    int value = opts.Get("capacity").As<Napi::Number>().Int32Value();
+    if (value < 1 || value > NIGHT_MAX_CAPACITY) {
+      Napi::RangeError::New(env, "capacity는 1~" + std::to_string(NIGHT_MAX_CAPACITY) + " 사이여야 합니다.").ThrowAsJavaScriptException();
+      return;
+    }
+    capacity = value;
+  }
+  if (opts.Get("column").IsNumber()) {
+    int value = opts.Get("column").As<Napi::Number>().Int32Value();
+    if (value < 0) {
+      Napi::RangeError::New(env, "column은 0 이상이어야 합니다.").ThrowAsJavaScriptException();
+      return;
+    }
+    column = value;
+  }
+
+  // 이전 실행의 상태가 있으면 그대로 이어 씀 (크기/열/용량은 파일을 따름)
+  std::string error;
+  resumed = OpenFiles(0, 0, false, error);
+  if (!error.empty()) {
+    Napi::Error::New(env, error).ThrowAsJavaScriptException();
+    return;
+  }
+  if (resumed) {
+    LOG_INFO("밤 합성 이어 쌓기: %s (%u프레임, 키오그램 %u열)", dir.c_str(), trail.header->frames, keogram.header->frames);
+  }
+}
+
+// add(image) -> Promise<{ frames, keogramColumns, keogramFull, addMs }>  image: { data: Uint16Array, width, height, exposureTime }
+// 첫 프레임이 상태 파일의 크기를 정함. 크기가 다른 프레임(비닝/영역 변경)은 거부
+Napi::Value NightComposite::Add(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  Napi::Promise::Deferred deferred = Napi::Promise::Deferred::New(env);
+
+  if (closed) {
+    deferred.Reject(Napi::Error::New(env, "닫힌 합성 객체입니다.").Value());
+    return deferred.Promise();
+  }
+  if (busy) {
+    deferred.Reject(Napi::Error::New(env, "이전 프레임을 반영하는 중입니다.").Value());
+    return deferred.Promise();
+  }
+
+  Napi::Object image = info.Length() >= 1 && info[0].IsObject() ? info[0].As<Napi::Object>() : Napi::Object::New(env);
+  Napi::Value data = image.Get("data");
+  int frameWidth = image.Get("width").IsNumber() ? image.Get("width").As<Napi::Number>().Int32Value() : 0;
+  int frameHeight = image.Get("height").IsNumber() ? image.Get("height").As<Napi::Number>().Int32Value() : 0;
+  if (!data.IsTypedArray() || data.As<Napi::TypedArray>().TypedArrayType() != napi_uint16_array ||
+      frameWidth <= 0 || frameHeight <= 0 ||
+      data.As<Napi::TypedArray>().ElementLength() < static_cast<size_t>(frameWidth) * frameHeight) {
+    deferred.Reject(Napi::TypeError::New(env, "이미지 데이터는 width*height 크기의 Uint16Array여야 합니다.").Value());
+    return deferred.Promise();
+  }
+
+  if (!keogram.mapped) {
+    if (column >= frameWidth) {
+      deferred.Reject(Napi::RangeError::New(env, "키오그램 열(" + std::to_string(column) + ")이 프레임 밖입니다.").Value());
+      return deferred.Promise();
+    }
+    std::string error;
+    if (!OpenFiles(frameWidth, frameHeight, true, error)) {
+      deferred.Reject(Napi::Error::New(env, error).Value());
+      return deferred.Promise();
+    }
+  } else if (static_cast<uint32_t>(frameWidth) != trail.header->width ||
+             static_cast<uint32_t>(frameHeight) != trail.header->height) {
+    deferred.Reject(Napi::Error::New(env, "프레임 크기(" + std::to_string(frameWidth) + "x" + std::to_string(frameHeight) +
+                                          ")가 밤 합성(" + std::to_string(trail.header->width) + "x" +
+                                          std::to_string(trail.header->height) + ")과 다릅니다.").Value());
+    return deferred.Promise();
+  }
+
+  busy = true;
+  Napi::Uint16Array pixels = data.As<Napi::Uint16Array>();
+  double exposure = image.Get("exposureTime").IsNumber() ? image.Get("exposureTime").As<Napi::Number>().DoubleValue() : 0.0;
+  NightAddWorker *worker = new NightAddWorker(env, this, pixels, pixels.Data(), exposure);
+  Napi::Promise promise = worker->GetPromise();
+  worker->Queue();
+  return promise;
+}
+
+// getKeogram() -> { data: Uint16Array, width(열 수), height, frames, totalExposure }  가로가 시간 축
+Napi::Value NightComposite::GetKeogram(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  if (busy) {
+    Napi::Error::New(env, "프레임을 반영하는 중에는 읽을 수 없습니다.").ThrowAsJavaScriptException();
+    return env.Undefined();
+  }
+  if (!keogram.mapped || keogram.header->frames == 0) {
+    Napi::Error::New(env, "키오그램에 쌓인 프레임이 없습니다.").ThrowAsJavaScriptException();
+    return env.Undefined();
+  }
+
+  // 파일은 열(프레임) 단위로 연속이므로 행 우선 이미지로 전치
+  const uint32_t columns = keogram.header->frames, height = keogram.header->height;
+  Napi::Uint16Array out = Napi::Uint16Array::New(env, static_cast<size_t>(columns) * height);
+  uint16_t *dst = out.Data();
+  for (uint32_t x = 0; x < columns; x++) {
+    const uint16_t *src = keogram.data + static_cast<size_t>(x) * height;
+    for (uint32_t y = 0; y < height; y++) dst[static_cast<size_t>(y) * columns + x] = src[y];
+  }
+
+  Napi::Object result = Napi::Object::New(env);
+  result.Set("data", out);
+  result.Set("width", Napi::Number::New(env, columns));
+  result.Set("height", Napi::Number::New(env, height));
+  result.Set("frames", Napi::Number::New(env, columns));
+  result.Set("column", Napi::Number::New(env, keogram.header->column));
+  result.Set("totalExposure", Napi::Number::New(env, keogram.header->totalExposure));
+  return result;
+}
+
+// getStarTrail() -> { data: Uint16Array, width, height, frames, totalExposure }
+Napi::Value NightComposite::GetStarTrail(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  if (busy) {
+    Napi::Error::New(env, "프레임을 반영하는 중에는 읽을 수 없습니다.").ThrowAsJavaScriptException();
+    return env.Undefined();
+  }
+  if (!trail.mapped || trail.header->frames == 0) {
+    Napi::Error::New(env, "별 궤적에 합친 프레임이 없습니다.").ThrowAsJavaScriptException();
+    return env.Undefined();
+  }
+
+  const size_t count = static_cast<size_t>(trail.header->width) * trail.header->height;
+  Napi::Uint16Array out = Napi::Uint16Array::New(env, count);
+  memcpy(out.Data(), trail.data, count * sizeof(uint16_t));
+
+  Napi::Object result = Napi::Object::New(env);
+  result.Set("data", out);
+  result.Set("width", Napi::Number::New(env, trail.header->width));
+  result.Set("height", Napi::Number::New(env, trail.header->height));
+  result.Set("frames", Napi::Number::New(env, trail.header->frames));
+  result.Set("totalExposure", Napi::Number::New(env, trail.header->totalExposure));
+  return result;
+}
+
+Napi::Value NightComposite::GetInfo(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  Napi::Object result = Napi::Object::New(env);
+  result.Set("dir", Napi::String::New(env, dir));
+  result.Set("resumed", Napi::Boolean::New(env, resumed));
+  result.Set("closed", Napi::Boolean::New(env, closed));
+  result.Set("busy", Napi::Boolean::New(env, busy));
+  result.Set("lastAddMs", Napi::Number::New(env, lastAddMs));
+  if (keogram.mapped) {
+    result.Set("width", Napi::Number::New(env, trail.header->width));
+    result.Set("height", Napi::Number::New(env, trail.header->height));
+    result.Set("frames", Napi::Number::New(env, trail.header->frames));
+    result.Set("keogramColumns", Napi::Number::New(env, keogram.header->frames));
+    result.Set("capacity", Napi::Number::New(env, keogram.header->capacity));
+    result.Set("column", Napi::Number::New(env, keogram.header->column));
+    result.Set("totalExposure", Napi::Number::New(env, trail.header->totalExposure));
+    result.Set("createdAt", Napi::Number::New(env, static_cast<double>(trail.header->createdAt)));
+    result.Set("updatedAt", Napi::Number::New(env, static_cast<double>(trail.header->updatedAt)));
+  } else {
+    result.Set("frames", Napi::Number::New(env, 0));
+    result.Set("keogramColumns", Napi::Number::New(env, 0));
+  }
+  return result;
+}
+
+// close(): 상태 파일을 디스크에 쓰고 매핑 해제 (이후 add/읽기 불가)
+Napi::Value NightComposite::Close(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  if (busy) {
+    Napi::Error::New(env, "프레임을 반영하는 중에는 닫을 수 없습니다.").ThrowAsJavaScriptException();
+    return env.Undefined();
+  }
+  CloseFiles();
+  closed = true;
+  return env.Undefined();
+}
+
+Napi::Object InitNightComposite(Napi::Env env, Napi::Object exports) {
+  return NightComposite::Init(env, exports);
+}
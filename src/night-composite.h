@@ -0,0 +1,80 @@
+// night-composite.h
+// 촬영할 때마다 갱신하는 밤 단위 합성 이미지 (키오그램, 별 궤적)
+// - 키오그램: 프레임마다 한 열(기본 가운데 열)을 잘라 시간 순으로 이어 붙임 (프레임당 O(height))
+// - 별 궤적: 픽셀별 최댓값 합성 (프레임당 O(pixels), SIMD max)
+// 상태는 밤 디렉터리의 파일을 mmap(MAP_SHARED)해 바로 갱신하므로, 밤 중간에 프로세스가 죽거나 다시 시작해도
+// 같은 디렉터리를 열면 이어서 쌓는다. 보관된 JPG를 다시 읽는 두 번째 패스가 필요 없다.
+#ifndef SX_NIGHT_COMPOSITE_H
+#define SX_NIGHT_COMPOSITE_H
+
+#include <napi.h>
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+#define NIGHT_KEOGRAM_MAGIC        "SXKEO001"
+#define NIGHT_TRAIL_MAGIC          "SXTRL001"
+#define NIGHT_KEOGRAM_FILE         "keogram.sxkeo"
+#define NIGHT_TRAIL_FILE           "startrail.sxtrl"
+#define NIGHT_DATA_OFFSET          4096    // 헤더 뒤 데이터 시작 (페이지 정렬)
+#define NIGHT_DEFAULT_CAPACITY     8192    // 키오그램 최대 열 수 (파일은 sparse라 쓴 만큼만 디스크 사용)
+#define NIGHT_MAX_CAPACITY         65536
+
+// 파일 앞부분 (little-endian, 나머지는 0으로 채워 NIGHT_DATA_OFFSET까지)
+struct NightCompositeHeader {
+  char magic[8];
+  uint32_t width;           // 프레임 크기
+  uint32_t height;
+  uint32_t capacity;        // 키오그램: 최대 열 수, 별 궤적: 1
+  uint32_t frames;          // 키오그램: 쌓은 열 수(capacity 이하), 별 궤적: 합친 프레임 수 (데이터를 쓴 뒤 올림)
+  uint32_t column;          // 키오그램: 잘라내는 열 (width 미만이어야 이어 씀)
+  uint32_t reserved;
+  int64_t createdAt;        // Unix 시간 (초)
+  int64_t updatedAt;
+  double totalExposure;     // 초
+};
+
+// mmap한 합성 상태 파일 하나
+struct NightCompositeFile {
+  void *mapped;
+  size_t bytes;
+  NightCompositeHeader *header;
+  uint16_t *data;
+};
+
+class NightComposite : public Napi::ObjectWrap<NightComposite> {
+public:
+  static Napi::Object Init(Napi::Env env, Napi::Object exports);
+  NightComposite(const Napi::CallbackInfo& info);
+  ~NightComposite();
+
+  // 워커 스레드에서 한 프레임 반영 (키오그램이 가득 차면 keogramFull, 별 궤적은 계속)
+  void Accumulate(const uint16_t *pixels, double exposure, bool &keogramFull);
+
+private:
+  friend class NightAddWorker;
+
+  Napi::Value Add(const Napi::CallbackInfo& info);
+  Napi::Value GetKeogram(const Napi::CallbackInfo& info);
+  Napi::Value GetStarTrail(const Napi::CallbackInfo& info);
+  Napi::Value GetInfo(const Napi::CallbackInfo& info);
+  Napi::Value Close(const Napi::CallbackInfo& info);
+
+  bool OpenFiles(int frameWidth, int frameHeight, bool create, std::string &error);
+  void CloseFiles();
+
+  std::string dir;
+  int capacity;
+  int column;               // -1이면 가운데 열
+  bool resumed;             // 기존 상태 파일에서 이어 쌓는지
+  bool closed;
+
+  std::atomic<bool> busy;   // 반영 중에는 다른 add/읽기/닫기를 받지 않음
+  double lastAddMs;
+  NightCompositeFile keogram;
+  NightCompositeFile trail;
+};
+
+Napi::Object InitNightComposite(Napi::Env env, Napi::Object exports);
+
+#endif // SX_NIGHT_COMPOSITE_H
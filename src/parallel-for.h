@@ -0,0 +1,100 @@
+// parallel-for.h
+// 프레임 처리용 공유 작업 스레드 풀과 ParallelFor
+//
+// 프레임마다 std::thread를 만들고 join하면 연속 촬영에서 스레드 생성 비용이 매번 든다.
+// 처음 필요할 때 만든 스레드를 프로세스 전체(스택/별 검출)가 계속 재사용한다.
+// 여러 libuv 워커가 동시에 ParallelFor를 불러도 되고, 호출 스레드도 자기 몫을 처리하므로
+// 풀이 다른 작업으로 바빠도 끝까지 진행된다.
+#ifndef SX_PARALLEL_FOR_H
+#define SX_PARALLEL_FOR_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+#define PARALLEL_MAX_THREADS       16      // 호출 스레드 포함
+
+class ParallelPool {
+public:
+  // 프로세스 종료 시 대기 중인 스레드를 join하지 않도록 해제하지 않음
+  static ParallelPool& Shared() {
+    static ParallelPool *pool = new ParallelPool();
+    return *pool;
+  }
+
+  // task를 풀 스레드 helpers개에 맡기고 호출 스레드도 task를 실행한 뒤, 맡긴 것이 모두 끝날 때까지 대기
+  void Run(int helpers, const std::function<void()> &task) {
+    struct Batch {
+      int pending;
+      std::mutex mutex;
+      std::condition_variable done;
+    } batch;
+    batch.pending = helpers;
+
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      while (threadCount < std::min(helpers, PARALLEL_MAX_THREADS - 1)) {
+        std::thread(&ParallelPool::WorkerLoop, this).detach();
+        threadCount++;
+      }
+      for (int i = 0; i < helpers; i++) {
+        queue.push_back([&task, &batch]() {
+          task();
+          std::lock_guard<std::mutex> lock(batch.mutex);
+          if (--batch.pending == 0) batch.done.notify_one();
+        });
+      }
+    }
+    wake.notify_all();
+
+    task();
+    std::unique_lock<std::mutex> lock(batch.mutex);
+    batch.done.wait(lock, [&batch] { return batch.pending == 0; });
+  }
+
+private:
+  ParallelPool() : threadCount(0) {}
+
+  void WorkerLoop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;) {
+      wake.wait(lock, [this] { return !queue.empty(); });
+      std::function<void()> job = std::move(queue.front());
+      queue.pop_front();
+      lock.unlock();
+      job();
+      lock.lock();
+    }
+  }
+
+  std::mutex mutex;
+  std::condition_variable wake;
+  std::deque<std::function<void()>> queue;
+  int threadCount;
+};
+
+// count개 작업을 스레드에 원자 카운터로 나눔 (fn(index)). threads가 0이면 CPU 수
+template <typename Fn>
+void ParallelFor(int count, int threads, Fn fn) {
+  int threadCount = threads > 0 ? threads : static_cast<int>(std::thread::hardware_concurrency());
+  threadCount = std::max(1, std::min(std::min(threadCount, PARALLEL_MAX_THREADS), count));
+  std::atomic<int> next(0);
+  auto worker = [&]() {
+    for (;;) {
+      int i = next.fetch_add(1);
+      if (i >= count) break;
+      fn(i);
+    }
+  };
+  if (threadCount == 1) {
+    worker();
+    return;
+  }
+  ParallelPool::Shared().Run(threadCount - 1, worker);
+}
+
+#endif // SX_PARALLEL_FOR_H
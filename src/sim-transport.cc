@@ -0,0 +1,488 @@
+// sim-transport.cc
+// ECHO2 시뮬레이터: 명령 블록 해석, 합성 별 영상 생성, 처리량 제한 스트리밍, 장애 주입
+#include "sim-transport.h"
+#include "usb-transport.h"
+#include "sx-log.h"
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+#include <thread>
+#include <algorithm>
+
+// 명령 블록 (sx_usb_prog_ref.txt)
+#define SIM_CMD_ECHO                 0
+#define SIM_CMD_CLEAR_PIXELS         1
+#define SIM_CMD_READ_PIXELS_DELAYED  2
+#define SIM_CMD_READ_PIXELS          3
+#define SIM_CMD_SET_TIMER            4
+#define SIM_CMD_GET_TIMER            5
+#define SIM_CMD_RESET                6
+#define SIM_CMD_GET_CCD_PARAMS       8
+#define SIM_CMD_CAMERA_MODEL         14
+#define SIM_CMD_GET_FIRMWARE_VERSION 255
+#define SIM_CMD_ECHO2_CAMERA_MODEL   0xFE    // SXCamera가 쓰는 대체 모델 명령
+#define SIM_FLAG_NOWIPE_FRAME        8
+
+#define SIM_GAUSS_TABLE_SIZE         65536   // 2의 거듭제곱
+#define SIM_HOT_PIXEL_ADU_PER_SEC    3000.0
+#define SIM_SHORT_READ_ALIGN         512     // 짧은 읽기는 벌크 패킷 경계에서 끊김
+
+SimOptions SimDefaultOptions() {
+  SimOptions options;
+  options.seed = SIM_DEFAULT_SEED;
+  options.ccdWidth = SIM_CCD_WIDTH;
+  options.ccdHeight = SIM_CCD_HEIGHT;
+  options.pixelSizeUm = SIM_PIXEL_SIZE_UM;
+  options.hBackPorch = SIM_H_BACK_PORCH;
+  options.stars = SIM_DEFAULT_STARS;
+  options.biasAdu = SIM_DEFAULT_BIAS_ADU;
+  options.biasDriftAdu = SIM_DEFAULT_BIAS_DRIFT_ADU;
+  options.skyAduPerSec = SIM_DEFAULT_SKY_ADU_PER_SEC;
+  options.starFlux = SIM_DEFAULT_STAR_FLUX;
+  options.starSigma = SIM_DEFAULT_STAR_SIGMA;
+  options.readNoiseAdu = SIM_DEFAULT_READ_NOISE_ADU;
+  options.hotPixels = SIM_DEFAULT_HOT_PIXELS;
+  options.throughputMBps = 0.0;
+  options.timeoutRate = 0.0;
+  options.shortReadRate = 0.0;
+  options.faultStallMs = SIM_DEFAULT_FAULT_STALL_MS;
+  return options;
+}
+
+bool ParseSimOptions(const Napi::Value &value, SimOptions &options, std::string &error) {
+  options = SimDefaultOptions();
+  if (value.IsUndefined() || value.IsNull()) {
+    return true;
+  }
+  if (!value.IsObject()) {
+    error = "sim 옵션은 객체여야 합니다.";
+    return false;
+  }
+  Napi::Object obj = value.As<Napi::Object>();
+  auto number = [&](const char *key, double &out) {
+    if (obj.Has(key) && obj.Get(key).IsNumber()) out = obj.Get(key).As<Napi::Number>().DoubleValue();
+  };
+
+  double seed = options.seed, stars = options.stars, hotPixels = options.hotPixels, stall = options.faultStallMs;
+  double ccdWidth = options.ccdWidth, ccdHeight = options.ccdHeight, hBackPorch = options.hBackPorch;
+  number("seed", seed);
+  number("ccdWidth", ccdWidth);
+  number("ccdHeight", ccdHeight);
+  number("pixelSizeUm", options.pixelSizeUm);
+  number("hBackPorch", hBackPorch);
+  number("stars", stars);
+  number("biasAdu", options.biasAdu);
+  number("biasDriftAdu", options.biasDriftAdu);
+  number("skyAduPerSec", options.skyAduPerSec);
+  number("starFlux", options.starFlux);
+  number("starSigma", options.starSigma);
+  number("readNoiseAdu", options.readNoiseAdu);
+  number("hotPixels", hotPixels);
+  number("throughputMBps", options.throughputMBps);
+  number("timeoutRate", options.timeoutRate);
+  number("shortReadRate", options.shortReadRate);
+  number("faultStallMs", stall);
+
+  if (ccdWidth < 1 || ccdWidth > SIM_MAX_CCD_SIZE || ccdHeight < 1 || ccdHeight > SIM_MAX_CCD_SIZE ||
+      options.pixelSizeUm <= 0 || options.pixelSizeUm >= 256 || hBackPorch < 0 || hBackPorch > 255 ||
+      options.biasDriftAdu < 0 ||
+      stars < 0 || hotPixels < 0 || stall < 0 || options.throughputMBps < 0 || options.starSigma <= 0 ||
+      options.timeoutRate < 0 || options.timeoutRate > 1 || options.shortReadRate < 0 || options.shortReadRate > 1) {
+    error = "sim 옵션 값이 범위를 벗어났습니다.";
+    return false;
+  }
+  options.seed = static_cast<uint32_t>(seed);
+  options.ccdWidth = static_cast<int>(ccdWidth);
+  options.ccdHeight = static_cast<int>(ccdHeight);
+  options.hBackPorch = static_cast<int>(hBackPorch);
+  options.stars = static_cast<int>(stars);
+  options.hotPixels = static_cast<int>(hotPixels);
+  options.faultStallMs = static_cast<unsigned int>(stall);
+  return true;
+}
+
+SimTransport::SimTransport(const SimOptions &opts)
+  : options(opts),
+    open(false),
+    clearedAt(std::chrono::steady_clock::now()),
+    timerMs(0),
+    timerSetAt(clearedAt),
+    readout(),
+    rngState(opts.seed ? opts.seed : 1),
+    frameReady(false)
+{
+  // 고정 시드로 하늘 배치 생성 (밝기는 멱법칙: 어두운 별이 많음)
+  std::mt19937 rng(options.seed);
+  std::uniform_real_distribution<float> ux(0.0f, options.ccdWidth);
+  std::uniform_real_distribution<float> uy(0.0f, options.ccdHeight);
+  std::uniform_real_distribution<float> u01(0.0f, 1.0f);
+  stars.resize(options.stars);
+  for (Star &star : stars) {
+    star.x = ux(rng);
+    star.y = uy(rng);
+    star.flux = static_cast<float>(options.starFlux * std::pow(u01(rng), 3.0f));
+  }
+
+  std::uniform_int_distribution<int> upix(0, options.ccdWidth * options.ccdHeight - 1);
+  hotPixels.resize(options.hotPixels);
+  for (int &index : hotPixels) index = upix(rng);
+
+  std::normal_distribution<float> gauss(0.0f, 1.0f);
+  gaussTable.resize(SIM_GAUSS_TABLE_SIZE);
+  for (float &g : gaussTable) g = gauss(rng);
+}
+
+bool SimTransport::Open(std::string & /*error*/) {
+  std::lock_guard<std::mutex> lock(mutex);
+  open = true;
+  response.clear();
+  readout.pending = false;
+  frameReady = false;
+  LOG_INFO("시뮬레이터 카메라 열림 (시드 %u, 별 %d개, 처리량 %.1f MB/s, 0이면 무제한)",
+           options.seed, options.stars, options.throughputMBps);
+  return true;
+}
+
+void SimTransport::Close() {
+  std::lock_guard<std::mutex> lock(mutex);
+  open = false;
+  readout.pending = false;
+  response.clear();
+}
+
+uint16_t SimTransport::ProductId() const {
+  return SX_ECHO2_PID;
+}
+
+uint32_t SimTransport::NextRandom() {
+  // xorshift32 (잡음/장애 주입용, 재현 가능)
+  uint32_t x = rngState;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  rngState = x;
+  return x;
+}
+
+void SimTransport::Stall(unsigned int timeoutMs) {
+  std::this_thread::sleep_for(std::chrono::milliseconds(std::min(timeoutMs, options.faultStallMs)));
+}
+
+void SimTransport::QueueResponse(const unsigned char *data, int length) {
+  response.insert(response.end(), data, data + length);
+}
+
+int SimTransport::ControlIn(uint8_t request, uint16_t /*value*/, uint16_t /*index*/,
+                            unsigned char *data, uint16_t length, unsigned int /*timeoutMs*/) {
+  if (!open) return LIBUSB_ERROR_NO_DEVICE;
+
+  // 기존 컨트롤 전송 명령 (펌웨어 0x11, 모델 0x14) 및 명령 블록 번호
+  unsigned char reply[2];
+  if (request == 0x11 || request == SIM_CMD_GET_FIRMWARE_VERSION) {
+    int version = SIM_FIRMWARE_MAJOR * 100 + SIM_FIRMWARE_MINOR;
+    reply[0] = version & 0xFF;
+    reply[1] = (version >> 8) & 0xFF;
+  } else if (request == 0x14 || request == SIM_CMD_CAMERA_MODEL) {
+    reply[0] = SIM_MODEL_CODE;
+    reply[1] = 0;
+  } else {
+    return LIBUSB_ERROR_PIPE;
+  }
+  int n = std::min<int>(length, sizeof(reply));
+  memcpy(data, reply, n);
+  return n;
+}
+
+int SimTransport::BulkWrite(const unsigned char *data, int length, int *transferred, unsigned int /*timeoutMs*/) {
+  *transferred = 0;
+  if (!open) return LIBUSB_ERROR_NO_DEVICE;
+  if (length < 8) return LIBUSB_ERROR_PIPE;
+
+  std::lock_guard<std::mutex> lock(mutex);
+  const unsigned char type = data[0];
+  const unsigned char cmd = data[1];
+  const uint16_t value = data[2] | (data[3] << 8);
+  const uint16_t paramLength = data[6] | (data[7] << 8);
+  const unsigned char *params = data + 8;
+  // 0xC0 명령의 LENGTH는 응답 길이 (GET_CCD_PARAMS는 17), 0x40 명령은 뒤따르는 매개변수 길이
+  if (type == 0x40 && length - 8 < paramLength) return LIBUSB_ERROR_PIPE;
+  auto now = std::chrono::steady_clock::now();
+
+  // 응답이 있는 명령 (SXCamera는 펌웨어/모델 조회를 0x40 타입으로도 보냄)
+  if (cmd == SIM_CMD_GET_FIRMWARE_VERSION) {
+    unsigned char reply[4] = {SIM_FIRMWARE_MINOR, 0, SIM_FIRMWARE_MAJOR, 0};
+    QueueResponse(reply, sizeof(reply));
+  } else if (cmd == SIM_CMD_ECHO2_CAMERA_MODEL || (type == 0xC0 && cmd == SIM_CMD_CAMERA_MODEL)) {
+    unsigned char reply[2] = {SIM_MODEL_CODE, 0};
+    QueueResponse(reply, sizeof(reply));
+  } else if (type == 0xC0 && cmd == SIM_CMD_ECHO) {
+    QueueResponse(params, std::min<int>(paramLength, length - 8));
+  } else if (type == 0xC0 && cmd == SIM_CMD_GET_TIMER) {
+    uint32_t elapsed = static_cast<uint32_t>(
+      std::chrono::duration_cast<std::chrono::milliseconds>(now - timerSetAt).count());
+    uint32_t remaining = elapsed < timerMs ? timerMs - elapsed : 0;
+    unsigned char reply[4] = {
+      static_cast<unsigned char>(remaining & 0xFF), static_cast<unsigned char>((remaining >> 8) & 0xFF),
+      static_cast<unsigned char>((remaining >> 16) & 0xFF), static_cast<unsigned char>((remaining >> 24) & 0xFF)
+    };
+    QueueResponse(reply, sizeof(reply));
+  } else if (type == 0xC0 && cmd == SIM_CMD_GET_CCD_PARAMS) {
+    const int pixelSize = static_cast<int>(options.pixelSizeUm * 256.0 + 0.5);  // 8.8 고정소수점
+    unsigned char reply[17] = {
+      0, static_cast<unsigned char>(options.hBackPorch),  // H 프런트/백 포치
+      static_cast<unsigned char>(options.ccdWidth & 0xFF), static_cast<unsigned char>(options.ccdWidth >> 8),
+      0, 0,                                         // V 프런트/백 포치
+      static_cast<unsigned char>(options.ccdHeight & 0xFF), static_cast<unsigned char>(options.ccdHeight >> 8),
+      static_cast<unsigned char>(pixelSize & 0xFF), static_cast<unsigned char>(pixelSize >> 8),
+      static_cast<unsigned char>(pixelSize & 0xFF), static_cast<unsigned char>(pixelSize >> 8),
+      0xFF, 0x0F,                                   // 컬러 매트릭스 (모노)
+      16,                                           // 비트/픽셀
+      0,                                            // 시리얼 포트 수
+      0                                             // 추가 기능
+    };
+    QueueResponse(reply, sizeof(reply));
+  } else if (type == 0x40) {
+    switch (cmd) {
+      case SIM_CMD_CLEAR_PIXELS:
+        // NOWIPE_FRAME은 수직 레지스터만 비움 (노출은 계속)
+        if (!(value & SIM_FLAG_NOWIPE_FRAME)) {
+          clearedAt = now;
+          readout.pending = false;
+        }
+        break;
+      case SIM_CMD_READ_PIXELS_DELAYED:
+      case SIM_CMD_READ_PIXELS: {
+        const bool delayed = cmd == SIM_CMD_READ_PIXELS_DELAYED;
+        if (paramLength < (delayed ? 14 : 10)) return LIBUSB_ERROR_PIPE;
+        Readout r;
+        r.pending = true;
+        r.xOffset = params[0] | (params[1] << 8);
+        r.yOffset = params[2] | (params[3] << 8);
+        r.width = params[4] | (params[5] << 8);
+        r.height = params[6] | (params[7] << 8);
+        r.xBin = std::max<int>(1, params[8]);
+        r.yBin = std::max<int>(1, params[9]);
+        if (delayed) {
+          // 암묵적 CLEAR_PIXELS 후 카메라 타이머만큼 노출
+          uint32_t delayMs = params[10] | (params[11] << 8) | (params[12] << 16) | ((uint32_t)params[13] << 24);
+          clearedAt = now;
+          timerMs = delayMs;
+          timerSetAt = now;
+          r.exposureSec = delayMs / 1000.0;
+          r.readyAt = now + std::chrono::milliseconds(delayMs);
+        } else {
+          r.exposureSec = std::chrono::duration<double>(now - clearedAt).count();
+          r.readyAt = now;
+        }
+        readout = r;
+        frameReady = false;
+        break;
+      }
+      case SIM_CMD_SET_TIMER:
+        if (paramLength < 4) return LIBUSB_ERROR_PIPE;
+        timerMs = params[0] | (params[1] << 8) | (params[2] << 16) | ((uint32_t)params[3] << 24);
+        timerSetAt = now;
+        break;
+      case SIM_CMD_RESET:
+        readout.pending = false;
+        frameReady = false;
+        timerMs = 0;
+        response.clear();
+        break;
+      default:
+        break;
+    }
+  }
+
+  *transferred = length;
+  return 0;
+}
+
+int SimTransport::BulkRead(unsigned char *data, int length, int *transferred, unsigned int timeoutMs) {
+  *transferred = 0;
+  if (!open) return LIBUSB_ERROR_NO_DEVICE;
+
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!response.empty()) {
+      int n = std::min<int>(length, response.size());
+      memcpy(data, response.data(), n);
+      response.erase(response.begin(), response.begin() + n);
+      *transferred = n;
+      return 0;
+    }
+  }
+
+  // 보낼 응답이 없으면 실제 장치처럼 타임아웃 (대기 시간은 faultStallMs로 제한)
+  Stall(timeoutMs);
+  return LIBUSB_ERROR_TIMEOUT;
+}
+
+void SimTransport::GenerateFrame(const Readout &r) {
+  const int w = r.width / r.xBin;
+  const int h = r.height / r.yBin;
+  const double t = r.exposureSec;
+  // 이번 프레임의 바이어스 (냉각하지 않는 카메라의 프레임 간 변동)
+  const double frameBias = options.biasAdu +
+    options.biasDriftAdu * gaussTable[NextRandom() & (SIM_GAUSS_TABLE_SIZE - 1)];
+
+  // 신호 (바이어스 + 하늘 + 별 + 핫 픽셀)
+  // CCD 폭을 넘는 열은 백 포치: 빛을 받지 않아 바이어스만 있음 (걸친 비닝 열은 활성 부분만큼 하늘)
+  std::vector<float> signal(static_cast<size_t>(w) * h);
+  std::vector<float> rowSignal(w);
+  for (int x = 0; x < w; x++) {
+    int activeColumns = std::max(0, std::min(r.xBin, options.ccdWidth - (r.xOffset + x * r.xBin)));
+    rowSignal[x] = static_cast<float>(frameBias + options.skyAduPerSec * t * activeColumns * r.yBin);
+  }
+  for (int y = 0; y < h; y++) {
+    std::copy(rowSignal.begin(), rowSignal.end(), signal.begin() + static_cast<size_t>(y) * w);
+  }
+  const int activeWidth = std::min(w, (options.ccdWidth - r.xOffset + r.xBin - 1) / r.xBin);
+
+  const double sx = options.starSigma / r.xBin;
+  const double sy = options.starSigma / r.yBin;
+  const int radiusX = static_cast<int>(std::ceil(4.0 * sx));
+  const int radiusY = static_cast<int>(std::ceil(4.0 * sy));
+  for (const Star &star : stars) {
+    // 비닝 좌표의 별 중심 (픽셀 중심 기준)
+    double cx = (star.x - r.xOffset) / r.xBin - 0.5;
+    double cy = (star.y - r.yOffset) / r.yBin - 0.5;
+    if (cx < -radiusX || cy < -radiusY || cx > w + radiusX || cy > h + radiusY) continue;
+    double amplitude = star.flux * t / (2.0 * M_PI * sx * sy);
+    int x0 = std::max(0, static_cast<int>(cx) - radiusX), x1 = std::min(activeWidth - 1, static_cast<int>(cx) + radiusX);
+    int y0 = std::max(0, static_cast<int>(cy) - radiusY), y1 = std::min(h - 1, static_cast<int>(cy) + radiusY);
+    for (int y = y0; y <= y1; y++) {
+      double dy = (y - cy) / sy;
+      float *row = signal.data() + static_cast<size_t>(y) * w;
+      for (int x = x0; x <= x1; x++) {
+        double dx = (x - cx) / sx;
+        row[x] += static_cast<float>(amplitude * std::exp(-0.5 * (dx * dx + dy * dy)));
+      }
+    }
+  }
+
+  for (int index : hotPixels) {
+    // 영역 밖(왼쪽/위)의 픽셀이 0 방향 나눗셈으로 첫 열/행에 들어오지 않도록 비닝 전에 확인
+    int ux = index % options.ccdWidth - r.xOffset;
+    int uy = index / options.ccdWidth - r.yOffset;
+    if (ux < 0 || uy < 0) continue;
+    int x = ux / r.xBin;
+    int y = uy / r.yBin;
+    if (x >= w || y >= h) continue;
+    signal[static_cast<size_t>(y) * w + x] += static_cast<float>(SIM_HOT_PIXEL_ADU_PER_SEC * t);
+  }
+
+  // 잡음 (읽기 잡음 + 광자 잡음, 이득 1 e-/ADU) 후 16비트로 클램프, little-endian으로 기록
+  frame.resize(signal.size() * 2);
+  const float readVar = static_cast<float>(options.readNoiseAdu * options.readNoiseAdu);
+  const float bias = static_cast<float>(frameBias);
+  for (size_t i = 0; i < signal.size(); i++) {
+    float s = signal[i];
+    float sigma = std::sqrt(readVar + std::max(0.0f, s - bias));
+    float v = s + sigma * gaussTable[NextRandom() & (SIM_GAUSS_TABLE_SIZE - 1)];
+    uint16_t pixel = static_cast<uint16_t>(std::min(65535.0f, std::max(0.0f, v + 0.5f)));
+    frame[i * 2] = pixel & 0xFF;
+    frame[i * 2 + 1] = pixel >> 8;
+  }
+}
+
+void SimTransport::ReadStream(SXReadStream &stream) {
+  stream.finished = false;
+  stream.error = 0;
+  if (!open) {
+    stream.error = LIBUSB_ERROR_NO_DEVICE;
+    return;
+  }
+
+  Readout r;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    r = readout;
+  }
+  if (!r.pending) {
+    Stall(stream.timeoutMs);
+    stream.error = LIBUSB_ERROR_TIMEOUT;
+    return;
+  }
+
+  // 노출이 끝날 때까지 대기 (전송 타임아웃보다 오래 남았으면 타임아웃)
+  auto now = std::chrono::steady_clock::now();
+  if (r.readyAt > now) {
+    if (r.readyAt - now > std::chrono::milliseconds(stream.timeoutMs)) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(stream.timeoutMs));
+      stream.error = LIBUSB_ERROR_TIMEOUT;
+      return;
+    }
+    std::this_thread::sleep_until(r.readyAt);
+  }
+
+  int total;
+  bool timeoutFault = false;
+  bool shortRead = false;
+  int end;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!readout.pending) {
+      // 대기 중 RESET
+      stream.error = LIBUSB_ERROR_TIMEOUT;
+      return;
+    }
+    if (!frameReady) {
+      GenerateFrame(readout);
+      frameReady = true;
+    }
+    total = std::min<int>(frame.size(), stream.expectedBytes);
+    end = total;
+
+    // 장애 주입: 타임아웃은 절반은 첫 데이터 전(재시도 경로), 절반은 중간(부분 수신 경로)
+    const int start = stream.contiguousBytes;
+    if (options.timeoutRate > 0 && NextUniform() < options.timeoutRate) {
+      timeoutFault = true;
+      int chunks = (total - start + stream.transferSize - 1) / stream.transferSize;
+      int k = (NextRandom() & 1) || chunks == 0 ? 0 : 1 + static_cast<int>(NextRandom() % chunks);
+      end = std::min(total, start + k * stream.transferSize);
+    } else if (options.shortReadRate > 0 && NextUniform() < options.shortReadRate) {
+      shortRead = true;
+      int packets = (total - start) / SIM_SHORT_READ_ALIGN;
+      end = start + (packets > 0 ? static_cast<int>(NextRandom() % packets) : 0) * SIM_SHORT_READ_ALIGN;
+    }
+  }
+
+  // 처리량 제한 스트리밍 (앞에서부터 순서대로, 전송 단위로 onData 호출)
+  auto streamStart = std::chrono::steady_clock::now();
+  const double bytesPerSec = options.throughputMBps * 1024.0 * 1024.0;
+  long sent = 0;
+  for (int offset = stream.contiguousBytes; offset < end; ) {
+    int length = std::min(stream.transferSize, end - offset);
+    sent += length;
+    if (bytesPerSec > 0) {
+      std::this_thread::sleep_until(streamStart + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<double>(sent / bytesPerSec)));
+    }
+    memcpy(stream.dest + offset, frame.data() + offset, length);
+    if (stream.contiguousBytes == 0) {
+      stream.firstChunkBytes = length;
+      stream.firstDataAt = std::chrono::steady_clock::now();
+    }
+    stream.contiguousBytes += length;
+    stream.transfers++;
+    if (stream.onData) stream.onData(offset, length);
+    offset += length;
+  }
+
+  if (timeoutFault) {
+    Stall(stream.timeoutMs);
+    stream.error = LIBUSB_ERROR_TIMEOUT;
+    LOG_WARN("시뮬레이터: 타임아웃 주입 (%d/%d 바이트 후)", stream.contiguousBytes, total);
+    // 첫 데이터 전이면 읽기를 유지해 재시도 가능
+    if (stream.contiguousBytes == 0) return;
+  } else if (shortRead || end < stream.expectedBytes) {
+    // 짧은 패킷 = 장치가 보낼 데이터 끝
+    stream.finished = true;
+    if (shortRead) LOG_WARN("시뮬레이터: 짧은 읽기 주입 (%d/%d 바이트)", end, total);
+  }
+
+  std::lock_guard<std::mutex> lock(mutex);
+  readout.pending = false;
+  frameReady = false;
+}
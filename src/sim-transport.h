@@ -0,0 +1,113 @@
+// sim-transport.h
+// 하드웨어 없는 ECHO2 시뮬레이터 transport
+// 명령 블록 프로토콜(CLEAR_PIXELS, READ_PIXELS, READ_PIXELS_DELAYED, SET/GET_TIMER, RESET, GET_CCD_PARAMS 등)을 해석하고
+// 고정 시드의 합성 별 영상을 설정한 USB 처리량으로 스트리밍한다. 타임아웃/짧은 읽기 장애 주입 지원.
+#ifndef SX_SIM_TRANSPORT_H
+#define SX_SIM_TRANSPORT_H
+
+#include <napi.h>
+#include "sx-transport.h"
+#include <mutex>
+#include <vector>
+#include <random>
+
+#define SIM_CCD_WIDTH                1392    // ECHO2 (ICX825) 해상도, GET_CCD_PARAMS로 보고 (다른 모델은 옵션으로)
+#define SIM_CCD_HEIGHT               1040
+#define SIM_PIXEL_SIZE_UM            6.45
+#define SIM_H_BACK_PORCH             16      // 행 끝의 검은 기준 픽셀 (GET_CCD_PARAMS로 보고, 바이어스만 들어 있음)
+#define SIM_MAX_CCD_SIZE             8192
+#define SIM_MODEL_CODE               0x25    // ECHO2
+#define SIM_FIRMWARE_MAJOR           1
+#define SIM_FIRMWARE_MINOR           17
+
+#define SIM_DEFAULT_SEED             1
+#define SIM_DEFAULT_STARS            400
+#define SIM_DEFAULT_BIAS_ADU         1000.0
+#define SIM_DEFAULT_BIAS_DRIFT_ADU   0.0     // 프레임마다 바뀌는 바이어스 변동 (표준편차)
+#define SIM_DEFAULT_SKY_ADU_PER_SEC  30.0
+#define SIM_DEFAULT_STAR_FLUX        20000.0 // 가장 밝은 별의 초당 총 ADU
+#define SIM_DEFAULT_STAR_SIGMA       1.3     // PSF 표준편차 (픽셀)
+#define SIM_DEFAULT_READ_NOISE_ADU   8.0
+#define SIM_DEFAULT_HOT_PIXELS       50
+#define SIM_DEFAULT_FAULT_STALL_MS   200     // 장애 주입 시 멈춰 있는 최대 시간
+
+struct SimOptions {
+  uint32_t seed;            // 별/핫 픽셀 배치와 잡음 시드 (같은 시드면 같은 하늘)
+  int ccdWidth;             // GET_CCD_PARAMS로 보고하는 CCD 크기와 픽셀 크기
+  int ccdHeight;
+  double pixelSizeUm;
+  int hBackPorch;
+  int stars;
+  double biasAdu;
+  double biasDriftAdu;      // 냉각하지 않는 카메라처럼 프레임마다 바이어스가 흔들림
+  double skyAduPerSec;
+  double starFlux;
+  double starSigma;
+  double readNoiseAdu;
+  int hotPixels;
+  double throughputMBps;    // 0이면 제한 없음
+  double timeoutRate;       // 수신 시도마다 타임아웃이 발생할 확률 (0~1)
+  double shortReadRate;     // 수신 시도마다 짧은 읽기(중간에 데이터 끝)가 발생할 확률 (0~1)
+  unsigned int faultStallMs;
+};
+
+SimOptions SimDefaultOptions();
+
+// JS 옵션 객체({ seed, stars, biasAdu, ... })를 기본값 위에 덮어씀
+bool ParseSimOptions(const Napi::Value &value, SimOptions &options, std::string &error);
+
+class SimTransport : public SXTransport {
+public:
+  explicit SimTransport(const SimOptions &options);
+
+  const char* Name() const override { return "sim"; }
+  bool Open(std::string &error) override;
+  void Close() override;
+  bool IsOpen() const override { return open; }
+  uint16_t ProductId() const override;
+
+  int ControlIn(uint8_t request, uint16_t value, uint16_t index,
+                unsigned char *data, uint16_t length, unsigned int timeoutMs) override;
+  int BulkWrite(const unsigned char *data, int length, int *transferred, unsigned int timeoutMs) override;
+  int BulkRead(unsigned char *data, int length, int *transferred, unsigned int timeoutMs) override;
+  void ReadStream(SXReadStream &stream) override;
+
+private:
+  struct Star {
+    float x, y;     // CCD 좌표 (비닝 전)
+    float flux;     // 초당 총 ADU
+  };
+
+  // 대기 중인 읽기 (READ_PIXELS / READ_PIXELS_DELAYED)
+  struct Readout {
+    bool pending;
+    int xOffset, yOffset, width, height, xBin, yBin;
+    double exposureSec;
+    std::chrono::steady_clock::time_point readyAt;
+  };
+
+  void QueueResponse(const unsigned char *data, int length);
+  void GenerateFrame(const Readout &readout);
+  uint32_t NextRandom();
+  double NextUniform() { return NextRandom() / 4294967296.0; }
+  void Stall(unsigned int timeoutMs);
+
+  SimOptions options;
+  bool open;
+
+  std::mutex mutex;  // 명령 상태 (워커 스레드와 JS 스레드가 공유)
+  std::vector<unsigned char> response;           // 0xC0 명령 응답 (BulkRead로 읽음)
+  std::chrono::steady_clock::time_point clearedAt; // 마지막 CLEAR_PIXELS (노출 시작)
+  uint32_t timerMs;
+  std::chrono::steady_clock::time_point timerSetAt;
+  Readout readout;
+
+  std::vector<Star> stars;
+  std::vector<int> hotPixels;                    // CCD 픽셀 인덱스
+  std::vector<float> gaussTable;                 // N(0,1) 표본 (잡음 생성용)
+  uint32_t rngState;
+  std::vector<unsigned char> frame;              // 현재 읽기의 little-endian 픽셀 데이터
+  bool frameReady;
+};
+
+#endif // SX_SIM_TRANSPORT_H
@@ -0,0 +1,344 @@
+// stacker.cc
+#include "stacker.h"
+#include "parallel-for.h"
+#include "sx-log.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <string>
+
+#define STACK_ROW_BLOCK            16      // 스레드가 한 번에 가져가는 행 수
+#define STACK_CLIP_SCALE_SIZE      1024    // 이보다 많이 받은 픽셀은 마지막 배율 사용 (kappa와 거의 같음)
+
+static const char *STACK_MODE_NAMES[] = {"mean", "sum", "sigma"};
+
+// 한 행 누적 (모드별로 분리해 평균/합 루프는 분기 없이 자동 벡터화되도록)
+static void AccumulateSumRow(const uint16_t *__restrict src, uint32_t *__restrict sum, int width) {
+  for (int x = 0; x < width; x++) sum[x] += src[x];
+}
+
+// 받은 수 n에서의 클리핑 폭 배율: 표본 표준편차로 새 값을 판정하므로 t 분포 분위수 근사(Cornish-Fisher 1차)와
+// 예측 구간 sqrt(1 + 1/n)을 곱함. 초반에 정상 값을 과하게 버리지 않고, n이 커지면 kappa로 수렴
+static std::vector<float> ClipScale(float kappa) {
+  std::vector<float> scale(STACK_CLIP_SCALE_SIZE, 0.0f);
+  for (int n = STACK_CLIP_WARMUP; n < STACK_CLIP_SCALE_SIZE; n++) {
+    scale[n] = kappa * (1.0f + (kappa * kappa + 1.0f) / (4.0f * (n - 1))) * std::sqrt(1.0f + 1.0f / n);
+  }
+  return scale;
+}
+
+// Welford 갱신: 받은 수가 STACK_CLIP_WARMUP 이상이면 평균에서 scale[n] * 표준편차 밖의 값은 버림
+static size_t AccumulateSigmaRow(const uint16_t *__restrict src, float *__restrict mean, float *__restrict m2,
+                                 uint16_t *__restrict count, int width, const float *scale) {
+  size_t rejected = 0;
+  for (int x = 0; x < width; x++) {
+    const float v = src[x];
+    const int n = count[x];
+    if (n >= STACK_CLIP_WARMUP) {
+      const float sigma = std::max(std::sqrt(m2[x] / (n - 1)), static_cast<float>(STACK_MIN_SIGMA_ADU));
+      if (std::fabs(v - mean[x]) > scale[std::min(n, STACK_CLIP_SCALE_SIZE - 1)] * sigma) {
+        rejected++;
+        continue;
+      }
+    }
+    const float delta = v - mean[x];
+    mean[x] += delta / (n + 1);
+    m2[x] += delta * (v - mean[x]);
+    count[x] = static_cast<uint16_t>(n + 1);
+  }
+  return rejected;
+}
+
+void FrameStacker::Accumulate(const uint16_t *pixels, size_t &rejectedPixels) {
+  const size_t pixelCount = static_cast<size_t>(width) * height;
+  if (mode == STACK_MODE_SIGMA) {
+    if (mean.size() != pixelCount) {
+      mean.assign(pixelCount, 0.0f);
+      m2.assign(pixelCount, 0.0f);
+      count.assign(pixelCount, 0);
+    }
+  } else if (sum.size() != pixelCount) {
+    sum.assign(pixelCount, 0);
+  }
+
+  // 행 블록을 공유 풀 스레드가 원자 카운터로 나눠 가짐 (한 스레드가 늦어도 나머지가 남은 블록을 처리)
+  std::atomic<size_t> rejected(0);
+  if (mode == STACK_MODE_SIGMA && clipScale.empty()) clipScale = ClipScale(static_cast<float>(kappa));
+  const float *scale = clipScale.data();
+  ParallelFor((height + STACK_ROW_BLOCK - 1) / STACK_ROW_BLOCK, threads, [&](int block) {
+    const int y0 = block * STACK_ROW_BLOCK;
+    const int y1 = std::min(height, y0 + STACK_ROW_BLOCK);
+    size_t blockRejected = 0;
+    for (int y = y0; y < y1; y++) {
+      const size_t offset = static_cast<size_t>(y) * width;
+      if (mode == STACK_MODE_SIGMA) {
+        blockRejected += AccumulateSigmaRow(pixels + offset, mean.data() + offset, m2.data() + offset,
+                                            count.data() + offset, width, scale);
+      } else {
+        AccumulateSumRow(pixels + offset, sum.data() + offset, width);
+      }
+    }
+    if (blockRejected > 0) rejected.fetch_add(blockRejected, std::memory_order_relaxed);
+  });
+  rejectedPixels = rejected.load();
+}
+
+void FrameStacker::ResetInternal() {
+  width = 0;
+  height = 0;
+  frames = 0;
+  totalExposure = 0.0;
+  rejected = 0;
+  lastAddMs = 0.0;
+  // 큰 버퍼는 메모리까지 돌려줌
+  std::vector<uint32_t>().swap(sum);
+  std::vector<float>().swap(mean);
+  std::vector<float>().swap(m2);
+  std::vector<uint16_t>().swap(count);
+}
+
+// ===== 비동기 누적 =====
+
+class StackAddWorker : public Napi::AsyncWorker {
+public:
+  StackAddWorker(Napi::Env env, FrameStacker *stacker, Napi::Object dataObj, const uint16_t *pixels, double exposure)
+    : Napi::AsyncWorker(env, "SXStackAdd"),
+      deferred(Napi::Promise::Deferred::New(env)),
+      stacker(stacker), pixels(pixels), exposure(exposure), rejected(0), addMs(0.0) {
+    // 누적이 끝날 때까지 프레임 버퍼와 스태커가 GC되지 않도록 참조 유지
+    dataRef = Napi::Persistent(dataObj);
+    stackerRef = Napi::Persistent(stacker->Value());
+  }
+
+  Napi::Promise GetPromise() const { return deferred.Promise(); }
+
+protected:
+  void Execute() override {
+    auto start = std::chrono::steady_clock::now();
+    stacker->Accumulate(pixels, rejected);
+    addMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  }
+
+  void OnOK() override {
+    Napi::Env env = Env();
+    stacker->frames++;
+    stacker->totalExposure += exposure;
+    stacker->rejected += rejected;
+    stacker->lastAddMs = addMs;
+    stacker->busy = false;
+    LOG_DEBUG("스택 %d번째 프레임 누적: %.1f ms, 제외 %zu픽셀", stacker->frames, addMs, rejected);
+
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("frames", Napi::Number::New(env, stacker->frames));
+    result.Set("rejected", Napi::Number::New(env, static_cast<double>(rejected)));
+    result.Set("addMs", Napi::Number::New(env, addMs));
+    deferred.Resolve(result);
+  }
+
+  void OnError(const Napi::Error &error) override {
+    stacker->busy = false;
+    deferred.Reject(error.Value());
+  }
+
+private:
+  Napi::Promise::Deferred deferred;
+  Napi::ObjectReference dataRef;
+  Napi::ObjectReference stackerRef;
+  FrameStacker *stacker;
+  const uint16_t *pixels;
+  double exposure;
+  size_t rejected;
+  double addMs;
+};
+
+// ===== N-API =====
+
+Napi::Object FrameStacker::Init(Napi::Env env, Napi::Object exports) {
+  Napi::Function func = DefineClass(env, "FrameStacker", {
+    InstanceMethod("add", &FrameStacker::Add),
+    InstanceMethod("getResult", &FrameStacker::GetResult),
+    InstanceMethod("getInfo", &FrameStacker::GetInfo),
+    InstanceMethod("reset", &FrameStacker::Reset)
+  });
+
+  // 모듈 수명 동안 생성자 유지
+  Napi::FunctionReference *constructor = new Napi::FunctionReference();
+  *constructor = Napi::Persistent(func);
+  constructor->SuppressDestruct();
+
+  exports.Set("FrameStacker", func);
+  return exports;
+}
+
+// new FrameStacker({ mode: 'mean' | 'sum' | 'sigma', kappa, threads })
+FrameStacker::FrameStacker(const Napi::CallbackInfo& info)
+  : Napi::ObjectWrap<FrameStacker>(info),
+    mode(STACK_MODE_MEAN),
+    kappa(STACK_DEFAULT_KAPPA),
+    threads(0),
+    width(0),
+    height(0),
+    busy(false),
+    frames(0),
+    totalExposure(0.0),
+    rejected(0),
+    lastAddMs(0.0)
+{
+  Napi::Env env = info.Env();
+  if (info.Length() < 1 || !info[0].IsObject()) return;
+
+  Napi::Object opts = info[0].As<Napi::Object>();
+  if (opts.Get("mode").IsString()) {
+    std::string name = opts.Get("mode").As<Napi::String>().Utf8Value();
+    int found = -1;
+    for (int i = STACK_MODE_MEAN; i <= STACK_MODE_SIGMA; i++) {
+      if (name == STACK_MODE_NAMES[i]) found = i;
+    }
+    if (found < 0) {
+      Napi::TypeError::New(env, "스택 방식(mode)은 'mean', 'sum', 'sigma' 중 하나여야 합니다.").ThrowAsJavaScriptException();
+      return;
+    }
+    mode = found;
+  }
+  if (opts.Get("kappa").IsNumber()) {
+    double value = opts.Get("kappa").As<Napi::Number>().DoubleValue();
+    if (!(value > 0.0)) {
+      Napi::RangeError::New(env, "kappa는 0보다 커야 합니다.").ThrowAsJavaScriptException();
+      return;
+    }
+    kappa = value;
+  }
+  if (opts.Get("threads").IsNumber()) {
+    threads = std::max(0, std::min(opts.Get("threads").As<Napi::Number>().Int32Value(), STACK_MAX_THREADS));
+  }
+}
+
+// add(image) -> Promise<{ frames, rejected, addMs }>  image: { data: Uint16Array, width, height, exposureTime }
+Napi::Value FrameStacker::Add(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  Napi::Promise::Deferred deferred = Napi::Promise::Deferred::New(env);
+
+  if (busy) {
+    deferred.Reject(Napi::Error::New(env, "이전 프레임을 누적하는 중입니다.").Value());
+    return deferred.Promise();
+  }
+  if (frames >= STACK_MAX_FRAMES) {
+    deferred.Reject(Napi::RangeError::New(env, "스택 프레임 수가 최대(" + std::to_string(STACK_MAX_FRAMES) + ")에 도달했습니다.").Value());
+    return deferred.Promise();
+  }
+
+  Napi::Object image = info.Length() >= 1 && info[0].IsObject() ? info[0].As<Napi::Object>() : Napi::Object::New(env);
+  Napi::Value data = image.Get("data");
+  int frameWidth = image.Get("width").IsNumber() ? image.Get("width").As<Napi::Number>().Int32Value() : 0;
+  int frameHeight = image.Get("height").IsNumber() ? image.Get("height").As<Napi::Number>().Int32Value() : 0;
+  if (!data.IsTypedArray() || data.As<Napi::TypedArray>().TypedArrayType() != napi_uint16_array ||
+      frameWidth <= 0 || frameHeight <= 0 ||
+      data.As<Napi::TypedArray>().ElementLength() < static_cast<size_t>(frameWidth) * frameHeight) {
+    deferred.Reject(Napi::TypeError::New(env, "이미지 데이터는 width*height 크기의 Uint16Array여야 합니다.").Value());
+    return deferred.Promise();
+  }
+  if (frames > 0 && (frameWidth != width || frameHeight != height)) {
+    deferred.Reject(Napi::Error::New(env, "프레임 크기(" + std::to_string(frameWidth) + "x" + std::to_string(frameHeight) +
+                                          ")가 스택(" + std::to_string(width) + "x" + std::to_string(height) +
+                                          ")과 다릅니다.").Value());
+    return deferred.Promise();
+  }
+
+  width = frameWidth;
+  height = frameHeight;
+  busy = true;
+  Napi::Uint16Array pixels = data.As<Napi::Uint16Array>();
+  double exposure = image.Get("exposureTime").IsNumber() ? image.Get("exposureTime").As<Napi::Number>().DoubleValue() : 0.0;
+  StackAddWorker *worker = new StackAddWorker(env, this, pixels, pixels.Data(), exposure);
+  Napi::Promise promise = worker->GetPromise();
+  worker->Queue();
+  return promise;
+}
+
+// getResult({ uint16 }) -> { data: Float32Array (uint16이면 반올림/포화한 Uint16Array), width, height, frames, ... }
+// 평균/시그마는 프레임 하나와 같은 단위, 합은 프레임 합
+Napi::Value FrameStacker::GetResult(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  if (busy) {
+    Napi::Error::New(env, "프레임을 누적하는 중에는 결과를 만들 수 없습니다.").ThrowAsJavaScriptException();
+    return env.Undefined();
+  }
+  if (frames == 0) {
+    Napi::Error::New(env, "누적한 프레임이 없습니다.").ThrowAsJavaScriptException();
+    return env.Undefined();
+  }
+  bool asUint16 = info.Length() >= 1 && info[0].IsObject() &&
+                  info[0].As<Napi::Object>().Get("uint16").ToBoolean().Value();
+
+  const size_t pixelCount = static_cast<size_t>(width) * height;
+  Napi::Float32Array floats;
+  Napi::Uint16Array words;
+  float *out = nullptr;
+  uint16_t *outWords = nullptr;
+  if (asUint16) {
+    words = Napi::Uint16Array::New(env, pixelCount);
+    outWords = words.Data();
+  } else {
+    floats = Napi::Float32Array::New(env, pixelCount);
+    out = floats.Data();
+  }
+
+  const float scale = mode == STACK_MODE_MEAN ? 1.0f / frames : 1.0f;
+  for (size_t i = 0; i < pixelCount; i++) {
+    float v = mode == STACK_MODE_SIGMA ? mean[i] : sum[i] * scale;
+    if (out) {
+      out[i] = v;
+    } else {
+      outWords[i] = static_cast<uint16_t>(std::min(65535.0f, v + 0.5f));
+    }
+  }
+
+  Napi::Object result = Napi::Object::New(env);
+  if (asUint16) {
+    result.Set("data", words);
+  } else {
+    result.Set("data", floats);
+  }
+  result.Set("width", Napi::Number::New(env, width));
+  result.Set("height", Napi::Number::New(env, height));
+  result.Set("pixelCount", Napi::Number::New(env, static_cast<double>(pixelCount)));
+  result.Set("frames", Napi::Number::New(env, frames));
+  result.Set("stackMode", Napi::String::New(env, STACK_MODE_NAMES[mode]));
+  // 평균/시그마 결과의 노출은 프레임 평균 (단위가 한 장과 같음), 합은 전체 노출
+  result.Set("exposureTime", Napi::Number::New(env, mode == STACK_MODE_SUM ? totalExposure : totalExposure / frames));
+  result.Set("totalExposure", Napi::Number::New(env, totalExposure));
+  result.Set("rejected", Napi::Number::New(env, static_cast<double>(rejected)));
+  result.Set("rejectedFraction", Napi::Number::New(env, static_cast<double>(rejected) / (static_cast<double>(pixelCount) * frames)));
+  return result;
+}
+
+Napi::Value FrameStacker::GetInfo(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  Napi::Object result = Napi::Object::New(env);
+  result.Set("mode", Napi::String::New(env, STACK_MODE_NAMES[mode]));
+  result.Set("kappa", Napi::Number::New(env, kappa));
+  result.Set("threads", Napi::Number::New(env, threads));
+  result.Set("width", Napi::Number::New(env, width));
+  result.Set("height", Napi::Number::New(env, height));
+  result.Set("frames", Napi::Number::New(env, frames));
+  result.Set("totalExposure", Napi::Number::New(env, totalExposure));
+  result.Set("rejected", Napi::Number::New(env, static_cast<double>(rejected)));
+  result.Set("lastAddMs", Napi::Number::New(env, lastAddMs));
+  result.Set("busy", Napi::Boolean::New(env, busy));
+  return result;
+}
+
+Napi::Value FrameStacker::Reset(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  if (busy) {
+    Napi::Error::New(env, "프레임을 누적하는 중에는 초기화할 수 없습니다.").ThrowAsJavaScriptException();
+    return env.Undefined();
+  }
+  ResetInternal();
+  return env.Undefined();
+}
+
+Napi::Object InitStacker(Napi::Env env, Napi::Object exports) {
+  return FrameStacker::Init(env, exports);
+}
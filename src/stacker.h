@@ -0,0 +1,64 @@
+// stacker.h
+// 네이티브 프레임 스태커 (긴 적분용)
+// 촬영한 Uint16Array 프레임을 하나씩 받아 32비트 누적 버퍼에 더한다. 프레임을 보관하지 않으므로 메모리는 스택 깊이와
+// 무관하게 프레임 몇 장 분량이다. 시그마 클리핑은 픽셀별 평균/분산을 Welford 방식으로 갱신하면서 새 값이
+// 지금까지의 분포에서 벗어나면 버리는 누적(running) 방식 (위성/비행기 궤적, 우주선 제거용).
+// 행을 나눠 여러 스레드에서 누적하고, 결과는 Float32Array로 돌려줘 기존 writeFits(BITPIX=-32)로 저장한다.
+#ifndef SX_STACKER_H
+#define SX_STACKER_H
+
+#include <napi.h>
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+#define STACK_MODE_MEAN            0       // 합 / 프레임 수
+#define STACK_MODE_SUM             1       // 합 (uint32, 포화 없음)
+#define STACK_MODE_SIGMA           2       // 누적 시그마 클리핑 평균
+
+#define STACK_DEFAULT_KAPPA        3.0
+#define STACK_CLIP_WARMUP          5       // 이 수만큼 받은 픽셀부터 클리핑 (그 전에는 분산 추정이 너무 불안정)
+#define STACK_MIN_SIGMA_ADU        2.0     // 클리핑 기준 표준편차의 하한 (잡음이 거의 없는 픽셀이 다 버려지지 않도록)
+#define STACK_MAX_FRAMES           65535   // 픽셀별 받은 수가 uint16
+#define STACK_MAX_THREADS          16
+
+class FrameStacker : public Napi::ObjectWrap<FrameStacker> {
+public:
+  static Napi::Object Init(Napi::Env env, Napi::Object exports);
+  FrameStacker(const Napi::CallbackInfo& info);
+
+  // 워커 스레드에서 한 프레임 누적 (rejected: 이 프레임에서 버린 픽셀 수)
+  void Accumulate(const uint16_t *pixels, size_t &rejected);
+
+private:
+  friend class StackAddWorker;
+
+  Napi::Value Add(const Napi::CallbackInfo& info);
+  Napi::Value GetResult(const Napi::CallbackInfo& info);
+  Napi::Value GetInfo(const Napi::CallbackInfo& info);
+  Napi::Value Reset(const Napi::CallbackInfo& info);
+
+  void ResetInternal();
+
+  int mode;
+  double kappa;
+  int threads;
+  int width;              // 첫 프레임에서 정함
+  int height;
+
+  std::atomic<bool> busy;  // 누적 중에는 다른 add/결과/초기화를 받지 않음
+  int frames;
+  double totalExposure;
+  uint64_t rejected;
+  double lastAddMs;
+
+  std::vector<uint32_t> sum;     // 평균/합 모드
+  std::vector<float> mean;       // 시그마 모드: 픽셀별 평균, 편차 제곱합, 받은 수
+  std::vector<float> m2;
+  std::vector<uint16_t> count;
+  std::vector<float> clipScale;  // 받은 수별 클리핑 폭 (kappa 배율, 첫 누적 때 계산)
+};
+
+Napi::Object InitStacker(Napi::Env env, Napi::Object exports);
+
+#endif // SX_STACKER_H
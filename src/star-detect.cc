@@ -0,0 +1,599 @@
+// star-detect.cc
+#include "star-detect.h"
+#include "cloud-cover.h"
+#include "frame-stats.h"
+#include "parallel-for.h"
+#include "sx-log.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+#define STAR_FWHM_PER_SIGMA        2.3548  // 2 * sqrt(2 ln 2)
+#define STAR_ANNULUS_WIDTH         2       // 측정 창 바깥 국소 배경 고리 폭 (픽셀)
+
+StarDetectOptions StarDetectDefaultOptions() {
+  StarDetectOptions options;
+  options.sigma = STAR_DEFAULT_SIGMA;
+  options.minArea = STAR_DEFAULT_MIN_AREA;
+  options.maxArea = STAR_DEFAULT_MAX_AREA;
+  options.meshSize = STAR_DEFAULT_MESH;
+  options.threads = 0;
+  options.list = false;
+  return options;
+}
+
+// ===== 배경 메시 =====
+
+struct Mesh {
+  int size;
+  int columns;
+  int rows;
+  std::vector<float> background;
+  std::vector<float> rms;
+  // 픽셀 열 -> 보간할 두 칸과 가중치 (프레임마다 한 번 계산)
+  std::vector<int> column0;
+  std::vector<float> columnWeight;
+};
+
+// 칸 하나: 포화 픽셀을 빼고 중앙값 ± 3 sigma(MAD) 클리핑을 반복한 뒤 남은 값의 평균/표준편차
+// 16비트 값 히스토그램에서 구간만 좁혀 가며 계산 (칸마다 정렬/선택을 반복하는 것보다 훨씬 빠름)
+static void MeshCell(const uint16_t *pixels, int width, int height, int size, int cx, int cy,
+                     float &background, float &rms) {
+  static thread_local std::vector<uint32_t> histogram;
+  if (histogram.empty()) histogram.assign(FRAME_STATS_BINS, 0);
+  const int x0 = cx * size, x1 = std::min(width, x0 + size);
+  const int y0 = cy * size, y1 = std::min(height, y0 + size);
+  int lo = FRAME_STATS_BINS, hi = -1;
+  uint32_t count = 0;
+  for (int y = y0; y < y1; y++) {
+    const uint16_t *row = pixels + static_cast<size_t>(y) * width;
+    for (int x = x0; x < x1; x++) {
+      const uint16_t v = row[x];
+      if (v >= FRAME_STATS_SATURATION) continue;
+      histogram[v]++;
+      count++;
+      lo = std::min(lo, static_cast<int>(v));
+      hi = std::max(hi, static_cast<int>(v));
+    }
+  }
+  if (count < 4) {
+    background = NAN;
+    rms = NAN;
+  } else {
+    for (int iteration = 0; iteration < STAR_MESH_CLIP_ITERATIONS; iteration++) {
+      int median = lo;
+      for (uint32_t below = histogram[lo]; below * 2 <= count; below += histogram[++median]) {}
+      // MAD: 중앙값에서 양쪽으로 넓혀 가며 절반이 들어오는 거리
+      int mad = 0;
+      for (uint32_t within = histogram[median]; within * 2 <= count;) {
+        mad++;
+        if (median - mad >= lo) within += histogram[median - mad];
+        if (median + mad <= hi) within += histogram[median + mad];
+      }
+      const double sigma = std::max(FRAME_STATS_MAD_TO_SIGMA * mad, STAR_MIN_RMS);
+      const int clipLo = std::max(lo, static_cast<int>(std::ceil(median - STAR_MESH_CLIP_SIGMA * sigma)));
+      const int clipHi = std::min(hi, static_cast<int>(std::floor(median + STAR_MESH_CLIP_SIGMA * sigma)));
+      uint32_t kept = 0;
+      for (int v = clipLo; v <= clipHi; v++) kept += histogram[v];
+      if (kept < 4) break;
+      const bool converged = kept == count;
+      lo = clipLo;
+      hi = clipHi;
+      count = kept;
+      if (converged) break;
+    }
+
+    double sum = 0.0, sumSq = 0.0;
+    for (int v = lo; v <= hi; v++) {
+      sum += static_cast<double>(histogram[v]) * v;
+      sumSq += static_cast<double>(histogram[v]) * v * v;
+    }
+    const double mean = sum / count;
+    background = static_cast<float>(mean);
+    rms = static_cast<float>(std::max(std::sqrt(std::max(0.0, sumSq / count - mean * mean)), STAR_MIN_RMS));
+  }
+
+  // 다음 칸을 위해 쓴 칸만 되돌림
+  for (int y = y0; y < y1; y++) {
+    const uint16_t *row = pixels + static_cast<size_t>(y) * width;
+    for (int x = x0; x < x1; x++) histogram[row[x]] = 0;
+  }
+}
+
+// 3x3 중앙값 필터 (밝은 별/빈 칸이 배경 지도에 남지 않도록). 값이 없는 칸은 이웃 값으로, 그래도 없으면 fallback
+static void FilterMesh(std::vector<float> &grid, int columns, int rows, float fallback) {
+  std::vector<float> out(grid.size());
+  float window[9];
+  for (int y = 0; y < rows; y++) {
+    for (int x = 0; x < columns; x++) {
+      int n = 0;
+      for (int dy = -1; dy <= 1; dy++) {
+        for (int dx = -1; dx <= 1; dx++) {
+          int nx = x + dx, ny = y + dy;
+          if (nx < 0 || ny < 0 || nx >= columns || ny >= rows) continue;
+          float v = grid[static_cast<size_t>(ny) * columns + nx];
+          if (!std::isnan(v)) window[n++] = v;
+        }
+      }
+      if (n == 0) {
+        out[static_cast<size_t>(y) * columns + x] = fallback;
+        continue;
+      }
+      std::nth_element(window, window + n / 2, window + n);
+      out[static_cast<size_t>(y) * columns + x] = window[n / 2];
+    }
+  }
+  grid.swap(out);
+}
+
+static float MedianOf(std::vector<float> values) {
+  values.erase(std::remove_if(values.begin(), values.end(), [](float v) { return std::isnan(v); }), values.end());
+  if (values.empty()) return 0.0f;
+  std::nth_element(values.begin(), values.begin() + values.size() / 2, values.end());
+  return values[values.size() / 2];
+}
+
+// 칸 중심 사이 쌍선형 보간으로 한 행의 배경/잡음 (가장자리 바깥은 끝 칸 값)
+static void InterpolateRow(const Mesh &mesh, int y, int width, float *background, float *rms) {
+  float fy = (y + 0.5f) / mesh.size - 0.5f;
+  int my0 = std::max(0, std::min(mesh.rows - 1, static_cast<int>(std::floor(fy))));
+  int my1 = std::min(mesh.rows - 1, my0 + 1);
+  float ty = std::max(0.0f, std::min(1.0f, fy - my0));
+
+  static thread_local std::vector<float> columnBackground, columnRms;
+  columnBackground.resize(mesh.columns);
+  columnRms.resize(mesh.columns);
+  for (int mx = 0; mx < mesh.columns; mx++) {
+    size_t a = static_cast<size_t>(my0) * mesh.columns + mx;
+    size_t b = static_cast<size_t>(my1) * mesh.columns + mx;
+    columnBackground[mx] = mesh.background[a] + (mesh.background[b] - mesh.background[a]) * ty;
+    columnRms[mx] = mesh.rms[a] + (mesh.rms[b] - mesh.rms[a]) * ty;
+  }
+  for (int x = 0; x < width; x++) {
+    int mx0 = mesh.column0[x];
+    int mx1 = std::min(mesh.columns - 1, mx0 + 1);
+    float tx = mesh.columnWeight[x];
+    background[x] = columnBackground[mx0] + (columnBackground[mx1] - columnBackground[mx0]) * tx;
+    rms[x] = columnRms[mx0] + (columnRms[mx1] - columnRms[mx0]) * tx;
+  }
+}
+
+static float BackgroundAt(const Mesh &mesh, float x, float y) {
+  float fx = (x + 0.5f) / mesh.size - 0.5f;
+  float fy = (y + 0.5f) / mesh.size - 0.5f;
+  int mx0 = std::max(0, std::min(mesh.columns - 1, static_cast<int>(std::floor(fx))));
+  int my0 = std::max(0, std::min(mesh.rows - 1, static_cast<int>(std::floor(fy))));
+  int mx1 = std::min(mesh.columns - 1, mx0 + 1);
+  int my1 = std::min(mesh.rows - 1, my0 + 1);
+  float tx = std::max(0.0f, std::min(1.0f, fx - mx0));
+  float ty = std::max(0.0f, std::min(1.0f, fy - my0));
+  auto at = [&](int mx, int my) { return mesh.background[static_cast<size_t>(my) * mesh.columns + mx]; };
+  float top = at(mx0, my0) + (at(mx1, my0) - at(mx0, my0)) * tx;
+  float bottom = at(mx0, my1) + (at(mx1, my1) - at(mx0, my1)) * tx;
+  return top + (bottom - top) * ty;
+}
+
+// ===== 임계값/연결 요소 =====
+
+// 임계값을 넘는 한 행의 연속 구간 [x0, x1]과 그 픽셀의 모멘트 (배경을 뺀 값)
+struct Run {
+  int y;
+  int x0;
+  int x1;
+  double flux;
+  double sumX;
+  double sumY;
+  float peak;
+  bool saturated;
+};
+
+// 행 띠 하나의 런과 띠 안 union-find (부모는 띠 안 인덱스)
+struct Band {
+  int y0;
+  int y1;
+  std::vector<Run> runs;
+  std::vector<int> parent;
+};
+
+static int FindRoot(std::vector<int> &parent, int i) {
+  while (parent[i] != i) {
+    parent[i] = parent[parent[i]];
+    i = parent[i];
+  }
+  return i;
+}
+
+static void Union(std::vector<int> &parent, int a, int b) {
+  a = FindRoot(parent, a);
+  b = FindRoot(parent, b);
+  if (a == b) return;
+  if (a < b) parent[b] = a;
+  else parent[a] = b;
+}
+
+// 8-연결: 이웃 행의 두 런이 한 칸 어긋나도 이어짐
+static bool RunsTouch(const Run &a, const Run &b) {
+  return a.x0 <= b.x1 + 1 && b.x0 <= a.x1 + 1;
+}
+
+// 위 행 런 [prevBegin, prevEnd)와 현재 행 런 [curBegin, curEnd)를 이음 (둘 다 x 순)
+static void LinkRows(const std::vector<Run> &runs, std::vector<int> &parent, int prevBegin, int prevEnd,
+                     int curBegin, int curEnd, int offsetPrev = 0, int offsetCur = 0,
+                     const std::vector<Run> *curRuns = nullptr) {
+  const std::vector<Run> &cur = curRuns ? *curRuns : runs;
+  int p = prevBegin;
+  for (int c = curBegin; c < curEnd; c++) {
+    // 현재 런보다 완전히 왼쪽에 있는 위 런은 이후 런과도 닿지 않음
+    while (p < prevEnd && runs[p].x1 + 1 < cur[c].x0) p++;
+    for (int q = p; q < prevEnd && runs[q].x0 <= cur[c].x1 + 1; q++) {
+      if (RunsTouch(runs[q], cur[c])) Union(parent, offsetPrev + q, offsetCur + c);
+    }
+  }
+}
+
+static void ScanBand(const uint16_t *pixels, int width, const Mesh &mesh, double sigma, Band &band) {
+  std::vector<float> background(width), rms(width);
+  int prevBegin = 0, prevEnd = 0;
+  for (int y = band.y0; y < band.y1; y++) {
+    InterpolateRow(mesh, y, width, background.data(), rms.data());
+    const uint16_t *row = pixels + static_cast<size_t>(y) * width;
+    const int curBegin = static_cast<int>(band.runs.size());
+    int x = 0;
+    while (x < width) {
+      if (row[x] - background[x] <= sigma * rms[x]) {
+        x++;
+        continue;
+      }
+      Run run = {y, x, x, 0.0, 0.0, 0.0, 0.0f, false};
+      for (; x < width && row[x] - background[x] > sigma * rms[x]; x++) {
+        float f = row[x] - background[x];
+        run.x1 = x;
+        run.flux += f;
+        run.sumX += static_cast<double>(f) * x;
+        run.sumY += static_cast<double>(f) * y;
+        run.peak = std::max(run.peak, f);
+        run.saturated = run.saturated || row[x] >= FRAME_STATS_SATURATION;
+      }
+      band.parent.push_back(static_cast<int>(band.runs.size()));
+      band.runs.push_back(run);
+    }
+    const int curEnd = static_cast<int>(band.runs.size());
+    if (y > band.y0) LinkRows(band.runs, band.parent, prevBegin, prevEnd, curBegin, curEnd);
+    prevBegin = curBegin;
+    prevEnd = curEnd;
+  }
+}
+
+// ===== 측정 =====
+
+struct Component {
+  int area;
+  double flux;
+  double sumX;
+  double sumY;
+  float peak;
+  bool saturated;
+};
+
+// 중심 주변 창에서 HFR(플럭스 가중 평균 반경, N.I.N.A./SGP 방식)과 2차 모멘트 FWHM
+// 배경은 창 바깥 고리의 중앙값 (메시 보간보다 국소적이라 모멘트가 배경 오차에 덜 흔들림)
+static bool MeasureStar(const uint16_t *pixels, int width, int height, StarInfo &star) {
+  const float rArea = std::sqrt(star.area / static_cast<float>(M_PI));
+  const int radius = std::max(3, std::min(STAR_MAX_WINDOW, static_cast<int>(std::ceil(2.0f * rArea)) + 2));
+  const int outer = radius + STAR_ANNULUS_WIDTH;
+  const int cx = static_cast<int>(std::lround(star.x));
+  const int cy = static_cast<int>(std::lround(star.y));
+  if (cx - outer < 0 || cy - outer < 0 || cx + outer >= width || cy + outer >= height) return false;
+
+  static thread_local std::vector<uint16_t> annulus;
+  annulus.clear();
+  for (int dy = -outer; dy <= outer; dy++) {
+    const uint16_t *row = pixels + static_cast<size_t>(cy + dy) * width;
+    for (int dx = -outer; dx <= outer; dx++) {
+      int r2 = dx * dx + dy * dy;
+      if (r2 > radius * radius && r2 <= outer * outer) annulus.push_back(row[cx + dx]);
+    }
+  }
+  std::nth_element(annulus.begin(), annulus.begin() + annulus.size() / 2, annulus.end());
+  const float background = annulus[annulus.size() / 2];
+
+  double sumF = 0.0, sumFr = 0.0, sumFr2 = 0.0;
+  for (int dy = -radius; dy <= radius; dy++) {
+    const uint16_t *row = pixels + static_cast<size_t>(cy + dy) * width;
+    for (int dx = -radius; dx <= radius; dx++) {
+      if (dx * dx + dy * dy > radius * radius) continue;
+      const double f = row[cx + dx] - background;
+      const double ddx = cx + dx - star.x, ddy = cy + dy - star.y;
+      const double r2 = ddx * ddx + ddy * ddy;
+      sumF += f;
+      sumFr += f * std::sqrt(r2);
+      sumFr2 += f * r2;
+    }
+  }
+  if (sumF <= 0.0 || sumFr2 <= 0.0) return false;
+  star.hfr = static_cast<float>(sumFr / sumF);
+  star.fwhm = static_cast<float>(STAR_FWHM_PER_SIGMA * std::sqrt(sumFr2 / (2.0 * sumF)));
+  return std::isfinite(star.fwhm) && star.hfr > 0.0f && star.hfr < radius;
+}
+
+bool StarDetect(const uint16_t *pixels, int width, int height, const StarDetectOptions &options,
+                StarDetectResult &result, std::string &error) {
+  auto start = std::chrono::steady_clock::now();
+  if (width < options.meshSize || height < options.meshSize) {
+    error = "이미지가 배경 메시 칸(" + std::to_string(options.meshSize) + "픽셀)보다 작습니다.";
+    return false;
+  }
+
+  // 1) 배경 메시 (칸마다 병렬)
+  Mesh mesh;
+  mesh.size = options.meshSize;
+  mesh.columns = (width + mesh.size - 1) / mesh.size;
+  mesh.rows = (height + mesh.size - 1) / mesh.size;
+  const int cells = mesh.columns * mesh.rows;
+  mesh.background.assign(cells, NAN);
+  mesh.rms.assign(cells, NAN);
+  ParallelFor(cells, options.threads, [&](int i) {
+    MeshCell(pixels, width, height, mesh.size, i % mesh.columns, i / mesh.columns, mesh.background[i], mesh.rms[i]);
+  });
+  FilterMesh(mesh.background, mesh.columns, mesh.rows, MedianOf(mesh.background));
+  FilterMesh(mesh.rms, mesh.columns, mesh.rows, std::max(MedianOf(mesh.rms), static_cast<float>(STAR_MIN_RMS)));
+  mesh.column0.resize(width);
+  mesh.columnWeight.resize(width);
+  for (int x = 0; x < width; x++) {
+    float fx = (x + 0.5f) / mesh.size - 0.5f;
+    mesh.column0[x] = std::max(0, std::min(mesh.columns - 1, static_cast<int>(std::floor(fx))));
+    mesh.columnWeight[x] = std::max(0.0f, std::min(1.0f, fx - mesh.column0[x]));
+  }
+
+  // 2) 임계값 + 띠 안 연결 요소 (메시 한 줄 높이의 띠마다 병렬)
+  std::vector<Band> bands(mesh.rows);
+  for (int b = 0; b < mesh.rows; b++) {
+    bands[b].y0 = b * mesh.size;
+    bands[b].y1 = std::min(height, bands[b].y0 + mesh.size);
+  }
+  ParallelFor(mesh.rows, options.threads, [&](int b) { ScanBand(pixels, width, mesh, options.sigma, bands[b]); });
+
+  // 3) 띠를 이어 붙이고 경계 행의 런을 이음
+  std::vector<Run> runs;
+  std::vector<int> parent;
+  std::vector<int> bandOffset(mesh.rows + 1, 0);
+  for (int b = 0; b < mesh.rows; b++) {
+    bandOffset[b] = static_cast<int>(runs.size());
+    for (int p : bands[b].parent) parent.push_back(p + bandOffset[b]);
+    runs.insert(runs.end(), bands[b].runs.begin(), bands[b].runs.end());
+  }
+  bandOffset[mesh.rows] = static_cast<int>(runs.size());
+  for (int b = 0; b + 1 < mesh.rows; b++) {
+    const int lastRow = bands[b].y1 - 1;
+    int prevBegin = bandOffset[b + 1];
+    while (prevBegin > bandOffset[b] && runs[prevBegin - 1].y == lastRow) prevBegin--;
+    int curEnd = bandOffset[b + 1];
+    while (curEnd < bandOffset[b + 2] && runs[curEnd].y == bands[b + 1].y0) curEnd++;
+    LinkRows(runs, parent, prevBegin, bandOffset[b + 1], bandOffset[b + 1], curEnd);
+  }
+
+  // 요소별 모멘트 합
+  std::vector<int> componentOf(runs.size(), -1);
+  std::vector<Component> components;
+  for (size_t i = 0; i < runs.size(); i++) {
+    int root = FindRoot(parent, static_cast<int>(i));
+    if (componentOf[root] < 0) {
+      componentOf[root] = static_cast<int>(components.size());
+      components.push_back(Component());
+    }
+    Component &c = components[componentOf[root]];
+    const Run &run = runs[i];
+    c.area += run.x1 - run.x0 + 1;
+    c.flux += run.flux;
+    c.sumX += run.sumX;
+    c.sumY += run.sumY;
+    c.peak = std::max(c.peak, run.peak);
+    c.saturated = c.saturated || run.saturated;
+  }
+
+  // 4) 별 측정 (요소마다 병렬)
+  result.count = 0;
+  result.large = 0;
+  std::vector<StarInfo> stars;
+  for (const Component &c : components) {
+    if (c.area < options.minArea || c.flux <= 0.0) continue;
+    if (c.area > options.maxArea) {
+      result.large++;
+      continue;
+    }
+    StarInfo star;
+    star.x = static_cast<float>(c.sumX / c.flux);
+    star.y = static_cast<float>(c.sumY / c.flux);
+    star.flux = static_cast<float>(c.flux);
+    star.peak = c.peak;
+    star.fwhm = 0.0f;
+    star.hfr = 0.0f;
+    star.area = c.area;
+    star.saturated = c.saturated;
+    stars.push_back(star);
+  }
+  std::vector<char> measured(stars.size(), 0);
+  ParallelFor(static_cast<int>(stars.size()), options.threads, [&](int i) {
+    if (stars[i].saturated) return;
+    if (MeasureStar(pixels, width, height, stars[i])) {
+      measured[i] = 1;
+    } else {
+      stars[i].fwhm = 0.0f;
+      stars[i].hfr = 0.0f;
+    }
+  });
+
+  std::vector<float> fwhms, hfrs;
+  result.saturated = 0;
+  for (size_t i = 0; i < stars.size(); i++) {
+    if (stars[i].saturated) result.saturated++;
+    if (!measured[i]) continue;
+    fwhms.push_back(stars[i].fwhm);
+    hfrs.push_back(stars[i].hfr);
+  }
+  result.count = static_cast<int>(stars.size());
+  result.measured = static_cast<int>(fwhms.size());
+  result.fwhm = MedianOf(fwhms);
+  result.hfr = MedianOf(hfrs);
+  result.background = MedianOf(mesh.background);
+  result.backgroundRms = MedianOf(mesh.rms);
+  result.meshSize = mesh.size;
+  result.meshColumns = mesh.columns;
+  result.meshRows = mesh.rows;
+  result.meshBackground = mesh.background;
+  result.meshRms = mesh.rms;
+
+  std::sort(stars.begin(), stars.end(), [](const StarInfo &a, const StarInfo &b) { return a.flux > b.flux; });
+  result.stars.swap(stars);
+  result.detectMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  LOG_DEBUG("별 검출: %d개 (측정 %d, 포화 %d, 큰 요소 %d), 배경 %.1f ± %.1f ADU, FWHM %.2f, HFR %.2f, %.1f ms",
+            result.count, result.measured, result.saturated, result.large, result.background, result.backgroundRms,
+            result.fwhm, result.hfr, result.detectMs);
+  return true;
+}
+
+// ===== N-API =====
+
+Napi::Object StarDetectResultToObject(Napi::Env env, const StarDetectResult &result, bool includeList) {
+  Napi::Object obj = Napi::Object::New(env);
+  obj.Set("stars", Napi::Number::New(env, result.count));
+  obj.Set("measured", Napi::Number::New(env, result.measured));
+  obj.Set("saturated", Napi::Number::New(env, result.saturated));
+  obj.Set("large", Napi::Number::New(env, result.large));
+  obj.Set("background", Napi::Number::New(env, result.background));
+  obj.Set("backgroundRms", Napi::Number::New(env, result.backgroundRms));
+  obj.Set("fwhm", Napi::Number::New(env, result.fwhm));
+  obj.Set("hfr", Napi::Number::New(env, result.hfr));
+  obj.Set("detectMs", Napi::Number::New(env, result.detectMs));
+
+  Napi::Object mesh = Napi::Object::New(env);
+  mesh.Set("columns", Napi::Number::New(env, result.meshColumns));
+  mesh.Set("rows", Napi::Number::New(env, result.meshRows));
+  mesh.Set("size", Napi::Number::New(env, result.meshSize));
+  Napi::Float32Array background = Napi::Float32Array::New(env, result.meshBackground.size());
+  std::copy(result.meshBackground.begin(), result.meshBackground.end(), background.Data());
+  mesh.Set("background", background);
+  obj.Set("mesh", mesh);
+
+  if (includeList) {
+    const size_t count = std::min(result.stars.size(), static_cast<size_t>(STAR_MAX_LIST));
+    Napi::Array list = Napi::Array::New(env, count);
+    for (size_t i = 0; i < count; i++) {
+      const StarInfo &s = result.stars[i];
+      Napi::Object star = Napi::Object::New(env);
+      star.Set("x", Napi::Number::New(env, s.x));
+      star.Set("y", Napi::Number::New(env, s.y));
+      star.Set("flux", Napi::Number::New(env, s.flux));
+      star.Set("peak", Napi::Number::New(env, s.peak));
+      star.Set("fwhm", Napi::Number::New(env, s.fwhm));
+      star.Set("hfr", Napi::Number::New(env, s.hfr));
+      star.Set("area", Napi::Number::New(env, s.area));
+      star.Set("saturated", Napi::Boolean::New(env, s.saturated));
+      list.Set(static_cast<uint32_t>(i), star);
+    }
+    obj.Set("list", list);
+  }
+  return obj;
+}
+
+class StarDetectWorker : public Napi::AsyncWorker {
+public:
+  StarDetectWorker(Napi::Env env, Napi::Object dataObj, const uint16_t *pixels, int width, int height,
+                   const StarDetectOptions &options, const CloudCoverOptions &cloudOptions)
+    : Napi::AsyncWorker(env, "SXStarDetect"),
+      deferred(Napi::Promise::Deferred::New(env)),
+      pixels(pixels), width(width), height(height), options(options), cloudOptions(cloudOptions),
+      result(), cloud() {
+    // 검출이 끝날 때까지 픽셀 버퍼가 GC되지 않도록 참조 유지
+    dataRef = Napi::Persistent(dataObj);
+  }
+
+  Napi::Promise GetPromise() const { return deferred.Promise(); }
+
+protected:
+  void Execute() override {
+    std::string error;
+    if (!StarDetect(pixels, width, height, options, result, error)) {
+      SetError(error);
+      return;
+    }
+    // 구름 지도는 검출한 별과 배경 메시만 사용 (픽셀을 다시 읽지 않음)
+    if (cloudOptions.enabled) CloudCoverAnalyze(result, width, height, cloudOptions, cloud);
+  }
+
+  void OnOK() override {
+    Napi::Object obj = StarDetectResultToObject(Env(), result, options.list);
+    if (cloudOptions.enabled) obj.Set("cloud", CloudCoverResultToObject(Env(), cloud));
+    deferred.Resolve(obj);
+  }
+
+  void OnError(const Napi::Error &error) override {
+    deferred.Reject(error.Value());
+  }
+
+private:
+  Napi::Promise::Deferred deferred;
+  Napi::ObjectReference dataRef;
+  const uint16_t *pixels;
+  int width;
+  int height;
+  StarDetectOptions options;
+  CloudCoverOptions cloudOptions;
+  StarDetectResult result;
+  CloudCoverResult cloud;
+};
+
+static int OptionInt(const Napi::Object &opts, const char *key, int fallback) {
+  return opts.Get(key).IsNumber() ? opts.Get(key).As<Napi::Number>().Int32Value() : fallback;
+}
+
+// detectStars(image, { sigma, minArea, maxArea, meshSize, threads, list, cloud }) -> Promise<Object>
+static Napi::Value DetectStars(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  Napi::Promise::Deferred deferred = Napi::Promise::Deferred::New(env);
+  auto reject = [&](const std::string &message) {
+    deferred.Reject(Napi::TypeError::New(env, message).Value());
+    return deferred.Promise();
+  };
+
+  if (info.Length() < 1 || !info[0].IsObject()) return reject("detectStars(image, options) 형식으로 호출해야 합니다.");
+  Napi::Object image = info[0].As<Napi::Object>();
+  Napi::Value data = image.Get("data");
+  int width = OptionInt(image, "width", 0);
+  int height = OptionInt(image, "height", 0);
+  if (!data.IsTypedArray() || data.As<Napi::TypedArray>().TypedArrayType() != napi_uint16_array ||
+      width <= 0 || height <= 0 ||
+      data.As<Napi::TypedArray>().ElementLength() < static_cast<size_t>(width) * height) {
+    return reject("이미지 데이터는 width*height 크기의 Uint16Array여야 합니다.");
+  }
+
+  StarDetectOptions options = StarDetectDefaultOptions();
+  CloudCoverOptions cloudOptions = CloudCoverDefaultOptions();
+  if (info.Length() >= 2 && info[1].IsObject()) {
+    Napi::Object opts = info[1].As<Napi::Object>();
+    if (opts.Get("sigma").IsNumber()) options.sigma = opts.Get("sigma").As<Napi::Number>().DoubleValue();
+    options.minArea = OptionInt(opts, "minArea", options.minArea);
+    options.maxArea = OptionInt(opts, "maxArea", options.maxArea);
+    options.meshSize = OptionInt(opts, "meshSize", options.meshSize);
+    options.threads = OptionInt(opts, "threads", options.threads);
+    options.list = opts.Get("list").ToBoolean().Value();
+    std::string error;
+    if (!CloudCoverOptionsFromValue(opts.Get("cloud"), cloudOptions, error)) return reject(error);
+  }
+  if (!(options.sigma > 0.0) || options.minArea < 1 || options.maxArea < options.minArea ||
+      options.meshSize < STAR_MIN_MESH) {
+    return reject("검출 옵션이 올바르지 않습니다 (sigma > 0, 1 <= minArea <= maxArea, meshSize >= " +
+                  std::to_string(STAR_MIN_MESH) + ").");
+  }
+
+  Napi::Uint16Array pixels = data.As<Napi::Uint16Array>();
+  StarDetectWorker *worker = new StarDetectWorker(env, pixels, pixels.Data(), width, height, options, cloudOptions);
+  Napi::Promise promise = worker->GetPromise();
+  worker->Queue();
+  return promise;
+}
+
+Napi::Object InitStarDetect(Napi::Env env, Napi::Object exports) {
+  exports.Set("detectStars", Napi::Function::New(env, DetectStars, "detectStars"));
+  return exports;
+}
@@ -0,0 +1,79 @@
+// star-detect.h
+// 네이티브 별 검출과 프레임별 하늘 상태 지표
+// 1) 배경 메시: 프레임을 meshSize 칸으로 나눠 칸마다 시그마 클리핑한 중앙값/잡음을 구하고 3x3 중앙값 필터로 다듬음
+//    (픽셀 배경은 칸 중심 사이를 쌍선형 보간)
+// 2) 임계값: 배경 + sigma * 잡음을 넘는 픽셀을 행마다 런(run)으로 묶음
+// 3) 연결 요소: 행 띠마다 런을 union-find로 잇고, 띠 경계의 런을 마지막에 이음 (8-연결)
+// 4) 측정: 요소마다 플럭스 가중 중심, 주변 창에서 2차 모멘트 FWHM과 HFR
+// 메시와 띠, 측정을 스레드로 나눠 처리한다.
+#ifndef SX_STAR_DETECT_H
+#define SX_STAR_DETECT_H
+
+#include <napi.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#define STAR_DEFAULT_MESH          64      // 배경 메시 칸 크기 (픽셀)
+#define STAR_MIN_MESH              16
+#define STAR_DEFAULT_SIGMA         5.0     // 검출 임계 (배경 잡음 배수)
+#define STAR_DEFAULT_MIN_AREA      3       // 최소 연결 픽셀 수 (핫 픽셀/우주선 한 점 제외)
+#define STAR_DEFAULT_MAX_AREA      400     // 이보다 크면 별이 아닌 것으로 봄 (달, 구름 가장자리 빛 번짐, 건물)
+#define STAR_MESH_CLIP_ITERATIONS  3
+#define STAR_MESH_CLIP_SIGMA       3.0
+#define STAR_MIN_RMS               1.0     // 잡음이 0으로 추정되는 칸(포화 등)의 하한
+#define STAR_MAX_WINDOW            15      // FWHM/HFR 측정 창 최대 반경 (픽셀)
+#define STAR_MAX_LIST              5000    // 돌려주는 별 목록 최대 길이 (밝은 순)
+#define STAR_MAX_THREADS           16
+
+struct StarDetectOptions {
+  double sigma;
+  int minArea;
+  int maxArea;
+  int meshSize;
+  int threads;          // 0이면 CPU 수
+  bool list;            // 별 목록(위치/플럭스/크기)을 돌려줄지
+};
+
+struct StarInfo {
+  float x;              // 플럭스 가중 중심 (픽셀, 0부터)
+  float y;
+  float flux;           // 배경을 뺀 연결 요소 플럭스 (ADU)
+  float peak;           // 배경을 뺀 최댓값
+  float fwhm;           // 측정하지 못했으면 0 (가장자리/포화)
+  float hfr;
+  int area;
+  bool saturated;
+};
+
+struct StarDetectResult {
+  int count;            // 별 수 (minArea~maxArea)
+  int measured;         // FWHM/HFR을 잰 별 수 (포화/가장자리 제외)
+  int saturated;
+  int large;            // maxArea를 넘은 요소 수
+  double background;    // 메시 배경의 중앙값
+  double backgroundRms; // 메시 잡음의 중앙값
+  double fwhm;          // 측정한 별의 중앙값 (없으면 0)
+  double hfr;
+  double detectMs;
+  int meshSize;
+  int meshColumns;
+  int meshRows;
+  std::vector<float> meshBackground;   // 메시 칸별 배경 (행 우선)
+  std::vector<float> meshRms;          // 메시 칸별 잡음
+  std::vector<StarInfo> stars;         // 검출한 별 전체, 밝은 순 (구름 지도 등 후속 분석용)
+};
+
+StarDetectOptions StarDetectDefaultOptions();
+
+bool StarDetect(const uint16_t *pixels, int width, int height, const StarDetectOptions &options,
+                StarDetectResult &result, std::string &error);
+
+// { stars, measured, saturated, large, background, backgroundRms, fwhm, hfr, detectMs,
+//   mesh: { columns, rows, size, background: Float32Array }, list: [{ x, y, flux, peak, fwhm, hfr, area, saturated }] }
+// list는 includeList일 때 밝은 순으로 STAR_MAX_LIST개까지
+Napi::Object StarDetectResultToObject(Napi::Env env, const StarDetectResult &result, bool includeList);
+
+Napi::Object InitStarDetect(Napi::Env env, Napi::Object exports);
+
+#endif // SX_STAR_DETECT_H
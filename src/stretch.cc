@@ -0,0 +1,214 @@
+// stretch.cc
+// 미리보기 JPG용 8비트 스트레칭 커널
+#include "stretch.h"
+#include <cmath>
+#include <cstring>
+#include <vector>
+#include <algorithm>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+void StretchHistogram(const uint16_t *src, size_t count, uint32_t *histogram) {
+  // 히스토그램 누적은 scatter라 SIMD 이득이 없음. 연속 같은 값의 store-load 의존을 줄이려고
+  // 두 개의 히스토그램에 번갈아 누적한 뒤 합침
+  std::vector<uint32_t> second(65536, 0);
+  std::memset(histogram, 0, 65536 * sizeof(uint32_t));
+
+  size_t i = 0;
+  for (; i + 2 <= count; i += 2) {
+    histogram[src[i]]++;
+    second[src[i + 1]]++;
+  }
+  if (i < count) histogram[src[i]]++;
+
+  for (size_t v = 0; v < 65536; v++) histogram[v] += second[v];
+}
+
+uint16_t StretchPercentile(const uint32_t *histogram, size_t count, double percent) {
+  if (count == 0) return 0;
+  double p = std::max(0.0, std::min(100.0, percent));
+  // percent 위치 픽셀 (0이면 최솟값, 100이면 최댓값)
+  size_t target = static_cast<size_t>(std::floor(p / 100.0 * (count - 1)));
+  size_t cumulative = 0;
+  for (size_t v = 0; v < 65536; v++) {
+    cumulative += histogram[v];
+    if (cumulative > target) return static_cast<uint16_t>(v);
+  }
+  return 65535;
+}
+
+void StretchLinear(const uint16_t *src, uint8_t *dst, size_t count, uint16_t black, uint16_t white) {
+  const float scale = white > black ? 255.0f / static_cast<float>(white - black) : 0.0f;
+  size_t i = 0;
+
+#if defined(__SSE2__)
+  // (v - black)를 0에서 포화시키고 float로 곱한 뒤 정수 포화 pack으로 0~255 클램프
+  const __m128i vblack = _mm_set1_epi16(static_cast<short>(black));
+  const __m128i zero = _mm_setzero_si128();
+  const __m128 vscale = _mm_set1_ps(scale);
+  const __m128 half = _mm_set1_ps(0.5f);
+  for (; i + 16 <= count; i += 16) {
+    __m128i a = _mm_subs_epu16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i)), vblack);
+    __m128i b = _mm_subs_epu16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i + 8)), vblack);
+
+    __m128i a0 = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(a, zero)), vscale), half));
+    __m128i a1 = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(a, zero)), vscale), half));
+    __m128i b0 = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(b, zero)), vscale), half));
+    __m128i b1 = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(b, zero)), vscale), half));
+
+    __m128i out = _mm_packus_epi16(_mm_packs_epi32(a0, a1), _mm_packs_epi32(b0, b1));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), out);
+  }
+#elif defined(__ARM_NEON)
+  const uint16x8_t vblack = vdupq_n_u16(black);
+  const float32x4_t vscale = vdupq_n_f32(scale);
+  const float32x4_t half = vdupq_n_f32(0.5f);
+  for (; i + 8 <= count; i += 8) {
+    uint16x8_t v = vqsubq_u16(vld1q_u16(src + i), vblack);
+    float32x4_t lo = vmlaq_f32(half, vcvtq_f32_u32(vmovl_u16(vget_low_u16(v))), vscale);
+    float32x4_t hi = vmlaq_f32(half, vcvtq_f32_u32(vmovl_u16(vget_high_u16(v))), vscale);
+    uint16x8_t packed = vcombine_u16(vqmovn_u32(vcvtq_u32_f32(lo)), vqmovn_u32(vcvtq_u32_f32(hi)));
+    vst1_u8(dst + i, vqmovn_u16(packed));
+  }
+#endif
+
+  for (; i < count; i++) {
+    uint16_t v = src[i];
+    float x = v > black ? static_cast<float>(v - black) * scale + 0.5f : 0.0f;
+    dst[i] = x >= 255.0f ? 255 : static_cast<uint8_t>(x);
+  }
+}
+
+// 비선형 곡선은 [black, white] 구간만 계산한 LUT로 적용
+static void StretchWithLut(const uint16_t *src, uint8_t *dst, size_t count, uint16_t black, uint16_t white,
+                           const StretchParams &params) {
+  std::vector<uint8_t> lut(65536);
+  std::memset(lut.data(), 0, black);
+  std::memset(lut.data() + white, 255, 65536 - white);
+
+  const double range = white > black ? static_cast<double>(white - black) : 1.0;
+  const double beta = params.asinhBeta > 0 ? params.asinhBeta : STRETCH_DEFAULT_ASINH_BETA;
+  const double invGamma = 1.0 / (params.gamma > 0 ? params.gamma : STRETCH_DEFAULT_GAMMA);
+  const double asinhNorm = 1.0 / std::asinh(beta);
+
+  for (uint32_t v = black; v < white; v++) {
+    double t = (v - black) / range;
+    double y = params.mode == STRETCH_ASINH ? std::asinh(beta * t) * asinhNorm : std::pow(t, invGamma);
+    lut[v] = static_cast<uint8_t>(std::min(255.0, std::round(y * 255.0)));
+  }
+
+  for (size_t i = 0; i < count; i++) dst[i] = lut[src[i]];
+}
+
+void StretchImage(const uint16_t *src, uint8_t *dst, size_t count, const StretchParams &params, StretchLevels &levels,
+                  const uint32_t *histogram) {
+  std::vector<uint32_t> computed;
+  size_t histCount = count;
+  if (histogram) {
+    // 미리 계산된 히스토그램은 수신된 픽셀만 포함할 수 있으므로 합계를 기준으로 백분위 계산
+    histCount = 0;
+    for (size_t v = 0; v < 65536; v++) histCount += histogram[v];
+  } else {
+    computed.resize(65536);
+    StretchHistogram(src, count, computed.data());
+    histogram = computed.data();
+  }
+
+  levels.min = 0;
+  levels.max = 0;
+  if (histCount > 0) {
+    levels.min = StretchPercentile(histogram, histCount, 0.0);
+    levels.max = StretchPercentile(histogram, histCount, 100.0);
+  }
+
+  levels.black = params.black >= 0 ? static_cast<uint16_t>(std::min(params.black, 65535))
+                                   : StretchPercentile(histogram, histCount, params.lowPercent);
+  levels.white = params.white >= 0 ? static_cast<uint16_t>(std::min(params.white, 65535))
+                                   : StretchPercentile(histogram, histCount, params.highPercent);
+  if (levels.white < levels.black) std::swap(levels.white, levels.black);
+  // 평탄한 이미지: 구간 폭이 0이면 한 단계로 벌려서 나눗셈/LUT 경계를 맞춤
+  if (levels.white == levels.black) {
+    if (levels.white < 65535) levels.white++;
+    else levels.black--;
+  }
+
+  if (params.mode == STRETCH_LINEAR) {
+    StretchLinear(src, dst, count, levels.black, levels.white);
+  } else {
+    StretchWithLut(src, dst, count, levels.black, levels.white, params);
+  }
+}
+
+// stretchImage(image, { mode, lowPercent, highPercent, black, white, beta, gamma, histogram })
+//   -> { data: Buffer(8비트), min, max, black, white }
+static Napi::Value StretchImageJs(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+
+  if (info.Length() < 1 || !info[0].IsObject()) {
+    Napi::TypeError::New(env, "유효한 이미지 데이터가 아닙니다.").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+
+  Napi::Object image = info[0].As<Napi::Object>();
+  Napi::Value dataValue = image.Get("data");
+  if (!dataValue.IsTypedArray() || dataValue.As<Napi::TypedArray>().TypedArrayType() != napi_uint16_array) {
+    Napi::TypeError::New(env, "이미지 데이터는 Uint16Array여야 합니다.").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+  Napi::Uint16Array pixels = dataValue.As<Napi::Uint16Array>();
+
+  Napi::Uint32Array histogram;
+  StretchParams params = { STRETCH_LINEAR, STRETCH_DEFAULT_LOW_PERCENT, STRETCH_DEFAULT_HIGH_PERCENT,
+                           -1, -1, STRETCH_DEFAULT_ASINH_BETA, STRETCH_DEFAULT_GAMMA };
+  if (info.Length() >= 2 && info[1].IsObject()) {
+    Napi::Object opts = info[1].As<Napi::Object>();
+    if (opts.Get("mode").IsString()) {
+      std::string mode = opts.Get("mode").As<Napi::String>().Utf8Value();
+      if (mode == "linear") params.mode = STRETCH_LINEAR;
+      else if (mode == "asinh") params.mode = STRETCH_ASINH;
+      else if (mode == "gamma") params.mode = STRETCH_GAMMA;
+      else {
+        Napi::TypeError::New(env, "mode는 'linear', 'asinh', 'gamma' 중 하나여야 합니다.").ThrowAsJavaScriptException();
+        return env.Null();
+      }
+    }
+    if (opts.Get("lowPercent").IsNumber()) params.lowPercent = opts.Get("lowPercent").As<Napi::Number>().DoubleValue();
+    if (opts.Get("highPercent").IsNumber()) params.highPercent = opts.Get("highPercent").As<Napi::Number>().DoubleValue();
+    if (opts.Get("black").IsNumber()) params.black = opts.Get("black").As<Napi::Number>().Int32Value();
+    if (opts.Get("white").IsNumber()) params.white = opts.Get("white").As<Napi::Number>().Int32Value();
+    if (opts.Get("beta").IsNumber()) params.asinhBeta = opts.Get("beta").As<Napi::Number>().DoubleValue();
+    if (opts.Get("gamma").IsNumber()) params.gamma = opts.Get("gamma").As<Napi::Number>().DoubleValue();
+
+    Napi::Value hist = opts.Get("histogram");
+    if (hist.IsTypedArray()) {
+      Napi::TypedArray typed = hist.As<Napi::TypedArray>();
+      if (typed.TypedArrayType() != napi_uint32_array || typed.ElementLength() != 65536) {
+        Napi::TypeError::New(env, "histogram은 길이 65536의 Uint32Array여야 합니다.").ThrowAsJavaScriptException();
+        return env.Null();
+      }
+      histogram = hist.As<Napi::Uint32Array>();
+    }
+  }
+
+  size_t count = pixels.ElementLength();
+  Napi::Buffer<uint8_t> out = Napi::Buffer<uint8_t>::New(env, count);
+  StretchLevels levels;
+  StretchImage(pixels.Data(), out.Data(), count, params, levels, histogram.IsEmpty() ? nullptr : histogram.Data());
+
+  Napi::Object result = Napi::Object::New(env);
+  result.Set("data", out);
+  result.Set("min", Napi::Number::New(env, levels.min));
+  result.Set("max", Napi::Number::New(env, levels.max));
+  result.Set("black", Napi::Number::New(env, levels.black));
+  result.Set("white", Napi::Number::New(env, levels.white));
+  return result;
+}
+
+Napi::Object InitStretch(Napi::Env env, Napi::Object exports) {
+  exports.Set("stretchImage", Napi::Function::New(env, StretchImageJs, "stretchImage"));
+  return exports;
+}
@@ -0,0 +1,53 @@
+// stretch.h
+// 16비트 이미지를 미리보기용 8비트로 변환하는 명암 스트레칭
+// 히스토그램 한 번으로 min/max와 백분위(블랙/화이트 레벨)를 구한 뒤 linear/asinh/gamma 곡선 적용
+#ifndef SX_STRETCH_H
+#define SX_STRETCH_H
+
+#include <napi.h>
+#include <cstdint>
+#include <cstddef>
+
+#define STRETCH_LINEAR      0
+#define STRETCH_ASINH       1
+#define STRETCH_GAMMA       2
+
+#define STRETCH_DEFAULT_LOW_PERCENT    0.5     // 블랙 레벨 백분위
+#define STRETCH_DEFAULT_HIGH_PERCENT   99.9    // 화이트 레벨 백분위 (핫 픽셀 제외)
+#define STRETCH_DEFAULT_ASINH_BETA     10.0
+#define STRETCH_DEFAULT_GAMMA          2.2
+
+struct StretchParams {
+  int mode;
+  double lowPercent;
+  double highPercent;
+  int black;            // 0 이상이면 백분위 대신 이 값을 블랙 레벨로 사용
+  int white;            // 0 이상이면 백분위 대신 이 값을 화이트 레벨로 사용
+  double asinhBeta;
+  double gamma;
+};
+
+struct StretchLevels {
+  uint16_t min;
+  uint16_t max;
+  uint16_t black;
+  uint16_t white;
+};
+
+// 65536 구간 히스토그램 (min/max는 양 끝 비어 있지 않은 구간)
+void StretchHistogram(const uint16_t *src, size_t count, uint32_t *histogram);
+
+// 히스토그램에서 percent(0~100) 위치의 값
+uint16_t StretchPercentile(const uint32_t *histogram, size_t count, double percent);
+
+// [black, white] 구간을 0~255로 선형 변환 (SSE2/NEON, 스칼라 fallback)
+void StretchLinear(const uint16_t *src, uint8_t *dst, size_t count, uint16_t black, uint16_t white);
+
+// 히스토그램 + 레벨 계산 + 곡선 적용
+// histogram이 주어지면 (촬영 시 계산한 프레임 통계) 히스토그램 패스를 건너뜀
+void StretchImage(const uint16_t *src, uint8_t *dst, size_t count, const StretchParams &params, StretchLevels &levels,
+                  const uint32_t *histogram = nullptr);
+
+Napi::Object InitStretch(Napi::Env env, Napi::Object exports);
+
+#endif // SX_STRETCH_H
@@ -3,10 +3,34 @@
 #include <string>
 #include <thread>
 #include <chrono>
+#include <atomic>
+#include <functional>
+#include <algorithm>
+#include <vector>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <cmath>
+#include <map>
+#include "frame-pool.h"
+#include "capture-metrics.h"
+#include "fits-writer.h"
+#include "fits-compress.h"
+#include "stretch.h"
+#include "frame-stats.h"
+#include "bias-correct.h"
+#include "calibration.h"
+#include "defect-map.h"
+#include "stacker.h"
+#include "star-detect.h"
+#include "transient-detect.h"
+#include "night-composite.h"
+#include "image-pyramid.h"
+#include "usb-transport.h"
+#include "sim-transport.h"
+#include "sx-log.h"
 
 // SX 카메라 관련 상수
-#define SX_VID                     0x1278  // Starlight Xpress Vendor ID
-#define SX_ECHO2_PID               0x0525  // Starlight Xpress ECHO2 Product ID
 #define SXUSB_GET_FIRMWARE_VERSION 0x11    // 기존 펌웨어 버전 명령
 #define SXUSB_CAMERA_MODEL         0x14    // 기존 카메라 모델 명령
 
@@ -18,6 +42,124 @@
 #define ECHO2_IMAGE_SETUP_CMD      0x02    // 이미지 설정 명령
 #define ECHO2_EXPOSURE_CMD         0x00    // 노출 명령
 
+// GET_CCD_PARAMS (sx_usb_prog_ref.txt 2.1.10)
+#define SX_CMD_TYPE_READ           0xC0    // 응답이 있는 명령 타입 바이트
+#define SXUSB_GET_CCD              8
+#define SX_CCD_PARAMS_LENGTH       17
+#define SX_CAPS_STAR2000           0x01    // EXTRA_CAPABILITIES 비트
+#define SX_CAPS_COMPRESSED_PIXEL   0x02
+#define SX_CAPS_EEPROM             0x04
+#define SX_CAPS_GUIDER_CCD         0x08
+
+// GET_CCD_PARAMS에 실패했을 때 쓰는 ECHO2 값
+#define SX_DEFAULT_CCD_WIDTH       1392
+#define SX_DEFAULT_CCD_HEIGHT      1040
+#define SX_DEFAULT_PIXEL_SIZE_UM   6.45
+#define SX_DEFAULT_BITS_PER_PIXEL  16
+
+// 비동기 촬영 진행 상황
+#define CAPTURE_PHASE_EXPOSING     0       // 노출 중 (done/total: 경과/전체 ms)
+#define CAPTURE_PHASE_DOWNLOADING  1       // 다운로드 중 (done/total: 수신/전체 바이트)
+#define EXPOSURE_POLL_MS           100     // 노출 대기 중 취소 확인 주기
+
+// 노출 타이밍 방식
+#define EXPOSURE_MODE_HOST         0       // CLEAR_PIXELS → 호스트 대기 → READ_PIXELS
+#define EXPOSURE_MODE_CAMERA       1       // READ_PIXELS_DELAYED (카메라 내부 타이머)
+#define CAMERA_TIMED_LEAD_MS       500     // 카메라 타이머 종료 이만큼 전에 다운로드 전송을 미리 걸어 둠
+
+// 비동기 벌크 다운로드 파이프라인 기본값
+#define READOUT_QUEUE_DEPTH        4               // 동시에 제출해 두는 전송 수
+#define READOUT_TRANSFER_SIZE      (128 * 1024)    // 전송 하나의 크기 (바이트)
+#define READOUT_TIMEOUT_MS         15000           // 전송 하나의 타임아웃
+#define READOUT_MAX_RETRIES        5               // 첫 데이터 수신 전 타임아웃 재시도 횟수
+#define READOUT_MAX_QUEUE_DEPTH    32
+#define READOUT_MAX_TRANSFER_SIZE  (4 * 1024 * 1024)
+#define USB_BULK_PACKET_SIZE       512             // High-speed 벌크 패킷 크기 (전송 크기는 이 배수)
+
+// 세션 모드 (촬영 사이에 연결 유지)
+#define SESSION_HEALTH_TIMEOUT_MS  1000    // 상태 확인 컨트롤 전송 타임아웃
+#define SESSION_REOPEN_RETRIES     3       // 장치가 끊겼을 때 다시 열기 시도 횟수
+#define SESSION_REOPEN_DELAY_MS    1000    // 다시 열기 시도 간격
+
+// 읽어 올 영역과 비닝 (READ_PIXELS 파라미터 블록)
+// 좌표와 크기는 비닝 전 CCD 픽셀 단위, 출력 크기는 width / xBin x height / yBin
+#define SX_MAX_BIN                 4       // 지원하는 최대 비닝 (SX 드라이버와 동일)
+
+// 16비트 명령 파라미터의 하위/상위 바이트
+#define LO(v) static_cast<unsigned char>((v) & 0xFF)
+#define HI(v) static_cast<unsigned char>(((v) >> 8) & 0xFF)
+
+struct CaptureRegion {
+  int x;
+  int y;
+  int width;
+  int height;
+  int xBin;
+  int yBin;
+  bool fullFrame;     // 크기를 지정하지 않음: open 후 CCD 크기가 바뀌면 따라감
+};
+
+// GET_CCD_PARAMS 결과 (open 시 한 번 조회해 캐시)
+struct CCDParams {
+  bool fromCamera;        // false면 조회 실패로 ECHO2 기본값 사용 중
+  int hFrontPorch;
+  int hBackPorch;
+  int width;              // 유효 픽셀 (포치 제외)
+  int height;
+  int vFrontPorch;
+  int vBackPorch;
+  double pixelWidthUm;
+  double pixelHeightUm;
+  int colorMatrix;
+  int bitsPerPixel;       // 8 또는 16
+  int serialPorts;
+  int extraCaps;          // SX_CAPS_* 비트
+  uint16_t productId;     // 연 장치의 USB 제품 ID (0이면 모름). 열 때 핸들을 가진 스레드에서 읽어 둠
+};
+
+// 제품 ID별 이름과 센서 (FITS INSTRUME/DETECTOR), 목록에 없으면 "SX 0xPID"
+struct SXModelInfo {
+  uint16_t productId;
+  const char *name;
+  const char *detector;
+};
+
+static const SXModelInfo SX_MODELS[] = {
+  {SX_ECHO2_PID, "SX ECHO2", "ICX825AL"},
+};
+
+// open 전이나 GET_CCD_PARAMS 실패 시에 쓰는 ECHO2 값
+static CCDParams DefaultCCDParams() {
+  return {false, 0, 0, SX_DEFAULT_CCD_WIDTH, SX_DEFAULT_CCD_HEIGHT, 0, 0,
+          SX_DEFAULT_PIXEL_SIZE_UM, SX_DEFAULT_PIXEL_SIZE_UM, 0, SX_DEFAULT_BITS_PER_PIXEL, 0, 0, 0};
+}
+
+// 2x2 비닝과 풀 해상도 프레임용 버퍼를 2개씩 미리 할당 (부분 영역 등 다른 크기는 필요할 때 할당)
+// ccdWidth는 수평 백 포치를 포함한 폭: 바이어스 보정 시 포치 열까지 같은 버퍼에 수신
+static std::map<size_t, int> FramePoolSizes(int ccdWidth, int ccdHeight) {
+  return {
+    {static_cast<size_t>(ccdWidth / 2) * (ccdHeight / 2) * sizeof(unsigned short), 2},
+    {static_cast<size_t>(ccdWidth) * ccdHeight * sizeof(unsigned short), 2}
+  };
+}
+
+struct CaptureProgress {
+  int phase;
+  long done;
+  long total;
+};
+
+typedef std::function<void(const CaptureProgress&)> CaptureProgressFn;
+
+// 노출 방식별 타이밍 오차 (측정 노출 - 요청 노출, ms)
+struct ExposureTimingStats {
+  long count;
+  double mean;
+  double m2;          // 편차 제곱합 (Welford)
+  double minErrorMs;
+  double maxErrorMs;
+};
+
 class SXCamera : public Napi::ObjectWrap<SXCamera> {
 public:
   static Napi::Object Init(Napi::Env env, Napi::Object exports);
@@ -25,6 +167,7 @@ public:
   ~SXCamera();
 
 private:
+  friend class CaptureWorker;
   static Napi::FunctionReference constructor;
   
   // 메서드
@@ -33,8 +176,28 @@ private:
   Napi::Value GetFirmwareVersion(const Napi::CallbackInfo& info);
   Napi::Value GetCameraModel(const Napi::CallbackInfo& info);
   Napi::Value IsConnected(const Napi::CallbackInfo& info);
+  Napi::Value GetBackend(const Napi::CallbackInfo& info);
+  Napi::Value SetUsbLogLevel(const Napi::CallbackInfo& info);
   Napi::Value GetLastError(const Napi::CallbackInfo& info);
   Napi::Value CaptureImage(const Napi::CallbackInfo& info);
+  Napi::Value CaptureImageAsync(const Napi::CallbackInfo& info);
+  Napi::Value CancelCapture(const Napi::CallbackInfo& info);
+  Napi::Value IsCapturing(const Napi::CallbackInfo& info);
+  Napi::Value SetReadoutOptions(const Napi::CallbackInfo& info);
+  Napi::Value GetReadoutOptions(const Napi::CallbackInfo& info);
+  Napi::Value GetPoolStats(const Napi::CallbackInfo& info);
+  Napi::Value SetSessionMode(const Napi::CallbackInfo& info);
+  Napi::Value CheckHealth(const Napi::CallbackInfo& info);
+  Napi::Value SetExposureMode(const Napi::CallbackInfo& info);
+  Napi::Value GetExposureStats(const Napi::CallbackInfo& info);
+  Napi::Value SetFrameStats(const Napi::CallbackInfo& info);
+  Napi::Value SetPyramid(const Napi::CallbackInfo& info);
+  Napi::Value GetMetrics(const Napi::CallbackInfo& info);
+  Napi::Value GetCCDParams(const Napi::CallbackInfo& info);
+  Napi::Value SetBiasCorrection(const Napi::CallbackInfo& info);
+  Napi::Value SetCalibration(const Napi::CallbackInfo& info);
+  Napi::Value SetDefectCorrection(const Napi::CallbackInfo& info);
+  Napi::Value GetDefectMap(const Napi::CallbackInfo& info);
 
     // 디버깅 함수 추가 - 이 부분을 추가하세요
   bool DebugUSBCommands();
@@ -42,24 +205,97 @@ private:
 
   
   // 내부 함수
-  bool FindEndpoints(int interface_number);
-  bool ClaimAnyInterface();
+  bool OpenInternal();
+  void CloseInternal();
+  bool HealthCheckInternal();
+  bool EnsureSessionInternal();
   bool GetFirmwareVersionInternal(float &version);
+  bool QueryCCDParamsInternal(CCDParams &params);
+  void ApplyCCDParams(const CCDParams &params);
+  static const SXModelInfo* ModelInfo(uint16_t productId);
+  void SetLastError(const std::string &error);
+  std::string LastError();
   bool SendTwoStageCommand(unsigned char cmdCode, unsigned char *responseData, int &responseLength);
-  bool CaptureImageInternal(unsigned short *buffer, int &width, int &height, float exposureTime, bool enableBinning = true);
+  bool WaitExposureInternal(uint32_t exposureMs, uint32_t waitMs, bool verticalClear,
+                            const CaptureProgressFn &onProgress);
+  void RecordExposureTiming(int mode, double errorMs);
+  bool ReadPixelsPipelined(unsigned char *dest, int expectedBytes, int &bytesReceived,
+                           const CaptureProgressFn &onProgress, uint32_t *histogram);
+  CaptureRegion FullFrameRegion(int bin) const;
+  bool FitRegionInternal(CaptureRegion &region);
+  bool ParseCaptureRegion(const Napi::Value &value, CaptureRegion &region, std::string &error) const;
+  BiasLayout ReadoutLayout(const CaptureRegion &region) const;
+  bool CaptureImageInternal(unsigned short *buffer, int &width, int &height, float exposureTime,
+                            const CaptureRegion &region, const CaptureProgressFn &onProgress = nullptr,
+                            uint32_t *histogram = nullptr);
+  Napi::Object CreateImageObject(Napi::Env env, unsigned short *buffer, int width, int height,
+                                 float exposureTime, const CaptureRegion &region, const uint32_t *histogram = nullptr);
   
   // 필드
-  libusb_device_handle *handle;
-  libusb_context *ctx;
+  std::unique_ptr<SXTransport> transport;  // USB 장치 또는 시뮬레이터
   std::string lastError;
-  int claimedInterface;  // 클레임한 인터페이스 번호
-  int bulkInEndpoint;    // 입력 엔드포인트 (0x82)
-  int bulkOutEndpoint;   // 출력 엔드포인트 (0x01)
-  
-  // 이미지 관련 정보
-  int width;          // 이미지 너비 (1392)
-  int height;         // 이미지 높이 (1040) 
-  int bitsPerPixel;   // 이미지 비트심도 (16)
+  std::mutex errorMutex;  // lastError는 워커 스레드가 쓰고 JS 스레드(getLastError)가 읽음
+  
+  // 비동기 촬영 상태 (워커 스레드와 공유)
+  std::atomic<bool> captureBusy;       // 촬영 진행 중 여부
+  std::atomic<bool> cancelRequested;   // cancelCapture() 요청 여부
+  
+  // 다운로드 파이프라인 설정 및 마지막 다운로드 결과
+  int readoutQueueDepth;
+  int readoutTransferSize;
+  int readoutTimeoutMs;
+  int lastDownloadBytes;
+  double lastDownloadMs;
+  double lastConvertMs;  // 수신 후 픽셀 변환/정리에 걸린 시간
+  
+  // 프레임 버퍼 풀 (ArrayBuffer finalizer가 카메라 객체보다 늦게 불릴 수 있어 shared_ptr로 공유)
+  std::shared_ptr<FramePool> framePool;
+  
+  // 세션 모드: 촬영 전 상태 확인 후 필요하면 자동으로 다시 열기
+  bool sessionMode;
+  std::atomic<int> sessionReopenCount;  // 워커 스레드가 올리고 JS가 읽음
+  
+  // 노출 방식과 방식별 타이밍 통계
+  int exposureMode;
+  double lastMeasuredExposureMs;
+  std::chrono::steady_clock::time_point lastFirstDataTime;  // 마지막 다운로드의 첫 데이터 수신 시각
+  std::mutex statsMutex;
+  ExposureTimingStats exposureStats[2];
+  
+  // 수신과 같은 패스에서 프레임 통계(히스토그램) 계산 여부
+  bool frameStatsEnabled;
+  
+  // 썸네일 피라미드 단계 수 (0이면 만들지 않음)와 마지막 촬영의 피라미드
+  int pyramidLevels;
+  ImagePyramid lastPyramid;
+  
+  // 전송/다운로드 계측 (getMetrics)
+  CaptureMetrics metrics;
+  
+  // CCD 정보 (open 시 GET_CCD_PARAMS로 갱신, 모든 영역/버퍼 크기 계산의 기준)
+  // 세션 모드에서는 워커 스레드가 다시 열며 ccd/framePool을 바꾸므로, 촬영 중에도 불리는 조회(getCcdParams,
+  // getPoolStats)와 변경은 ccdMutex로 보호 (워커 스레드 자신의 읽기는 촬영 중 JS가 바꾸지 않으므로 잠그지 않음)
+  CCDParams ccd;
+  std::mutex ccdMutex;
+  
+  // 포치 기반 바이어스 보정 (BIAS_MODE_*)과 마지막 촬영의 보정 결과
+  int biasMode;
+  int biasPedestal;
+  BiasResult lastBias;
+  std::map<int, double> porchBiasLevel;  // 비닝별 마지막 포치 바이어스 (좁은 영역에서 포치를 읽지 않을 때 사용)
+  
+  // 마스터 바이어스/다크/플랫 보정 (setCalibration)과 마지막 촬영에 적용한 마스터
+  std::unique_ptr<CalibrationLibrary> calibration;
+  bool calibrationUse[3];   // CAL_TYPE_* 별 사용 여부
+  int calibrationPedestal;
+  bool lastCalibrated;
+  CalibrationFrames lastCalibration;
+  
+  // 핫/데드 픽셀 맵 (setDefectCorrection)과 마지막 촬영에서 교체한 픽셀 수 (-1이면 보정하지 않음)
+  std::unique_ptr<DefectMap> defectMap;
+  bool defectCorrect;
+  bool defectLearn;
+  int lastDefectsCorrected;
 };
 
 Napi::FunctionReference SXCamera::constructor;
@@ -73,8 +309,28 @@ Napi::Object SXCamera::Init(Napi::Env env, Napi::Object exports) {
     InstanceMethod("getFirmwareVersion", &SXCamera::GetFirmwareVersion),
     InstanceMethod("getCameraModel", &SXCamera::GetCameraModel),
     InstanceMethod("isConnected", &SXCamera::IsConnected),
+    InstanceMethod("getBackend", &SXCamera::GetBackend),
+    InstanceMethod("setUsbLogLevel", &SXCamera::SetUsbLogLevel),
     InstanceMethod("getLastError", &SXCamera::GetLastError),
     InstanceMethod("captureImage", &SXCamera::CaptureImage),
+    InstanceMethod("captureImageAsync", &SXCamera::CaptureImageAsync),
+    InstanceMethod("cancelCapture", &SXCamera::CancelCapture),
+    InstanceMethod("isCapturing", &SXCamera::IsCapturing),
+    InstanceMethod("setReadoutOptions", &SXCamera::SetReadoutOptions),
+    InstanceMethod("getReadoutOptions", &SXCamera::GetReadoutOptions),
+    InstanceMethod("getPoolStats", &SXCamera::GetPoolStats),
+    InstanceMethod("setSessionMode", &SXCamera::SetSessionMode),
+    InstanceMethod("checkHealth", &SXCamera::CheckHealth),
+    InstanceMethod("setExposureMode", &SXCamera::SetExposureMode),
+    InstanceMethod("getExposureStats", &SXCamera::GetExposureStats),
+    InstanceMethod("setFrameStats", &SXCamera::SetFrameStats),
+    InstanceMethod("setPyramid", &SXCamera::SetPyramid),
+    InstanceMethod("getMetrics", &SXCamera::GetMetrics),
+    InstanceMethod("getCcdParams", &SXCamera::GetCCDParams),
+    InstanceMethod("setBiasCorrection", &SXCamera::SetBiasCorrection),
+    InstanceMethod("setCalibration", &SXCamera::SetCalibration),
+    InstanceMethod("setDefectCorrection", &SXCamera::SetDefectCorrection),
+    InstanceMethod("getDefectMap", &SXCamera::GetDefectMap),
 
     InstanceMethod("debugCamera", &SXCamera::DebugCamera)
 
@@ -89,253 +345,264 @@ Napi::Object SXCamera::Init(Napi::Env env, Napi::Object exports) {
 
 SXCamera::SXCamera(const Napi::CallbackInfo& info)
   : Napi::ObjectWrap<SXCamera>(info), 
-    handle(nullptr), 
-    ctx(nullptr), 
-    claimedInterface(-1), 
-    bulkInEndpoint(0x82),  // 와이어샤크에서 확인된 IN 엔드포인트
-    bulkOutEndpoint(0x01), // 와이어샤크에서 확인된 OUT 엔드포인트
-    width(1392),          // ECHO2 카메라 해상도
-    height(1040),         // ECHO2 카메라 해상도
-    bitsPerPixel(16)      // 16비트 이미지
+    captureBusy(false),
+    cancelRequested(false),
+    readoutQueueDepth(READOUT_QUEUE_DEPTH),
+    readoutTransferSize(READOUT_TRANSFER_SIZE),
+    readoutTimeoutMs(READOUT_TIMEOUT_MS),
+    lastDownloadBytes(0),
+    lastDownloadMs(0.0),
+    lastConvertMs(0.0),
+    // CCD 크기가 ECHO2와 다르면 open 시 다시 만듦 (ApplyCCDParams)
+    framePool(std::make_shared<FramePool>(FramePoolSizes(SX_DEFAULT_CCD_WIDTH, SX_DEFAULT_CCD_HEIGHT))),
+    sessionMode(false),
+    sessionReopenCount(0),
+    exposureMode(EXPOSURE_MODE_HOST),
+    lastMeasuredExposureMs(0.0),
+    exposureStats(),
+    frameStatsEnabled(false),
+    pyramidLevels(0),
+    lastPyramid(),
+    ccd(DefaultCCDParams()),
+    biasMode(BIAS_MODE_OFF),
+    biasPedestal(BIAS_DEFAULT_PEDESTAL),
+    lastBias(),
+    calibrationUse{true, true, true},
+    calibrationPedestal(CAL_DEFAULT_PEDESTAL),
+    lastCalibrated(false),
+    lastCalibration(),
+    defectCorrect(false),
+    defectLearn(false),
+    lastDefectsCorrected(-1)
 {
-  // libusb 초기화
-  libusb_init(&ctx);
-  
-  // 디버그 모드 활성화 (2는 info 레벨, 3은 debug 레벨)
-  libusb_set_option(ctx, LIBUSB_OPTION_LOG_LEVEL, 3);
-}
-
-SXCamera::~SXCamera() {
-  // 정리
-  if (handle) {
-    if (claimedInterface >= 0) {
-      libusb_release_interface(handle, claimedInterface);
+  // 통신 계층 선택: new SXCamera({ backend: 'sim', sim: {...} }) 또는 환경 변수 SX_CAMERA_BACKEND=sim
+  std::string backend;
+  Napi::Value simArg;
+  if (info.Length() > 0 && info[0].IsObject()) {
+    Napi::Object options = info[0].As<Napi::Object>();
+    if (options.Has("backend") && options.Get("backend").IsString()) {
+      backend = options.Get("backend").As<Napi::String>().Utf8Value();
+    }
+    if (options.Has("sim")) {
+      simArg = options.Get("sim");
     }
-    libusb_close(handle);
-    handle = nullptr;
   }
-  
-  if (ctx) {
-    libusb_exit(ctx);
-    ctx = nullptr;
+  if (backend.empty()) {
+    const char *env = getenv("SX_CAMERA_BACKEND");
+    backend = env ? env : "usb";
+  }
+
+  if (backend == "sim") {
+    SimOptions simOptions;
+    std::string error;
+    if (!simArg.IsEmpty() && !ParseSimOptions(simArg, simOptions, error)) {
+      Napi::TypeError::New(info.Env(), error).ThrowAsJavaScriptException();
+      return;
+    }
+    transport.reset(new SimTransport(simOptions));
+  } else if (backend == "usb") {
+    transport.reset(new UsbTransport());
+  } else {
+    Napi::TypeError::New(info.Env(), "backend는 'usb' 또는 'sim'이어야 합니다: " + backend).ThrowAsJavaScriptException();
+    return;
   }
 }
 
-bool SXCamera::FindEndpoints(int interface_number) {
-  libusb_config_descriptor *config;
-  int res = libusb_get_active_config_descriptor(libusb_get_device(handle), &config);
+SXCamera::~SXCamera() {
+  // transport 소멸자가 장치 닫기/정리를 담당
+}
+
+bool SXCamera::OpenInternal() {
+  // 이미 연결되어 있으면 성공으로 반환
+  if (transport->IsOpen()) {
+    return true;
+  }
   
-  if (res < 0) {
-    lastError = "설정 디스크립터를 가져올 수 없습니다: " + std::string(libusb_error_name(res));
+  std::string error;
+  if (!transport->Open(error)) {
+    SetLastError(error);
     return false;
   }
   
-  bool found = false;
-  
-  // 인터페이스 검색
-  if (interface_number < config->bNumInterfaces) {
-    const libusb_interface *interface = &config->interface[interface_number];
-    
-    for (int j = 0; j < interface->num_altsetting; j++) {
-      const libusb_interface_descriptor *intf = &interface->altsetting[j];
-      
-      printf("인터페이스 %d, Alt Setting %d: 엔드포인트 %d개\n", 
-             interface_number, j, intf->bNumEndpoints);
-      
-      // 각 엔드포인트 검사
-      for (int k = 0; k < intf->bNumEndpoints; k++) {
-        const libusb_endpoint_descriptor *ep = &intf->endpoint[k];
-        
-        // 엔드포인트 방향 확인
-        if (ep->bEndpointAddress & LIBUSB_ENDPOINT_IN) {
-          bulkInEndpoint = ep->bEndpointAddress;
-          printf("IN 엔드포인트 발견: 0x%02x\n", bulkInEndpoint);
-          found = true;
-        } else {
-          bulkOutEndpoint = ep->bEndpointAddress;
-          printf("OUT 엔드포인트 발견: 0x%02x\n", bulkOutEndpoint);
-          found = true;
-        }
-      }
-    }
+  // 장치마다 CCD 크기/픽셀 크기/비트 심도가 다르므로 열 때마다 조회 (다시 연결 시 다른 카메라일 수 있음)
+  // 제품 ID도 여기서 읽어 스냅숏에 넣음 (세션 모드에서는 워커 스레드가 핸들을 닫고 다시 열 수 있어
+  // JS 스레드가 핸들에 직접 묻지 않도록)
+  CCDParams params;
+  if (!QueryCCDParamsInternal(params)) {
+    LOG_WARN("GET_CCD_PARAMS 실패, ECHO2 기본값 사용 (%dx%d): %s",
+             SX_DEFAULT_CCD_WIDTH, SX_DEFAULT_CCD_HEIGHT, LastError().c_str());
+    params = DefaultCCDParams();
   }
-  
-  libusb_free_config_descriptor(config);
-  return found;
+  params.productId = transport->ProductId();
+  ApplyCCDParams(params);
+  return true;
 }
 
-bool SXCamera::ClaimAnyInterface() {
-  libusb_config_descriptor *config;
-  int res = libusb_get_active_config_descriptor(libusb_get_device(handle), &config);
+bool SXCamera::QueryCCDParamsInternal(CCDParams &params) {
+  unsigned char cmd[8] = {SX_CMD_TYPE_READ, SXUSB_GET_CCD, 0, 0, 0, 0, SX_CCD_PARAMS_LENGTH, 0};
+  int transferred = 0;
   
+  int res = transport->BulkWrite(cmd, sizeof(cmd), &transferred, 5000);
   if (res < 0) {
-    lastError = "설정 디스크립터를 가져올 수 없습니다: " + std::string(libusb_error_name(res));
+    SetLastError("GET_CCD_PARAMS 명령 전송 실패: " + std::string(libusb_error_name(res)));
     return false;
   }
   
-  bool claimed = false;
-  
-  // 먼저 인터페이스 1 시도 (Wireshark 분석 기반)
-  res = libusb_claim_interface(handle, 1);
-  if (res == 0) {
-    printf("인터페이스 1 클레임 성공\n");
-    claimed = true;
-    claimedInterface = 1;
-    FindEndpoints(1);
-  } else {
-    printf("인터페이스 1 클레임 실패: %s\n", libusb_error_name(res));
-    
-    // 다른 모든 인터페이스 시도
-    for (int i = 0; i < config->bNumInterfaces; i++) {
-      if (i == 1) continue; // 이미 시도함
-      
-      res = libusb_claim_interface(handle, i);
-      if (res == 0) {
-        printf("인터페이스 %d 클레임 성공\n", i);
-        claimed = true;
-        claimedInterface = i;
-        FindEndpoints(i);
-        break;
-      } else {
-        printf("인터페이스 %d 클레임 실패: %s\n", i, libusb_error_name(res));
-      }
+  unsigned char data[SX_CCD_PARAMS_LENGTH] = {0};
+  res = transport->BulkRead(data, sizeof(data), &transferred, 5000);
+  if (res < 0 || transferred < SX_CCD_PARAMS_LENGTH) {
+    SetLastError("GET_CCD_PARAMS 응답 읽기 실패: " + std::string(res < 0 ? libusb_error_name(res) : "짧은 응답"));
+    return false;
+  }
+  LOG_HEX(SX_LOG_DEBUG, "GET_CCD_PARAMS 응답", data, transferred);
+  
+  params.fromCamera = true;
+  params.hFrontPorch = data[0];
+  params.hBackPorch = data[1];
+  params.width = data[2] | (data[3] << 8);
+  params.vFrontPorch = data[4];
+  params.vBackPorch = data[5];
+  params.height = data[6] | (data[7] << 8);
+  // 픽셀 크기는 8.8 고정소수점 (마이크론)
+  params.pixelWidthUm = (data[8] | (data[9] << 8)) / 256.0;
+  params.pixelHeightUm = (data[10] | (data[11] << 8)) / 256.0;
+  params.colorMatrix = data[12] | (data[13] << 8);
+  params.bitsPerPixel = data[14];
+  params.serialPorts = data[15];
+  params.extraCaps = data[16];
+  
+  if (params.width <= 0 || params.height <= 0 || (params.bitsPerPixel != 8 && params.bitsPerPixel != 16)) {
+    SetLastError("GET_CCD_PARAMS 값이 올바르지 않습니다: " + std::to_string(params.width) + "x" +
+                 std::to_string(params.height) + ", " + std::to_string(params.bitsPerPixel) + "비트");
+    return false;
+  }
+  return true;
+}
+
+void SXCamera::ApplyCCDParams(const CCDParams &params) {
+  // 크기가 바뀌면 새 크기로 버퍼 풀을 다시 만듦 (JS가 들고 있는 버퍼는 이전 풀로 반납됨)
+  {
+    std::lock_guard<std::mutex> lock(ccdMutex);
+    if (params.width != ccd.width || params.height != ccd.height || params.hBackPorch != ccd.hBackPorch) {
+      framePool = std::make_shared<FramePool>(FramePoolSizes(params.width + params.hBackPorch, params.height));
+      porchBiasLevel.clear();
     }
+    ccd = params;
   }
   
-  libusb_free_config_descriptor(config);
-  return claimed;
+  LOG_INFO("CCD: %dx%d, 픽셀 %.2fx%.2f um, %d비트, 포치 H %d/%d V %d/%d, 추가 기능 0x%02x%s",
+           ccd.width, ccd.height, ccd.pixelWidthUm, ccd.pixelHeightUm, ccd.bitsPerPixel,
+           ccd.hFrontPorch, ccd.hBackPorch, ccd.vFrontPorch, ccd.vBackPorch, ccd.extraCaps,
+           ccd.fromCamera ? "" : " (기본값)");
+}
+
+void SXCamera::SetLastError(const std::string &error) {
+  std::lock_guard<std::mutex> lock(errorMutex);
+  lastError = error;
+}
+
+std::string SXCamera::LastError() {
+  std::lock_guard<std::mutex> lock(errorMutex);
+  return lastError;
+}
+
+const SXModelInfo* SXCamera::ModelInfo(uint16_t productId) {
+  for (const SXModelInfo &model : SX_MODELS) {
+    if (model.productId == productId) return &model;
+  }
+  return nullptr;
 }
 
 Napi::Value SXCamera::Open(const Napi::CallbackInfo& info) {
   Napi::Env env = info.Env();
   
-  // 이미 연결되어 있으면 성공으로 반환
-  if (handle) {
-    return Napi::Boolean::New(env, true);
-  }
-  
-  // USB 장치 검색
-  libusb_device **devs;
-  libusb_device *dev = nullptr;
-  int count = libusb_get_device_list(ctx, &devs);
-  
-  if (count < 0) {
-    lastError = "USB 장치 목록을 가져올 수 없습니다.";
-    return Napi::Boolean::New(env, false);
+  if (captureBusy) {
+    Napi::Error::New(env, "촬영이 진행 중입니다.").ThrowAsJavaScriptException();
+    return env.Undefined();
   }
   
-  printf("USB 장치 검색 중...\n");
+  return Napi::Boolean::New(env, OpenInternal());
+}
+
+Napi::Value SXCamera::Close(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
   
-  // SX 카메라 찾기 (ECHO2 제품 ID 포함)
-  for (int i = 0; i < count; i++) {
-    libusb_device_descriptor desc;
-    int res = libusb_get_device_descriptor(devs[i], &desc);
-    
-    if (res < 0) {
-      continue;
-    }
-    
-    // 벤더 ID 출력
-    printf("검색 중: VID=0x%04x, PID=0x%04x\n", desc.idVendor, desc.idProduct);
-    
-    // Starlight Xpress ECHO2 장치 확인
-    if (desc.idVendor == SX_VID && desc.idProduct == SX_ECHO2_PID) {
-      printf("Starlight Xpress ECHO2 카메라 발견!\n");
-      dev = devs[i];
-      break;
-    }
+  // 워커 스레드가 핸들을 사용 중이면 닫지 않음
+  if (captureBusy) {
+    Napi::Error::New(env, "촬영이 진행 중입니다. cancelCapture() 후 다시 시도하세요.").ThrowAsJavaScriptException();
+    return env.Undefined();
   }
   
-  // 장치가 없으면 실패
-  if (!dev) {
-    libusb_free_device_list(devs, 1);
-    lastError = "Starlight Xpress ECHO2 카메라를 찾을 수 없습니다.";
-    return Napi::Boolean::New(env, false);
+  CloseInternal();
+  return env.Undefined();
+}
+
+void SXCamera::CloseInternal() {
+  if (transport) {
+    transport->Close();
   }
-  
-  // 장치 열기
-  int res = libusb_open(dev, &handle);
-  
-  if (res < 0) {
-    lastError = "카메라를 열 수 없습니다: " + std::string(libusb_error_name(res));
-    libusb_free_device_list(devs, 1);
-    handle = nullptr;
-    return Napi::Boolean::New(env, false);
+}
+
+bool SXCamera::HealthCheckInternal() {
+  if (!transport || !transport->IsOpen()) {
+    SetLastError("카메라가 연결되어 있지 않습니다.");
+    return false;
   }
   
-  // 구성 정보 가져오기
-  libusb_config_descriptor *config;
-  res = libusb_get_active_config_descriptor(dev, &config);
-  libusb_free_device_list(devs, 1);
+  // 가벼운 컨트롤 전송(펌웨어 버전)으로 장치 응답 확인
+  unsigned char data[16] = {0};
+  int res = transport->ControlIn(
+    SXUSB_GET_FIRMWARE_VERSION,
+    0, 0,
+    data, sizeof(data),
+    SESSION_HEALTH_TIMEOUT_MS
+  );
   
   if (res < 0) {
-    lastError = "설정 정보를 가져올 수 없습니다: " + std::string(libusb_error_name(res));
-    libusb_close(handle);
-    handle = nullptr;
-    return Napi::Boolean::New(env, false);
+    SetLastError("카메라 응답 없음: " + std::string(libusb_error_name(res)));
+    LOG_WARN("세션 상태 확인 실패: %s", libusb_error_name(res));
+    return false;
   }
-  
-  printf("장치 정보: %d개의 인터페이스\n", config->bNumInterfaces);
-  
-  // 커널 드라이버가 활성화되어 있는지 확인
-  for (int i = 0; i < config->bNumInterfaces; i++) {
-    int active = libusb_kernel_driver_active(handle, i);
-    if (active) {
-      printf("인터페이스 %d에 커널 드라이버가 활성화되어 있습니다. 분리 시도...\n", i);
-      int err = libusb_detach_kernel_driver(handle, i);
-      if (err) {
-        printf("커널 드라이버 분리 실패: %s\n", libusb_error_name(err));
-      } else {
-        printf("커널 드라이버 분리 성공\n");
-      }
+  return true;
+}
+
+bool SXCamera::EnsureSessionInternal() {
+  // 세션 모드가 아니면 기존처럼 열린 핸들만 사용
+  if (!sessionMode) {
+    if (!transport || !transport->IsOpen()) {
+      SetLastError("카메라가 연결되어 있지 않습니다.");
+      return false;
     }
+    return true;
   }
   
-  // 인터페이스 클레임
-  if (!ClaimAnyInterface()) {
-    lastError = "어떤 인터페이스도 클레임할 수 없습니다.";
-    libusb_close(handle);
-    handle = nullptr;
-    return Napi::Boolean::New(env, false);
-  }
-  
-  printf("카메라 연결 성공. 인터페이스: %d, 입력 엔드포인트: 0x%02x, 출력 엔드포인트: 0x%02x\n", 
-         claimedInterface, bulkInEndpoint, bulkOutEndpoint);
-  
-  // 장치 재설정 시도
-  res = libusb_reset_device(handle);
-  if (res < 0) {
-    printf("장치 재설정 경고: %s\n", libusb_error_name(res));
-    // 계속 진행
+  if (transport && transport->IsOpen() && HealthCheckInternal()) {
+    return true;
   }
   
-  return Napi::Boolean::New(env, true);
-}
-
-Napi::Value SXCamera::Close(const Napi::CallbackInfo& info) {
-  Napi::Env env = info.Env();
-  
-  if (handle) {
-    if (claimedInterface >= 0) {
-      libusb_release_interface(handle, claimedInterface);
-      claimedInterface = -1;
+  // 장치가 끊겼거나 응답이 없으면 다시 열기 (재열거 시간을 고려해 몇 번 재시도)
+  CloseInternal();
+  for (int attempt = 1; attempt <= SESSION_REOPEN_RETRIES; attempt++) {
+    LOG_INFO("카메라 세션 재연결 시도 %d/%d...", attempt, SESSION_REOPEN_RETRIES);
+    if (OpenInternal()) {
+      sessionReopenCount++;
+      LOG_INFO("카메라 세션 재연결 성공");
+      return true;
     }
-    libusb_close(handle);
-    handle = nullptr;
+    std::this_thread::sleep_for(std::chrono::milliseconds(SESSION_REOPEN_DELAY_MS));
   }
   
-  return env.Undefined();
+  SetLastError("카메라 세션 재연결 실패: " + LastError());
+  return false;
 }
 
 bool SXCamera::GetFirmwareVersionInternal(float &version) {
   // 기존 컨트롤 전송 방식 시도
   unsigned char data[16] = {0};
   
-  printf("기존 방식으로 펌웨어 버전 요청 (명령 0x%02x)...\n", SXUSB_GET_FIRMWARE_VERSION);
+  LOG_DEBUG("기존 방식으로 펌웨어 버전 요청 (명령 0x%02x)...", SXUSB_GET_FIRMWARE_VERSION);
   
-  int res = libusb_control_transfer(
-    handle,
-    LIBUSB_ENDPOINT_IN | LIBUSB_REQUEST_TYPE_VENDOR,
+  int res = transport->ControlIn(
     SXUSB_GET_FIRMWARE_VERSION,
     0, 0,
     data, 16,
@@ -345,22 +612,20 @@ bool SXCamera::GetFirmwareVersionInternal(float &version) {
   if (res >= 2) {
     int versionInt = data[0] | (data[1] << 8);
     version = versionInt / 100.0f;
-    printf("기존 방식으로 펌웨어 버전 가져오기 성공: %.2f\n", version);
+    LOG_DEBUG("기존 방식으로 펌웨어 버전 가져오기 성공: %.2f", version);
     return true;
   }
   
-  printf("기존 방식 실패. 새로운 벌크 전송 방식으로 시도...\n");
+  LOG_DEBUG("기존 방식 실패. 새로운 벌크 전송 방식으로 시도...");
   
   // 새로운 벌크 전송 방식 시도 (Wireshark 분석 기반)
   // 1단계: 명령 전송
   unsigned char cmd[8] = {SX_CMD_TYPE, ECHO2_GET_FIRMWARE_VERSION, 0, 0, 0, 0, 0, 0};
   int transferred = 0;
   
-  printf("벌크 전송 방식으로 펌웨어 버전 명령 전송: %02x %02x ...\n", cmd[0], cmd[1]);
+  LOG_DEBUG("벌크 전송 방식으로 펌웨어 버전 명령 전송: %02x %02x ...", cmd[0], cmd[1]);
   
-  res = libusb_bulk_transfer(
-    handle,
-    bulkOutEndpoint,  // OUT 엔드포인트
+  res = transport->BulkWrite(
     cmd, 
     sizeof(cmd),
     &transferred,
@@ -368,17 +633,15 @@ bool SXCamera::GetFirmwareVersionInternal(float &version) {
   );
   
   if (res < 0) {
-    printf("펌웨어 버전 명령 전송 실패: %s\n", libusb_error_name(res));
-    lastError = "펌웨어 버전 명령 전송 실패: " + std::string(libusb_error_name(res));
+    LOG_ERROR("펌웨어 버전 명령 전송 실패: %s", libusb_error_name(res));
+    SetLastError("펌웨어 버전 명령 전송 실패: " + std::string(libusb_error_name(res)));
     return false;
   }
   
   // 2단계: 응답 데이터 읽기
   unsigned char verData[4] = {0};
   
-  res = libusb_bulk_transfer(
-    handle,
-    bulkInEndpoint,  // IN 엔드포인트
+  res = transport->BulkRead(
     verData,
     sizeof(verData),
     &transferred,
@@ -386,17 +649,13 @@ bool SXCamera::GetFirmwareVersionInternal(float &version) {
   );
   
   if (res < 0 || transferred < 4) {
-    printf("펌웨어 버전 데이터 읽기 실패: %s\n", libusb_error_name(res));
-    lastError = "펌웨어 버전 데이터 읽기 실패: " + std::string(libusb_error_name(res));
+    LOG_ERROR("펌웨어 버전 데이터 읽기 실패: %s", libusb_error_name(res));
+    SetLastError("펌웨어 버전 데이터 읽기 실패: " + std::string(libusb_error_name(res)));
     return false;
   }
   
   // 데이터 출력
-  printf("펌웨어 버전 데이터 (%d 바이트): ", transferred);
-  for (int i = 0; i < transferred; i++) {
-    printf("%02x ", verData[i]);
-  }
-  printf("\n");
+  LOG_HEX(SX_LOG_DEBUG, "펌웨어 버전 데이터", verData, transferred);
   
   // 버전 해석 (Wireshark 분석 기반)
   int minor = verData[0];  // 0x1b = 27
@@ -404,7 +663,7 @@ bool SXCamera::GetFirmwareVersionInternal(float &version) {
   
   // 버전 값 설정
   version = major + (minor / 100.0f);
-  printf("펌웨어 버전: %.2f\n", version);
+  LOG_INFO("펌웨어 버전: %.2f", version);
   
   return true;
 }
@@ -412,7 +671,13 @@ bool SXCamera::GetFirmwareVersionInternal(float &version) {
 Napi::Value SXCamera::GetFirmwareVersion(const Napi::CallbackInfo& info) {
   Napi::Env env = info.Env();
   
-  if (!handle) {
+  // 워커 스레드가 핸들을 사용 중이면 USB 명령을 보내지 않음
+  if (captureBusy) {
+    Napi::Error::New(env, "촬영이 진행 중입니다.").ThrowAsJavaScriptException();
+    return env.Undefined();
+  }
+  
+  if (!transport || !transport->IsOpen()) {
     Napi::Error::New(env, "카메라가 연결되어 있지 않습니다.").ThrowAsJavaScriptException();
     return env.Undefined();
   }
@@ -421,7 +686,7 @@ Napi::Value SXCamera::GetFirmwareVersion(const Napi::CallbackInfo& info) {
   bool success = GetFirmwareVersionInternal(version);
   
   if (!success) {
-    Napi::Error::New(env, lastError).ThrowAsJavaScriptException();
+    Napi::Error::New(env, LastError()).ThrowAsJavaScriptException();
     return env.Undefined();
   }
   
@@ -431,7 +696,13 @@ Napi::Value SXCamera::GetFirmwareVersion(const Napi::CallbackInfo& info) {
 Napi::Value SXCamera::GetCameraModel(const Napi::CallbackInfo& info) {
   Napi::Env env = info.Env();
   
-  if (!handle) {
+  // 워커 스레드가 핸들을 사용 중이면 USB 명령을 보내지 않음
+  if (captureBusy) {
+    Napi::Error::New(env, "촬영이 진행 중입니다.").ThrowAsJavaScriptException();
+    return env.Undefined();
+  }
+  
+  if (!transport || !transport->IsOpen()) {
     Napi::Error::New(env, "카메라가 연결되어 있지 않습니다.").ThrowAsJavaScriptException();
     return env.Undefined();
   }
@@ -439,11 +710,9 @@ Napi::Value SXCamera::GetCameraModel(const Napi::CallbackInfo& info) {
   // 컨트롤 전송으로 모델 정보 요청
   unsigned char data[2] = {0};
   
-  printf("컨트롤 전송으로 카메라 모델 요청 (명령 0x%02x)...\n", 14);
+  LOG_DEBUG("컨트롤 전송으로 카메라 모델 요청 (명령 0x%02x)...", 14);
   
-  int res = libusb_control_transfer(
-    handle,
-    LIBUSB_ENDPOINT_IN | LIBUSB_REQUEST_TYPE_VENDOR,
+  int res = transport->ControlIn(
     14, // CAMERA_MODEL
     0, 0, // VALUE, INDEX
     data, 2, // 2바이트 데이터
@@ -452,10 +721,10 @@ Napi::Value SXCamera::GetCameraModel(const Napi::CallbackInfo& info) {
   
   if (res < 0) {
     std::string error = "카메라 모델을 가져오지 못했습니다: " + std::string(libusb_error_name(res));
-    printf("오류: %s\n", error.c_str());
+    LOG_WARN("오류: %s", error.c_str());
     
     // 오류가 발생해도 계속 진행 (ECHO2로 간주)
-    printf("ECHO2 카메라로 간주하고 계속 진행합니다.\n");
+    LOG_WARN("ECHO2 카메라로 간주하고 계속 진행합니다.");
     
     // ECHO2로 강제 설정
     Napi::Object result = Napi::Object::New(env);
@@ -465,17 +734,13 @@ Napi::Value SXCamera::GetCameraModel(const Napi::CallbackInfo& info) {
   }
   
   // 받은 데이터 크기 출력
-  printf("받은 데이터 크기: %d 바이트\n", res);
+  LOG_DEBUG("받은 데이터 크기: %d 바이트", res);
   
   // 데이터 덤프
-  printf("데이터 덤프: ");
-  for (int i = 0; i < res; i++) {
-    printf("%02x ", data[i]);
-  }
-  printf("\n");
+  LOG_HEX(SX_LOG_DEBUG, "데이터 덤프", data, res);
   
   int model = (res >= 1) ? data[0] : 0;
-  printf("모델 코드: %d (0x%02x)\n", model, model);
+  LOG_DEBUG("모델 코드: %d (0x%02x)", model, model);
   
   // 모델 코드와 함께 모델 이름 반환
   Napi::Object result = Napi::Object::New(env);
@@ -487,7 +752,7 @@ Napi::Value SXCamera::GetCameraModel(const Napi::CallbackInfo& info) {
     // 기존 케이스 분기...
   }
   
-  printf("모델 이름: %s\n", modelName.c_str());
+  LOG_INFO("모델 이름: %s", modelName.c_str());
   result.Set("modelName", Napi::String::New(env, modelName));
   return result;
 }
@@ -497,9 +762,7 @@ bool SXCamera::SendTwoStageCommand(unsigned char cmdCode, unsigned char *respons
   unsigned char cmd[8] = {SX_CMD_TYPE, cmdCode, 0, 0, 0, 0, 0, 0};
   int transferred = 0;
   
-  int res = libusb_bulk_transfer(
-    handle,
-    bulkOutEndpoint,  // OUT 엔드포인트
+  int res = transport->BulkWrite(
     cmd, 
     sizeof(cmd),
     &transferred,
@@ -507,15 +770,13 @@ bool SXCamera::SendTwoStageCommand(unsigned char cmdCode, unsigned char *respons
   );
   
   if (res < 0) {
-    printf("명령 전송 실패 (0x%02x): %s\n", cmdCode, libusb_error_name(res));
-    lastError = "명령 전송 실패: " + std::string(libusb_error_name(res));
+    LOG_ERROR("명령 전송 실패 (0x%02x): %s", cmdCode, libusb_error_name(res));
+    SetLastError("명령 전송 실패: " + std::string(libusb_error_name(res)));
     return false;
   }
   
   // 2단계: 응답 데이터 읽기
-  res = libusb_bulk_transfer(
-    handle,
-    bulkInEndpoint,  // IN 엔드포인트
+  res = transport->BulkRead(
     responseData,
     responseLength,
     &transferred,
@@ -523,8 +784,8 @@ bool SXCamera::SendTwoStageCommand(unsigned char cmdCode, unsigned char *respons
   );
   
   if (res < 0) {
-    printf("응답 데이터 읽기 실패 (0x%02x): %s\n", cmdCode, libusb_error_name(res));
-    lastError = "응답 데이터 읽기 실패: " + std::string(libusb_error_name(res));
+    LOG_ERROR("응답 데이터 읽기 실패 (0x%02x): %s", cmdCode, libusb_error_name(res));
+    SetLastError("응답 데이터 읽기 실패: " + std::string(libusb_error_name(res)));
     return false;
   }
   
@@ -536,33 +797,29 @@ bool SXCamera::DebugUSBCommands() {
   int transferred = 0;
   int res = 0;
   
-  printf("\n===== USB 디버깅 시작 =====\n");
-  printf("카메라 엔드포인트 설정: IN=0x%02x, OUT=0x%02x\n", bulkInEndpoint, bulkOutEndpoint);
+  LOG_INFO("===== USB 디버깅 시작 =====");
+  LOG_INFO("카메라 통신 계층: %s", transport->Name());
   
   // 1. 카메라 모델 요청 테스트 - 정확한 프로토콜 사용
   unsigned char modelCmd[8] = {0xC0, 14, 0, 0, 0, 0, 0, 0};
-  printf("\n카메라 모델 요청 명령 전송: ");
-  for (int i = 0; i < 8; i++) printf("%02x ", modelCmd[i]);
-  printf("\n");
+  LOG_HEX(SX_LOG_INFO, "카메라 모델 요청 명령 전송", modelCmd, 8);
   
-  res = libusb_bulk_transfer(handle, bulkOutEndpoint, modelCmd, sizeof(modelCmd), &transferred, 5000);
-  printf("결과: %s, 전송: %d 바이트\n", libusb_error_name(res), transferred);
+  res = transport->BulkWrite(modelCmd, sizeof(modelCmd), &transferred, 5000);
+  LOG_INFO("결과: %s, 전송: %d 바이트", libusb_error_name(res), transferred);
   
   // 응답 확인
   unsigned char modelResponse[2] = {0};
-  printf("모델 응답 읽기 시도...\n");
-  res = libusb_bulk_transfer(handle, bulkInEndpoint, modelResponse, sizeof(modelResponse), &transferred, 5000);
-  printf("결과: %s, 수신: %d 바이트\n", libusb_error_name(res), transferred);
+  LOG_INFO("모델 응답 읽기 시도...");
+  res = transport->BulkRead(modelResponse, sizeof(modelResponse), &transferred, 5000);
+  LOG_INFO("결과: %s, 수신: %d 바이트", libusb_error_name(res), transferred);
   
   if (transferred > 0) {
-    printf("모델 응답 데이터: ");
-    for (int i = 0; i < transferred; i++) printf("%02x ", modelResponse[i]);
-    printf("\n");
+    LOG_HEX(SX_LOG_INFO, "모델 응답 데이터", modelResponse, transferred);
     
     // 모델 해석
     if (transferred >= 2) {
       int modelNum = modelResponse[0] | (modelResponse[1] << 8);
-      printf("모델 번호: 0x%04x\n", modelNum);
+      LOG_INFO("모델 번호: 0x%04x", modelNum);
       
       // 모델 코드에 따른 모델 이름 매핑
       std::string modelName = "Unknown";
@@ -585,51 +842,43 @@ bool SXCamera::DebugUSBCommands() {
         case 0xBC: modelName = "ECHO2 (0xBC)"; break; // 새 모델 코드 추가
         default: 
           // 제품 ID로 모델 식별
-          libusb_device_descriptor desc;
-          libusb_device *dev = libusb_get_device(handle);
-          libusb_get_device_descriptor(dev, &desc);
-          
-          if (desc.idProduct == SX_ECHO2_PID) {
+          if (transport->ProductId() == SX_ECHO2_PID) {
             modelName = "ECHO2";
           } else {
             modelName = "Unknown SX camera";
           }
           break;
       }
-      printf("모델 이름: %s\n", modelName.c_str());
+      LOG_INFO("모델 이름: %s", modelName.c_str());
     }
   }
   
   // 2. 펌웨어 버전 요청 테스트
   unsigned char fwCmd[8] = {0xC0, 255, 0, 0, 0, 0, 0, 0};
-  printf("\n펌웨어 버전 요청 명령 전송: ");
-  for (int i = 0; i < 8; i++) printf("%02x ", fwCmd[i]);
-  printf("\n");
+  LOG_HEX(SX_LOG_INFO, "펌웨어 버전 요청 명령 전송", fwCmd, 8);
   
-  res = libusb_bulk_transfer(handle, bulkOutEndpoint, fwCmd, sizeof(fwCmd), &transferred, 5000);
-  printf("결과: %s, 전송: %d 바이트\n", libusb_error_name(res), transferred);
+  res = transport->BulkWrite(fwCmd, sizeof(fwCmd), &transferred, 5000);
+  LOG_INFO("결과: %s, 전송: %d 바이트", libusb_error_name(res), transferred);
   
   // 응답 확인
   unsigned char fwResponse[4] = {0};
-  printf("펌웨어 버전 응답 읽기 시도...\n");
-  res = libusb_bulk_transfer(handle, bulkInEndpoint, fwResponse, sizeof(fwResponse), &transferred, 5000);
-  printf("결과: %s, 수신: %d 바이트\n", libusb_error_name(res), transferred);
+  LOG_INFO("펌웨어 버전 응답 읽기 시도...");
+  res = transport->BulkRead(fwResponse, sizeof(fwResponse), &transferred, 5000);
+  LOG_INFO("결과: %s, 수신: %d 바이트", libusb_error_name(res), transferred);
   
   if (transferred > 0) {
-    printf("펌웨어 버전 응답 데이터: ");
-    for (int i = 0; i < transferred; i++) printf("%02x ", fwResponse[i]);
-    printf("\n");
+    LOG_HEX(SX_LOG_INFO, "펌웨어 버전 응답 데이터", fwResponse, transferred);
     
     // 버전 해석
     if (transferred >= 4) {
       int minorVersion = fwResponse[0] | (fwResponse[1] << 8);
       int majorVersion = fwResponse[2] | (fwResponse[3] << 8);
-      printf("펌웨어 버전: %d.%d\n", majorVersion, minorVersion);
+      LOG_INFO("펌웨어 버전: %d.%d", majorVersion, minorVersion);
     }
   }
   
   // 3. 이미지 픽셀 읽기 테스트 (간단한 예)
-  printf("\n이미지 픽셀 읽기 테스트...\n");
+  LOG_INFO("이미지 픽셀 읽기 테스트...");
   
   // 이미지 읽기 명령 구성 (READ_PIXELS=3)
   unsigned char pixelCmd[18] = {
@@ -641,26 +890,22 @@ bool SXCamera::DebugUSBCommands() {
     1, 1      // X_BIN, Y_BIN
   };
   
-  printf("픽셀 읽기 명령 전송: ");
-  for (int i = 0; i < 18; i++) printf("%02x ", pixelCmd[i]);
-  printf("\n");
+  LOG_HEX(SX_LOG_INFO, "픽셀 읽기 명령 전송", pixelCmd, 18);
   
-  res = libusb_bulk_transfer(handle, bulkOutEndpoint, pixelCmd, sizeof(pixelCmd), &transferred, 5000);
-  printf("결과: %s, 전송: %d 바이트\n", libusb_error_name(res), transferred);
+  res = transport->BulkWrite(pixelCmd, sizeof(pixelCmd), &transferred, 5000);
+  LOG_INFO("결과: %s, 전송: %d 바이트", libusb_error_name(res), transferred);
   
   // 이미지 데이터 읽기 시도 (작은 블록만)
   unsigned char pixelData[1024] = {0};
-  printf("이미지 데이터 읽기 시도 (1KB)...\n");
-  res = libusb_bulk_transfer(handle, bulkInEndpoint, pixelData, sizeof(pixelData), &transferred, 10000);
-  printf("결과: %s, 수신: %d 바이트\n", libusb_error_name(res), transferred);
+  LOG_INFO("이미지 데이터 읽기 시도 (1KB)...");
+  res = transport->BulkRead(pixelData, sizeof(pixelData), &transferred, 10000);
+  LOG_INFO("결과: %s, 수신: %d 바이트", libusb_error_name(res), transferred);
   
   if (transferred > 0) {
-    printf("처음 16바이트: ");
-    for (int i = 0; i < (transferred > 16 ? 16 : transferred); i++) printf("%02x ", pixelData[i]);
-    printf("\n");
+    LOG_HEX(SX_LOG_INFO, "처음 16바이트", pixelData, std::min(16, transferred));
   }
   
-  printf("\n===== USB 디버깅 완료 =====\n");
+  LOG_INFO("===== USB 디버깅 완료 =====");
   return true;
 }
 
@@ -668,7 +913,13 @@ bool SXCamera::DebugUSBCommands() {
 Napi::Value SXCamera::DebugCamera(const Napi::CallbackInfo& info) {
   Napi::Env env = info.Env();
   
-  if (!handle) {
+  // 워커 스레드가 핸들을 사용 중이면 USB 명령을 보내지 않음
+  if (captureBusy) {
+    Napi::Error::New(env, "촬영이 진행 중입니다.").ThrowAsJavaScriptException();
+    return env.Undefined();
+  }
+  
+  if (!transport || !transport->IsOpen()) {
     Napi::Error::New(env, "카메라가 연결되어 있지 않습니다.").ThrowAsJavaScriptException();
     return env.Undefined();
   }
@@ -677,704 +928,663 @@ Napi::Value SXCamera::DebugCamera(const Napi::CallbackInfo& info) {
   return Napi::Boolean::New(env, success);
 }
 
-// bool SXCamera::CaptureImageInternal(unsigned short *buffer, int &width, int &height, float exposureTime) {
-//   int transferred = 0;
-//   int res = 0;
+bool SXCamera::ReadPixelsPipelined(unsigned char *dest, int expectedBytes, int &bytesReceived,
+                                   const CaptureProgressFn &onProgress, uint32_t *histogram) {
+  LOG_DEBUG("다운로드 파이프라인 (%s): 전송 %d개 x %d 바이트",
+            transport->Name(), readoutQueueDepth, readoutTransferSize);
+  if (onProgress) onProgress({CAPTURE_PHASE_DOWNLOADING, 0, (long)expectedBytes});
+  
+  SXReadStream p = {};
+  p.dest = dest;
+  p.expectedBytes = expectedBytes;
+  p.queueDepth = readoutQueueDepth;
+  p.transferSize = readoutTransferSize;
+  p.timeoutMs = readoutTimeoutMs;
+  
+  // 연속 구간이 늘어날 때마다 호출: 방금 받은 구간이 캐시에 있을 때 통계 누적 (픽셀 단위로만)
+  int statsBytes = 0;
+  p.onData = [&](int offset, int length) {
+    if (histogram) {
+      int end = (offset + length) & ~1;
+      FrameStatsAccumulateLE(dest + statsBytes, end - statsBytes, histogram);
+      statsBytes = end;
+    }
+    if (onProgress) onProgress({CAPTURE_PHASE_DOWNLOADING, (long)(offset + length), (long)expectedBytes});
+  };
   
-//   // 변환: 밀리초 단위 노출 시간 계산
-//   uint32_t exposureMs = static_cast<uint32_t>(exposureTime * 1000.0f);
+  auto downloadStart = std::chrono::steady_clock::now();
+  int retryCount = 0;
   
-//   // READ_PIXELS_DELAYED 명령 구성 (14바이트 파라미터)
-//   unsigned char cmd[22] = {
-//     // 명령 헤더 (8바이트)
-//     //0x40, 0x02, 0x00, 0x00, 0x00, 0x00, 14, 0,
-//     0x40, 0x02, 0x8B, 0x00, 0x00, 0x00, 14, 0,
-
-    
-//     // 파라미터 블록 (14바이트)
-//     0, 0,                                        // X_OFFSET_L, X_OFFSET_H
-//     0, 0,                                        // Y_OFFSET_L, Y_OFFSET_H
-//     0x70, 0x05,                                  // WIDTH_L, WIDTH_H (1392)
-//     0x10, 0x04,                                  // HEIGHT_L, HEIGHT_H (1040)
-//     1, 1,                                        // X_BIN, Y_BIN
-//     static_cast<unsigned char>(exposureMs & 0xFF),               // DELAY_0 (노출 시간 밀리초, 하위 바이트)
-//     static_cast<unsigned char>((exposureMs >> 8) & 0xFF),        // DELAY_1
-//     static_cast<unsigned char>((exposureMs >> 16) & 0xFF),       // DELAY_2
-//     static_cast<unsigned char>((exposureMs >> 24) & 0xFF)        // DELAY_3 (노출 시간 밀리초, 상위 바이트)
-//   };
-  
-//   printf("READ_PIXELS_DELAYED 명령 전송 (노출 시간: %.2f초)...\n", exposureTime);
-//   res = libusb_bulk_transfer(handle, bulkOutEndpoint, cmd, sizeof(cmd), &transferred, 5000);
-//   if (res < 0) {
-//     lastError = "READ_PIXELS_DELAYED 명령 전송 실패: " + std::string(libusb_error_name(res));
-//     return false;
-//   }
-  
-//   printf("노출 시작 (%.2f초)... 카메라 내부 타이머 사용 중\n", exposureTime);
-  
-//   // 노출 완료 대기 (내부 타이머 + 여유 시간)
-//   std::this_thread::sleep_for(std::chrono::milliseconds(exposureMs + 500));
-//   printf("노출 완료. 이미지 데이터 수신 시작...\n");
-  
-//   // 이미지 데이터 청크 단위로 읽기
-//   const int expectedTotalBytes = width * height * 2; // 2바이트(16비트) 픽셀
-//   unsigned char *imageBuffer = new unsigned char[expectedTotalBytes];
-//   int totalBytesReceived = 0;
-  
-//   // 여러 작은 청크로 데이터 읽기
-//   const int chunkSize = 64 * 1024; // 64KB
-//   int retryCount = 0;
-//   const int maxRetries = 3;
-  
-//   while (totalBytesReceived < expectedTotalBytes && retryCount < maxRetries) {
-//     int bytesToRead = std::min(chunkSize, expectedTotalBytes - totalBytesReceived);
+  while (true) {
+    transport->ReadStream(p);
     
-//     printf("청크 데이터 요청: %d 바이트 (총 %d/%d)...\n", 
-//            bytesToRead, totalBytesReceived, expectedTotalBytes);
-    
-//     res = libusb_bulk_transfer(
-//       handle,
-//       bulkInEndpoint,
-//       imageBuffer + totalBytesReceived,
-//       bytesToRead,
-//       &transferred,
-//       10000 // 10초 타임아웃
-//     );
-    
-//     if (res < 0) {
-//       if (res == LIBUSB_ERROR_TIMEOUT) {
-//         retryCount++;
-//         printf("타임아웃 발생. 재시도 %d/%d...\n", retryCount, maxRetries);
-        
-//         // 첫 청크에서 타임아웃이 발생하고 재시도가 남아있으면 계속
-//         if (totalBytesReceived == 0 && retryCount < maxRetries) {
-//           std::this_thread::sleep_for(std::chrono::milliseconds(500));
-//           continue;
-//         }
-        
-//         // 이미 일부 데이터를 받았으면 부분 성공
-//         if (totalBytesReceived > 0) {
-//           printf("타임아웃 발생했지만 이미 %d 바이트를 수신했습니다. 부분 성공으로 간주합니다.\n", totalBytesReceived);
-//           break;
-//         }
-//       }
-      
-//       if (retryCount >= maxRetries) {
-//         delete[] imageBuffer;
-//         lastError = "이미지 데이터 수신 실패 (최대 재시도 횟수 초과): " + std::string(libusb_error_name(res));
-//         return false;
-//       }
-//     } else {
-//       // 성공적으로 데이터 수신
-//       totalBytesReceived += transferred;
-//       printf("청크 데이터 수신 완료: %d 바이트 (총 %d/%d)\n", 
-//              transferred, totalBytesReceived, expectedTotalBytes);
-      
-//       // 더 이상 데이터가 없으면 종료
-//       if (transferred < bytesToRead) {
-//         printf("더 이상 수신할 데이터가 없습니다. 전송 완료로 간주합니다.\n");
-//         break;
-//       }
-      
-//       // 짧은 대기 시간 추가
-//       std::this_thread::sleep_for(std::chrono::milliseconds(10));
-      
-//       // 재시도 카운터 초기화
-//       retryCount = 0;
-//     }
-//   }
-  
-//   printf("총 이미지 데이터 크기: %d 바이트 (예상: %d 바이트)\n", 
-//          totalBytesReceived, expectedTotalBytes);
-  
-//   // 데이터 수신 완전히 실패한 경우
-//   if (totalBytesReceived == 0) {
-//     delete[] imageBuffer;
-//     lastError = "이미지 데이터를 수신하지 못했습니다.";
-//     return false;
-//   }
-  
-//   // // 이미지 데이터 변환 (16비트)
-//   // int processablePixels = totalBytesReceived / 2;
-//   // for (int i = 0; i < processablePixels; i++) {
-//   //   buffer[i] = imageBuffer[i*2] | (imageBuffer[i*2+1] << 8);
-//   //   //buffer[i] = imageBuffer[i*2+1] | (imageBuffer[i*2] << 8);
-//   //   //buffer[i] = (imageBuffer[i*2] << 8) | imageBuffer[i*2+1];
-//   // }
-
-
-
-//   // 이미지 데이터 변환 전에 디버깅 정보 추가
-// printf("=== 이미지 데이터 분석 ===\n");
-// printf("총 수신 바이트: %d\n", totalBytesReceived);
-// printf("예상 픽셀 수: %d\n", width * height);
-// printf("예상 바이트 수: %d\n", width * height * 2);
-
-// // 첫 32바이트 원본 데이터 출력
-// printf("첫 32바이트 raw 데이터:\n");
-// for (int i = 0; i < 32 && i < totalBytesReceived; i++) {
-//   printf("%02x ", imageBuffer[i]);
-//   if ((i + 1) % 16 == 0) printf("\n");
-// }
-// printf("\n");
-
-// // 원본 바이트 순서로 복원 (수정 전 상태)
-// int processablePixels = totalBytesReceived / 2;
-// for (int i = 0; i < processablePixels; i++) {
-//   buffer[i] = imageBuffer[i*2] | (imageBuffer[i*2+1] << 8);
-// }
-
-// // 변환된 첫 16개 픽셀 값 출력
-// printf("변환된 첫 16개 픽셀 값:\n");
-// for (int i = 0; i < 16 && i < processablePixels; i++) {
-//   printf("%d ", buffer[i]);
-// }
-// printf("\n");
-
-// // 이미지 중앙 부분의 몇 픽셀도 확인
-// int centerStart = (height / 2) * width + (width / 2);
-// printf("중앙 부분 픽셀 값 (인덱스 %d부터):\n", centerStart);
-// for (int i = 0; i < 8 && (centerStart + i) < processablePixels; i++) {
-//   printf("%d ", buffer[centerStart + i]);
-// }
-// printf("\n");
-  
-//   // 데이터가 부족한 경우 남은 픽셀을 0으로 채움
-//   if (processablePixels < width * height) {
-//     printf("경고: 수신된 데이터가 예상보다 적습니다 (%d/%d 픽셀). 남은 픽셀을 0으로 채웁니다.\n", 
-//            processablePixels, width * height);
-//     for (int i = processablePixels; i < width * height; i++) {
-//       buffer[i] = 0;
-//     }
-//   }
-  
-//   delete[] imageBuffer;
-//   return true;
-// }
-
-
-// last
-// bool SXCamera::CaptureImageInternal(unsigned short *buffer, int &width, int &height, float exposureTime, bool enableBinning) {
-//   int transferred = 0;
-//   int res = 0;
-  
-//   // 비닝에 따른 해상도 계산
-//   int actualWidth, actualHeight;
-//   unsigned char xBin, yBin;
-  
-//   if (enableBinning) {
-//     // 2x2 하드웨어 비닝 
-//     actualWidth = 1392;   // 1392 / 2
-//     actualHeight = 1040;  // 1040 / 2
-//     xBin = 2;
-//     yBin = 2;
-//     printf("=== 2x2 하드웨어 비닝 모드 ===\n");
-//   } else {
-//     // 1x1 풀 해상도
-//     actualWidth = 1392;
-//     actualHeight = 1040;
-//     xBin = 1;
-//     yBin = 1;
-//     printf("=== 풀 해상도 모드 ===\n");
-//   }
-  
-//   printf("해상도: %dx%d, 비닝: %dx%d, 노출 시간: %.2f초\n", 
-//          actualWidth, actualHeight, xBin, yBin, exposureTime);
-  
-//   // width, height 업데이트
-//   width = actualWidth;
-//   height = actualHeight;
-  
-//   // 1단계: sxClearPixels() - Wireshark에서 확인된 정확한 구조
-//   printf("1단계: sxClearPixels (flags=0x03)...\n");
-//   unsigned char clearCmd[8] = {0x40, 0x01, 0x03, 0x00, 0x00, 0x00, 0x00, 0x00};
-//   res = libusb_bulk_transfer(handle, bulkOutEndpoint, clearCmd, 8, &transferred, 5000);
-//   if (res < 0) {
-//     lastError = "sxClearPixels 실패: " + std::string(libusb_error_name(res));
-//     return false;
-//   }
-//   printf("sxClearPixels 완료\n");
-  
-//   // 2단계: Host PC 타이밍으로 노출 제어
-//   printf("2단계: Host PC 타이밍으로 노출 제어...\n");
-//   uint32_t exposureMs = static_cast<uint32_t>(exposureTime * 1000.0f);
-//   printf("노출 진행 중... (%.2f초)\n", exposureTime);
-  
-//   // 30초 이상의 긴 노출인 경우 30초마다 vertical register 클리어
-//   if (exposureTime > 30.0f) {
-//     int clearInterval = 30000; // 30초
-//     int remainingMs = exposureMs;
+    if (p.error == 0 || p.finished) {
+      break;
+    }
     
-//     while (remainingMs > 4000) { // 마지막 4초는 건드리지 않음
-//       int sleepTime = std::min(clearInterval, remainingMs - 4000);
-//       std::this_thread::sleep_for(std::chrono::milliseconds(sleepTime));
+    if (p.error == LIBUSB_ERROR_TIMEOUT) {
+      metrics.RecordTimeout();
+      retryCount++;
+      LOG_WARN("타임아웃 발생. 재시도 %d/%d...", retryCount, READOUT_MAX_RETRIES);
       
-//       // Vertical register 클리어 (NOWIPE_FRAME flag)
-//       unsigned char clearVertCmd[8] = {0x40, 0x01, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00};
-//       libusb_bulk_transfer(handle, bulkOutEndpoint, clearVertCmd, 8, &transferred, 5000);
-//       printf("Vertical register 클리어 (남은 시간: %.1f초)\n", remainingMs / 1000.0f);
+      // 이미 일부 데이터를 받았으면 부분 성공
+      if (p.contiguousBytes > 0) {
+        LOG_WARN("타임아웃 발생했지만 이미 %d 바이트를 수신했습니다. 부분 성공으로 간주합니다.", p.contiguousBytes);
+        break;
+      }
       
-//       remainingMs -= sleepTime;
-//     }
-    
-//     // 마지막 남은 시간 대기
-//     if (remainingMs > 0) {
-//       std::this_thread::sleep_for(std::chrono::milliseconds(remainingMs));
-//     }
-//   } else {
-//     // 30초 이하면 그냥 대기
-//     std::this_thread::sleep_for(std::chrono::milliseconds(exposureMs));
-//   }
-  
-//   printf("노출 완료\n");
-  
-//   // 3단계: sxReadPixels() - 비닝에 맞는 파라미터로 설정
-//   printf("3단계: sxReadPixels로 이미지 읽기...\n");
-  
-//   // 비닝에 따른 WIDTH, HEIGHT 바이트 계산
-//   unsigned char widthL = actualWidth & 0xFF;
-//   unsigned char widthH = (actualWidth >> 8) & 0xFF;
-//   unsigned char heightL = actualHeight & 0xFF;
-//   unsigned char heightH = (actualHeight >> 8) & 0xFF;
-  
-//   unsigned char readCmd[18] = {
-//     // 헤더 (8바이트) - Wireshark 분석 결과
-//     0x40, 0x03, 0x03, 0x00, 0x00, 0x00, 0x0A, 0x00,
-    
-//     // 파라미터 (10바이트) - 비닝 적용
-//     0x00, 0x00,       // X_OFFSET_L, X_OFFSET_H
-//     0x00, 0x00,       // Y_OFFSET_L, Y_OFFSET_H  
-//     widthL, widthH,   // WIDTH_L, WIDTH_H (비닝에 따라 동적) // 아니다 그냥 풀해상도 적어야함
-//     heightL, heightH, // HEIGHT_L, HEIGHT_H (비닝에 따라 동적) // 아니다 그냥 풀해상도 적어야함
-//     xBin, yBin        // X_BIN, Y_BIN (비닝 설정)
-//   };
-  
-//   printf("파라미터: WIDTH=%d(%02x %02x), HEIGHT=%d(%02x %02x), BIN=%dx%d\n",
-//          actualWidth, widthL, widthH, actualHeight, heightL, heightH, xBin, yBin);
-  
-//   // USB 명령 전체 덤프
-//   printf("USB 명령 덤프: ");
-//   for (int i = 0; i < 18; i++) {
-//     printf("%02x ", readCmd[i]);
-//   }
-//   printf("\n");
-  
-//   res = libusb_bulk_transfer(handle, bulkOutEndpoint, readCmd, 18, &transferred, 5000);
-//   if (res < 0) {
-//     lastError = "sxReadPixels 실패: " + std::string(libusb_error_name(res));
-//     return false;
-//   }
-//   printf("sxReadPixels 명령 전송 완료\n");
-  
-//   // 4단계: 이미지 데이터 수신
-//   printf("4단계: 이미지 데이터 수신 중...\n");
-//   const int expectedTotalBytes = actualWidth/2 * actualHeight/2 * 2; // 16비트 이미지
-//   unsigned char *imageBuffer = new unsigned char[expectedTotalBytes];
-//   int totalBytesReceived = 0;
-  
-//   printf("예상 이미지 크기: %d 바이트 (%d x %d x 2)\n", expectedTotalBytes, actualWidth/2, actualHeight/2);
-  
-//   // 청크 단위로 데이터 읽기
-//   const int chunkSize = 64 * 1024; // 64KB 청크
-//   int retryCount = 0;
-//   const int maxRetries = 5;
-  
-//   while (totalBytesReceived < expectedTotalBytes && retryCount < maxRetries) {
-//     int bytesToRead = std::min(chunkSize, expectedTotalBytes - totalBytesReceived);
-    
-//     printf("청크 데이터 요청: %d 바이트 (총 %d/%d)...\n", 
-//            bytesToRead, totalBytesReceived, expectedTotalBytes);
-    
-//     res = libusb_bulk_transfer(
-//       handle,
-//       bulkInEndpoint,
-//       imageBuffer + totalBytesReceived,
-//       bytesToRead,
-//       &transferred,
-//       15000 // 15초 타임아웃
-//     );
+      // 첫 데이터 전에 타임아웃이 발생하고 재시도가 남아있으면 계속
+      if (retryCount < READOUT_MAX_RETRIES) {
+        metrics.RecordRetry();
+        std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+        continue;
+      }
+    }
     
-//     if (res < 0) {
-//       if (res == LIBUSB_ERROR_TIMEOUT) {
-//         retryCount++;
-//         printf("타임아웃 발생. 재시도 %d/%d...\n", retryCount, maxRetries);
-        
-//         // 첫 청크에서 타임아웃이 발생하고 재시도가 남아있으면 계속
-//         if (totalBytesReceived == 0 && retryCount < maxRetries) {
-//           std::this_thread::sleep_for(std::chrono::milliseconds(1000));
-//           continue;
-//         }
-        
-//         // 이미 일부 데이터를 받았으면 부분 성공
-//         if (totalBytesReceived > 0) {
-//           printf("타임아웃 발생했지만 이미 %d 바이트를 수신했습니다. 부분 성공으로 간주합니다.\n", totalBytesReceived);
-//           break;
-//         }
-//       }
-      
-//       if (retryCount >= maxRetries) {
-//         delete[] imageBuffer;
-//         lastError = "이미지 데이터 수신 실패 (최대 재시도 횟수 초과): " + std::string(libusb_error_name(res));
-//         return false;
-//       }
-//     } else {
-//       // 성공적으로 데이터 수신
-//       totalBytesReceived += transferred;
-//       printf("청크 데이터 수신 완료: %d 바이트 (총 %d/%d)\n", 
-//              transferred, totalBytesReceived, expectedTotalBytes);
-      
-//       // 더 이상 데이터가 없으면 종료
-//       if (transferred < bytesToRead) {
-//         printf("더 이상 수신할 데이터가 없습니다. 전송 완료로 간주합니다.\n");
-//         break;
-//       }
-      
-//       // 짧은 대기 시간 추가
-//       std::this_thread::sleep_for(std::chrono::milliseconds(10));
-      
-//       // 재시도 카운터 초기화
-//       retryCount = 0;
-//     }
-//   }
-  
-//   printf("총 이미지 데이터 크기: %d 바이트 (예상: %d 바이트)\n", 
-//          totalBytesReceived, expectedTotalBytes);
-  
-//   // 데이터 수신 완전히 실패한 경우
-//   if (totalBytesReceived == 0) {
-//     delete[] imageBuffer;
-//     lastError = "이미지 데이터를 수신하지 못했습니다.";
-//     return false;
-//   }
-  
-//   // 이미지 데이터 변환 및 디버깅
-//   printf("=== 이미지 데이터 분석 ===\n");
-//   printf("총 수신 바이트: %d\n", totalBytesReceived);
-//   printf("실제 해상도: %dx%d\n", actualWidth, actualHeight);
-//   printf("예상 픽셀 수: %d\n", actualWidth * actualHeight);
-//   printf("예상 바이트 수: %d\n", actualWidth * actualHeight * 2);
-
-//   // 첫 32바이트 원본 데이터 출력
-//   printf("첫 32바이트 raw 데이터:\n");
-//   for (int i = 0; i < 32 && i < totalBytesReceived; i++) {
-//     printf("%02x ", imageBuffer[i]);
-//     if ((i + 1) % 16 == 0) printf("\n");
-//   }
-//   printf("\n");
-
-//   // 실제 수신된 데이터로 16비트 픽셀 변환
-//   int processablePixels = totalBytesReceived / 2;
-//   for (int i = 0; i < processablePixels; i++) {
-//     buffer[i] = imageBuffer[i*2] | (imageBuffer[i*2+1] << 8);
-//   }
-
-//   // 변환된 첫 16개 픽셀 값 출력
-//   printf("변환된 첫 16개 픽셀 값:\n");
-//   for (int i = 0; i < 16 && i < processablePixels; i++) {
-//     printf("%d ", buffer[i]);
-//   }
-//   printf("\n");
-
-//   // 이미지 중앙 부분의 몇 픽셀도 확인
-//   int centerStart = (actualHeight / 2) * actualWidth + (actualWidth / 2);
-//   if (centerStart + 8 < processablePixels) {
-//     printf("중앙 부분 픽셀 값 (인덱스 %d부터):\n", centerStart);
-//     for (int i = 0; i < 8 && (centerStart + i) < processablePixels; i++) {
-//       printf("%d ", buffer[centerStart + i]);
-//     }
-//     printf("\n");
-//   }
-  
-//   delete[] imageBuffer;
-//   printf("=== 하드웨어 비닝 촬영 완료 ===\n");
-//   return true;
-// }
-
-bool SXCamera::CaptureImageInternal(unsigned short *buffer, int &width, int &height, float exposureTime, bool enableBinning) {
-  int transferred = 0;
-  int res = 0;
+    metrics.RecordReadoutFailure(p.transfers);
+    SetLastError("이미지 데이터 수신 실패: " + std::string(libusb_error_name(p.error)));
+    return false;
+  }
   
-  // 비닝에 따른 해상도 계산
-  int actualWidth, actualHeight;
-  unsigned char xBin, yBin;
-  
-  if (enableBinning) {
-    // 2x2 하드웨어 비닝 
-    actualWidth = 696;   // 1392 / 2
-    actualHeight = 520;  // 1040 / 2
-    xBin = 2;
-    yBin = 2;
-    printf("=== 2x2 하드웨어 비닝 모드 ===\n");
+  auto downloadEnd = std::chrono::steady_clock::now();
+  bytesReceived = p.contiguousBytes;
+  lastDownloadBytes = p.contiguousBytes;
+  lastFirstDataTime = p.firstChunkBytes > 0 ? p.firstDataAt : downloadEnd;
+  
+  // 카메라 타이머 모드에서는 전송을 노출 종료 전에 미리 걸어 두므로
+  // 처리량은 첫 전송 완료 이후 구간으로 계산
+  double mbps = 0.0;
+  if (p.firstChunkBytes > 0 && p.contiguousBytes > p.firstChunkBytes) {
+    double streamMs = std::chrono::duration<double, std::milli>(downloadEnd - p.firstDataAt).count();
+    lastDownloadMs = streamMs * p.contiguousBytes / (p.contiguousBytes - p.firstChunkBytes);
   } else {
-    // 1x1 풀 해상도
-    actualWidth = 1392;
-    actualHeight = 1040;
-    xBin = 1;
-    yBin = 1;
-    printf("=== 풀 해상도 모드 ===\n");
+    lastDownloadMs = std::chrono::duration<double, std::milli>(downloadEnd - downloadStart).count();
   }
+  if (lastDownloadMs > 0) mbps = (lastDownloadBytes / (1024.0 * 1024.0)) / (lastDownloadMs / 1000.0);
+  
+  metrics.RecordReadout(p.contiguousBytes, p.transfers,
+                        p.finished && p.contiguousBytes < expectedBytes,
+                        p.contiguousBytes < expectedBytes);
+  if (mbps > 0) metrics.RecordDownloadMBps(mbps);
+  LOG_INFO("다운로드 완료: %d/%d 바이트, %.1f ms, %.2f MB/s",
+           lastDownloadBytes, expectedBytes, lastDownloadMs, mbps);
+  return true;
+}
+
+bool SXCamera::WaitExposureInternal(uint32_t exposureMs, uint32_t waitMs, bool verticalClear,
+                                    const CaptureProgressFn &onProgress) {
+  int transferred = 0;
   
-  printf("해상도: %dx%d, 비닝: %dx%d, 노출 시간: %.2f초\n", 
-         actualWidth, actualHeight, xBin, yBin, exposureTime);
-  
-  // width, height 업데이트
-  width = actualWidth;
-  height = actualHeight;
+  // 긴 노출인 경우 30초마다 vertical register 클리어 (마지막 4초는 건드리지 않음)
+  // 취소 요청을 확인할 수 있도록 EXPOSURE_POLL_MS 단위로 나누어 대기
+  const uint32_t clearInterval = 30000; // 30초
+  const uint32_t lastClearAt = waitMs > 4000 ? waitMs - 4000 : 0;
+  uint32_t nextClearAt = verticalClear ? std::min(clearInterval, lastClearAt) : waitMs + 1;
+  uint32_t lastReportedSec = 0;
   
-  // 1단계: sxClearPixels() - Wireshark에서 확인된 정확한 구조
-  printf("1단계: sxClearPixels (flags=0x03)...\n");
-  unsigned char clearCmd[8] = {0x40, 0x01, 0x03, 0x00, 0x00, 0x00, 0x00, 0x00};
-  res = libusb_bulk_transfer(handle, bulkOutEndpoint, clearCmd, 8, &transferred, 5000);
-  if (res < 0) {
-    lastError = "sxClearPixels 실패: " + std::string(libusb_error_name(res));
-    return false;
-  }
-  printf("sxClearPixels 완료\n");
+  auto waitStart = std::chrono::steady_clock::now();
+  uint32_t elapsedMs = 0;
   
-  // 2단계: Host PC 타이밍으로 노출 제어
-  printf("2단계: Host PC 타이밍으로 노출 제어...\n");
-  uint32_t exposureMs = static_cast<uint32_t>(exposureTime * 1000.0f);
-  printf("노출 진행 중... (%.2f초)\n", exposureTime);
+  if (onProgress) onProgress({CAPTURE_PHASE_EXPOSING, 0, (long)exposureMs});
   
-  // 30초 이상의 긴 노출인 경우 30초마다 vertical register 클리어
-  if (exposureTime > 30.0f) {
-    int clearInterval = 30000; // 30초
-    int remainingMs = exposureMs;
+  while (elapsedMs < waitMs) {
+    if (cancelRequested) {
+      LOG_INFO("노출 중 촬영 취소 (%.1f/%.1f초)", elapsedMs / 1000.0f, exposureMs / 1000.0f);
+      SetLastError("촬영이 취소되었습니다.");
+      return false;
+    }
     
-    while (remainingMs > 4000) { // 마지막 4초는 건드리지 않음
-      int sleepTime = std::min(clearInterval, remainingMs - 4000);
-      std::this_thread::sleep_for(std::chrono::milliseconds(sleepTime));
-      
+    uint32_t sleepTime = std::min<uint32_t>(EXPOSURE_POLL_MS, waitMs - elapsedMs);
+    if (nextClearAt > elapsedMs) {
+      sleepTime = std::min(sleepTime, nextClearAt - elapsedMs);
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(sleepTime));
+    
+    elapsedMs = static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::steady_clock::now() - waitStart).count());
+    
+    if (elapsedMs >= nextClearAt && nextClearAt < waitMs) {
       // Vertical register 클리어 (NOWIPE_FRAME flag)
       unsigned char clearVertCmd[8] = {0x40, 0x01, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00};
-      libusb_bulk_transfer(handle, bulkOutEndpoint, clearVertCmd, 8, &transferred, 5000);
-      printf("Vertical register 클리어 (남은 시간: %.1f초)\n", remainingMs / 1000.0f);
+      transport->BulkWrite(clearVertCmd, 8, &transferred, 5000);
+      LOG_DEBUG("Vertical register 클리어 (남은 시간: %.1f초)", (waitMs - std::min(elapsedMs, waitMs)) / 1000.0f);
       
-      remainingMs -= sleepTime;
+      nextClearAt = (nextClearAt >= lastClearAt) ? waitMs + 1 : std::min(nextClearAt + clearInterval, lastClearAt);
     }
     
-    // 마지막 남은 시간 대기
-    if (remainingMs > 0) {
-      std::this_thread::sleep_for(std::chrono::milliseconds(remainingMs));
+    // 진행 상황은 1초 단위로만 보고
+    if (onProgress && elapsedMs / 1000 != lastReportedSec) {
+      lastReportedSec = elapsedMs / 1000;
+      onProgress({CAPTURE_PHASE_EXPOSING, (long)std::min(elapsedMs, exposureMs), (long)exposureMs});
     }
-  } else {
-    // 30초 이하면 그냥 대기
-    std::this_thread::sleep_for(std::chrono::milliseconds(exposureMs));
-  }
-  
-  printf("노출 완료\n");
-  
-  // 3단계: sxReadPixels() - WIDTH/HEIGHT는 항상 원본 해상도
-  printf("3단계: sxReadPixels로 이미지 읽기...\n");
-  
-  // WIDTH, HEIGHT는 항상 1392x1040 (원본 해상도)
-  unsigned char readCmd[18] = {
-    // 헤더 (8바이트) - Wireshark 분석 결과
-    0x40, 0x03, 0x03, 0x00, 0x00, 0x00, 0x0A, 0x00,
-    
-    // 파라미터 (10바이트) - 원본 해상도 + 비닝 파라미터
-    0x00, 0x00,       // X_OFFSET_L, X_OFFSET_H
-    0x00, 0x00,       // Y_OFFSET_L, Y_OFFSET_H  
-    0x70, 0x05,       // WIDTH_L, WIDTH_H (1392 = 0x0570)
-    0x10, 0x04,       // HEIGHT_L, HEIGHT_H (1040 = 0x0410)
-    xBin, yBin        // X_BIN, Y_BIN (비닝 설정)
-  };
-  
-  printf("파라미터: WIDTH=1392(70 05), HEIGHT=1040(10 04), BIN=%dx%d\n", xBin, yBin);
-  printf("실제 출력 해상도: %dx%d\n", actualWidth, actualHeight);
-  
-  // USB 명령 전체 덤프
-  printf("USB 명령 덤프: ");
-  for (int i = 0; i < 18; i++) {
-    printf("%02x ", readCmd[i]);
   }
-  printf("\n");
   
-  res = libusb_bulk_transfer(handle, bulkOutEndpoint, readCmd, 18, &transferred, 5000);
-  if (res < 0) {
-    lastError = "sxReadPixels 실패: " + std::string(libusb_error_name(res));
+  if (cancelRequested) {
+    SetLastError("촬영이 취소되었습니다.");
     return false;
   }
-  printf("sxReadPixels 명령 전송 완료\n");
-  
-  // 4단계: 이미지 데이터 수신
-  printf("4단계: 이미지 데이터 수신 중...\n");
-  const int expectedTotalBytes = actualWidth * actualHeight * 2; // 16비트 이미지
-  unsigned char *imageBuffer = new unsigned char[expectedTotalBytes];
-  int totalBytesReceived = 0;
-  
-  printf("예상 이미지 크기: %d 바이트 (%d x %d x 2)\n", expectedTotalBytes, actualWidth, actualHeight);
-  
-  // 청크 단위로 데이터 읽기
-  const int chunkSize = 64 * 1024; // 64KB 청크
-  int retryCount = 0;
-  const int maxRetries = 5;
-  
-  while (totalBytesReceived < expectedTotalBytes && retryCount < maxRetries) {
-    int bytesToRead = std::min(chunkSize, expectedTotalBytes - totalBytesReceived);
-    
-    printf("청크 데이터 요청: %d 바이트 (총 %d/%d)...\n", 
-           bytesToRead, totalBytesReceived, expectedTotalBytes);
-    
-    res = libusb_bulk_transfer(
-      handle,
-      bulkInEndpoint,
-      imageBuffer + totalBytesReceived,
-      bytesToRead,
-      &transferred,
-      15000 // 15초 타임아웃
-    );
-    
-    if (res < 0) {
-      if (res == LIBUSB_ERROR_TIMEOUT) {
-        retryCount++;
-        printf("타임아웃 발생. 재시도 %d/%d...\n", retryCount, maxRetries);
-        
-        // 첫 청크에서 타임아웃이 발생하고 재시도가 남아있으면 계속
-        if (totalBytesReceived == 0 && retryCount < maxRetries) {
-          std::this_thread::sleep_for(std::chrono::milliseconds(1000));
-          continue;
-        }
-        
-        // 이미 일부 데이터를 받았으면 부분 성공
-        if (totalBytesReceived > 0) {
-          printf("타임아웃 발생했지만 이미 %d 바이트를 수신했습니다. 부분 성공으로 간주합니다.\n", totalBytesReceived);
-          break;
-        }
-      }
-      
-      if (retryCount >= maxRetries) {
-        delete[] imageBuffer;
-        lastError = "이미지 데이터 수신 실패 (최대 재시도 횟수 초과): " + std::string(libusb_error_name(res));
-        return false;
-      }
-    } else {
-      // 성공적으로 데이터 수신
-      totalBytesReceived += transferred;
-      printf("청크 데이터 수신 완료: %d 바이트 (총 %d/%d)\n", 
-             transferred, totalBytesReceived, expectedTotalBytes);
-      
-      // 더 이상 데이터가 없으면 종료
-      if (transferred < bytesToRead) {
-        printf("더 이상 수신할 데이터가 없습니다. 전송 완료로 간주합니다.\n");
-        break;
-      }
-      
-      // 짧은 대기 시간 추가
-      std::this_thread::sleep_for(std::chrono::milliseconds(10));
-      
-      // 재시도 카운터 초기화
-      retryCount = 0;
-    }
+  return true;
+}
+
+void SXCamera::RecordExposureTiming(int mode, double errorMs) {
+  std::lock_guard<std::mutex> lock(statsMutex);
+  ExposureTimingStats &st = exposureStats[mode];
+  
+  // Welford 방식으로 평균/분산 누적
+  st.count++;
+  double delta = errorMs - st.mean;
+  st.mean += delta / st.count;
+  st.m2 += delta * (errorMs - st.mean);
+  if (st.count == 1 || errorMs < st.minErrorMs) st.minErrorMs = errorMs;
+  if (st.count == 1 || errorMs > st.maxErrorMs) st.maxErrorMs = errorMs;
+  
+  metrics.RecordExposureOvershoot(errorMs);
+}
+
+// CCD 전체 영역
+CaptureRegion SXCamera::FullFrameRegion(int bin) const {
+  return {0, 0, ccd.width - ccd.width % bin, ccd.height - ccd.height % bin, bin, bin, true};
+}
+
+// 영역을 요청 시점 이후 열린 카메라의 CCD 크기에 맞춤 (세션 재연결로 크기가 바뀐 경우)
+bool SXCamera::FitRegionInternal(CaptureRegion &region) {
+  if (region.fullFrame) {
+    region.width = ccd.width - region.x;
+    region.height = ccd.height - region.y;
+    region.width -= region.width % region.xBin;
+    region.height -= region.height % region.yBin;
   }
-  
-  printf("총 이미지 데이터 크기: %d 바이트 (예상: %d 바이트)\n", 
-         totalBytesReceived, expectedTotalBytes);
-  
-  // 데이터 수신 완전히 실패한 경우
-  if (totalBytesReceived == 0) {
-    delete[] imageBuffer;
-    lastError = "이미지 데이터를 수신하지 못했습니다.";
+  if (region.width < region.xBin || region.height < region.yBin ||
+      region.x + region.width > ccd.width || region.y + region.height > ccd.height) {
+    SetLastError("촬영 영역이 CCD(" + std::to_string(ccd.width) + "x" + std::to_string(ccd.height) + ")를 벗어났습니다.");
     return false;
   }
-  
-  // 이미지 데이터 변환 및 디버깅
-  printf("=== 이미지 데이터 분석 ===\n");
-  printf("총 수신 바이트: %d\n", totalBytesReceived);
-  printf("실제 해상도: %dx%d (2x2 비닝)\n", actualWidth, actualHeight);
-  printf("예상 픽셀 수: %d\n", actualWidth * actualHeight);
-  printf("예상 바이트 수: %d\n", actualWidth * actualHeight * 2);
+  return true;
+}
 
-  // 첫 32바이트 원본 데이터 출력
-  printf("첫 32바이트 raw 데이터:\n");
-  for (int i = 0; i < 32 && i < totalBytesReceived; i++) {
-    printf("%02x ", imageBuffer[i]);
-    if ((i + 1) % 16 == 0) printf("\n");
+// 수신 버퍼의 행 배치. 바이어스 보정을 켜면 영역 오른쪽부터 수평 백 포치 끝까지 함께 읽음
+// (READ_PIXELS 오프셋은 첫 활성 픽셀 기준의 부호 없는 값이라 프런트 포치는 지정할 수 없음)
+// 센서 왼쪽의 좁은 영역은 포치까지 읽으면 거의 전체 행을 전송하게 되므로 포치를 읽지 않음 (마지막 포치 바이어스 사용)
+BiasLayout SXCamera::ReadoutLayout(const CaptureRegion &region) const {
+  BiasLayout layout;
+  layout.outWidth = region.width / region.xBin;
+  layout.rawWidth = layout.outWidth;
+  layout.porchStart = layout.outWidth;
+  layout.porchEnd = layout.outWidth;
+  if (biasMode != BIAS_MODE_OFF && ccd.hBackPorch > 0) {
+    // 활성 영역과 걸친 비닝 열은 빛을 받으므로 포치에서 제외
+    int rawWidth = (ccd.width + ccd.hBackPorch - region.x) / region.xBin;
+    int porchStart = (ccd.width - region.x + region.xBin - 1) / region.xBin;
+    if (porchStart < rawWidth && rawWidth - layout.outWidth <= BIAS_MAX_PORCH_OVERHEAD * layout.outWidth) {
+      layout.rawWidth = rawWidth;
+      layout.porchStart = porchStart;
+      layout.porchEnd = rawWidth;
+    }
   }
-  printf("\n");
+  return layout;
+}
 
-  // 실제 수신된 데이터로 16비트 픽셀 변환
-  int processablePixels = totalBytesReceived / 2;
-  for (int i = 0; i < processablePixels; i++) {
-    buffer[i] = imageBuffer[i*2] | (imageBuffer[i*2+1] << 8);
+// captureImage 두 번째 인자 해석
+//  - boolean: true면 전체 영역 2x2 비닝, false면 1x1 (기존 API)
+//  - { x, y, width, height, bin, xBin, yBin }: 부분 영역 (생략한 값은 전체 영역 / 1x1 비닝)
+bool SXCamera::ParseCaptureRegion(const Napi::Value &value, CaptureRegion &region, std::string &error) const {
+  if (value.IsEmpty() || value.IsUndefined() || value.IsNull()) {
+    region = FullFrameRegion(2);
+    return true;
   }
-
-  // 변환된 첫 16개 픽셀 값 출력
-  printf("변환된 첫 16개 픽셀 값:\n");
-  for (int i = 0; i < 16 && i < processablePixels; i++) {
-    printf("%d ", buffer[i]);
+  if (value.IsBoolean()) {
+    region = FullFrameRegion(value.As<Napi::Boolean>().Value() ? 2 : 1);
+    return true;
   }
-  printf("\n");
-
-  // 이미지 중앙 부분의 몇 픽셀도 확인
-  int centerStart = (actualHeight / 2) * actualWidth + (actualWidth / 2);
-  if (centerStart + 8 < processablePixels) {
-    printf("중앙 부분 픽셀 값 (인덱스 %d부터):\n", centerStart);
-    for (int i = 0; i < 8 && (centerStart + i) < processablePixels; i++) {
-      printf("%d ", buffer[centerStart + i]);
-    }
-    printf("\n");
+  if (!value.IsObject()) {
+    error = "촬영 영역은 boolean(2x2 비닝 여부) 또는 { x, y, width, height, bin } 객체여야 합니다.";
+    return false;
+  }
+  
+  Napi::Object obj = value.As<Napi::Object>();
+  auto number = [&](const char *key, int &out) {
+    if (obj.Has(key) && obj.Get(key).IsNumber()) out = obj.Get(key).As<Napi::Number>().Int32Value();
+  };
+  
+  region = FullFrameRegion(1);
+  region.fullFrame = !obj.Has("width") && !obj.Has("height");
+  number("bin", region.xBin);
+  region.yBin = region.xBin;
+  number("xBin", region.xBin);
+  number("yBin", region.yBin);
+  number("x", region.x);
+  number("y", region.y);
+  region.width = ccd.width - region.x;
+  region.height = ccd.height - region.y;
+  number("width", region.width);
+  number("height", region.height);
+  
+  if (region.xBin < 1 || region.xBin > SX_MAX_BIN || region.yBin < 1 || region.yBin > SX_MAX_BIN) {
+    error = "비닝은 1~" + std::to_string(SX_MAX_BIN) + " 사이여야 합니다.";
+    return false;
+  }
+  if (region.x < 0 || region.y < 0 || region.width < region.xBin || region.height < region.yBin ||
+      region.x + region.width > ccd.width || region.y + region.height > ccd.height) {
+    error = "촬영 영역이 CCD(" + std::to_string(ccd.width) + "x" + std::to_string(ccd.height) + ")를 벗어났습니다.";
+    return false;
   }
   
-  delete[] imageBuffer;
-  printf("=== 하드웨어 비닝 촬영 완료 ===\n");
+  // 카메라는 INT(WIDTH / X_BIN) 픽셀만 보내므로 남는 열/행은 잘라서 메타데이터와 맞춤
+  region.width -= region.width % region.xBin;
+  region.height -= region.height % region.yBin;
   return true;
 }
 
-// Napi::Value SXCamera::CaptureImage(const Napi::CallbackInfo& info) {
-//   Napi::Env env = info.Env();
+bool SXCamera::CaptureImageInternal(unsigned short *buffer, int &width, int &height, float exposureTime,
+                                    const CaptureRegion &region, const CaptureProgressFn &onProgress,
+                                    uint32_t *histogram) {
+  int transferred = 0;
+  int res = 0;
   
-//   if (!handle) {
-//     Napi::Error::New(env, "카메라가 연결되어 있지 않습니다.").ThrowAsJavaScriptException();
-//     return env.Undefined();
-//   }
+  // 비닝 후 출력 해상도
+  const int actualWidth = region.width / region.xBin;
+  const int actualHeight = region.height / region.yBin;
+  const unsigned char xBin = static_cast<unsigned char>(region.xBin);
+  const unsigned char yBin = static_cast<unsigned char>(region.yBin);
+  
+  // 바이어스 보정 시 포치 열까지 읽는 창 (비닝 전 폭)
+  const BiasLayout layout = ReadoutLayout(region);
+  const bool biasCorrect = layout.porchEnd > layout.porchStart;
+  const int readWidth = layout.rawWidth * region.xBin;
+  
+  // 좁은 영역이라 포치를 읽지 않으면 같은 비닝에서 마지막으로 잰 포치 바이어스를 프레임 전체에 적용
+  const int biasKey = region.xBin * (SX_MAX_BIN + 1) + region.yBin;
+  double fallbackBias = -1.0;
+  if (!biasCorrect && biasMode != BIAS_MODE_OFF && ccd.hBackPorch > 0) {
+    auto it = porchBiasLevel.find(biasKey);
+    if (it != porchBiasLevel.end()) fallbackBias = it->second;
+  }
+  const bool biasFallback = fallbackBias >= 0.0;
+  
+  LOG_INFO("영역: (%d, %d) %dx%d, 비닝: %dx%d, 출력 해상도: %dx%d, 노출 시간: %.2f초",
+           region.x, region.y, region.width, region.height, xBin, yBin, actualWidth, actualHeight, exposureTime);
+  if (biasCorrect) {
+    LOG_DEBUG("바이어스 보정 (%s): 읽기 폭 %d, 포치 열 %d개",
+              BiasModeName(biasMode), readWidth, layout.porchEnd - layout.porchStart);
+  } else if (biasFallback) {
+    LOG_DEBUG("바이어스 보정 (%s): 좁은 영역이라 포치를 읽지 않고 마지막 포치 바이어스 %.1f ADU 적용",
+              BiasModeName(biasMode), fallbackBias);
+  } else if (biasMode != BIAS_MODE_OFF && ccd.hBackPorch > 0) {
+    LOG_WARN("좁은 영역이라 포치를 읽지 않았고 같은 비닝의 포치 바이어스가 아직 없어 바이어스 보정을 건너뜁니다.");
+  } else if (biasMode != BIAS_MODE_OFF) {
+    LOG_WARN("카메라가 수평 백 포치를 보고하지 않아 바이어스 보정을 건너뜁니다.");
+  }
   
-//   // 노출 시간 매개변수 (기본값: 1초)
-//   float exposureTime = 1.0;
-//   if (info.Length() >= 1 && info[0].IsNumber()) {
-//     exposureTime = info[0].As<Napi::Number>().FloatValue();
-//   }
+  // 영역/비닝/노출에 맞는 마스터 선택 (수신 중 통계 누적 여부가 여기에 달림)
+  CalibrationFrames cal = CalibrationFrames();
+  const bool calibrate = calibration &&
+    calibration->Select(region.x, region.y, region.width, region.height, xBin, yBin, exposureTime,
+                        biasCorrect || biasFallback,
+                        calibrationUse[CAL_TYPE_BIAS], calibrationUse[CAL_TYPE_DARK], calibrationUse[CAL_TYPE_FLAT], cal);
+  if (calibrate) {
+    LOG_DEBUG("보정 마스터: 바이어스 %s, 다크 %s (x%.3f), 플랫 %s",
+              cal.masters[CAL_TYPE_BIAS] ? cal.masters[CAL_TYPE_BIAS]->Path().c_str() : "없음",
+              cal.masters[CAL_TYPE_DARK] ? cal.masters[CAL_TYPE_DARK]->Path().c_str() : "없음", cal.darkScale,
+              cal.masters[CAL_TYPE_FLAT] ? cal.masters[CAL_TYPE_FLAT]->Path().c_str() : "없음");
+  } else if (calibration) {
+    LOG_WARN("영역/비닝/노출에 맞는 보정 마스터가 없어 보정하지 않습니다.");
+  }
   
-//   // 이미지 크기 (ECHO2 카메라 해상도: 1392x1040)
-//   int width = this->width;
-//   int height = this->height;
-//   int pixelCount = width * height;
+  // width, height 업데이트
+  width = actualWidth;
+  height = actualHeight;
   
-//   // 이미지 버퍼 할당
-//   unsigned short *buffer = new unsigned short[pixelCount];
+  uint32_t exposureMs = static_cast<uint32_t>(exposureTime * 1000.0f);
+  std::chrono::steady_clock::time_point exposureStart;
+  
+  if (exposureMode == EXPOSURE_MODE_CAMERA) {
+    // 1단계: READ_PIXELS_DELAYED - 카메라 내부 밀리초 타이머로 노출 (CLEAR_PIXELS는 카메라가 암묵적으로 수행)
+    LOG_DEBUG("1단계: READ_PIXELS_DELAYED (카메라 타이머, %u ms)...", exposureMs);
+    unsigned char delayedCmd[22] = {
+      // 헤더 (8바이트)
+      0x40, 0x02, 0x03, 0x00, 0x00, 0x00, 14, 0x00,
+      
+      // 파라미터 (14바이트)
+      LO(region.x), HI(region.x),              // X_OFFSET_L, X_OFFSET_H
+      LO(region.y), HI(region.y),              // Y_OFFSET_L, Y_OFFSET_H
+      LO(readWidth), HI(readWidth),            // WIDTH_L, WIDTH_H (전체 1392 = 0x0570, 바이어스 보정 시 포치 포함)
+      LO(region.height), HI(region.height),    // HEIGHT_L, HEIGHT_H (전체 1040 = 0x0410)
+      xBin, yBin,                              // X_BIN, Y_BIN (비닝 설정)
+      static_cast<unsigned char>(exposureMs & 0xFF),          // DELAY_0
+      static_cast<unsigned char>((exposureMs >> 8) & 0xFF),   // DELAY_1
+      static_cast<unsigned char>((exposureMs >> 16) & 0xFF),  // DELAY_2
+      static_cast<unsigned char>((exposureMs >> 24) & 0xFF)   // DELAY_3
+    };
+    
+    res = transport->BulkWrite(delayedCmd, sizeof(delayedCmd), &transferred, 5000);
+    if (res < 0) {
+      SetLastError("READ_PIXELS_DELAYED 명령 전송 실패: " + std::string(libusb_error_name(res)));
+      return false;
+    }
+    exposureStart = std::chrono::steady_clock::now();
+    
+    // 2단계: 호스트는 타이밍에 관여하지 않음. 노출 종료 직전까지 취소만 확인하며 대기하고
+    // 이후 다운로드 전송을 미리 걸어 두어 카메라가 데이터를 보내는 즉시 수신
+    // (이 대기 동안에도 워커 스레드는 점유됨. 대기를 워커 밖으로 빼려면 촬영을 두 워커로 나눠야 함)
+    LOG_DEBUG("2단계: 카메라 타이머로 노출 진행 중... (%.2f초)", exposureTime);
+    uint32_t waitMs = exposureMs > CAMERA_TIMED_LEAD_MS ? exposureMs - CAMERA_TIMED_LEAD_MS : 0;
+    if (!WaitExposureInternal(exposureMs, waitMs, false, onProgress)) {
+      // 진행 중인 지연 읽기 취소
+      unsigned char resetCmd[8] = {0x40, 0x06, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
+      transport->BulkWrite(resetCmd, 8, &transferred, 5000);
+      return false;
+    }
+  } else {
+    // 1단계: sxClearPixels() - Wireshark에서 확인된 정확한 구조
+    LOG_DEBUG("1단계: sxClearPixels (flags=0x03)...");
+    unsigned char clearCmd[8] = {0x40, 0x01, 0x03, 0x00, 0x00, 0x00, 0x00, 0x00};
+    res = transport->BulkWrite(clearCmd, 8, &transferred, 5000);
+    if (res < 0) {
+      SetLastError("sxClearPixels 실패: " + std::string(libusb_error_name(res)));
+      return false;
+    }
+    exposureStart = std::chrono::steady_clock::now();
+    LOG_DEBUG("sxClearPixels 완료");
+    
+    // 2단계: Host PC 타이밍으로 노출 제어
+    LOG_DEBUG("2단계: Host PC 타이밍으로 노출 제어...");
+    LOG_DEBUG("노출 진행 중... (%.2f초)", exposureTime);
+    
+    // 30초 이상의 긴 노출인 경우 30초마다 vertical register 클리어
+    if (!WaitExposureInternal(exposureMs, exposureMs, exposureTime > 30.0f, onProgress)) {
+      return false;
+    }
+    
+    LOG_DEBUG("노출 완료");
+    
+    // 3단계: sxReadPixels() - 오프셋/WIDTH/HEIGHT는 비닝 전 CCD 좌표
+    LOG_DEBUG("3단계: sxReadPixels로 이미지 읽기...");
+    
+    unsigned char readCmd[18] = {
+      // 헤더 (8바이트) - Wireshark 분석 결과
+      0x40, 0x03, 0x03, 0x00, 0x00, 0x00, 0x0A, 0x00,
+      
+      // 파라미터 (10바이트) - 영역 + 비닝 파라미터
+      LO(region.x), HI(region.x),              // X_OFFSET_L, X_OFFSET_H
+      LO(region.y), HI(region.y),              // Y_OFFSET_L, Y_OFFSET_H
+      LO(readWidth), HI(readWidth),            // WIDTH_L, WIDTH_H (전체 1392 = 0x0570, 바이어스 보정 시 포치 포함)
+      LO(region.height), HI(region.height),    // HEIGHT_L, HEIGHT_H (전체 1040 = 0x0410)
+      xBin, yBin                               // X_BIN, Y_BIN (비닝 설정)
+    };
+    
+    LOG_DEBUG("파라미터: X=%d, Y=%d, WIDTH=%d, HEIGHT=%d, BIN=%dx%d",
+              region.x, region.y, readWidth, region.height, xBin, yBin);
+    LOG_DEBUG("실제 출력 해상도: %dx%d", actualWidth, actualHeight);
+    
+    // USB 명령 전체 덤프
+    LOG_HEX(SX_LOG_TRACE, "USB 명령 덤프", readCmd, 18);
+    
+    res = transport->BulkWrite(readCmd, 18, &transferred, 5000);
+    if (res < 0) {
+      SetLastError("sxReadPixels 실패: " + std::string(libusb_error_name(res)));
+      return false;
+    }
+    
+    // 호스트 타이밍 노출의 실제 길이: CLEAR_PIXELS 완료 ~ READ_PIXELS 전송 완료
+    lastMeasuredExposureMs = std::chrono::duration<double, std::milli>(
+      std::chrono::steady_clock::now() - exposureStart).count();
+    LOG_DEBUG("sxReadPixels 명령 전송 완료");
+  }
+  
+  // 4단계: 이미지 데이터 수신
+  LOG_DEBUG("4단계: 이미지 데이터 수신 중...");
+  const int bytesPerPixel = ccd.bitsPerPixel > 8 ? 2 : 1;
+  const int expectedTotalBytes = layout.rawWidth * actualHeight * bytesPerPixel;
+  // 스테이징 버퍼 없이 최종 픽셀 버퍼(JS ArrayBuffer로 넘어갈 메모리)에 직접 수신
+  unsigned char *imageBuffer = reinterpret_cast<unsigned char*>(buffer);
+  int totalBytesReceived = 0;
+  
+  LOG_DEBUG("예상 이미지 크기: %d 바이트 (%d x %d x %d)", expectedTotalBytes, layout.rawWidth, actualHeight, bytesPerPixel);
+  
+  // 여러 비동기 벌크 전송을 겹쳐서 수신 (IN 엔드포인트가 쉬지 않도록)
+  // 8비트 카메라는 16비트로 넓힌 뒤, 바이어스/마스터 보정 시에는 보정한 값으로 변환 패스에서 통계를 누적
+  if (!ReadPixelsPipelined(imageBuffer, expectedTotalBytes, totalBytesReceived, onProgress,
+                           bytesPerPixel == 2 && !biasCorrect && !biasFallback && !calibrate ? histogram : nullptr)) {
+    return false;
+  }
   
-//   // 이미지 캡처
-//   bool success = CaptureImageInternal(buffer, width, height, exposureTime);
+  // 데이터 수신 완전히 실패한 경우
+  if (totalBytesReceived == 0) {
+    SetLastError("이미지 데이터를 수신하지 못했습니다.");
+    return false;
+  }
+  auto convertStart = std::chrono::steady_clock::now();
+  
+  // 카메라 타이머 노출의 실제 길이: READ_PIXELS_DELAYED 전송 ~ 첫 데이터 수신
+  if (exposureMode == EXPOSURE_MODE_CAMERA) {
+    lastMeasuredExposureMs = std::chrono::duration<double, std::milli>(lastFirstDataTime - exposureStart).count();
+  }
+  RecordExposureTiming(exposureMode, lastMeasuredExposureMs - exposureMs);
+  LOG_INFO("측정 노출: %.1f ms (요청 %u ms, %s 타이밍)", lastMeasuredExposureMs, exposureMs,
+           exposureMode == EXPOSURE_MODE_CAMERA ? "카메라" : "호스트");
   
-//   if (!success) {
-//     delete[] buffer;
-//     Napi::Error::New(env, lastError).ThrowAsJavaScriptException();
-//     return env.Undefined();
-//   }
+  // 이미지 데이터 변환 및 디버깅
+  LOG_TRACE("=== 이미지 데이터 분석 ===");
+  LOG_TRACE("총 수신 바이트: %d", totalBytesReceived);
+  LOG_TRACE("실제 해상도: %dx%d (%dx%d 비닝)", actualWidth, actualHeight, xBin, yBin);
+  LOG_TRACE("예상 픽셀 수: %d", layout.rawWidth * actualHeight);
+  LOG_TRACE("예상 바이트 수: %d", expectedTotalBytes);
+
+  // 첫 32바이트 원본 데이터 출력
+  LOG_HEX(SX_LOG_TRACE, "첫 32바이트 raw 데이터", imageBuffer, std::min(32, totalBytesReceived));
+
+  // USB 데이터는 little-endian uint16이므로 little-endian 호스트(Pi 등)에서는 변환이 필요 없음
+  int processablePixels = totalBytesReceived / bytesPerPixel;
+  if (bytesPerPixel == 1) {
+    // 8비트 픽셀을 같은 버퍼 안에서 16비트로 넓힘 (겹치지 않도록 뒤에서부터)
+    for (int i = processablePixels - 1; i >= 0; i--) {
+      buffer[i] = imageBuffer[i];
+    }
+  } else {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    for (int i = 0; i < processablePixels; i++) {
+      buffer[i] = __builtin_bswap16(buffer[i]);
+    }
+#endif
+  }
+
+  // 바이어스 보정: 포치 열로 바이어스를 구해 빼면서 행을 출력 폭으로 앞당김 (끝이 잘린 마지막 행은 버림)
+  // 마스터 보정도 하면 포치 바이어스를 행별 오프셋으로 넘겨 한 패스에서 함께 처리
+  int outputPixels = processablePixels;
+  lastBias = BiasResult();
+  lastCalibrated = calibrate;
+  lastCalibration = cal;
+  std::vector<int> fallbackOffset;
+  if (biasFallback) {
+    // 포치 열 없이 적용한 바이어스 (porchColumns 0으로 구분)
+    lastBias.mode = biasMode;
+    lastBias.porchColumns = 0;
+    lastBias.level = fallbackBias;
+    lastBias.minRow = lastBias.maxRow = static_cast<uint16_t>(std::lround(fallbackBias));
+    lastBias.pedestal = biasPedestal;
+    fallbackOffset.assign(processablePixels / layout.rawWidth, biasPedestal - static_cast<int>(std::lround(fallbackBias)));
+  }
+  if (calibrate) {
+    int rows = processablePixels / layout.rawWidth;
+    std::vector<int> rowOffset;
+    if (biasCorrect) BiasEstimateRows(buffer, rows, layout, biasMode, biasPedestal, rowOffset, lastBias);
+    else if (biasFallback) rowOffset.swap(fallbackOffset);
+    CalibrationPass pass = {actualWidth, rows, layout.rawWidth, rowOffset.empty() ? nullptr : rowOffset.data(),
+                            calibrationPedestal};
+    CalibrationApply(buffer, pass, cal, histogram);
+    outputPixels = rows * actualWidth;
+  } else if (biasCorrect) {
+    int rows = processablePixels / layout.rawWidth;
+    if (BiasCorrectFrame(buffer, rows, layout, biasMode, biasPedestal, histogram, lastBias)) {
+      LOG_DEBUG("바이어스 %.1f ADU (행 %u~%u), 페디스털 %d",
+                lastBias.level, lastBias.minRow, lastBias.maxRow, lastBias.pedestal);
+    }
+    outputPixels = rows * actualWidth;
+  } else if (biasFallback) {
+    int rows = processablePixels / layout.rawWidth;
+    BiasApplyRows(buffer, rows, layout, fallbackOffset.data(), histogram);
+    outputPixels = rows * actualWidth;
+  } else if (bytesPerPixel == 1 && histogram) {
+    FrameStatsAccumulate(buffer, processablePixels, histogram);
+  }
+  if (lastBias.porchColumns > 0) porchBiasLevel[biasKey] = lastBias.level;
+
+  // 핫/데드 픽셀: 학습은 교체 전 값으로, 교체는 목록에 있는 픽셀만 (통계 히스토그램도 함께 고침)
+  // 결함 맵은 비닝 격자 좌표라 영역 원점이 비닝 단위에 맞아야 함
+  lastDefectsCorrected = -1;
+  if (defectMap && region.x % region.xBin == 0 && region.y % region.yBin == 0) {
+    DefectFrame defects = {region.x / region.xBin, region.y / region.yBin, actualWidth, actualHeight,
+                           outputPixels / actualWidth, region.xBin, region.yBin,
+                           ccd.width / region.xBin, ccd.height / region.yBin};
+    if (defectLearn) {
+      std::string error;
+      defectMap->Learn(buffer, defects, error);
+      if (!error.empty()) LOG_WARN("%s", error.c_str());
+    }
+    if (defectCorrect) {
+      lastDefectsCorrected = defectMap->Correct(buffer, defects, histogram);
+      LOG_DEBUG("결함 픽셀 %d개 교체", lastDefectsCorrected);
+    }
+  }
+
+  // 데이터가 부족한 경우 남은 픽셀을 0으로 채움
+  if (outputPixels < actualWidth * actualHeight) {
+    LOG_WARN("경고: 수신된 데이터가 예상보다 적습니다 (%d/%d 픽셀). 남은 픽셀을 0으로 채웁니다.", 
+             outputPixels, actualWidth * actualHeight);
+    memset(buffer + outputPixels, 0, (actualWidth * actualHeight - outputPixels) * sizeof(unsigned short));
+  }
+
+  // 썸네일 피라미드: 보정/결함 교체가 끝난 프레임을 변환 직후 한 번 더 읽어 1/2 단계를 만들고 아래 단계는 그 결과에서
+  if (pyramidLevels > 0) {
+    ImagePyramidBuild(buffer, actualWidth, actualHeight, pyramidLevels, lastPyramid);
+    LOG_DEBUG("썸네일 피라미드 %zu단계: %.2f ms", lastPyramid.levels.size(), lastPyramid.buildMs);
+  } else {
+    lastPyramid.levels.clear();
+  }
+
+  // 변환된 첫 16개 픽셀 값 출력
+  LOG_VALUES(SX_LOG_TRACE, "변환된 첫 16개 픽셀 값", buffer, std::min(16, outputPixels));
+
+  // 이미지 중앙 부분의 몇 픽셀도 확인
+  int centerStart = (actualHeight / 2) * actualWidth + (actualWidth / 2);
+  if (centerStart + 8 < outputPixels) {
+    LOG_TRACE("중앙 부분 픽셀 값 (인덱스 %d부터)", centerStart);
+    LOG_VALUES(SX_LOG_TRACE, "중앙 부분 픽셀 값", buffer + centerStart, 8);
+  }
+  
+  lastConvertMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - convertStart).count();
+  LOG_DEBUG("=== 하드웨어 비닝 촬영 완료 ===");
+  return true;
+}
+
+Napi::Object SXCamera::CreateImageObject(Napi::Env env, unsigned short *buffer, int width, int height,
+                                         float exposureTime, const CaptureRegion &region, const uint32_t *histogram) {
+  int pixelCount = width * height;
+  
+  // Node.js ArrayBuffer로 변환 - GC 시 버퍼는 해제되지 않고 풀로 반납됨
+  Napi::ArrayBuffer arrayBuffer = Napi::ArrayBuffer::New(env, buffer, pixelCount * sizeof(unsigned short), 
+    [](Napi::Env /*env*/, void* data, std::shared_ptr<FramePool>* pool) {
+      (*pool)->Release(data);
+      delete pool;
+    }, new std::shared_ptr<FramePool>(framePool));
+  
+  // Uint16Array 뷰 생성
+  Napi::Uint16Array result = Napi::Uint16Array::New(env, pixelCount, arrayBuffer, 0);
+  
+  // 이미지 정보를 포함한 객체 반환
+  Napi::Object imageObj = Napi::Object::New(env);
+  imageObj.Set("data", result);
+  imageObj.Set("width", Napi::Number::New(env, width));
+  imageObj.Set("height", Napi::Number::New(env, height));
+  imageObj.Set("bitsPerPixel", Napi::Number::New(env, ccd.bitsPerPixel));  // 카메라 비트 심도 (data는 항상 16비트)
+  imageObj.Set("binning", Napi::String::New(env, std::to_string(region.xBin) + "x" + std::to_string(region.yBin)));
+  imageObj.Set("xBinning", Napi::Number::New(env, region.xBin));
+  imageObj.Set("yBinning", Napi::Number::New(env, region.yBin));
+  // 읽은 영역 (비닝 전 CCD 좌표)
+  Napi::Object roi = Napi::Object::New(env);
+  roi.Set("x", Napi::Number::New(env, region.x));
+  roi.Set("y", Napi::Number::New(env, region.y));
+  roi.Set("width", Napi::Number::New(env, region.width));
+  roi.Set("height", Napi::Number::New(env, region.height));
+  imageObj.Set("roi", roi);
+  imageObj.Set("subframe", Napi::Boolean::New(env, region.width != ccd.width || region.height != ccd.height));
+  
+  // FITS 헤더용 카메라 정보 (픽셀 크기는 비닝 전)
+  const SXModelInfo *model = ModelInfo(ccd.productId);
+  char modelName[16];
+  snprintf(modelName, sizeof(modelName), "SX 0x%04x", ccd.productId);
+  imageObj.Set("camera", Napi::String::New(env, model ? model->name : modelName));
+  if (model && model->detector) imageObj.Set("detector", Napi::String::New(env, model->detector));
+  imageObj.Set("pixelWidthUm", Napi::Number::New(env, ccd.pixelWidthUm));
+  imageObj.Set("pixelHeightUm", Napi::Number::New(env, ccd.pixelHeightUm));
+  imageObj.Set("pixelCount", Napi::Number::New(env, pixelCount));
+  imageObj.Set("exposureTime", Napi::Number::New(env, exposureTime));
+  
+  // 다운로드 성능 (파이프라인 튜닝용)
+  double mbps = lastDownloadMs > 0 ? (lastDownloadBytes / (1024.0 * 1024.0)) / (lastDownloadMs / 1000.0) : 0.0;
+  imageObj.Set("downloadMs", Napi::Number::New(env, lastDownloadMs));
+  imageObj.Set("downloadMBps", Napi::Number::New(env, mbps));
+  imageObj.Set("exposureMode", Napi::String::New(env, exposureMode == EXPOSURE_MODE_CAMERA ? "camera" : "host"));
+  imageObj.Set("measuredExposureMs", Napi::Number::New(env, lastMeasuredExposureMs));
+  
+  // 포치 기반 바이어스 보정 결과 (보정하지 않았으면 생략)
+  if (lastBias.mode != BIAS_MODE_OFF) {
+    imageObj.Set("biasMode", Napi::String::New(env, BiasModeName(lastBias.mode)));
+    imageObj.Set("biasLevel", Napi::Number::New(env, lastBias.level));
+    imageObj.Set("biasRowMin", Napi::Number::New(env, lastBias.minRow));
+    imageObj.Set("biasRowMax", Napi::Number::New(env, lastBias.maxRow));
+    imageObj.Set("biasPedestal", Napi::Number::New(env, lastBias.pedestal));
+    imageObj.Set("biasColumns", Napi::Number::New(env, lastBias.porchColumns));
+  }
+  
+  // 적용한 보정 마스터 (파일 경로, 보정하지 않았으면 생략)
+  if (lastCalibrated) {
+    Napi::Object cal = Napi::Object::New(env);
+    for (int type = CAL_TYPE_BIAS; type <= CAL_TYPE_FLAT; type++) {
+      const std::shared_ptr<CalibrationMaster> &master = lastCalibration.masters[type];
+      cal.Set(CalibrationTypeName(type), master ? Napi::String::New(env, master->Path()) : env.Null());
+    }
+    cal.Set("darkScale", Napi::Number::New(env, lastCalibration.darkScale));
+    cal.Set("pedestal", Napi::Number::New(env, calibrationPedestal));
+    imageObj.Set("calibration", cal);
+  }
   
-//   // Node.js 버퍼로 변환
-//   Napi::ArrayBuffer arrayBuffer = Napi::ArrayBuffer::New(env, buffer, pixelCount * sizeof(unsigned short), 
-//     [](Napi::Env env, void* data) {
-//       delete[] static_cast<unsigned short*>(data);
-//     });
+  // 결함 맵으로 교체한 픽셀 수 (보정하지 않았으면 생략)
+  if (lastDefectsCorrected >= 0) {
+    imageObj.Set("defectsCorrected", Napi::Number::New(env, lastDefectsCorrected));
+  }
   
-//   Napi::Uint16Array result = Napi::Uint16Array::New(env, pixelCount, arrayBuffer, 0);
+  // 썸네일 피라미드 (setPyramid로 켜지 않았으면 생략)
+  if (!lastPyramid.levels.empty()) {
+    imageObj.Set("pyramid", ImagePyramidToArray(env, lastPyramid));
+    imageObj.Set("pyramidMs", Napi::Number::New(env, lastPyramid.buildMs));
+  }
   
-//   // 이미지 정보를 포함한 객체 반환
-//   Napi::Object imageObj = Napi::Object::New(env);
-//   imageObj.Set("data", result);
-//   imageObj.Set("width", Napi::Number::New(env, width));
-//   imageObj.Set("height", Napi::Number::New(env, height));
-//   imageObj.Set("bitsPerPixel", Napi::Number::New(env, bitsPerPixel));
+  // 수신 중 누적한 히스토그램으로 계산한 통계 (수신하지 못해 0으로 채운 픽셀은 제외)
+  double convertMs = lastConvertMs;
+  if (histogram) {
+    auto statsStart = std::chrono::steady_clock::now();
+    FrameStats stats;
+    FrameStatsFromHistogram(histogram, stats);
+    imageObj.Set("stats", FrameStatsToObject(env, stats, histogram));
+    convertMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - statsStart).count();
+  }
+  // 수신 후 변환 + 통계 정리 시간 (벤치마크의 단계별 측정용)
+  imageObj.Set("convertMs", Napi::Number::New(env, convertMs));
   
-//   return imageObj;
-// }
+  return imageObj;
+}
 
 Napi::Value SXCamera::CaptureImage(const Napi::CallbackInfo& info) {
   Napi::Env env = info.Env();
   
-  if (!handle) {
-    Napi::Error::New(env, "카메라가 연결되어 있지 않습니다.").ThrowAsJavaScriptException();
+  if (captureBusy) {
+    Napi::Error::New(env, "이미 촬영이 진행 중입니다.").ThrowAsJavaScriptException();
+    return env.Undefined();
+  }
+  
+  if (!EnsureSessionInternal()) {
+    Napi::Error::New(env, LastError()).ThrowAsJavaScriptException();
     return env.Undefined();
   }
   
@@ -1384,79 +1594,682 @@ Napi::Value SXCamera::CaptureImage(const Napi::CallbackInfo& info) {
     exposureTime = info[0].As<Napi::Number>().FloatValue();
   }
   
-  // 두 번째 파라미터: 하드웨어 비닝 활성화 (기본값: true - 2x2 비닝)
-  bool enableBinning = true;
-  if (info.Length() >= 2 && info[1].IsBoolean()) {
-    enableBinning = info[1].As<Napi::Boolean>().Value();
+  // 두 번째 파라미터: 2x2 비닝 여부(기본값: true) 또는 촬영 영역 { x, y, width, height, bin }
+  CaptureRegion region;
+  std::string regionError;
+  if (!ParseCaptureRegion(info.Length() >= 2 ? info[1] : Napi::Value(), region, regionError)) {
+    Napi::TypeError::New(env, regionError).ThrowAsJavaScriptException();
+    return env.Undefined();
+  }
+  
+  // 비닝 후 출력 해상도
+  int width = region.width / region.xBin;
+  int height = region.height / region.yBin;
+  int pixelCount = width * height;
+  LOG_INFO("이미지 캡처 시작: %dx%d (%d 픽셀), 노출 시간: %.2f초", 
+           width, height, pixelCount, exposureTime);
+  
+  // 이미지 버퍼 할당 (풀에서 빌림, 바이어스 보정 시 포치 열까지 수신할 크기)
+  size_t bufferPixels = static_cast<size_t>(ReadoutLayout(region).rawWidth) * height;
+  unsigned short *buffer = static_cast<unsigned short*>(framePool->Acquire(bufferPixels * sizeof(unsigned short)));
+  if (!buffer) {
+    Napi::Error::New(env, "이미지 버퍼를 할당할 수 없습니다.").ThrowAsJavaScriptException();
+    return env.Undefined();
+  }
+  
+  // 이미지 캡처 실행
+  std::vector<uint32_t> histogram(frameStatsEnabled ? FRAME_STATS_BINS : 0, 0);
+  uint32_t *histogramPtr = histogram.empty() ? nullptr : histogram.data();
+  
+  captureBusy = true;
+  cancelRequested = false;
+  bool success = CaptureImageInternal(buffer, width, height, exposureTime, region, nullptr, histogramPtr);
+  captureBusy = false;
+  
+  if (!success) {
+    framePool->Release(buffer);
+    Napi::Error::New(env, LastError()).ThrowAsJavaScriptException();
+    return env.Undefined();
+  }
+  
+  Napi::Object imageObj = CreateImageObject(env, buffer, width, height, exposureTime, region, histogramPtr);
+  
+  LOG_INFO("이미지 캡처 완료: %dx%d, %dx%d 비닝, 16비트", 
+           width, height, region.xBin, region.yBin);
+  
+  return imageObj;
+}
+
+// 노출과 다운로드를 워커 스레드에서 실행하고 Promise로 결과를 돌려주는 비동기 촬영 작업
+class CaptureWorker : public Napi::AsyncProgressQueueWorker<CaptureProgress> {
+public:
+  CaptureWorker(Napi::Env env, SXCamera *camera, Napi::Object cameraObj, float exposureTime,
+                const CaptureRegion &region, Napi::Function progressCallback)
+    : Napi::AsyncProgressQueueWorker<CaptureProgress>(env, "SXCameraCapture"),
+      camera(camera),
+      pool(camera->framePool),
+      deferred(Napi::Promise::Deferred::New(env)),
+      exposureTime(exposureTime),
+      region(region),
+      width(region.width / region.xBin),
+      height(region.height / region.yBin),
+      buffer(nullptr),
+      histogram(camera->frameStatsEnabled ? FRAME_STATS_BINS : 0, 0) {
+    // 촬영 중 JS 객체가 GC되지 않도록 참조 유지
+    cameraRef = Napi::Persistent(cameraObj);
+    if (!progressCallback.IsEmpty()) {
+      progress = Napi::Persistent(progressCallback);
+    }
+  }
+  
+  ~CaptureWorker() {
+    pool->Release(buffer);
+  }
+  
+  Napi::Promise GetPromise() const { return deferred.Promise(); }
+  
+protected:
+  void Execute(const ExecutionProgress &executionProgress) override {
+    if (!camera->EnsureSessionInternal() || !camera->FitRegionInternal(region)) {
+      SetError(camera->LastError());
+      return;
+    }
+    
+    // 여기서 처음 열렸다면 CCD 크기에 맞춰 풀이 바뀌었을 수 있음
+    pool = camera->framePool;
+    width = region.width / region.xBin;
+    height = region.height / region.yBin;
+    size_t bufferPixels = static_cast<size_t>(camera->ReadoutLayout(region).rawWidth) * height;
+    buffer = static_cast<unsigned short*>(pool->Acquire(bufferPixels * sizeof(unsigned short)));
+    if (!buffer) {
+      SetError("이미지 버퍼를 할당할 수 없습니다.");
+      return;
+    }
+    
+    bool success = camera->CaptureImageInternal(buffer, width, height, exposureTime, region,
+      [&executionProgress](const CaptureProgress &p) {
+        executionProgress.Send(&p, 1);
+      }, histogram.empty() ? nullptr : histogram.data());
+    
+    if (!success) {
+      SetError(camera->LastError());
+    }
+  }
+  
+  void OnProgress(const CaptureProgress *data, size_t count) override {
+    if (progress.IsEmpty() || count == 0) return;
+    
+    Napi::Env env = Env();
+    Napi::HandleScope scope(env);
+    
+    Napi::Object event = Napi::Object::New(env);
+    if (data->phase == CAPTURE_PHASE_EXPOSING) {
+      event.Set("phase", Napi::String::New(env, "exposing"));
+      event.Set("elapsedMs", Napi::Number::New(env, data->done));
+      event.Set("exposureMs", Napi::Number::New(env, data->total));
+    } else {
+      event.Set("phase", Napi::String::New(env, "downloading"));
+      event.Set("bytes", Napi::Number::New(env, data->done));
+      event.Set("totalBytes", Napi::Number::New(env, data->total));
+    }
+    progress.Call({event});
+  }
+  
+  void OnOK() override {
+    Napi::Env env = Env();
+    Napi::HandleScope scope(env);
+    camera->captureBusy = false;
+    
+    // 버퍼 소유권은 ArrayBuffer로 넘어감 (GC 시 풀로 반납)
+    Napi::Object imageObj = camera->CreateImageObject(env, buffer, width, height, exposureTime, region,
+                                                      histogram.empty() ? nullptr : histogram.data());
+    buffer = nullptr;
+    
+    LOG_INFO("이미지 캡처 완료: %dx%d, %dx%d 비닝, 16비트", 
+             width, height, region.xBin, region.yBin);
+    deferred.Resolve(imageObj);
+  }
+  
+  void OnError(const Napi::Error &error) override {
+    camera->captureBusy = false;
+    deferred.Reject(error.Value());
+  }
+  
+private:
+  SXCamera *camera;
+  std::shared_ptr<FramePool> pool;
+  Napi::ObjectReference cameraRef;
+  Napi::FunctionReference progress;
+  Napi::Promise::Deferred deferred;
+  float exposureTime;
+  CaptureRegion region;
+  int width;
+  int height;
+  unsigned short *buffer;
+  std::vector<uint32_t> histogram;  // 통계 비활성화 시 비어 있음
+};
+
+Napi::Value SXCamera::CaptureImageAsync(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  Napi::Promise::Deferred deferred = Napi::Promise::Deferred::New(env);
+  
+  // 세션 모드에서는 워커 스레드에서 상태 확인 및 재연결을 수행
+  if (!transport->IsOpen() && !sessionMode) {
+    deferred.Reject(Napi::Error::New(env, "카메라가 연결되어 있지 않습니다.").Value());
+    return deferred.Promise();
+  }
+  
+  if (captureBusy) {
+    deferred.Reject(Napi::Error::New(env, "이미 촬영이 진행 중입니다.").Value());
+    return deferred.Promise();
+  }
+  
+  // 첫 번째 파라미터: 노출 시간 (기본값: 1초)
+  float exposureTime = 1.0;
+  if (info.Length() >= 1 && info[0].IsNumber()) {
+    exposureTime = info[0].As<Napi::Number>().FloatValue();
+  }
+  
+  // 두 번째 파라미터: 2x2 비닝 여부(기본값: true) 또는 촬영 영역 { x, y, width, height, bin }
+  CaptureRegion region;
+  std::string regionError;
+  if (!ParseCaptureRegion(info.Length() >= 2 ? info[1] : Napi::Value(), region, regionError)) {
+    deferred.Reject(Napi::TypeError::New(env, regionError).Value());
+    return deferred.Promise();
+  }
+  
+  // 세 번째 파라미터: 진행 상황 콜백 (선택)
+  Napi::Function progressCallback;
+  if (info.Length() >= 3 && info[2].IsFunction()) {
+    progressCallback = info[2].As<Napi::Function>();
+  }
+  
+  LOG_INFO("비동기 이미지 캡처 시작: (%d, %d) %dx%d, %dx%d 비닝, 노출 시간: %.2f초", 
+           region.x, region.y, region.width, region.height, region.xBin, region.yBin, exposureTime);
+  
+  captureBusy = true;
+  cancelRequested = false;
+  
+  CaptureWorker *worker = new CaptureWorker(env, this, info.This().As<Napi::Object>(), exposureTime,
+                                            region, progressCallback);
+  Napi::Promise promise = worker->GetPromise();
+  worker->Queue();
+  return promise;
+}
+
+Napi::Value SXCamera::CancelCapture(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  
+  if (!captureBusy) {
+    return Napi::Boolean::New(env, false);
+  }
+  
+  // 워커 스레드가 노출 대기 루프에서 확인 후 중단
+  cancelRequested = true;
+  return Napi::Boolean::New(env, true);
+}
+
+Napi::Value SXCamera::IsCapturing(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  return Napi::Boolean::New(env, captureBusy.load());
+}
+
+Napi::Value SXCamera::SetReadoutOptions(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  
+  if (info.Length() < 1 || !info[0].IsObject()) {
+    Napi::TypeError::New(env, "옵션 객체가 필요합니다.").ThrowAsJavaScriptException();
+    return env.Undefined();
+  }
+  
+  if (captureBusy) {
+    Napi::Error::New(env, "촬영 중에는 다운로드 설정을 바꿀 수 없습니다.").ThrowAsJavaScriptException();
+    return env.Undefined();
+  }
+  
+  Napi::Object options = info[0].As<Napi::Object>();
+  
+  if (options.Has("queueDepth") && options.Get("queueDepth").IsNumber()) {
+    int depth = options.Get("queueDepth").As<Napi::Number>().Int32Value();
+    readoutQueueDepth = std::max(1, std::min(depth, READOUT_MAX_QUEUE_DEPTH));
+  }
+  
+  if (options.Has("transferSize") && options.Get("transferSize").IsNumber()) {
+    int size = options.Get("transferSize").As<Napi::Number>().Int32Value();
+    size = std::max(USB_BULK_PACKET_SIZE, std::min(size, READOUT_MAX_TRANSFER_SIZE));
+    // 패킷 크기 배수로 올림 (중간 전송이 짧은 패킷으로 끝나지 않도록)
+    readoutTransferSize = (size + USB_BULK_PACKET_SIZE - 1) / USB_BULK_PACKET_SIZE * USB_BULK_PACKET_SIZE;
   }
   
-  // 비닝에 따른 해상도 설정
-  int width, height;
-  if (enableBinning) {
-    // 2x2 하드웨어 비닝
-    width = 696;   // 1392 / 2
-    height = 520;  // 1040 / 2
-    printf("2x2 하드웨어 비닝 모드로 이미지 캡처\n");
+  if (options.Has("timeoutMs") && options.Get("timeoutMs").IsNumber()) {
+    readoutTimeoutMs = std::max(100, options.Get("timeoutMs").As<Napi::Number>().Int32Value());
+  }
+  
+  return GetReadoutOptions(info);
+}
+
+Napi::Value SXCamera::GetReadoutOptions(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  
+  Napi::Object options = Napi::Object::New(env);
+  options.Set("queueDepth", Napi::Number::New(env, readoutQueueDepth));
+  options.Set("transferSize", Napi::Number::New(env, readoutTransferSize));
+  options.Set("timeoutMs", Napi::Number::New(env, readoutTimeoutMs));
+  return options;
+}
+
+Napi::Value SXCamera::SetSessionMode(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  
+  if (info.Length() >= 1 && info[0].IsBoolean()) {
+    // 워커 스레드가 EnsureSessionInternal에서 읽는 값이므로 촬영 중에는 바꾸지 않음
+    if (captureBusy) {
+      Napi::Error::New(env, "촬영 중에는 세션 모드를 바꿀 수 없습니다.").ThrowAsJavaScriptException();
+      return env.Undefined();
+    }
+    sessionMode = info[0].As<Napi::Boolean>().Value();
+  }
+  
+  Napi::Object result = Napi::Object::New(env);
+  result.Set("enabled", Napi::Boolean::New(env, sessionMode));
+  result.Set("reopenCount", Napi::Number::New(env, sessionReopenCount.load()));
+  return result;
+}
+
+Napi::Value SXCamera::CheckHealth(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  
+  // 워커 스레드가 USB를 사용 중이면 촬영 자체가 상태 확인 역할을 함
+  if (captureBusy) {
+    return Napi::Boolean::New(env, true);
+  }
+  
+  return Napi::Boolean::New(env, HealthCheckInternal());
+}
+
+Napi::Value SXCamera::SetExposureMode(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  
+  if (info.Length() < 1 || !info[0].IsString()) {
+    Napi::TypeError::New(env, "노출 방식('host' 또는 'camera')이 필요합니다.").ThrowAsJavaScriptException();
+    return env.Undefined();
+  }
+  
+  if (captureBusy) {
+    Napi::Error::New(env, "촬영 중에는 노출 방식을 바꿀 수 없습니다.").ThrowAsJavaScriptException();
+    return env.Undefined();
+  }
+  
+  std::string mode = info[0].As<Napi::String>().Utf8Value();
+  if (mode == "host") {
+    exposureMode = EXPOSURE_MODE_HOST;
+  } else if (mode == "camera") {
+    exposureMode = EXPOSURE_MODE_CAMERA;
   } else {
-    // 1x1 풀 해상도
-    width = 1392;
-    height = 1040;
-    printf("풀 해상도 모드로 이미지 캡처\n");
+    Napi::TypeError::New(env, "알 수 없는 노출 방식: " + mode).ThrowAsJavaScriptException();
+    return env.Undefined();
   }
   
-  int pixelCount = width * height;
-  printf("이미지 캡처 시작: %dx%d (%d 픽셀), 노출 시간: %.2f초\n", 
-         width, height, pixelCount, exposureTime);
+  return Napi::String::New(env, mode);
+}
+
+Napi::Value SXCamera::GetExposureStats(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  std::lock_guard<std::mutex> lock(statsMutex);
   
-  // 이미지 버퍼 할당
-  unsigned short *buffer = new unsigned short[pixelCount];
+  Napi::Object result = Napi::Object::New(env);
+  const char *names[2] = {"host", "camera"};
+  for (int mode = 0; mode < 2; mode++) {
+    const ExposureTimingStats &st = exposureStats[mode];
+    Napi::Object entry = Napi::Object::New(env);
+    entry.Set("count", Napi::Number::New(env, st.count));
+    entry.Set("meanErrorMs", Napi::Number::New(env, st.mean));
+    // 지터 = 오차의 표준편차
+    entry.Set("jitterMs", Napi::Number::New(env, st.count > 1 ? std::sqrt(st.m2 / (st.count - 1)) : 0.0));
+    entry.Set("minErrorMs", Napi::Number::New(env, st.minErrorMs));
+    entry.Set("maxErrorMs", Napi::Number::New(env, st.maxErrorMs));
+    result.Set(names[mode], entry);
+  }
+  return result;
+}
+
+Napi::Value SXCamera::SetFrameStats(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
   
-  // 이미지 캡처 실행
-  bool success = CaptureImageInternal(buffer, width, height, exposureTime, enableBinning);
+  if (info.Length() < 1 || !info[0].IsBoolean()) {
+    Napi::TypeError::New(env, "활성화 여부(boolean)가 필요합니다.").ThrowAsJavaScriptException();
+    return env.Undefined();
+  }
   
-  if (!success) {
-    delete[] buffer;
-    Napi::Error::New(env, lastError).ThrowAsJavaScriptException();
+  if (captureBusy) {
+    Napi::Error::New(env, "촬영 중에는 통계 설정을 바꿀 수 없습니다.").ThrowAsJavaScriptException();
     return env.Undefined();
   }
   
-  // Node.js ArrayBuffer로 변환 (자동 메모리 관리)
-  Napi::ArrayBuffer arrayBuffer = Napi::ArrayBuffer::New(env, buffer, pixelCount * sizeof(unsigned short), 
-    [](Napi::Env env, void* data) {
-      delete[] static_cast<unsigned short*>(data);
-    });
+  frameStatsEnabled = info[0].As<Napi::Boolean>().Value();
+  return Napi::Boolean::New(env, frameStatsEnabled);
+}
+
+// setPyramid(levels) - 촬영마다 만들 썸네일 피라미드 단계 수 (0이면 끔, 1/2부터 단계마다 절반)
+Napi::Value SXCamera::SetPyramid(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
   
-  // Uint16Array 뷰 생성
-  Napi::Uint16Array result = Napi::Uint16Array::New(env, pixelCount, arrayBuffer, 0);
+  if (info.Length() < 1 || !info[0].IsNumber()) {
+    Napi::TypeError::New(env, "피라미드 단계 수(number)가 필요합니다.").ThrowAsJavaScriptException();
+    return env.Undefined();
+  }
+  int levels = info[0].As<Napi::Number>().Int32Value();
+  if (levels < 0 || levels > PYRAMID_MAX_LEVELS) {
+    Napi::RangeError::New(env, "피라미드 단계 수는 0~" + std::to_string(PYRAMID_MAX_LEVELS) + " 사이여야 합니다.").ThrowAsJavaScriptException();
+    return env.Undefined();
+  }
   
-  // 이미지 정보를 포함한 객체 반환
-  Napi::Object imageObj = Napi::Object::New(env);
-  imageObj.Set("data", result);
-  imageObj.Set("width", Napi::Number::New(env, width));
-  imageObj.Set("height", Napi::Number::New(env, height));
-  imageObj.Set("bitsPerPixel", Napi::Number::New(env, 16));
-  imageObj.Set("binning", Napi::String::New(env, enableBinning ? "2x2" : "1x1"));
-  imageObj.Set("pixelCount", Napi::Number::New(env, pixelCount));
-  imageObj.Set("exposureTime", Napi::Number::New(env, exposureTime));
+  if (captureBusy) {
+    Napi::Error::New(env, "촬영 중에는 피라미드 설정을 바꿀 수 없습니다.").ThrowAsJavaScriptException();
+    return env.Undefined();
+  }
   
-  printf("이미지 캡처 완료: %dx%d, %s, 16비트\n", 
-         width, height, enableBinning ? "2x2 비닝" : "풀 해상도");
+  pyramidLevels = levels;
+  return Napi::Number::New(env, pyramidLevels);
+}
+
+// setBiasCorrection(mode, pedestal) - 'off' | 'frame' | 'row', 보정 후 더할 페디스털 (기본 100 ADU)
+Napi::Value SXCamera::SetBiasCorrection(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
   
-  return imageObj;
+  int mode;
+  if (info.Length() < 1 || !info[0].IsString() ||
+      !BiasModeFromName(info[0].As<Napi::String>().Utf8Value().c_str(), mode)) {
+    Napi::TypeError::New(env, "바이어스 보정 방식('off', 'frame', 'row')이 필요합니다.").ThrowAsJavaScriptException();
+    return env.Undefined();
+  }
+  
+  int pedestal = biasPedestal;
+  if (info.Length() >= 2 && !info[1].IsUndefined()) {
+    if (!info[1].IsNumber()) {
+      Napi::TypeError::New(env, "페디스털은 숫자여야 합니다.").ThrowAsJavaScriptException();
+      return env.Undefined();
+    }
+    pedestal = info[1].As<Napi::Number>().Int32Value();
+    if (pedestal < 0 || pedestal > BIAS_MAX_PEDESTAL) {
+      Napi::RangeError::New(env, "페디스털은 0~" + std::to_string(BIAS_MAX_PEDESTAL) + " 사이여야 합니다.")
+        .ThrowAsJavaScriptException();
+      return env.Undefined();
+    }
+  }
+  
+  if (captureBusy) {
+    Napi::Error::New(env, "촬영 중에는 바이어스 보정 설정을 바꿀 수 없습니다.").ThrowAsJavaScriptException();
+    return env.Undefined();
+  }
+  
+  // 포치가 없는 카메라면 설정은 유지하되 촬영 시 보정하지 않음 (다른 카메라로 다시 열릴 수 있음)
+  if (mode != BIAS_MODE_OFF && transport->IsOpen() && ccd.hBackPorch == 0) {
+    LOG_WARN("카메라가 수평 백 포치를 보고하지 않아 바이어스 보정이 적용되지 않습니다.");
+  }
+  
+  biasMode = mode;
+  biasPedestal = pedestal;
+  return Napi::String::New(env, BiasModeName(biasMode));
+}
+
+// setCalibration({ dir, bias, dark, flat, pedestal }) - 마스터 라이브러리를 열고 촬영마다 보정 (null이면 끔)
+// 같은 디렉터리로 다시 호출하면 새로 만든 마스터를 다시 읽음. 읽은 마스터 목록을 돌려줌
+Napi::Value SXCamera::SetCalibration(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  
+  if (captureBusy) {
+    Napi::Error::New(env, "촬영 중에는 보정 설정을 바꿀 수 없습니다.").ThrowAsJavaScriptException();
+    return env.Undefined();
+  }
+  
+  if (info.Length() < 1 || info[0].IsNull() || info[0].IsUndefined()) {
+    calibration.reset();
+    return Napi::Array::New(env, 0);
+  }
+  if (!info[0].IsObject() || !info[0].As<Napi::Object>().Get("dir").IsString()) {
+    Napi::TypeError::New(env, "보정 설정은 { dir, bias, dark, flat, pedestal } 객체 또는 null이어야 합니다.")
+      .ThrowAsJavaScriptException();
+    return env.Undefined();
+  }
+  
+  Napi::Object opts = info[0].As<Napi::Object>();
+  int pedestal = opts.Get("pedestal").IsNumber() ? opts.Get("pedestal").As<Napi::Number>().Int32Value()
+                                                 : CAL_DEFAULT_PEDESTAL;
+  if (pedestal < 0 || pedestal > BIAS_MAX_PEDESTAL) {
+    Napi::RangeError::New(env, "페디스털은 0~" + std::to_string(BIAS_MAX_PEDESTAL) + " 사이여야 합니다.")
+      .ThrowAsJavaScriptException();
+    return env.Undefined();
+  }
+  
+  std::unique_ptr<CalibrationLibrary> library(new CalibrationLibrary());
+  std::string error;
+  if (!library->Load(opts.Get("dir").As<Napi::String>().Utf8Value(), error)) {
+    Napi::Error::New(env, error).ThrowAsJavaScriptException();
+    return env.Undefined();
+  }
+  
+  for (int type = CAL_TYPE_BIAS; type <= CAL_TYPE_FLAT; type++) {
+    Napi::Value use = opts.Get(CalibrationTypeName(type));
+    calibrationUse[type] = !use.IsBoolean() || use.As<Napi::Boolean>().Value();
+  }
+  calibrationPedestal = pedestal;
+  calibration = std::move(library);
+  
+  const auto &masters = calibration->Masters();
+  Napi::Array result = Napi::Array::New(env, masters.size());
+  for (size_t i = 0; i < masters.size(); i++) {
+    result.Set(static_cast<uint32_t>(i), CalibrationMasterToObject(env, *masters[i]));
+  }
+  return result;
+}
+
+// setDefectCorrection({ path, correct, learn, threshold, learnFrames }) - 결함 맵을 읽고 촬영마다 교체/학습 (null이면 끔)
+// path가 있으면 학습 결과를 그 파일에 저장. 결함 맵 정보를 돌려줌
+Napi::Value SXCamera::SetDefectCorrection(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  
+  if (captureBusy) {
+    Napi::Error::New(env, "촬영 중에는 결함 보정 설정을 바꿀 수 없습니다.").ThrowAsJavaScriptException();
+    return env.Undefined();
+  }
+  
+  if (info.Length() < 1 || info[0].IsNull() || info[0].IsUndefined()) {
+    defectMap.reset();
+    defectCorrect = false;
+    defectLearn = false;
+    return env.Null();
+  }
+  if (!info[0].IsObject()) {
+    Napi::TypeError::New(env, "결함 보정 설정은 { path, correct, learn, threshold, learnFrames } 객체 또는 null이어야 합니다.")
+      .ThrowAsJavaScriptException();
+    return env.Undefined();
+  }
+  
+  Napi::Object opts = info[0].As<Napi::Object>();
+  int threshold = opts.Get("threshold").IsNumber() ? opts.Get("threshold").As<Napi::Number>().Int32Value()
+                                                   : DEFECT_DEFAULT_THRESHOLD_ADU;
+  int learnFrames = opts.Get("learnFrames").IsNumber() ? opts.Get("learnFrames").As<Napi::Number>().Int32Value()
+                                                       : DEFECT_DEFAULT_LEARN_FRAMES;
+  if (threshold < 1 || threshold > 65535) {
+    Napi::RangeError::New(env, "결함 임계값은 1~65535 ADU 사이여야 합니다.").ThrowAsJavaScriptException();
+    return env.Undefined();
+  }
+  if (learnFrames < DEFECT_MIN_LEARN_FRAMES || learnFrames > DEFECT_MAX_LEARN_FRAMES) {
+    Napi::RangeError::New(env, "학습 프레임 수는 " + std::to_string(DEFECT_MIN_LEARN_FRAMES) + "~" +
+                          std::to_string(DEFECT_MAX_LEARN_FRAMES) + " 사이여야 합니다.").ThrowAsJavaScriptException();
+    return env.Undefined();
+  }
+  
+  std::unique_ptr<DefectMap> map(new DefectMap());
+  std::string error;
+  std::string path = opts.Get("path").IsString() ? opts.Get("path").As<Napi::String>().Utf8Value() : "";
+  if (!map->Load(path, error)) {
+    Napi::Error::New(env, error).ThrowAsJavaScriptException();
+    return env.Undefined();
+  }
+  map->SetThreshold(threshold);
+  map->SetLearnFrames(learnFrames);
+  
+  defectCorrect = !opts.Get("correct").IsBoolean() || opts.Get("correct").As<Napi::Boolean>().Value();
+  defectLearn = opts.Get("learn").IsBoolean() && opts.Get("learn").As<Napi::Boolean>().Value();
+  defectMap = std::move(map);
+  return defectMap->ToObject(env);
+}
+
+// 결함 맵 정보 (학습 진행 상황 포함, 촬영 중에도 호출 가능). 꺼져 있으면 null
+Napi::Value SXCamera::GetDefectMap(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  if (!defectMap) return env.Null();
+  Napi::Object result = defectMap->ToObject(env);
+  result.Set("correct", Napi::Boolean::New(env, defectCorrect));
+  result.Set("learn", Napi::Boolean::New(env, defectLearn));
+  return result;
+}
+
+Napi::Value SXCamera::GetCCDParams(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  
+  // 세션 모드에서 워커 스레드가 다시 열며 바꿀 수 있으므로 복사해서 사용
+  CCDParams params;
+  {
+    std::lock_guard<std::mutex> lock(ccdMutex);
+    params = ccd;
+  }
+  
+  Napi::Object result = Napi::Object::New(env);
+  result.Set("fromCamera", Napi::Boolean::New(env, params.fromCamera));
+  result.Set("width", Napi::Number::New(env, params.width));
+  result.Set("height", Napi::Number::New(env, params.height));
+  result.Set("hFrontPorch", Napi::Number::New(env, params.hFrontPorch));
+  result.Set("hBackPorch", Napi::Number::New(env, params.hBackPorch));
+  result.Set("vFrontPorch", Napi::Number::New(env, params.vFrontPorch));
+  result.Set("vBackPorch", Napi::Number::New(env, params.vBackPorch));
+  result.Set("pixelWidthUm", Napi::Number::New(env, params.pixelWidthUm));
+  result.Set("pixelHeightUm", Napi::Number::New(env, params.pixelHeightUm));
+  result.Set("colorMatrix", Napi::Number::New(env, params.colorMatrix));
+  result.Set("bitsPerPixel", Napi::Number::New(env, params.bitsPerPixel));
+  result.Set("serialPorts", Napi::Number::New(env, params.serialPorts));
+  result.Set("extraCaps", Napi::Number::New(env, params.extraCaps));
+  result.Set("guiderCcd", Napi::Boolean::New(env, (params.extraCaps & SX_CAPS_GUIDER_CCD) != 0));
+  result.Set("eeprom", Napi::Boolean::New(env, (params.extraCaps & SX_CAPS_EEPROM) != 0));
+  
+  const SXModelInfo *model = ModelInfo(params.productId);
+  if (model) {
+    result.Set("camera", Napi::String::New(env, model->name));
+    result.Set("detector", Napi::String::New(env, model->detector));
+  }
+  return result;
+}
+
+static Napi::Object HistogramToObject(Napi::Env env, const CaptureMetrics::Histogram &h) {
+  Napi::Array bounds = Napi::Array::New(env, h.bounds.size());
+  for (uint32_t i = 0; i < h.bounds.size(); i++) bounds.Set(i, Napi::Number::New(env, h.bounds[i]));
+  Napi::Array counts = Napi::Array::New(env, h.counts.size());
+  for (uint32_t i = 0; i < h.counts.size(); i++) counts.Set(i, Napi::Number::New(env, static_cast<double>(h.counts[i])));
+  
+  Napi::Object result = Napi::Object::New(env);
+  result.Set("bounds", bounds);
+  result.Set("counts", counts);
+  result.Set("count", Napi::Number::New(env, static_cast<double>(h.count)));
+  result.Set("sum", Napi::Number::New(env, h.sum));
+  return result;
+}
+
+Napi::Value SXCamera::GetMetrics(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  CaptureMetrics::Stats stats = metrics.GetStats();
+  
+  Napi::Object result = Napi::Object::New(env);
+  result.Set("backend", Napi::String::New(env, transport ? transport->Name() : ""));
+  result.Set("connected", Napi::Boolean::New(env, transport && transport->IsOpen()));
+  result.Set("frames", Napi::Number::New(env, static_cast<double>(stats.frames)));
+  result.Set("readoutFailures", Napi::Number::New(env, static_cast<double>(stats.readoutFailures)));
+  result.Set("bytes", Napi::Number::New(env, static_cast<double>(stats.bytes)));
+  result.Set("transfers", Napi::Number::New(env, static_cast<double>(stats.transfers)));
+  result.Set("timeouts", Napi::Number::New(env, static_cast<double>(stats.timeouts)));
+  result.Set("retries", Napi::Number::New(env, static_cast<double>(stats.retries)));
+  result.Set("shortReads", Napi::Number::New(env, static_cast<double>(stats.shortReads)));
+  result.Set("partialFrames", Napi::Number::New(env, static_cast<double>(stats.partialFrames)));
+  result.Set("sessionReopens", Napi::Number::New(env, sessionReopenCount.load()));
+  result.Set("lastDownloadMBps", Napi::Number::New(env, stats.lastDownloadMBps));
+  result.Set("lastExposureOvershootMs", Napi::Number::New(env, stats.lastOvershootMs));
+  result.Set("downloadMBps", HistogramToObject(env, stats.downloadMBps));
+  result.Set("exposureOvershootMs", HistogramToObject(env, stats.exposureOvershootMs));
+  return result;
+}
+
+Napi::Value SXCamera::GetPoolStats(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  std::shared_ptr<FramePool> pool;
+  {
+    std::lock_guard<std::mutex> lock(ccdMutex);
+    pool = framePool;
+  }
+  FramePool::Stats stats = pool->GetStats();
+  
+  Napi::Object result = Napi::Object::New(env);
+  result.Set("hits", Napi::Number::New(env, stats.hits));
+  result.Set("misses", Napi::Number::New(env, stats.misses));
+  result.Set("inUse", Napi::Number::New(env, stats.inUse));
+  result.Set("highWater", Napi::Number::New(env, stats.highWater));
+  result.Set("freeBuffers", Napi::Number::New(env, stats.freeBuffers));
+  result.Set("pooledBytes", Napi::Number::New(env, stats.pooledBytes));
+  return result;
 }
 
 Napi::Value SXCamera::IsConnected(const Napi::CallbackInfo& info) {
   Napi::Env env = info.Env();
-  return Napi::Boolean::New(env, handle != nullptr);
+  return Napi::Boolean::New(env, transport && transport->IsOpen());
+}
+
+Napi::Value SXCamera::GetBackend(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  return Napi::String::New(env, transport ? transport->Name() : "");
+}
+
+// libusb 로그 레벨: 'none' | 'error' | 'warning' | 'info' | 'debug' 또는 0~4
+Napi::Value SXCamera::SetUsbLogLevel(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  static const char *names[] = {"none", "error", "warning", "info", "debug"};
+  
+  int level = -1;
+  if (info.Length() >= 1 && info[0].IsNumber()) {
+    level = info[0].As<Napi::Number>().Int32Value();
+  } else if (info.Length() >= 1 && info[0].IsString()) {
+    std::string name = info[0].As<Napi::String>().Utf8Value();
+    for (int i = 0; i < 5; i++) {
+      if (name == names[i]) level = i;
+    }
+  }
+  if (level < LIBUSB_LOG_LEVEL_NONE || level > LIBUSB_LOG_LEVEL_DEBUG) {
+    Napi::TypeError::New(env, "USB 로그 레벨은 'none', 'error', 'warning', 'info', 'debug' 또는 0~4여야 합니다.")
+      .ThrowAsJavaScriptException();
+    return env.Undefined();
+  }
+  
+  transport->SetLogLevel(level);
+  return Napi::String::New(env, names[level]);
 }
 
 Napi::Value SXCamera::GetLastError(const Napi::CallbackInfo& info) {
   Napi::Env env = info.Env();
-  return Napi::String::New(env, lastError);
+  return Napi::String::New(env, LastError());
 }
 
 // 모듈 초기화
 Napi::Object Init(Napi::Env env, Napi::Object exports) {
+  InitLog(env, exports);
+  InitFitsWriter(env, exports);
+  InitFitsCompress(env, exports);
+  InitStretch(env, exports);
+  InitFrameStats(env, exports);
+  InitCalibration(env, exports);
+  InitStacker(env, exports);
+  InitStarDetect(env, exports);
+  InitTransientDetect(env, exports);
+  InitNightComposite(env, exports);
+  InitImagePyramid(env, exports);
   return SXCamera::Init(env, exports);
 }
 
@@ -0,0 +1,212 @@
+// sx-log.cc
+// 로그 출력 (콘솔 / 링 버퍼 / JS 콜백)
+#include "sx-log.h"
+#include <cstdio>
+#include <cstdarg>
+#include <cstring>
+#include <chrono>
+#include <mutex>
+
+std::atomic<int> sxLogLevel(SX_LOG_DEFAULT_LEVEL);
+
+static const char *LOG_LEVEL_NAMES[] = {"error", "warn", "info", "debug", "trace"};
+
+struct LogEntry {
+  double time;      // Unix 시간 (ms, JS Date와 같은 기준)
+  int level;
+  char message[SX_LOG_MESSAGE_MAX];
+};
+
+// 출력 상태 (워커 스레드와 JS 스레드가 공유)
+static std::mutex logMutex;
+static bool logConsole = true;
+static LogEntry logRing[SX_LOG_RING_SIZE];
+static uint64_t logRingHead = 0;     // 지금까지 기록한 항목 수
+static uint64_t logRingTail = 0;     // getLogs()가 다음에 읽을 위치
+static uint64_t logDropped = 0;      // 읽기 전에 덮어쓴 항목 수
+static Napi::ThreadSafeFunction logHandler;
+static bool logHandlerSet = false;
+
+static void DeliverLog(int level, const char *message) {
+  LogEntry entry;
+  entry.time = std::chrono::duration<double, std::milli>(
+    std::chrono::system_clock::now().time_since_epoch()).count();
+  entry.level = level;
+  snprintf(entry.message, sizeof(entry.message), "%s", message);
+
+  std::lock_guard<std::mutex> lock(logMutex);
+  if (logConsole) {
+    fputs(entry.message, stdout);
+    fputc('\n', stdout);
+  }
+
+  if (logRingHead - logRingTail == SX_LOG_RING_SIZE) {
+    logRingTail++;
+    logDropped++;
+  }
+  logRing[logRingHead % SX_LOG_RING_SIZE] = entry;
+  logRingHead++;
+
+  if (logHandlerSet) {
+    // JS 스레드에서 비동기로 전달 (큐가 가득 차면 버림)
+    LogEntry *copy = new LogEntry(entry);
+    napi_status status = logHandler.NonBlockingCall(copy, [](Napi::Env env, Napi::Function fn, LogEntry *e) {
+      Napi::Object obj = Napi::Object::New(env);
+      obj.Set("time", Napi::Number::New(env, e->time));
+      obj.Set("level", Napi::String::New(env, LOG_LEVEL_NAMES[e->level]));
+      obj.Set("message", Napi::String::New(env, e->message));
+      delete e;
+      fn.Call({obj});
+    });
+    if (status != napi_ok) delete copy;
+  }
+}
+
+void SXLogWrite(int level, const char *format, ...) {
+  char buf[SX_LOG_MESSAGE_MAX];
+  va_list args;
+  va_start(args, format);
+  vsnprintf(buf, sizeof(buf), format, args);
+  va_end(args);
+
+  // 기존 printf 문자열의 앞뒤 줄바꿈 제거
+  char *start = buf;
+  while (*start == '\n') start++;
+  size_t len = strlen(start);
+  while (len > 0 && start[len - 1] == '\n') start[--len] = '\0';
+
+  DeliverLog(level, start);
+}
+
+void SXLogHex(int level, const char *label, const unsigned char *data, int length) {
+  char buf[SX_LOG_MESSAGE_MAX];
+  int pos = snprintf(buf, sizeof(buf), "%s (%d 바이트):", label, length);
+  for (int i = 0; i < length && pos + 4 < (int)sizeof(buf); i++) {
+    pos += snprintf(buf + pos, sizeof(buf) - pos, " %02x", data[i]);
+  }
+  DeliverLog(level, buf);
+}
+
+void SXLogValues(int level, const char *label, const uint16_t *data, int count) {
+  char buf[SX_LOG_MESSAGE_MAX];
+  int pos = snprintf(buf, sizeof(buf), "%s:", label);
+  for (int i = 0; i < count && pos + 7 < (int)sizeof(buf); i++) {
+    pos += snprintf(buf + pos, sizeof(buf) - pos, " %u", data[i]);
+  }
+  DeliverLog(level, buf);
+}
+
+static bool ParseLogLevel(const Napi::Value &value, int &level) {
+  if (value.IsNumber()) {
+    level = value.As<Napi::Number>().Int32Value();
+    return level >= SX_LOG_ERROR && level <= SX_LOG_TRACE;
+  }
+  if (value.IsString()) {
+    std::string name = value.As<Napi::String>().Utf8Value();
+    for (int i = SX_LOG_ERROR; i <= SX_LOG_TRACE; i++) {
+      if (name == LOG_LEVEL_NAMES[i]) {
+        level = i;
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+// setLogLevel(level) - 'error' | 'warn' | 'info' | 'debug' | 'trace' 또는 0~4
+static Napi::Value SetLogLevel(const Napi::CallbackInfo &info) {
+  Napi::Env env = info.Env();
+  int level;
+  if (info.Length() < 1 || !ParseLogLevel(info[0], level)) {
+    Napi::TypeError::New(env, "로그 레벨은 'error', 'warn', 'info', 'debug', 'trace' 또는 0~4여야 합니다.")
+      .ThrowAsJavaScriptException();
+    return env.Undefined();
+  }
+  if (level > SX_LOG_COMPILE_LEVEL) {
+    // 컴파일 시 제거된 레벨은 켜도 출력되지 않음
+    SXLogWrite(SX_LOG_WARN, "로그 레벨 %s는 빌드에서 제거되었습니다 (최대 %s)",
+               LOG_LEVEL_NAMES[level], LOG_LEVEL_NAMES[SX_LOG_COMPILE_LEVEL]);
+  }
+  sxLogLevel = level;
+  return Napi::String::New(env, LOG_LEVEL_NAMES[level]);
+}
+
+// setLogConsole(enabled) - stdout 출력 여부
+static Napi::Value SetLogConsole(const Napi::CallbackInfo &info) {
+  Napi::Env env = info.Env();
+  if (info.Length() < 1 || !info[0].IsBoolean()) {
+    Napi::TypeError::New(env, "true 또는 false가 필요합니다.").ThrowAsJavaScriptException();
+    return env.Undefined();
+  }
+  std::lock_guard<std::mutex> lock(logMutex);
+  logConsole = info[0].As<Napi::Boolean>().Value();
+  return Napi::Boolean::New(env, logConsole);
+}
+
+// setLogHandler(fn | null) - 로그 항목 { time, level, message }을 JS 함수로 전달
+static Napi::Value SetLogHandler(const Napi::CallbackInfo &info) {
+  Napi::Env env = info.Env();
+  bool clear = info.Length() < 1 || info[0].IsNull() || info[0].IsUndefined();
+  if (!clear && !info[0].IsFunction()) {
+    Napi::TypeError::New(env, "함수 또는 null이 필요합니다.").ThrowAsJavaScriptException();
+    return env.Undefined();
+  }
+
+  std::lock_guard<std::mutex> lock(logMutex);
+  if (logHandlerSet) {
+    logHandler.Release();
+    logHandlerSet = false;
+  }
+  if (!clear) {
+    logHandler = Napi::ThreadSafeFunction::New(env, info[0].As<Napi::Function>(), "SXLogHandler", 1024, 1);
+    // 로그 핸들러 때문에 프로세스가 종료되지 않는 일이 없도록
+    logHandler.Unref(env);
+    logHandlerSet = true;
+  }
+  return env.Undefined();
+}
+
+// getLogs() - 링 버퍼에서 아직 읽지 않은 항목을 꺼냄
+static Napi::Value GetLogs(const Napi::CallbackInfo &info) {
+  Napi::Env env = info.Env();
+  std::lock_guard<std::mutex> lock(logMutex);
+
+  Napi::Array entries = Napi::Array::New(env, logRingHead - logRingTail);
+  uint32_t index = 0;
+  for (; logRingTail < logRingHead; logRingTail++) {
+    const LogEntry &e = logRing[logRingTail % SX_LOG_RING_SIZE];
+    Napi::Object obj = Napi::Object::New(env);
+    obj.Set("time", Napi::Number::New(env, e.time));
+    obj.Set("level", Napi::String::New(env, LOG_LEVEL_NAMES[e.level]));
+    obj.Set("message", Napi::String::New(env, e.message));
+    entries.Set(index++, obj);
+  }
+
+  Napi::Object result = Napi::Object::New(env);
+  result.Set("entries", entries);
+  result.Set("dropped", Napi::Number::New(env, static_cast<double>(logDropped)));
+  logDropped = 0;
+  return result;
+}
+
+// getLogConfig() - 현재 설정
+static Napi::Value GetLogConfig(const Napi::CallbackInfo &info) {
+  Napi::Env env = info.Env();
+  std::lock_guard<std::mutex> lock(logMutex);
+  Napi::Object result = Napi::Object::New(env);
+  result.Set("level", Napi::String::New(env, LOG_LEVEL_NAMES[sxLogLevel.load()]));
+  result.Set("compileLevel", Napi::String::New(env, LOG_LEVEL_NAMES[SX_LOG_COMPILE_LEVEL]));
+  result.Set("console", Napi::Boolean::New(env, logConsole));
+  result.Set("handler", Napi::Boolean::New(env, logHandlerSet));
+  result.Set("ringSize", Napi::Number::New(env, SX_LOG_RING_SIZE));
+  return result;
+}
+
+Napi::Object InitLog(Napi::Env env, Napi::Object exports) {
+  exports.Set("setLogLevel", Napi::Function::New(env, SetLogLevel, "setLogLevel"));
+  exports.Set("setLogConsole", Napi::Function::New(env, SetLogConsole, "setLogConsole"));
+  exports.Set("setLogHandler", Napi::Function::New(env, SetLogHandler, "setLogHandler"));
+  exports.Set("getLogs", Napi::Function::New(env, GetLogs, "getLogs"));
+  exports.Set("getLogConfig", Napi::Function::New(env, GetLogConfig, "getLogConfig"));
+  return exports;
+}
@@ -0,0 +1,57 @@
+// sx-log.h
+// 레벨별 로그 (printf 대체)
+//  - 컴파일 시: SX_LOG_COMPILE_LEVEL보다 자세한 로그는 호출과 인자 계산까지 코드에서 제거
+//  - 실행 시: setLogLevel()로 걸러냄 (원자 변수 비교 한 번)
+//  - 출력: 콘솔(stdout), 링 버퍼(getLogs), JS 콜백(setLogHandler) 중 켜진 곳으로 전달
+#ifndef SX_LOG_H
+#define SX_LOG_H
+
+#include <napi.h>
+#include <atomic>
+#include <cstdint>
+
+#define SX_LOG_ERROR     0
+#define SX_LOG_WARN      1
+#define SX_LOG_INFO      2
+#define SX_LOG_DEBUG     3       // 촬영 단계별 진행, 명령 파라미터
+#define SX_LOG_TRACE     4       // 원시 바이트/픽셀 덤프 등 매 프레임 대량 출력
+
+// binding.gyp의 defines로 바꿀 수 있음 (예: SX_LOG_COMPILE_LEVEL=2 이면 DEBUG/TRACE 제거)
+#ifndef SX_LOG_COMPILE_LEVEL
+#define SX_LOG_COMPILE_LEVEL SX_LOG_DEBUG
+#endif
+
+#define SX_LOG_DEFAULT_LEVEL   SX_LOG_INFO
+#define SX_LOG_RING_SIZE       512     // 링 버퍼 항목 수
+#define SX_LOG_MESSAGE_MAX     256     // 항목 하나의 최대 길이 (넘으면 잘림)
+
+extern std::atomic<int> sxLogLevel;
+
+#define SX_LOG_ENABLED(level) \
+  ((level) <= SX_LOG_COMPILE_LEVEL && (level) <= sxLogLevel.load(std::memory_order_relaxed))
+
+#define SX_LOG(level, ...) \
+  do { if (SX_LOG_ENABLED(level)) SXLogWrite((level), __VA_ARGS__); } while (0)
+
+#define LOG_ERROR(...)   SX_LOG(SX_LOG_ERROR, __VA_ARGS__)
+#define LOG_WARN(...)    SX_LOG(SX_LOG_WARN, __VA_ARGS__)
+#define LOG_INFO(...)    SX_LOG(SX_LOG_INFO, __VA_ARGS__)
+#define LOG_DEBUG(...)   SX_LOG(SX_LOG_DEBUG, __VA_ARGS__)
+#define LOG_TRACE(...)   SX_LOG(SX_LOG_TRACE, __VA_ARGS__)
+
+// "label: 01 02 03 ..." 형식의 바이트 덤프 (한 항목, 길이 제한 안에서)
+#define LOG_HEX(level, label, data, length) \
+  do { if (SX_LOG_ENABLED(level)) SXLogHex((level), (label), (data), (length)); } while (0)
+
+// "label: 1203 1187 ..." 형식의 16비트 값 덤프
+#define LOG_VALUES(level, label, data, count) \
+  do { if (SX_LOG_ENABLED(level)) SXLogValues((level), (label), (data), (count)); } while (0)
+
+// 메시지 앞뒤 줄바꿈은 제거 후 전달 (콘솔 출력에는 줄바꿈 하나를 붙임)
+void SXLogWrite(int level, const char *format, ...) __attribute__((format(printf, 2, 3)));
+void SXLogHex(int level, const char *label, const unsigned char *data, int length);
+void SXLogValues(int level, const char *label, const uint16_t *data, int count);
+
+Napi::Object InitLog(Napi::Env env, Napi::Object exports);
+
+#endif // SX_LOG_H
@@ -0,0 +1,64 @@
+// sx-transport.h
+// 카메라 통신 계층 추상화
+// SXCamera는 명령 블록 프로토콜(sx_usb_prog_ref.txt)만 알고, 실제 전송은 transport가 담당한다.
+//   - UsbTransport: libusb로 실제 ECHO2 장치와 통신
+//   - SimTransport: 같은 명령을 해석해 합성 별 영상을 돌려주는 시뮬레이터 (하드웨어 없는 테스트/벤치마크용)
+// 반환값/오류 코드는 모든 transport에서 libusb 규약(LIBUSB_ERROR_*)을 따른다.
+#ifndef SX_TRANSPORT_H
+#define SX_TRANSPORT_H
+
+#include <libusb-1.0/libusb.h>
+#include <cstdint>
+#include <string>
+#include <chrono>
+#include <functional>
+
+// 이미지 데이터 스트리밍 수신 한 번의 시도 상태
+// 시도 사이에 contiguousBytes가 유지되므로 첫 데이터 전 타임아웃이면 같은 위치부터 다시 시도할 수 있다.
+struct SXReadStream {
+  // 입력
+  unsigned char *dest;
+  int expectedBytes;
+  int queueDepth;         // 동시에 걸어 둘 전송 수
+  int transferSize;       // 전송 하나의 크기
+  unsigned int timeoutMs; // 전송 하나의 타임아웃
+  // 앞에서부터 연속으로 수신된 구간이 늘어날 때마다 수신 스레드에서 호출 (offset, length)
+  std::function<void(int, int)> onData;
+
+  // 결과
+  int contiguousBytes;    // 앞에서부터 빈틈없이 수신된 바이트 수
+  bool finished;          // 짧은 패킷 수신 (장치가 데이터를 모두 보냄)
+  int error;              // 첫 번째 오류 (LIBUSB_ERROR_*), 0이면 정상
+  int firstChunkBytes;    // 첫 전송으로 받은 바이트 (0이면 아직 데이터 없음)
+  std::chrono::steady_clock::time_point firstDataAt;  // 첫 전송 완료 시각
+  int transfers;          // 완료된 전송 수 (시도 사이에 누적)
+};
+
+class SXTransport {
+public:
+  virtual ~SXTransport() {}
+
+  virtual const char* Name() const = 0;
+
+  // 장치 열기 (실패 시 error에 사유)
+  virtual bool Open(std::string &error) = 0;
+  virtual void Close() = 0;
+  virtual bool IsOpen() const = 0;
+  virtual uint16_t ProductId() const = 0;
+
+  // 벤더 컨트롤 IN 전송. 받은 바이트 수 또는 LIBUSB_ERROR_*
+  virtual int ControlIn(uint8_t request, uint16_t value, uint16_t index,
+                        unsigned char *data, uint16_t length, unsigned int timeoutMs) = 0;
+
+  // 명령 블록 쓰기 / 응답 읽기. 0 또는 LIBUSB_ERROR_*
+  virtual int BulkWrite(const unsigned char *data, int length, int *transferred, unsigned int timeoutMs) = 0;
+  virtual int BulkRead(unsigned char *data, int length, int *transferred, unsigned int timeoutMs) = 0;
+
+  // 이미지 데이터 스트리밍 수신 (한 번의 시도, 결과는 stream에 기록)
+  virtual void ReadStream(SXReadStream &stream) = 0;
+
+  // 통신 라이브러리 자체 로그 레벨 (libusb: LIBUSB_LOG_LEVEL_NONE ~ DEBUG). 없으면 무시
+  virtual void SetLogLevel(int /*level*/) {}
+};
+
+#endif // SX_TRANSPORT_H
@@ -0,0 +1,567 @@
+// transient-detect.cc
+#include "transient-detect.h"
+#include "sx-log.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <string>
+#include <thread>
+
+#define TRANSIENT_ROW_BLOCK        16      // 스레드가 한 번에 가져가는 행 수
+#define TRANSIENT_BODY_WIDTH       6.0     // 궤적으로 확정한 뒤 직선에서 이 거리 안의 점까지 궤적 몸체로 묶음 (굵은 유성)
+#define TRANSIENT_PEAK_SUPPRESS_ANGLE  2   // 궤적이 아닌 봉우리 주변을 지우는 범위 (각도 칸)
+#define TRANSIENT_PEAK_SUPPRESS_RHO    3   // (거리 칸)
+
+struct TransientPoint {
+  int x;
+  int y;
+  int32_t value;
+};
+
+// 행 블록을 원자 카운터로 나눠 처리 (fn(block, y0, y1), 블록 번호로 결과를 모으면 행 순서가 유지됨)
+template <typename Fn>
+static void ForRowBlocks(int rows, int threadCount, Fn fn) {
+  std::atomic<int> nextBlock(0);
+  auto worker = [&]() {
+    for (;;) {
+      const int block = nextBlock.fetch_add(1);
+      const int y0 = block * TRANSIENT_ROW_BLOCK;
+      if (y0 >= rows) break;
+      fn(block, y0, std::min(rows, y0 + TRANSIENT_ROW_BLOCK));
+    }
+  };
+  std::vector<std::thread> pool;
+  for (int i = 1; i < threadCount; i++) pool.emplace_back(worker);
+  worker();
+  for (std::thread &th : pool) th.join();
+}
+
+// 픽셀 이력 n개(최대 TRANSIENT_MAX_HISTORY)의 중앙값. 값이 몇 개 안 되므로 정렬 대신 분기 없는 순위 계산
+// (잡음 때문에 비교 결과가 매번 달라 정렬은 분기 예측이 거의 다 틀림)
+static inline int HistoryMedian(const uint16_t *src, int n) {
+  int median = 0;
+  for (int k = 0; k < n; k++) {
+    int rank = 0;
+    for (int j = 0; j < n; j++) rank += (src[j] < src[k]) | ((j < k) & (src[j] == src[k]));
+    median = rank == n / 2 ? src[k] : median;
+  }
+  return median;
+}
+
+int TransientDetector::ThreadCount(int rows) const {
+  int threadCount = threads > 0 ? threads : static_cast<int>(std::thread::hardware_concurrency());
+  return std::max(1, std::min(std::min(threadCount, TRANSIENT_MAX_THREADS),
+                              (rows + TRANSIENT_ROW_BLOCK - 1) / TRANSIENT_ROW_BLOCK));
+}
+
+// 잔차 점에서 허프 봉우리를 골라, 직선 위 점이 TRANSIENT_MAX_GAP 이하 간격으로 이어진 가장 긴 구간을 궤적으로 확정
+// 확정한 궤적의 점은 누적기에서 빼고 다음 봉우리를 찾음 (한 프레임에 여러 궤적)
+static void FindTrails(const std::vector<TransientPoint> &points, int workWidth, int workHeight, int binning,
+                       std::vector<TransientTrail> &trails) {
+  const int diag = static_cast<int>(std::ceil(std::sqrt(static_cast<double>(workWidth) * workWidth +
+                                                        static_cast<double>(workHeight) * workHeight)));
+  const int rhoBins = 2 * diag + 1;
+  std::vector<float> cosTable(TRANSIENT_HOUGH_ANGLES), sinTable(TRANSIENT_HOUGH_ANGLES);
+  for (int a = 0; a < TRANSIENT_HOUGH_ANGLES; a++) {
+    const double theta = M_PI * a / TRANSIENT_HOUGH_ANGLES;
+    cosTable[a] = static_cast<float>(std::cos(theta));
+    sinTable[a] = static_cast<float>(std::sin(theta));
+  }
+  std::vector<int32_t> accumulator(static_cast<size_t>(TRANSIENT_HOUGH_ANGLES) * rhoBins, 0);
+  auto vote = [&](const TransientPoint &p, int delta) {
+    for (int a = 0; a < TRANSIENT_HOUGH_ANGLES; a++) {
+      // diag를 더하면 항상 양수라 +0.5 버림이 반올림
+      const int rho = static_cast<int>(p.x * cosTable[a] + p.y * sinTable[a] + diag + 0.5f);
+      accumulator[static_cast<size_t>(a) * rhoBins + rho] += delta;
+    }
+  };
+  for (const TransientPoint &p : points) vote(p, 1);
+
+  // 봉우리 후보는 처음 누적에서 한 번만 골라 득표 순으로 (궤적을 확정하면 그 점의 표를 빼므로 차례가 왔을 때 다시 확인)
+  std::vector<uint32_t> candidates;
+  for (size_t i = 0; i < accumulator.size(); i++) {
+    if (accumulator[i] >= TRANSIENT_MIN_VOTES) candidates.push_back(static_cast<uint32_t>(i));
+  }
+  std::stable_sort(candidates.begin(), candidates.end(),
+                   [&](uint32_t l, uint32_t r) { return accumulator[l] > accumulator[r]; });
+
+  std::vector<char> alive(points.size(), 1);
+  std::vector<std::pair<float, int>> onLine;
+  int peaks = 0;
+  for (uint32_t candidate : candidates) {
+    if (peaks >= TRANSIENT_MAX_PEAKS || trails.size() >= TRANSIENT_MAX_TRAILS) break;
+    if (accumulator[candidate] < TRANSIENT_MIN_VOTES) continue;
+    peaks++;
+    const size_t index = candidate;
+    const int a = static_cast<int>(index / rhoBins);
+    const float rho = static_cast<float>(static_cast<int>(index % rhoBins) - diag);
+    const float c = cosTable[a], s = sinTable[a];
+
+    // 직선 근처 점을 직선 방향 위치 t로 정렬
+    onLine.clear();
+    for (size_t i = 0; i < points.size(); i++) {
+      if (!alive[i]) continue;
+      const float d = points[i].x * c + points[i].y * s - rho;
+      if (std::fabs(d) <= TRANSIENT_LINE_WIDTH) onLine.emplace_back(-points[i].x * s + points[i].y * c, static_cast<int>(i));
+    }
+    std::sort(onLine.begin(), onLine.end());
+    size_t runStart = 0, bestStart = 0, bestEnd = 0;
+    for (size_t i = 1; i <= onLine.size(); i++) {
+      if (i == onLine.size() || onLine[i].first - onLine[i - 1].first > TRANSIENT_MAX_GAP) {
+        if (i - runStart > bestEnd - bestStart) {
+          bestStart = runStart;
+          bestEnd = i;
+        }
+        runStart = i;
+      }
+    }
+    const float t1 = bestEnd > bestStart ? onLine[bestStart].first : 0.0f;
+    const float t2 = bestEnd > bestStart ? onLine[bestEnd - 1].first : 0.0f;
+    if (static_cast<int>(bestEnd - bestStart) < TRANSIENT_MIN_VOTES || t2 - t1 < TRANSIENT_MIN_LENGTH) {
+      // 흩어진 점이 우연히 한 직선에 모인 봉우리: 주변까지 지우고 다음 봉우리로
+      for (int da = -TRANSIENT_PEAK_SUPPRESS_ANGLE; da <= TRANSIENT_PEAK_SUPPRESS_ANGLE; da++) {
+        const int aa = a + da;
+        if (aa < 0 || aa >= TRANSIENT_HOUGH_ANGLES) continue;
+        for (int dr = -TRANSIENT_PEAK_SUPPRESS_RHO; dr <= TRANSIENT_PEAK_SUPPRESS_RHO; dr++) {
+          const int rr = static_cast<int>(index % rhoBins) + dr;
+          if (rr >= 0 && rr < rhoBins) accumulator[static_cast<size_t>(aa) * rhoBins + rr] = 0;
+        }
+      }
+      continue;
+    }
+
+    // 궤적 몸체: 확정한 구간 안에서 직선 가까이 있는 점 전체
+    TransientTrail trail = TransientTrail();
+    int minX = workWidth, minY = workHeight, maxX = -1, maxY = -1;
+    for (size_t i = 0; i < points.size(); i++) {
+      if (!alive[i]) continue;
+      const TransientPoint &p = points[i];
+      const float d = p.x * c + p.y * s - rho;
+      const float t = -p.x * s + p.y * c;
+      if (std::fabs(d) > TRANSIENT_BODY_WIDTH || t < t1 - TRANSIENT_MAX_GAP || t > t2 + TRANSIENT_MAX_GAP) continue;
+      alive[i] = 0;
+      vote(p, -1);
+      trail.points++;
+      trail.flux += p.value;
+      minX = std::min(minX, p.x);
+      maxX = std::max(maxX, p.x);
+      minY = std::min(minY, p.y);
+      maxY = std::max(maxY, p.y);
+    }
+
+    // 끝점은 직선 위로 투영 (작업 해상도 픽셀 중심 -> 원본 픽셀)
+    const float b = static_cast<float>(binning);
+    trail.x1 = (rho * c - t1 * s + 0.5f) * b;
+    trail.y1 = (rho * s + t1 * c + 0.5f) * b;
+    trail.x2 = (rho * c - t2 * s + 0.5f) * b;
+    trail.y2 = (rho * s + t2 * c + 0.5f) * b;
+    trail.length = (t2 - t1) * b;
+    float angle = static_cast<float>(std::atan2(c, -s) * 180.0 / M_PI);
+    if (angle < 0.0f) angle += 180.0f;
+    if (angle >= 180.0f) angle -= 180.0f;
+    trail.angle = angle;
+    trail.flux *= binning * binning;
+    trail.boxX = minX * binning;
+    trail.boxY = minY * binning;
+    trail.boxWidth = (maxX + 1) * binning - trail.boxX;
+    trail.boxHeight = (maxY + 1) * binning - trail.boxY;
+    trails.push_back(trail);
+  }
+}
+
+void TransientDetector::Process(const uint16_t *pixels, TransientFrameResult &result) {
+  auto start = std::chrono::steady_clock::now();
+  const int b = binning;
+  const size_t workPixels = static_cast<size_t>(workWidth) * workHeight;
+  if (work.size() != workPixels) {
+    work.assign(workPixels, 0);
+    residual.assign(workPixels, 0);
+    mask.assign(workPixels, 0);
+    ring.assign(static_cast<size_t>(history) * workPixels, 0);
+  }
+  const int threadCount = ThreadCount(workHeight);
+
+  // 1) binning x binning 평균 (나머지 가장자리 열/행은 버림)
+  ForRowBlocks(workHeight, threadCount, [&](int, int y0, int y1) {
+    const uint32_t area = static_cast<uint32_t>(b * b);
+    for (int y = y0; y < y1; y++) {
+      uint16_t *out = work.data() + static_cast<size_t>(y) * workWidth;
+      for (int x = 0; x < workWidth; x++) {
+        uint32_t sum = 0;
+        for (int dy = 0; dy < b; dy++) {
+          const uint16_t *src = pixels + static_cast<size_t>(y * b + dy) * width + x * b;
+          for (int dx = 0; dx < b; dx++) sum += src[dx];
+        }
+        out[x] = static_cast<uint16_t>((sum + area / 2) / area);
+      }
+    }
+  });
+
+  result.ready = ringFrames >= TRANSIENT_MIN_HISTORY;
+  result.skipped = false;
+  result.noise = 0.0;
+  result.points = 0;
+  result.trails.clear();
+
+  if (result.ready) {
+    // 2) 픽셀별 이력 중앙값을 뺀 잔차 (배경이 포화된 픽셀은 제외)
+    // 먼저 표본 픽셀의 잔차로 차분 잡음(MAD)과 임계값을 정함
+    const int n = ringFrames;
+    const size_t step = std::max<size_t>(1, workPixels / TRANSIENT_NOISE_SAMPLES);
+    std::vector<int32_t> sample;
+    sample.reserve(workPixels / step + 1);
+    for (size_t i = 0; i < workPixels; i += step) {
+      const int median = HistoryMedian(ring.data() + i * history, n);
+      if (median < TRANSIENT_SATURATION - 1) sample.push_back(static_cast<int32_t>(work[i]) - median);
+    }
+    if (sample.empty()) sample.push_back(0);
+    std::nth_element(sample.begin(), sample.begin() + sample.size() / 2, sample.end());
+    const int32_t center = sample[sample.size() / 2];
+    for (int32_t &v : sample) v = std::abs(v - center);
+    std::nth_element(sample.begin(), sample.begin() + sample.size() / 2, sample.end());
+    result.noise = std::max(1.4826 * sample[sample.size() / 2], 1.0);
+    const int32_t threshold = center + static_cast<int32_t>(std::ceil(sigma * result.noise));
+
+    // 중앙값 >= 이력 최솟값이므로 새 값 - 최솟값이 임계값 이하인 픽셀(대부분)은 중앙값을 구하지 않음
+    ForRowBlocks(workHeight, threadCount, [&](int, int y0, int y1) {
+      for (size_t i = static_cast<size_t>(y0) * workWidth; i < static_cast<size_t>(y1) * workWidth; i++) {
+        const uint16_t *src = ring.data() + i * history;
+        int lowest = src[0];
+        for (int k = 1; k < n; k++) lowest = std::min(lowest, static_cast<int>(src[k]));
+        mask[i] = 0;
+        if (static_cast<int32_t>(work[i]) - lowest <= threshold) continue;
+        const int median = HistoryMedian(src, n);
+        if (median >= TRANSIENT_SATURATION - 1) continue;
+        residual[i] = static_cast<int32_t>(work[i]) - median;
+        mask[i] = residual[i] > threshold;
+      }
+    });
+
+    // 이웃(8방향)에 임계값을 넘은 점이 하나도 없는 외톨이 점은 잡음/우주선으로 보고 뺌
+    const int blocks = (workHeight + TRANSIENT_ROW_BLOCK - 1) / TRANSIENT_ROW_BLOCK;
+    std::vector<std::vector<TransientPoint>> blockPoints(blocks);
+    ForRowBlocks(workHeight, threadCount, [&](int block, int y0, int y1) {
+      std::vector<TransientPoint> &out = blockPoints[block];
+      for (int y = y0; y < y1; y++) {
+        const uint8_t *row = mask.data() + static_cast<size_t>(y) * workWidth;
+        for (int x = 0; x < workWidth; x++) {
+          if (!row[x]) continue;
+          bool neighbor = false;
+          for (int dy = -1; dy <= 1 && !neighbor; dy++) {
+            const int ny = y + dy;
+            if (ny < 0 || ny >= workHeight) continue;
+            const uint8_t *nrow = mask.data() + static_cast<size_t>(ny) * workWidth;
+            for (int dx = -1; dx <= 1; dx++) {
+              const int nx = x + dx;
+              if ((dx || dy) && nx >= 0 && nx < workWidth && nrow[nx]) {
+                neighbor = true;
+                break;
+              }
+            }
+          }
+          if (neighbor) out.push_back({x, y, residual[static_cast<size_t>(y) * workWidth + x]});
+        }
+      }
+    });
+    std::vector<TransientPoint> points;
+    for (const std::vector<TransientPoint> &block : blockPoints) points.insert(points.end(), block.begin(), block.end());
+    result.points = static_cast<int>(points.size());
+
+    // 3) 허프 변환으로 직선 궤적 (점이 너무 많으면 구름/조명 변화로 보고 건너뜀)
+    if (points.size() > TRANSIENT_MAX_POINTS) {
+      result.skipped = true;
+      LOG_DEBUG("잔차 점 %zu개: 배경 변화가 커서 궤적 검출 생략", points.size());
+    } else if (points.size() >= TRANSIENT_MIN_VOTES) {
+      FindTrails(points, workWidth, workHeight, b, result.trails);
+    }
+  }
+
+  // 4) 이력에 추가 (픽셀마다 가장 오래된 칸을 덮어씀)
+  ForRowBlocks(workHeight, threadCount, [&](int, int y0, int y1) {
+    for (size_t i = static_cast<size_t>(y0) * workWidth; i < static_cast<size_t>(y1) * workWidth; i++) {
+      ring[i * history + ringNext] = work[i];
+    }
+  });
+  ringNext = (ringNext + 1) % history;
+  ringFrames = std::min(ringFrames + 1, history);
+
+  // 5) 궤적 영역을 여백과 함께 원본 해상도로 잘라냄
+  for (TransientTrail &trail : result.trails) {
+    const int x0 = std::max(0, trail.boxX - TRANSIENT_CROP_MARGIN);
+    const int y0 = std::max(0, trail.boxY - TRANSIENT_CROP_MARGIN);
+    const int x1 = std::min(width, trail.boxX + trail.boxWidth + TRANSIENT_CROP_MARGIN);
+    const int y1 = std::min(height, trail.boxY + trail.boxHeight + TRANSIENT_CROP_MARGIN);
+    trail.boxX = x0;
+    trail.boxY = y0;
+    trail.boxWidth = x1 - x0;
+    trail.boxHeight = y1 - y0;
+    trail.crop.resize(static_cast<size_t>(trail.boxWidth) * trail.boxHeight);
+    for (int y = y0; y < y1; y++) {
+      std::memcpy(trail.crop.data() + static_cast<size_t>(y - y0) * trail.boxWidth,
+                  pixels + static_cast<size_t>(y) * width + x0, trail.boxWidth * sizeof(uint16_t));
+    }
+  }
+
+  result.processMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void TransientDetector::ResetInternal() {
+  width = 0;
+  height = 0;
+  workWidth = 0;
+  workHeight = 0;
+  frames = 0;
+  ringFrames = 0;
+  ringNext = 0;
+  trailsFound = 0;
+  lastProcessMs = 0.0;
+  // 큰 버퍼는 메모리까지 돌려줌
+  std::vector<uint16_t>().swap(ring);
+  std::vector<uint16_t>().swap(work);
+  std::vector<int32_t>().swap(residual);
+  std::vector<uint8_t>().swap(mask);
+  UpdateInfoSnapshot();
+}
+
+void TransientDetector::UpdateInfoSnapshot() {
+  infoHistoryFrames = ringFrames;
+  infoHistoryBytes = ring.size() * sizeof(uint16_t);
+}
+
+// ===== 비동기 처리 =====
+
+class TransientAddWorker : public Napi::AsyncWorker {
+public:
+  TransientAddWorker(Napi::Env env, TransientDetector *detector, Napi::Object dataObj, const uint16_t *pixels)
+    : Napi::AsyncWorker(env, "SXTransientAdd"),
+      deferred(Napi::Promise::Deferred::New(env)),
+      detector(detector), pixels(pixels), result() {
+    // 처리가 끝날 때까지 프레임 버퍼와 검출기가 GC되지 않도록 참조 유지
+    dataRef = Napi::Persistent(dataObj);
+    detectorRef = Napi::Persistent(detector->Value());
+  }
+
+  Napi::Promise GetPromise() const { return deferred.Promise(); }
+
+protected:
+  void Execute() override {
+    detector->Process(pixels, result);
+  }
+
+  void OnOK() override {
+    Napi::Env env = Env();
+    detector->frames++;
+    detector->trailsFound += static_cast<int>(result.trails.size());
+    detector->lastProcessMs = result.processMs;
+    detector->UpdateInfoSnapshot();
+    detector->busy = false;
+    if (!result.trails.empty()) {
+      LOG_INFO("프레임 %d: 궤적 %zu개 검출 (잔차 점 %d, %.1f ms)", detector->frames, result.trails.size(),
+               result.points, result.processMs);
+    }
+
+    Napi::Object obj = Napi::Object::New(env);
+    obj.Set("frame", Napi::Number::New(env, detector->frames));
+    obj.Set("ready", Napi::Boolean::New(env, result.ready));
+    obj.Set("skipped", Napi::Boolean::New(env, result.skipped));
+    obj.Set("noise", Napi::Number::New(env, result.noise));
+    obj.Set("points", Napi::Number::New(env, result.points));
+    obj.Set("processMs", Napi::Number::New(env, result.processMs));
+    Napi::Array trails = Napi::Array::New(env, result.trails.size());
+    for (size_t i = 0; i < result.trails.size(); i++) {
+      const TransientTrail &t = result.trails[i];
+      Napi::Object trail = Napi::Object::New(env);
+      trail.Set("x1", Napi::Number::New(env, t.x1));
+      trail.Set("y1", Napi::Number::New(env, t.y1));
+      trail.Set("x2", Napi::Number::New(env, t.x2));
+      trail.Set("y2", Napi::Number::New(env, t.y2));
+      trail.Set("length", Napi::Number::New(env, t.length));
+      trail.Set("angle", Napi::Number::New(env, t.angle));
+      trail.Set("points", Napi::Number::New(env, t.points));
+      trail.Set("flux", Napi::Number::New(env, t.flux));
+      Napi::Object box = Napi::Object::New(env);
+      box.Set("x", Napi::Number::New(env, t.boxX));
+      box.Set("y", Napi::Number::New(env, t.boxY));
+      box.Set("width", Napi::Number::New(env, t.boxWidth));
+      box.Set("height", Napi::Number::New(env, t.boxHeight));
+      trail.Set("box", box);
+      Napi::Uint16Array crop = Napi::Uint16Array::New(env, t.crop.size());
+      std::copy(t.crop.begin(), t.crop.end(), crop.Data());
+      Napi::Object cropImage = Napi::Object::New(env);
+      cropImage.Set("data", crop);
+      cropImage.Set("width", Napi::Number::New(env, t.boxWidth));
+      cropImage.Set("height", Napi::Number::New(env, t.boxHeight));
+      trail.Set("crop", cropImage);
+      trails.Set(static_cast<uint32_t>(i), trail);
+    }
+    obj.Set("trails", trails);
+    deferred.Resolve(obj);
+  }
+
+  void OnError(const Napi::Error &error) override {
+    detector->UpdateInfoSnapshot();
+    detector->busy = false;
+    deferred.Reject(error.Value());
+  }
+
+private:
+  Napi::Promise::Deferred deferred;
+  Napi::ObjectReference dataRef;
+  Napi::ObjectReference detectorRef;
+  TransientDetector *detector;
+  const uint16_t *pixels;
+  TransientFrameResult result;
+};
+
+// ===== N-API =====
+
+Napi::Object TransientDetector::Init(Napi::Env env, Napi::Object exports) {
+  Napi::Function func = DefineClass(env, "TransientDetector", {
+    InstanceMethod("add", &TransientDetector::Add),
+    InstanceMethod("getInfo", &TransientDetector::GetInfo),
+    InstanceMethod("reset", &TransientDetector::Reset)
+  });
+
+  // 모듈 수명 동안 생성자 유지
+  Napi::FunctionReference *constructor = new Napi::FunctionReference();
+  *constructor = Napi::Persistent(func);
+  constructor->SuppressDestruct();
+
+  exports.Set("TransientDetector", func);
+  return exports;
+}
+
+// new TransientDetector({ history, binning, sigma, threads })
+TransientDetector::TransientDetector(const Napi::CallbackInfo& info)
+  : Napi::ObjectWrap<TransientDetector>(info),
+    history(TRANSIENT_DEFAULT_HISTORY),
+    binning(TRANSIENT_DEFAULT_BINNING),
+    sigma(TRANSIENT_DEFAULT_SIGMA),
+    threads(0),
+    width(0),
+    height(0),
+    workWidth(0),
+    workHeight(0),
+    busy(false),
+    frames(0),
+    ringFrames(0),
+    ringNext(0),
+    trailsFound(0),
+    lastProcessMs(0.0),
+    infoHistoryFrames(0),
+    infoHistoryBytes(0)
+{
+  Napi::Env env = info.Env();
+  if (info.Length() < 1 || !info[0].IsObject()) return;
+
+  Napi::Object opts = info[0].As<Napi::Object>();
+  if (opts.Get("history").IsNumber()) {
+    int value = opts.Get("history").As<Napi::Number>().Int32Value();
+    if (value < TRANSIENT_MIN_HISTORY || value > TRANSIENT_MAX_HISTORY) {
+      Napi::RangeError::New(env, "history는 " + std::to_string(TRANSIENT_MIN_HISTORY) + "~" +
+                                 std::to_string(TRANSIENT_MAX_HISTORY) + " 사이여야 합니다.").ThrowAsJavaScriptException();
+      return;
+    }
+    history = value;
+  }
+  if (opts.Get("binning").IsNumber()) {
+    int value = opts.Get("binning").As<Napi::Number>().Int32Value();
+    if (value < 1 || value > TRANSIENT_MAX_BINNING) {
+      Napi::RangeError::New(env, "binning은 1~" + std::to_string(TRANSIENT_MAX_BINNING) + " 사이여야 합니다.").ThrowAsJavaScriptException();
+      return;
+    }
+    binning = value;
+  }
+  if (opts.Get("sigma").IsNumber()) {
+    double value = opts.Get("sigma").As<Napi::Number>().DoubleValue();
+    if (!(value > 0.0)) {
+      Napi::RangeError::New(env, "sigma는 0보다 커야 합니다.").ThrowAsJavaScriptException();
+      return;
+    }
+    sigma = value;
+  }
+  if (opts.Get("threads").IsNumber()) {
+    threads = std::max(0, std::min(opts.Get("threads").As<Napi::Number>().Int32Value(), TRANSIENT_MAX_THREADS));
+  }
+}
+
+// add(image) -> Promise<{ frame, ready, skipped, noise, points, processMs, trails: [...] }>
+// image: { data: Uint16Array, width, height }. 크기가 바뀌면 (비닝/영역 변경) 이력을 비우고 다시 쌓음
+Napi::Value TransientDetector::Add(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  Napi::Promise::Deferred deferred = Napi::Promise::Deferred::New(env);
+
+  if (busy) {
+    deferred.Reject(Napi::Error::New(env, "이전 프레임을 처리하는 중입니다.").Value());
+    return deferred.Promise();
+  }
+
+  Napi::Object image = info.Length() >= 1 && info[0].IsObject() ? info[0].As<Napi::Object>() : Napi::Object::New(env);
+  Napi::Value data = image.Get("data");
+  int frameWidth = image.Get("width").IsNumber() ? image.Get("width").As<Napi::Number>().Int32Value() : 0;
+  int frameHeight = image.Get("height").IsNumber() ? image.Get("height").As<Napi::Number>().Int32Value() : 0;
+  if (!data.IsTypedArray() || data.As<Napi::TypedArray>().TypedArrayType() != napi_uint16_array ||
+      frameWidth <= 0 || frameHeight <= 0 ||
+      data.As<Napi::TypedArray>().ElementLength() < static_cast<size_t>(frameWidth) * frameHeight) {
+    deferred.Reject(Napi::TypeError::New(env, "이미지 데이터는 width*height 크기의 Uint16Array여야 합니다.").Value());
+    return deferred.Promise();
+  }
+  if (frameWidth / binning < TRANSIENT_MIN_LENGTH || frameHeight / binning < TRANSIENT_MIN_LENGTH) {
+    deferred.Reject(Napi::RangeError::New(env, "프레임이 궤적 검출에 너무 작습니다.").Value());
+    return deferred.Promise();
+  }
+
+  if (frameWidth != width || frameHeight != height) {
+    if (width > 0) {
+      LOG_INFO("프레임 크기 변경 (%dx%d -> %dx%d): 궤적 검출 이력 초기화", width, height, frameWidth, frameHeight);
+    }
+    int processed = frames, found = trailsFound;
+    ResetInternal();
+    frames = processed;
+    trailsFound = found;
+    width = frameWidth;
+    height = frameHeight;
+    workWidth = frameWidth / binning;
+    workHeight = frameHeight / binning;
+  }
+
+  busy = true;
+  Napi::Uint16Array pixels = data.As<Napi::Uint16Array>();
+  TransientAddWorker *worker = new TransientAddWorker(env, this, pixels, pixels.Data());
+  Napi::Promise promise = worker->GetPromise();
+  worker->Queue();
+  return promise;
+}
+
+Napi::Value TransientDetector::GetInfo(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  Napi::Object result = Napi::Object::New(env);
+  result.Set("history", Napi::Number::New(env, history));
+  result.Set("binning", Napi::Number::New(env, binning));
+  result.Set("sigma", Napi::Number::New(env, sigma));
+  result.Set("threads", Napi::Number::New(env, threads));
+  result.Set("width", Napi::Number::New(env, width));
+  result.Set("height", Napi::Number::New(env, height));
+  result.Set("frames", Napi::Number::New(env, frames));
+  result.Set("historyFrames", Napi::Number::New(env, infoHistoryFrames));
+  result.Set("historyBytes", Napi::Number::New(env, static_cast<double>(infoHistoryBytes)));
+  result.Set("trails", Napi::Number::New(env, trailsFound));
+  result.Set("lastProcessMs", Napi::Number::New(env, lastProcessMs));
+  result.Set("busy", Napi::Boolean::New(env, busy));
+  return result;
+}
+
+Napi::Value TransientDetector::Reset(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  if (busy) {
+    Napi::Error::New(env, "프레임을 처리하는 중에는 초기화할 수 없습니다.").ThrowAsJavaScriptException();
+    return env.Undefined();
+  }
+  ResetInternal();
+  return env.Undefined();
+}
+
+Napi::Object InitTransientDetect(Napi::Env env, Napi::Object exports) {
+  return TransientDetector::Init(env, exports);
+}
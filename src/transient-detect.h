@@ -0,0 +1,105 @@
+// transient-detect.h
+// 연속 프레임 차분으로 유성/위성 궤적 검출 (촬영 주기에 맞춰 스트리밍)
+// 최근 N장을 binning x binning으로 묶어 네이티브 링 버퍼에 보관하고(JS에는 이력을 두지 않음), 새 프레임에서 픽셀별 중앙값
+// 배경을 뺀 잔차를 임계값으로 자른 뒤 허프 변환으로 직선을 찾는다. 직선 위 점이 끊기지 않고 충분히 길면 궤적으로 보고
+// 원본 해상도의 경계 상자와 그 영역을 잘라낸 픽셀을 돌려준다.
+#ifndef SX_TRANSIENT_DETECT_H
+#define SX_TRANSIENT_DETECT_H
+
+#include <napi.h>
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+#define TRANSIENT_DEFAULT_HISTORY  8       // 중앙값 배경 프레임 수
+#define TRANSIENT_MIN_HISTORY      3       // 이보다 적게 쌓였으면 검출하지 않고 이력만 채움
+#define TRANSIENT_MAX_HISTORY      31
+#define TRANSIENT_DEFAULT_BINNING  2       // 이력/차분 해상도 (궤적은 여러 픽셀 폭이라 묶어도 검출에 지장 없음, 메모리 1/4)
+#define TRANSIENT_MAX_BINNING      8
+#define TRANSIENT_DEFAULT_SIGMA    4.0     // 잔차 임계 (차분 잡음 배수)
+#define TRANSIENT_NOISE_SAMPLES    65536   // 잡음(MAD) 추정에 쓰는 잔차 표본 수
+#define TRANSIENT_HOUGH_ANGLES     180     // 1도 간격
+#define TRANSIENT_MIN_VOTES        20      // 직선 후보 최소 점 수 (작업 해상도)
+#define TRANSIENT_MIN_LENGTH       20      // 궤적 최소 길이 (작업 해상도 픽셀)
+#define TRANSIENT_LINE_WIDTH       2.0     // 직선에서 이 거리 안의 점을 궤적에 포함
+#define TRANSIENT_MAX_GAP          8       // 궤적 안 이웃 점 사이 최대 간격 (작업 해상도 픽셀)
+#define TRANSIENT_MAX_POINTS       50000   // 잔차 점이 이보다 많으면 (구름/조명 변화) 직선 검출 생략
+#define TRANSIENT_MAX_TRAILS       8
+#define TRANSIENT_MAX_PEAKS        64      // 궤적이 아닌 허프 봉우리를 버리며 찾는 최대 횟수
+#define TRANSIENT_CROP_MARGIN      16      // 잘라내는 영역 여백 (원본 픽셀)
+#define TRANSIENT_SATURATION       65535
+#define TRANSIENT_MAX_THREADS      16
+
+struct TransientTrail {
+  float x1;               // 양 끝점 (원본 픽셀)
+  float y1;
+  float x2;
+  float y2;
+  float length;           // 원본 픽셀
+  float angle;            // +x 축 기준 0~180도
+  int points;             // 궤적에 포함된 잔차 점 수 (작업 해상도)
+  double flux;            // 잔차 합 (원본 ADU로 환산)
+  int boxX;               // 경계 상자 + 여백 (원본 픽셀, 프레임 안으로 자름)
+  int boxY;
+  int boxWidth;
+  int boxHeight;
+  std::vector<uint16_t> crop;   // 경계 상자 영역의 원본 픽셀
+};
+
+struct TransientFrameResult {
+  bool ready;             // 이력이 TRANSIENT_MIN_HISTORY 이상이라 검출했는지
+  bool skipped;           // 잔차 점이 너무 많아 직선 검출을 건너뛰었는지
+  double noise;           // 차분 잡음 (작업 해상도 ADU)
+  int points;             // 임계값을 넘은 잔차 점 수
+  double processMs;
+  std::vector<TransientTrail> trails;
+};
+
+class TransientDetector : public Napi::ObjectWrap<TransientDetector> {
+public:
+  static Napi::Object Init(Napi::Env env, Napi::Object exports);
+  TransientDetector(const Napi::CallbackInfo& info);
+
+  // 워커 스레드에서 한 프레임 처리 (검출 후 이력에 추가)
+  void Process(const uint16_t *pixels, TransientFrameResult &result);
+
+private:
+  friend class TransientAddWorker;
+
+  Napi::Value Add(const Napi::CallbackInfo& info);
+  Napi::Value GetInfo(const Napi::CallbackInfo& info);
+  Napi::Value Reset(const Napi::CallbackInfo& info);
+
+  void ResetInternal();
+  void UpdateInfoSnapshot();
+  int ThreadCount(int rows) const;
+
+  int history;
+  int binning;
+  double sigma;
+  int threads;
+  int width;              // 첫 프레임에서 정함 (원본)
+  int height;
+  int workWidth;
+  int workHeight;
+
+  std::atomic<bool> busy;  // 처리 중에는 다른 add/초기화를 받지 않음
+  int frames;
+  int ringFrames;          // 링 버퍼에 든 프레임 수 (최대 history)
+  int ringNext;            // 다음에 덮어쓸 칸
+  int trailsFound;
+  double lastProcessMs;
+
+  // getInfo가 읽는 이력 상태. 워커가 ring/ringFrames를 바꾸는 동안 읽지 않도록 JS 스레드에서만 갱신
+  int infoHistoryFrames;
+  size_t infoHistoryBytes;
+
+  std::vector<uint16_t> ring;     // 픽셀 순 [픽셀][history] (중앙값 계산 때 한 픽셀의 이력이 연속)
+  std::vector<uint16_t> work;     // 새 프레임 (묶은 것)
+  std::vector<int32_t> residual;  // 새 프레임 - 중앙값 배경 (mask인 픽셀만 유효)
+  std::vector<uint8_t> mask;
+};
+
+Napi::Object InitTransientDetect(Napi::Env env, Napi::Object exports);
+
+#endif // SX_TRANSIENT_DETECT_H
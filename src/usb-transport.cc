@@ -0,0 +1,376 @@
+// usb-transport.cc
+// libusb 기반 ECHO2 transport (장치 검색/인터페이스 클레임/비동기 벌크 수신 파이프라인)
+#include "usb-transport.h"
+#include "sx-log.h"
+#include <cstdio>
+#include <vector>
+#include <algorithm>
+
+UsbTransport::UsbTransport()
+  : handle(nullptr),
+    ctx(nullptr),
+    claimedInterface(-1),
+    bulkInEndpoint(0x82),  // 와이어샤크에서 확인된 IN 엔드포인트
+    bulkOutEndpoint(0x01)  // 와이어샤크에서 확인된 OUT 엔드포인트
+{
+  // libusb 초기화
+  libusb_init(&ctx);
+  
+  // libusb 자체 로그는 경고 이상만 (전송마다 출력되는 debug 로그는 setUsbLogLevel로 필요할 때만)
+  SetLogLevel(USB_DEFAULT_LOG_LEVEL);
+}
+
+void UsbTransport::SetLogLevel(int level) {
+  libusb_set_option(ctx, LIBUSB_OPTION_LOG_LEVEL, level);
+}
+
+UsbTransport::~UsbTransport() {
+  Close();
+  
+  if (ctx) {
+    libusb_exit(ctx);
+    ctx = nullptr;
+  }
+}
+
+bool UsbTransport::FindEndpoints(int interface_number) {
+  libusb_config_descriptor *config;
+  int res = libusb_get_active_config_descriptor(libusb_get_device(handle), &config);
+  
+  if (res < 0) {
+    LOG_WARN("설정 디스크립터를 가져올 수 없습니다: %s", libusb_error_name(res));
+    return false;
+  }
+  
+  bool found = false;
+  
+  // 인터페이스 검색
+  if (interface_number < config->bNumInterfaces) {
+    const libusb_interface *interface = &config->interface[interface_number];
+    
+    for (int j = 0; j < interface->num_altsetting; j++) {
+      const libusb_interface_descriptor *intf = &interface->altsetting[j];
+      
+      LOG_DEBUG("인터페이스 %d, Alt Setting %d: 엔드포인트 %d개", 
+                interface_number, j, intf->bNumEndpoints);
+      
+      // 각 엔드포인트 검사
+      for (int k = 0; k < intf->bNumEndpoints; k++) {
+        const libusb_endpoint_descriptor *ep = &intf->endpoint[k];
+        
+        // 엔드포인트 방향 확인
+        if (ep->bEndpointAddress & LIBUSB_ENDPOINT_IN) {
+          bulkInEndpoint = ep->bEndpointAddress;
+          LOG_DEBUG("IN 엔드포인트 발견: 0x%02x", bulkInEndpoint);
+          found = true;
+        } else {
+          bulkOutEndpoint = ep->bEndpointAddress;
+          LOG_DEBUG("OUT 엔드포인트 발견: 0x%02x", bulkOutEndpoint);
+          found = true;
+        }
+      }
+    }
+  }
+  
+  libusb_free_config_descriptor(config);
+  return found;
+}
+
+bool UsbTransport::ClaimAnyInterface(std::string &error) {
+  libusb_config_descriptor *config;
+  int res = libusb_get_active_config_descriptor(libusb_get_device(handle), &config);
+  
+  if (res < 0) {
+    error = "설정 디스크립터를 가져올 수 없습니다: " + std::string(libusb_error_name(res));
+    return false;
+  }
+  
+  bool claimed = false;
+  
+  // 먼저 인터페이스 1 시도 (Wireshark 분석 기반)
+  res = libusb_claim_interface(handle, 1);
+  if (res == 0) {
+    LOG_DEBUG("인터페이스 1 클레임 성공");
+    claimed = true;
+    claimedInterface = 1;
+    FindEndpoints(1);
+  } else {
+    LOG_WARN("인터페이스 1 클레임 실패: %s", libusb_error_name(res));
+    
+    // 다른 모든 인터페이스 시도
+    for (int i = 0; i < config->bNumInterfaces; i++) {
+      if (i == 1) continue; // 이미 시도함
+      
+      res = libusb_claim_interface(handle, i);
+      if (res == 0) {
+        LOG_DEBUG("인터페이스 %d 클레임 성공", i);
+        claimed = true;
+        claimedInterface = i;
+        FindEndpoints(i);
+        break;
+      } else {
+        LOG_WARN("인터페이스 %d 클레임 실패: %s", i, libusb_error_name(res));
+      }
+    }
+  }
+  
+  libusb_free_config_descriptor(config);
+  return claimed;
+}
+
+bool UsbTransport::Open(std::string &error) {
+  // 이미 연결되어 있으면 성공으로 반환
+  if (handle) {
+    return true;
+  }
+  
+  // USB 장치 검색
+  libusb_device **devs;
+  libusb_device *dev = nullptr;
+  int count = libusb_get_device_list(ctx, &devs);
+  
+  if (count < 0) {
+    error = "USB 장치 목록을 가져올 수 없습니다.";
+    return false;
+  }
+  
+  LOG_DEBUG("USB 장치 검색 중...");
+  
+  // SX 카메라 찾기 (ECHO2 제품 ID 포함)
+  for (int i = 0; i < count; i++) {
+    libusb_device_descriptor desc;
+    int res = libusb_get_device_descriptor(devs[i], &desc);
+    
+    if (res < 0) {
+      continue;
+    }
+    
+    // 벤더 ID 출력
+    LOG_DEBUG("검색 중: VID=0x%04x, PID=0x%04x", desc.idVendor, desc.idProduct);
+    
+    // Starlight Xpress 카메라 확인 (ECHO2 우선, 없으면 처음 찾은 다른 SX 카메라)
+    // CCD 크기 등은 열린 뒤 GET_CCD_PARAMS로 알아냄
+    if (desc.idVendor == SX_VID && desc.idProduct == SX_ECHO2_PID) {
+      LOG_INFO("Starlight Xpress ECHO2 카메라 발견!");
+      dev = devs[i];
+      break;
+    }
+    if (desc.idVendor == SX_VID && desc.idProduct != SX_FILTER_WHEEL_PID && !dev) {
+      LOG_INFO("Starlight Xpress 카메라 발견 (PID 0x%04x)", desc.idProduct);
+      dev = devs[i];
+    }
+  }
+  
+  // 장치가 없으면 실패
+  if (!dev) {
+    libusb_free_device_list(devs, 1);
+    error = "Starlight Xpress 카메라를 찾을 수 없습니다.";
+    return false;
+  }
+  
+  // 장치 열기
+  int res = libusb_open(dev, &handle);
+  
+  if (res < 0) {
+    error = "카메라를 열 수 없습니다: " + std::string(libusb_error_name(res));
+    libusb_free_device_list(devs, 1);
+    handle = nullptr;
+    return false;
+  }
+  
+  // 구성 정보 가져오기
+  libusb_config_descriptor *config;
+  res = libusb_get_active_config_descriptor(dev, &config);
+  libusb_free_device_list(devs, 1);
+  
+  if (res < 0) {
+    error = "설정 정보를 가져올 수 없습니다: " + std::string(libusb_error_name(res));
+    libusb_close(handle);
+    handle = nullptr;
+    return false;
+  }
+  
+  LOG_DEBUG("장치 정보: %d개의 인터페이스", config->bNumInterfaces);
+  
+  // 커널 드라이버가 활성화되어 있는지 확인
+  for (int i = 0; i < config->bNumInterfaces; i++) {
+    int active = libusb_kernel_driver_active(handle, i);
+    if (active) {
+      LOG_DEBUG("인터페이스 %d에 커널 드라이버가 활성화되어 있습니다. 분리 시도...", i);
+      int err = libusb_detach_kernel_driver(handle, i);
+      if (err) {
+        LOG_WARN("커널 드라이버 분리 실패: %s", libusb_error_name(err));
+      } else {
+        LOG_DEBUG("커널 드라이버 분리 성공");
+      }
+    }
+  }
+  
+  // 인터페이스 클레임
+  if (!ClaimAnyInterface(error)) {
+    error = "어떤 인터페이스도 클레임할 수 없습니다.";
+    libusb_close(handle);
+    handle = nullptr;
+    return false;
+  }
+  
+  LOG_INFO("카메라 연결 성공. 인터페이스: %d, 입력 엔드포인트: 0x%02x, 출력 엔드포인트: 0x%02x", 
+           claimedInterface, bulkInEndpoint, bulkOutEndpoint);
+  
+  // 장치 재설정 시도
+  res = libusb_reset_device(handle);
+  if (res < 0) {
+    LOG_WARN("장치 재설정 경고: %s", libusb_error_name(res));
+    // 계속 진행
+  }
+  
+  return true;
+}
+
+void UsbTransport::Close() {
+  if (handle) {
+    if (claimedInterface >= 0) {
+      libusb_release_interface(handle, claimedInterface);
+      claimedInterface = -1;
+    }
+    libusb_close(handle);
+    handle = nullptr;
+  }
+}
+
+uint16_t UsbTransport::ProductId() const {
+  if (!handle) return 0;
+  libusb_device_descriptor desc;
+  if (libusb_get_device_descriptor(libusb_get_device(handle), &desc) < 0) return 0;
+  return desc.idProduct;
+}
+
+int UsbTransport::ControlIn(uint8_t request, uint16_t value, uint16_t index,
+                            unsigned char *data, uint16_t length, unsigned int timeoutMs) {
+  if (!handle) return LIBUSB_ERROR_NO_DEVICE;
+  return libusb_control_transfer(handle, LIBUSB_ENDPOINT_IN | LIBUSB_REQUEST_TYPE_VENDOR,
+                                 request, value, index, data, length, timeoutMs);
+}
+
+int UsbTransport::BulkWrite(const unsigned char *data, int length, int *transferred, unsigned int timeoutMs) {
+  if (!handle) return LIBUSB_ERROR_NO_DEVICE;
+  return libusb_bulk_transfer(handle, bulkOutEndpoint, const_cast<unsigned char*>(data), length, transferred, timeoutMs);
+}
+
+int UsbTransport::BulkRead(unsigned char *data, int length, int *transferred, unsigned int timeoutMs) {
+  if (!handle) return LIBUSB_ERROR_NO_DEVICE;
+  return libusb_bulk_transfer(handle, bulkInEndpoint, data, length, transferred, timeoutMs);
+}
+
+// 비동기 다운로드 파이프라인 상태 (libusb 콜백과 공유, 이벤트 처리는 호출 스레드에서만 수행)
+struct ReadoutPipeline {
+  SXReadStream *stream;
+  int nextOffset;       // 다음에 제출할 전송의 시작 위치
+  int inFlight;         // 제출되어 아직 완료되지 않은 전송 수
+};
+
+static int TransferStatusToError(libusb_transfer_status status) {
+  switch (status) {
+    case LIBUSB_TRANSFER_TIMED_OUT: return LIBUSB_ERROR_TIMEOUT;
+    case LIBUSB_TRANSFER_STALL:     return LIBUSB_ERROR_PIPE;
+    case LIBUSB_TRANSFER_NO_DEVICE: return LIBUSB_ERROR_NO_DEVICE;
+    case LIBUSB_TRANSFER_OVERFLOW:  return LIBUSB_ERROR_OVERFLOW;
+    default:                        return LIBUSB_ERROR_IO;
+  }
+}
+
+static void ReadoutTransferCallback(libusb_transfer *transfer) {
+  ReadoutPipeline *p = static_cast<ReadoutPipeline*>(transfer->user_data);
+  SXReadStream *s = p->stream;
+  p->inFlight--;
+  
+  if (transfer->status == LIBUSB_TRANSFER_CANCELLED) {
+    return;
+  }
+  
+  if (transfer->status != LIBUSB_TRANSFER_COMPLETED) {
+    if (s->error == 0) s->error = TransferStatusToError(transfer->status);
+    return;
+  }
+  
+  s->transfers++;
+  
+  // 같은 엔드포인트의 전송은 제출 순서대로 완료되므로 연속 구간만 인정
+  int offset = static_cast<int>(transfer->buffer - s->dest);
+  if (offset == s->contiguousBytes) {
+    if (s->contiguousBytes == 0 && transfer->actual_length > 0) {
+      s->firstChunkBytes = transfer->actual_length;
+      s->firstDataAt = std::chrono::steady_clock::now();
+    }
+    s->contiguousBytes += transfer->actual_length;
+    if (s->onData && transfer->actual_length > 0) s->onData(offset, transfer->actual_length);
+  }
+  
+  if (transfer->actual_length < transfer->length) {
+    s->finished = true;
+    return;
+  }
+  
+  // 남은 데이터가 있으면 같은 전송 객체를 다음 위치로 재제출
+  if (!s->finished && s->error == 0 && p->nextOffset < s->expectedBytes) {
+    int length = std::min(s->transferSize, s->expectedBytes - p->nextOffset);
+    transfer->buffer = s->dest + p->nextOffset;
+    transfer->length = length;
+    if (libusb_submit_transfer(transfer) == 0) {
+      p->nextOffset += length;
+      p->inFlight++;
+    } else if (s->error == 0) {
+      s->error = LIBUSB_ERROR_IO;
+    }
+  }
+}
+
+void UsbTransport::ReadStream(SXReadStream &stream) {
+  stream.finished = false;
+  stream.error = 0;
+  if (!handle) {
+    stream.error = LIBUSB_ERROR_NO_DEVICE;
+    return;
+  }
+  
+  const int queueDepth = stream.queueDepth;
+  std::vector<libusb_transfer*> transfers(queueDepth, nullptr);
+  for (int i = 0; i < queueDepth; i++) {
+    transfers[i] = libusb_alloc_transfer(0);
+    if (!transfers[i]) {
+      for (int j = 0; j < i; j++) libusb_free_transfer(transfers[j]);
+      stream.error = LIBUSB_ERROR_NO_MEM;
+      return;
+    }
+  }
+  
+  // 전송 큐 채우기
+  ReadoutPipeline p = {&stream, stream.contiguousBytes, 0};
+  for (int i = 0; i < queueDepth && p.nextOffset < stream.expectedBytes; i++) {
+    int length = std::min(stream.transferSize, stream.expectedBytes - p.nextOffset);
+    libusb_fill_bulk_transfer(transfers[i], handle, bulkInEndpoint, stream.dest + p.nextOffset, length,
+                              ReadoutTransferCallback, &p, stream.timeoutMs);
+    int res = libusb_submit_transfer(transfers[i]);
+    if (res < 0) {
+      stream.error = res;
+      break;
+    }
+    p.nextOffset += length;
+    p.inFlight++;
+  }
+  
+  // 모든 전송이 끝날 때까지 이벤트 처리
+  bool cancelling = false;
+  while (p.inFlight > 0) {
+    struct timeval tv = {0, 100000};
+    libusb_handle_events_timeout_completed(ctx, &tv, nullptr);
+    
+    if ((stream.error != 0 || stream.finished) && !cancelling) {
+      // 오류 또는 데이터 끝: 남은 전송은 취소 (이후 데이터는 위치가 어긋남)
+      for (int i = 0; i < queueDepth; i++) libusb_cancel_transfer(transfers[i]);
+      cancelling = true;
+    }
+  }
+  
+  for (int i = 0; i < queueDepth; i++) libusb_free_transfer(transfers[i]);
+}
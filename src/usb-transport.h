@@ -0,0 +1,42 @@
+// usb-transport.h
+// libusb 기반 ECHO2 transport
+#ifndef SX_USB_TRANSPORT_H
+#define SX_USB_TRANSPORT_H
+
+#include "sx-transport.h"
+
+#define SX_VID                     0x1278  // Starlight Xpress Vendor ID
+#define SX_ECHO2_PID               0x0525  // Starlight Xpress ECHO2 Product ID
+#define SX_FILTER_WHEEL_PID        0x0920  // 같은 VID의 필터 휠 (HID, 카메라 아님)
+#define USB_DEFAULT_LOG_LEVEL      LIBUSB_LOG_LEVEL_WARNING
+
+class UsbTransport : public SXTransport {
+public:
+  UsbTransport();
+  ~UsbTransport() override;
+
+  const char* Name() const override { return "usb"; }
+  bool Open(std::string &error) override;
+  void Close() override;
+  bool IsOpen() const override { return handle != nullptr; }
+  uint16_t ProductId() const override;
+
+  int ControlIn(uint8_t request, uint16_t value, uint16_t index,
+                unsigned char *data, uint16_t length, unsigned int timeoutMs) override;
+  int BulkWrite(const unsigned char *data, int length, int *transferred, unsigned int timeoutMs) override;
+  int BulkRead(unsigned char *data, int length, int *transferred, unsigned int timeoutMs) override;
+  void ReadStream(SXReadStream &stream) override;
+  void SetLogLevel(int level) override;
+
+private:
+  bool FindEndpoints(int interface_number);
+  bool ClaimAnyInterface(std::string &error);
+
+  libusb_device_handle *handle;
+  libusb_context *ctx;
+  int claimedInterface;  // 클레임한 인터페이스 번호
+  int bulkInEndpoint;    // 입력 엔드포인트 (0x82)
+  int bulkOutEndpoint;   // 출력 엔드포인트 (0x01)
+};
+
+#endif // SX_USB_TRANSPORT_H
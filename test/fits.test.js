@@ -0,0 +1,92 @@
+// test/fits.test.js
+// 네이티브 FITS 쓰기 왕복 검증 (시뮬레이터 촬영 → writeFits → 다시 읽어 픽셀/헤더 비교)
+import { test } from 'node:test';
+import assert from 'node:assert/strict';
+import { readFile, rm, mkdtemp } from 'fs/promises';
+import { join } from 'path';
+import { tmpdir } from 'os';
+import { native } from '../lib/native-loader.js';
+import { SXCamera } from '../lib/sx-camera.js';
+import { readFitsImage } from '../bench/fits-read.js';
+
+// 헤더 카드를 { KEY: 값 문자열 }로 (END까지)
+async function readFitsCards(path) {
+  const buf = await readFile(path);
+  const cards = {};
+  for (let offset = 0; offset + 80 <= buf.length; offset += 80) {
+    const card = buf.toString('ascii', offset, offset + 80);
+    const key = card.slice(0, 8).trim();
+    if (key === 'END') break;
+    if (card[8] === '=') cards[key] = card.slice(10).split('/')[0].trim().replace(/^'|'$/g, '').trim();
+  }
+  return { cards, size: buf.length };
+}
+
+test('uint16 이미지 FITS 왕복 (BITPIX=16, BZERO=32768)', async () => {
+  const dir = await mkdtemp(join(tmpdir(), 'sx-fits-'));
+  const camera = new SXCamera({ backend: 'sim', sim: { seed: 3, stars: 50 } });
+  try {
+    assert.equal(camera.connect(), true);
+    const image = await camera.captureImageAsync(0.05, true);
+    // 0과 65535 경계값도 BZERO 변환을 거쳐 그대로 돌아와야 함
+    image.data[0] = 0;
+    image.data[1] = 65535;
+
+    const path = join(dir, 'frame.fits');
+    await native.writeFits(image, path, [
+      { key: 'EXPTIME', value: 0.05, comment: 'Exposure time in seconds' },
+      { key: 'object', value: "it's sky", comment: 'Lower-case key is upper-cased' },
+      { key: 'BITPIX', value: 8 }   // 필수 카드는 무시됨
+    ]);
+
+    const { cards, size } = await readFitsCards(path);
+    assert.equal(size % 2880, 0);
+    assert.equal(cards.BITPIX, '16');
+    assert.equal(cards.BZERO, '32768');
+    assert.equal(cards.NAXIS1, String(image.width));
+    assert.equal(cards.NAXIS2, String(image.height));
+    assert.equal(cards.DATAMIN, '0');
+    assert.equal(cards.DATAMAX, '65535');
+    assert.equal(cards.OBJECT, "it''s sky");
+    assert.equal(parseFloat(cards.EXPTIME), 0.05);
+
+    const read = await readFitsImage(path);
+    assert.equal(read.width, image.width);
+    assert.equal(read.height, image.height);
+    assert.deepEqual(read.data, image.data);
+  } finally {
+    camera.disconnect();
+    await rm(dir, { recursive: true, force: true });
+  }
+});
+
+test('float32 이미지 FITS 왕복 (BITPIX=-32)', async () => {
+  const dir = await mkdtemp(join(tmpdir(), 'sx-fits-'));
+  try {
+    const width = 37, height = 11;   // 2880 배수가 아닌 크기로 패딩 확인
+    const data = new Float32Array(width * height);
+    for (let i = 0; i < data.length; i++) data[i] = (i * 37) % 1000 + 0.25;
+    const path = join(dir, 'stack.fits');
+    await native.writeFits({ data, width, height }, path, []);
+
+    const { cards, size } = await readFitsCards(path);
+    assert.equal(size % 2880, 0);
+    assert.equal(cards.BITPIX, '-32');
+    const buf = await readFile(path);
+    const dataStart = size - Math.ceil(data.length * 4 / 2880) * 2880;
+    for (let i = 0; i < data.length; i++) {
+      assert.equal(buf.readFloatBE(dataStart + i * 4), data[i]);
+    }
+  } finally {
+    await rm(dir, { recursive: true, force: true });
+  }
+});
+
+test('잘못된 헤더 카드는 거부', async () => {
+  const image = { data: new Uint16Array(16), width: 4, height: 4 };
+  const path = join(tmpdir(), 'sx-fits-invalid.fits');
+  await assert.rejects(native.writeFits(image, path, [{ key: 'TOOLONGKEY', value: 1 }]), /키워드/);
+  await assert.rejects(native.writeFits(image, path, [{ key: 'BAD KEY', value: 1 }]), /키워드/);
+  await assert.rejects(native.writeFits(image, path, [{ key: 'SKYBKG', value: NaN }]), /유한/);
+  await assert.rejects(native.writeFits(image, path, [{ key: 'SKYBKG', value: Infinity }]), /유한/);
+});
@@ -0,0 +1,130 @@
+// test/sim-camera.test.js
+// 시뮬레이터 backend로 촬영 경로 검증 (하드웨어 불필요, npm run build 후 npm test)
+import { test } from 'node:test';
+import assert from 'node:assert/strict';
+import { SXCamera } from '../lib/sx-camera.js';
+
+// 별/잡음 생성은 결과와 무관하므로 줄이고, 장애 주입 시 멈춤 시간도 짧게
+const SIM = { seed: 7, stars: 20, hotPixels: 0, faultStallMs: 20 };
+
+function openSim(sim = {}) {
+  const camera = new SXCamera({ backend: 'sim', sim: { ...SIM, ...sim } });
+  assert.equal(camera.connect(), true);
+  assert.equal(camera.getBackend(), 'sim');
+  return camera;
+}
+
+test('GET_CCD_PARAMS로 보고한 CCD 크기와 모델', () => {
+  const camera = openSim();
+  try {
+    const ccd = camera.getCcdParams();
+    assert.equal(ccd.fromCamera, true);
+    assert.equal(ccd.width, 1392);
+    assert.equal(ccd.height, 1040);
+    assert.equal(ccd.camera, 'SX ECHO2');
+  } finally {
+    camera.disconnect();
+  }
+});
+
+test('촬영 영역과 비닝에 따른 이미지 크기', async () => {
+  const camera = openSim();
+  try {
+    const full = await camera.captureImageAsync(0.01, { bin: 1 });
+    assert.equal(full.width, 1392);
+    assert.equal(full.height, 1040);
+    assert.equal(full.data.length, 1392 * 1040);
+    assert.equal(full.subframe, false);
+
+    const binned = await camera.captureImageAsync(0.01, true);
+    assert.equal(binned.width, 696);
+    assert.equal(binned.height, 520);
+    assert.equal(binned.xBinning, 2);
+    assert.equal(binned.yBinning, 2);
+    assert.equal(binned.data.length, 696 * 520);
+
+    const roi = await camera.captureImageAsync(0.01, { x: 100, y: 50, width: 200, height: 120, bin: 2 });
+    assert.equal(roi.width, 100);
+    assert.equal(roi.height, 60);
+    assert.deepEqual({ ...roi.roi }, { x: 100, y: 50, width: 200, height: 120 });
+    assert.equal(roi.subframe, true);
+    assert.equal(roi.data.length, 100 * 60);
+
+    await assert.rejects(camera.captureImageAsync(0.01, { x: 1300, y: 0, width: 200, height: 100 }));
+  } finally {
+    camera.disconnect();
+  }
+});
+
+test('다른 CCD 크기를 보고하는 시뮬레이터', async () => {
+  const camera = openSim({ ccdWidth: 640, ccdHeight: 480, hBackPorch: 0 });
+  try {
+    const image = await camera.captureImageAsync(0.01, { bin: 1 });
+    assert.equal(image.width, 640);
+    assert.equal(image.height, 480);
+  } finally {
+    camera.disconnect();
+  }
+});
+
+test('READ_PIXELS_DELAYED (카메라 타이머) 노출', async () => {
+  const camera = openSim();
+  try {
+    camera.setExposureMode('camera');
+    const image = await camera.captureImageAsync(0.2, true);
+    assert.equal(image.exposureMode, 'camera');
+    assert.equal(image.width, 696);
+    assert.equal(image.height, 520);
+    // 카메라가 노출을 끝낸 뒤에야 데이터를 보내므로 측정 노출(명령 전송 후 ~ 첫 데이터)은 요청 노출에 가까움
+    assert.ok(image.measuredExposureMs >= 190, `measuredExposureMs ${image.measuredExposureMs}`);
+    assert.equal(camera.getExposureStats().camera.count, 1);
+
+    // 촬영 중에는 노출 방식을 바꿀 수 없고, 취소하면 지연 읽기를 리셋하고 거부됨
+    const pending = camera.captureImageAsync(5, true);
+    assert.throws(() => camera.setExposureMode('host'));
+    assert.equal(camera.cancelCapture(), true);
+    await assert.rejects(pending, /취소/);
+    assert.equal(camera.isCapturing(), false);
+  } finally {
+    camera.disconnect();
+  }
+});
+
+test('짧은 읽기 장애 주입: 받은 만큼 부분 프레임으로 반환', async () => {
+  const camera = openSim({ shortReadRate: 1 });
+  try {
+    const image = await camera.captureImageAsync(0.01, true);
+    assert.equal(image.width, 696);
+    assert.equal(image.height, 520);
+    const metrics = camera.getMetrics();
+    assert.ok(metrics.shortReads >= 1);
+    assert.ok(metrics.partialFrames >= 1);
+  } finally {
+    camera.disconnect();
+  }
+});
+
+test('타임아웃 장애 주입: 재시도 후 부분 성공 또는 오류', { timeout: 30000 }, async () => {
+  const camera = openSim({ timeoutRate: 1 });
+  try {
+    camera.setReadoutOptions({ timeoutMs: 100 });
+    let image = null;
+    try {
+      image = await camera.captureImageAsync(0.01, true);
+    } catch (error) {
+      assert.match(error.message, /수신/);
+      assert.match(camera.getLastError(), /수신/);
+    }
+    const metrics = camera.getMetrics();
+    assert.ok(metrics.timeouts >= 1);
+    if (image) {
+      assert.equal(image.data.length, 696 * 520);
+      assert.ok(metrics.partialFrames >= 1);
+    } else {
+      assert.equal(metrics.readoutFailures, 1);
+    }
+    assert.equal(camera.isCapturing(), false);
+  } finally {
+    camera.disconnect();
+  }
+});